@@ -0,0 +1,201 @@
+#include "JobSystem.h"
+#include "SceneStore.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+//times the scene store's kernels on a big hierarchy, cpu only: propagating transforms, then writing
+//every instance and just the visible ones, with the SSE2 kernels and the plain loops at increasing
+//thread counts. no device needed, see the README
+
+struct SceneBenchmarkOptions
+{
+    uint32_t entities = 1000000;
+    uint32_t iterations = 20;
+    uint32_t maxThreads = 0; //0 is the core count
+    std::string jsonOutput;  //"-" writes the json to stdout instead of the table
+};
+
+struct SceneBenchmarkRow
+{
+    uint32_t threads = 0;
+    bool simd = false;
+    double updateMs = 0.0;  //median over the iterations
+    double writeAllMs = 0.0;
+    double writeCulledMs = 0.0;
+    uint32_t visible = 0;
+};
+
+static SceneBenchmarkOptions parseArguments(int argc, char** argv)
+{
+    SceneBenchmarkOptions options;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--entities" && i + 1 < argc)
+            options.entities = std::max(1u, static_cast<uint32_t>(std::stoul(argv[++i])));
+        else if (arg == "--iterations" && i + 1 < argc)
+            options.iterations = std::max(1u, static_cast<uint32_t>(std::stoul(argv[++i])));
+        else if (arg == "--threads" && i + 1 < argc)
+            options.maxThreads = std::max(1u, static_cast<uint32_t>(std::stoul(argv[++i])));
+        else if (arg == "--json" && i + 1 < argc)
+            options.jsonOutput = argv[++i];
+        else
+            throw std::runtime_error("unknown argument: " + arg);
+    }
+
+    if( options.maxThreads == 0 )
+        options.maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    return options;
+}
+
+//a complete 4-ary tree, entity i's parent is (i - 1) / 4, which is breadth first by construction
+static void createHierarchy(SceneStore& scene, uint32_t entities)
+{
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> unit(-1.f, 1.f);
+
+    for (uint32_t i = 0; i < entities; i++)
+    {
+        Transform2D local;
+        local.x = unit(random);
+        local.y = unit(random);
+        local.rotation = 3.14159265f * unit(random);
+        local.scale = i == 0 ? 16.f : 0.7f;
+
+        Renderable renderable;
+        renderable.mesh = i % 6;
+        renderable.radius = 0.5f;
+        scene.create(local, renderable, i == 0 ? NO_PARENT : (i - 1) / 4);
+    }
+}
+
+template<typename Body>
+static double medianMs(uint32_t iterations, Body&& body)
+{
+    std::vector<double> samples;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        body();
+        samples.push_back(std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+static void printTable(std::ostream& out, const SceneBenchmarkOptions& options, const std::vector<SceneBenchmarkRow>& rows)
+{
+    out << "Scene benchmark: " << options.entities << " entities, median of " << options.iterations << " iterations, times in ms"
+        << std::endl;
+    out << "  " << std::setw(8) << "threads" << std::setw(8) << "kernel" << std::setw(12) << "update" << std::setw(12) << "write all"
+        << std::setw(14) << "write culled" << std::setw(14) << "M entities/s" << std::endl;
+
+    out << std::fixed << std::setprecision(3);
+    for (auto& row : rows)
+    {
+        double total = row.updateMs + row.writeAllMs;
+        out << "  " << std::setw(8) << row.threads << std::setw(8) << (row.simd ? "sse2" : "scalar") << std::setw(12) << row.updateMs
+            << std::setw(12) << row.writeAllMs << std::setw(14) << row.writeCulledMs
+            << std::setw(14) << (total > 0.0 ? options.entities / total / 1000.0 : 0.0) << std::endl;
+    }
+    out << std::defaultfloat;
+
+    if( !rows.empty() )
+        out << "  culled writes kept " << rows.front().visible << " of " << options.entities << std::endl;
+}
+
+static void writeJson(std::ostream& out, const SceneBenchmarkOptions& options, const std::vector<SceneBenchmarkRow>& rows)
+{
+    out << std::setprecision(6);
+    out << "{" << std::endl;
+    out << "  \"entities\": " << options.entities << "," << std::endl;
+    out << "  \"iterations\": " << options.iterations << "," << std::endl;
+    out << "  \"unit\": \"ms\"," << std::endl;
+    out << "  \"results\": [" << std::endl;
+    for (size_t i = 0; i < rows.size(); i++)
+    {
+        auto& row = rows[i];
+        out << "    {\"threads\": " << row.threads << ", \"simd\": " << (row.simd ? "true" : "false")
+            << ", \"update\": " << row.updateMs << ", \"writeAll\": " << row.writeAllMs << ", \"writeCulled\": " << row.writeCulledMs
+            << ", \"visible\": " << row.visible << "}" << (i + 1 < rows.size() ? "," : "") << std::endl;
+    }
+    out << "  ]" << std::endl << "}" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        auto options = parseArguments(argc, argv);
+
+        SceneStore scene(options.entities);
+        createHierarchy(scene, options.entities);
+        std::cerr << "Built " << scene.size() << " entities, " << scene.depthCount() << " deep" << std::endl;
+
+        //stands in for a mapped instance buffer
+        std::vector<GpuInstance> instances(options.entities);
+        SceneView view = {};
+        view.halfExtent[0] = 16.f;
+        view.halfExtent[1] = 9.f;
+
+        std::vector<SceneBenchmarkRow> rows;
+        for (uint32_t threads = 1;; threads = std::min(threads * 2, options.maxThreads))
+        {
+            JobSystem jobs(threads - 1);
+            for (bool simd : {false, true})
+            {
+                scene.setSimd(simd);
+
+                SceneBenchmarkRow row;
+                row.threads = threads;
+                row.simd = simd;
+                row.updateMs = medianMs(options.iterations, [&] { scene.updateTransforms(jobs); });
+                row.writeAllMs = medianMs(options.iterations, [&] {
+                    scene.writeInstances(jobs, nullptr, instances.data(), options.entities);
+                });
+                row.writeCulledMs = medianMs(options.iterations, [&] {
+                    row.visible = scene.writeInstances(jobs, &view, instances.data(), options.entities);
+                });
+                rows.push_back(row);
+
+                std::cerr << threads << " threads " << (simd ? "sse2" : "scalar") << ": update " << row.updateMs << "ms" << std::endl;
+            }
+
+            if( threads == options.maxThreads )
+                break;
+        }
+
+        if( options.jsonOutput == "-" )
+            writeJson(std::cout, options, rows);
+        else
+        {
+            printTable(std::cout, options, rows);
+
+            if( !options.jsonOutput.empty() )
+            {
+                std::ofstream file(options.jsonOutput);
+                if( !file.is_open() )
+                    throw std::runtime_error("failed to open " + options.jsonOutput + " for writing!");
+                writeJson(file, options, rows);
+                std::cout << "Wrote results to " << options.jsonOutput << std::endl;
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
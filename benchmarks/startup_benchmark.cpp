@@ -0,0 +1,305 @@
+#include "Application.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+//runs the app headless over and over, timing each init stage, the frame loop and cleanup, then reports
+//percentiles over the runs. meant to be pointed at a software ICD (lavapipe, swiftshader) on machines
+//without a gpu so startup regressions show up in CI, see the README
+
+struct BenchmarkOptions
+{
+    uint32_t runs = 10;
+    uint32_t warmupRuns = 1; //first run pays for loading the ICD and cold disk caches, not counted
+    std::string jsonOutput;  //"-" writes the json to stdout instead of the table
+    bool verbose = false;    //leaves the app's own output on
+    AppOptions app;
+};
+
+struct Percentiles
+{
+    double min = 0.0;
+    double mean = 0.0;
+    double p50 = 0.0;
+    double p90 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+};
+
+//nearest rank, the samples are few enough that interpolating would only invent precision
+static Percentiles computePercentiles(std::vector<double> samples)
+{
+    Percentiles result;
+    if( samples.empty() )
+        return result;
+
+    std::sort(samples.begin(), samples.end());
+    auto rank = [&](double p) {
+        size_t index = static_cast<size_t>(std::ceil(p * samples.size()));
+        return samples[std::clamp<size_t>(index, 1, samples.size()) - 1];
+    };
+
+    double total = 0.0;
+    for (double sample : samples)
+        total += sample;
+
+    result.min = samples.front();
+    result.mean = total / samples.size();
+    result.p50 = rank(0.50);
+    result.p90 = rank(0.90);
+    result.p99 = rank(0.99);
+    result.max = samples.back();
+    return result;
+}
+
+//stage names are fixed identifiers, only the device name needs escaping
+static std::string jsonString(const std::string& value)
+{
+    std::string result = "\"";
+    for (char c : value)
+    {
+        if( c == '"' || c == '\\' )
+            result += '\\';
+        if( static_cast<unsigned char>(c) >= 0x20 )
+            result += c;
+    }
+    return result + "\"";
+}
+
+static void writeJsonPercentiles(std::ostream& out, const Percentiles& p)
+{
+    out << "{\"min\": " << p.min << ", \"mean\": " << p.mean << ", \"p50\": " << p.p50 << ", \"p90\": " << p.p90
+        << ", \"p99\": " << p.p99 << ", \"max\": " << p.max << "}";
+}
+
+static void printRow(std::ostream& out, const std::string& name, const Percentiles& p)
+{
+    out << "  " << std::left << std::setw(26) << name << std::right
+        << std::setw(10) << p.min << std::setw(10) << p.p50 << std::setw(10) << p.p90
+        << std::setw(10) << p.p99 << std::setw(10) << p.max << std::endl;
+}
+
+//swallows the app's console output between runs
+class NullBuffer : public std::streambuf
+{
+protected:
+    int overflow(int c) override { return traits_type::not_eof(c); }
+};
+
+static BenchmarkOptions parseArguments(int argc, char** argv)
+{
+    BenchmarkOptions options;
+    options.app.headless = true;
+    options.app.frameCount = DEFAULT_HEADLESS_FRAMES;
+    options.app.pipelineCachePath.clear(); //every run compiles from scratch unless --pipeline-cache says otherwise
+    options.app.capabilityCachePath.clear(); //and queries every capability, --capability-cache alternates cold and warm
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--runs" && i + 1 < argc)
+            options.runs = std::max(1u, static_cast<uint32_t>(std::stoul(argv[++i])));
+        else if (arg == "--warmup" && i + 1 < argc)
+            options.warmupRuns = static_cast<uint32_t>(std::stoul(argv[++i]));
+        else if (arg == "--json" && i + 1 < argc)
+            options.jsonOutput = argv[++i];
+        else if (arg == "--verbose")
+            options.verbose = true;
+        else if (arg == "--frames" && i + 1 < argc)
+            options.app.frameCount = std::max(1u, static_cast<uint32_t>(std::stoul(argv[++i])));
+        else if (arg == "--device" && i + 1 < argc)
+            options.app.deviceSelector = argv[++i];
+        else if (arg == "--draws" && i + 1 < argc)
+            options.app.drawCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+        else if (arg == "--threads" && i + 1 < argc)
+            options.app.recordThreads = std::max(1u, static_cast<uint32_t>(std::stoul(argv[++i])));
+        else if (arg == "--frames-in-flight" && i + 1 < argc)
+            options.app.framesInFlight = std::clamp(static_cast<uint32_t>(std::stoul(argv[++i])), 1u, MAX_FRAMES_IN_FLIGHT);
+        else if (arg == "--pipeline-cache" && i + 1 < argc)
+            options.app.pipelineCachePath = argv[++i];
+        else if (arg == "--capability-cache" && i + 1 < argc)
+            options.app.capabilityCachePath = argv[++i];
+        else if (arg == "--mesh" && i + 1 < argc)
+            options.app.meshPath = argv[++i];
+        else
+            throw std::runtime_error("unknown argument: " + arg);
+    }
+
+    return options;
+}
+
+struct BenchmarkResults
+{
+    std::string deviceName;
+    std::vector<std::pair<std::string, std::vector<double>>> stages; //in the order the app ran them
+    std::vector<double> initMs;
+    std::vector<double> frameLoopMs;
+    std::vector<double> frameMs; //every frame of every run
+    std::vector<double> cleanupMs;
+    //split by whether the capability cache was warm, only both filled with --capability-cache
+    std::vector<double> coldCapabilityMs;
+    std::vector<double> warmCapabilityMs;
+    std::vector<double> coldInitMs;
+    std::vector<double> warmInitMs;
+
+    void add(const RunTimings& timings)
+    {
+        deviceName = timings.deviceName;
+
+        for (auto& stage : timings.initStages)
+        {
+            auto it = std::find_if(stages.begin(), stages.end(), [&](auto& entry) { return entry.first == stage.name; });
+            if( it == stages.end() )
+                it = stages.insert(stages.end(), {stage.name, {}});
+            it->second.push_back(stage.ms);
+        }
+
+        initMs.push_back(timings.initMs);
+        frameLoopMs.push_back(timings.frameLoopMs);
+        frameMs.insert(frameMs.end(), timings.frameMs.begin(), timings.frameMs.end());
+        cleanupMs.push_back(timings.cleanupMs);
+
+        (timings.capabilitiesCached ? warmCapabilityMs : coldCapabilityMs).push_back(timings.capabilityMs);
+        (timings.capabilitiesCached ? warmInitMs : coldInitMs).push_back(timings.initMs);
+    }
+};
+
+static void printTable(std::ostream& out, const BenchmarkOptions& options, const BenchmarkResults& results)
+{
+    out << "Startup benchmark on " << results.deviceName << ": " << options.runs << " runs of " << options.app.frameCount
+        << " frames (" << options.warmupRuns << " warmup), times in ms" << std::endl;
+    out << "  " << std::left << std::setw(26) << "stage" << std::right
+        << std::setw(10) << "min" << std::setw(10) << "p50" << std::setw(10) << "p90"
+        << std::setw(10) << "p99" << std::setw(10) << "max" << std::endl;
+
+    out << std::fixed << std::setprecision(3);
+    for (auto& stage : results.stages)
+        printRow(out, stage.first, computePercentiles(stage.second));
+    printRow(out, "init total", computePercentiles(results.initMs));
+    if( !results.warmCapabilityMs.empty() )
+    {
+        printRow(out, "capabilities, cold", computePercentiles(results.coldCapabilityMs));
+        printRow(out, "capabilities, warm", computePercentiles(results.warmCapabilityMs));
+        printRow(out, "init total, cold caps", computePercentiles(results.coldInitMs));
+        printRow(out, "init total, warm caps", computePercentiles(results.warmInitMs));
+    }
+    printRow(out, "frame", computePercentiles(results.frameMs));
+    printRow(out, "frame loop", computePercentiles(results.frameLoopMs));
+    printRow(out, "cleanup", computePercentiles(results.cleanupMs));
+    out << std::defaultfloat;
+}
+
+static void writeJson(std::ostream& out, const BenchmarkOptions& options, const BenchmarkResults& results)
+{
+    out << std::setprecision(6);
+    out << "{" << std::endl;
+    out << "  \"device\": " << jsonString(results.deviceName) << "," << std::endl;
+    out << "  \"runs\": " << options.runs << "," << std::endl;
+    out << "  \"warmupRuns\": " << options.warmupRuns << "," << std::endl;
+    out << "  \"framesPerRun\": " << options.app.frameCount << "," << std::endl;
+    out << "  \"draws\": " << options.app.drawCount << "," << std::endl;
+    out << "  \"pipelineCache\": " << (options.app.pipelineCachePath.empty() ? "false" : "true") << "," << std::endl;
+    out << "  \"capabilityCache\": " << (options.app.capabilityCachePath.empty() ? "false" : "true") << "," << std::endl;
+    out << "  \"unit\": \"ms\"," << std::endl;
+
+    out << "  \"initStages\": [" << std::endl;
+    for (size_t i = 0; i < results.stages.size(); i++)
+    {
+        out << "    {\"name\": " << jsonString(results.stages[i].first) << ", \"time\": ";
+        writeJsonPercentiles(out, computePercentiles(results.stages[i].second));
+        out << "}" << (i + 1 < results.stages.size() ? "," : "") << std::endl;
+    }
+    out << "  ]," << std::endl;
+
+    out << "  \"init\": ";
+    writeJsonPercentiles(out, computePercentiles(results.initMs));
+    out << "," << std::endl << "  \"capabilities\": {\"cold\": ";
+    writeJsonPercentiles(out, computePercentiles(results.coldCapabilityMs));
+    out << ", \"warm\": ";
+    writeJsonPercentiles(out, computePercentiles(results.warmCapabilityMs));
+    out << "}," << std::endl << "  \"initByCapabilities\": {\"cold\": ";
+    writeJsonPercentiles(out, computePercentiles(results.coldInitMs));
+    out << ", \"warm\": ";
+    writeJsonPercentiles(out, computePercentiles(results.warmInitMs));
+    out << "}";
+    out << "," << std::endl << "  \"frame\": ";
+    writeJsonPercentiles(out, computePercentiles(results.frameMs));
+    out << "," << std::endl << "  \"frameLoop\": ";
+    writeJsonPercentiles(out, computePercentiles(results.frameLoopMs));
+    out << "," << std::endl << "  \"cleanup\": ";
+    writeJsonPercentiles(out, computePercentiles(results.cleanupMs));
+    out << std::endl << "}" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        auto options = parseArguments(argc, argv);
+
+        NullBuffer nullBuffer;
+        BenchmarkResults results;
+        for (uint32_t run = 0; run < options.warmupRuns + options.runs; run++)
+        {
+            //a fresh app every run, so each one pays the whole startup cost again. with a capability cache every
+            //other run starts without the file, so cold and warm starts are measured under the same conditions
+            HelloTriangleApplication app;
+            if( !options.app.capabilityCachePath.empty() && run % 2 == 0 )
+                std::remove(options.app.capabilityCachePath.c_str());
+
+            auto coutBuffer = std::cout.rdbuf();
+            if( !options.verbose )
+                std::cout.rdbuf(&nullBuffer);
+            try
+            {
+                app.run("VKLearning startup benchmark", options.app);
+            }
+            catch (...)
+            {
+                std::cout.rdbuf(coutBuffer);
+                throw;
+            }
+            std::cout.rdbuf(coutBuffer);
+
+            bool warmup = run < options.warmupRuns;
+            if( !warmup )
+                results.add(app.timings());
+
+            std::cerr << (warmup ? "warmup " : "run ") << (warmup ? run + 1 : run - options.warmupRuns + 1) << ": init "
+                << app.timings().initMs << "ms (capabilities " << (app.timings().capabilitiesCached ? "warm " : "cold ")
+                << app.timings().capabilityMs << "ms), frame loop " << app.timings().frameLoopMs << "ms" << std::endl;
+        }
+
+        if( options.jsonOutput == "-" )
+            writeJson(std::cout, options, results);
+        else
+        {
+            printTable(std::cout, options, results);
+
+            if( !options.jsonOutput.empty() )
+            {
+                std::ofstream file(options.jsonOutput);
+                if( !file.is_open() )
+                    throw std::runtime_error("failed to open " + options.jsonOutput + " for writing!");
+                writeJson(file, options, results);
+                std::cout << "Wrote results to " << options.jsonOutput << std::endl;
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
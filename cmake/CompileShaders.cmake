@@ -0,0 +1,104 @@
+#compiles every glsl source in a directory to spir-v at build time
+#
+#each shader is its own custom command, so make/ninja only rebuild what changed and compile them in
+#parallel. glslc writes a depfile so edits to #included files trigger a rebuild too. with EMBED the
+#spir-v is also written as a list of words and gathered into a generated header of constexpr arrays,
+#see src/ShaderLibrary.cpp for the consumer. without it, ARCHIVE packs the .spv files into one asset
+#archive (src/AssetArchive.h) with the PACK_TOOL target so they load through a single mapping
+
+find_program(GLSLC_EXECUTABLE glslc HINTS "$ENV{VULKAN_SDK}/bin" "$ENV{VULKAN_SDK}/Bin")
+
+#depfiles for custom commands only work with ninja before cmake 3.20
+if(CMAKE_GENERATOR MATCHES "Ninja" OR NOT CMAKE_VERSION VERSION_LESS 3.20)
+    set(VKL_SHADER_DEPFILES ON)
+else()
+    set(VKL_SHADER_DEPFILES OFF)
+    message(STATUS "shader #include tracking needs ninja or cmake >= 3.20, only the shader sources themselves are tracked")
+endif()
+
+#vkl_compile_shaders(<target> SOURCE_DIR <dir> OUTPUT_DIR <dir> [EMBED] [ARCHIVE <file> PACK_TOOL <target>])
+function(vkl_compile_shaders TARGET)
+    cmake_parse_arguments(ARG "EMBED" "SOURCE_DIR;OUTPUT_DIR;ARCHIVE;PACK_TOOL" "" ${ARGN})
+
+    if(NOT GLSLC_EXECUTABLE)
+        message(FATAL_ERROR "glslc not found, install the Vulkan SDK or set GLSLC_EXECUTABLE")
+    endif()
+
+    file(GLOB SHADER_SOURCES CONFIGURE_DEPENDS
+        "${ARG_SOURCE_DIR}/*.vert" "${ARG_SOURCE_DIR}/*.frag" "${ARG_SOURCE_DIR}/*.comp"
+        "${ARG_SOURCE_DIR}/*.geom" "${ARG_SOURCE_DIR}/*.tesc" "${ARG_SOURCE_DIR}/*.tese")
+
+    file(MAKE_DIRECTORY "${ARG_OUTPUT_DIR}")
+
+    set(SHADER_OUTPUTS)
+    set(SPV_OUTPUTS)
+    set(EMBED_ARRAYS "")
+    set(EMBED_TABLE "")
+
+    foreach(SOURCE ${SHADER_SOURCES})
+        get_filename_component(SHADER_NAME "${SOURCE}" NAME)
+        set(SPV "${ARG_OUTPUT_DIR}/${SHADER_NAME}.spv")
+        set(OUTPUTS "${SPV}")
+        set(COMMANDS COMMAND "${GLSLC_EXECUTABLE}" -I "${ARG_SOURCE_DIR}" "${SOURCE}" -o "${SPV}")
+        set(DEPFILE_ARGS)
+
+        if(VKL_SHADER_DEPFILES)
+            set(COMMANDS COMMAND "${GLSLC_EXECUTABLE}" -I "${ARG_SOURCE_DIR}" -MD -MF "${SPV}.d" "${SOURCE}" -o "${SPV}")
+            set(DEPFILE_ARGS DEPFILE "${SPV}.d")
+        endif()
+
+        if(ARG_EMBED)
+            #-mfmt=num writes the words as a comma separated list, ready to #include inside an initializer
+            set(INC "${ARG_OUTPUT_DIR}/${SHADER_NAME}.inc")
+            list(APPEND OUTPUTS "${INC}")
+            list(APPEND COMMANDS COMMAND "${GLSLC_EXECUTABLE}" -I "${ARG_SOURCE_DIR}" -mfmt=num "${SOURCE}" -o "${INC}")
+
+            string(MAKE_C_IDENTIFIER "${SHADER_NAME}" IDENTIFIER)
+            string(APPEND EMBED_ARRAYS "constexpr uint32_t ${IDENTIFIER}[] = {\n#include \"${SHADER_NAME}.inc\"\n};\n\n")
+            string(APPEND EMBED_TABLE "    {\"${SHADER_NAME}\", ${IDENTIFIER}, sizeof(${IDENTIFIER})},\n")
+        endif()
+
+        add_custom_command(
+            OUTPUT ${OUTPUTS}
+            ${COMMANDS}
+            MAIN_DEPENDENCY "${SOURCE}"
+            ${DEPFILE_ARGS}
+            COMMENT "Compiling shader ${SHADER_NAME}"
+            VERBATIM)
+
+        list(APPEND SHADER_OUTPUTS ${OUTPUTS})
+        list(APPEND SPV_OUTPUTS "${SPV}")
+    endforeach()
+
+    if(ARG_ARCHIVE AND NOT ARG_EMBED)
+        set(ARCHIVE "${ARG_OUTPUT_DIR}/${ARG_ARCHIVE}")
+        add_custom_command(
+            OUTPUT "${ARCHIVE}"
+            COMMAND $<TARGET_FILE:${ARG_PACK_TOOL}> "${ARCHIVE}" ${SPV_OUTPUTS}
+            DEPENDS ${SPV_OUTPUTS} ${ARG_PACK_TOOL}
+            COMMENT "Packing shaders into ${ARG_ARCHIVE}"
+            VERBATIM)
+        list(APPEND SHADER_OUTPUTS "${ARCHIVE}")
+    endif()
+
+    add_custom_target(${TARGET}Shaders ALL DEPENDS ${SHADER_OUTPUTS})
+    add_dependencies(${TARGET} ${TARGET}Shaders)
+
+    target_include_directories(${TARGET} PRIVATE "${ARG_OUTPUT_DIR}")
+    target_compile_definitions(${TARGET} PRIVATE VKL_SHADER_DIR="${ARG_OUTPUT_DIR}")
+    #for recompiling them while the app runs, see src/ShaderReloader.h
+    target_compile_definitions(${TARGET} PRIVATE VKL_SHADER_SOURCE_DIR="${ARG_SOURCE_DIR}" VKL_GLSLC="${GLSLC_EXECUTABLE}")
+
+    if(ARG_EMBED)
+        target_compile_definitions(${TARGET} PRIVATE VKL_EMBED_SHADERS=1)
+
+        #only rewritten when the set of shaders changes, the arrays themselves come from the .inc files
+        set(HEADER "${ARG_OUTPUT_DIR}/EmbeddedShaders.h")
+        set(CONTENT "//generated by cmake/CompileShaders.cmake, do not edit\n#pragma once\n\n#include <cstddef>\n#include <cstdint>\n\n")
+        string(APPEND CONTENT "namespace embedded_shaders\n{\n\n${EMBED_ARRAYS}")
+        string(APPEND CONTENT "struct Entry\n{\n    const char* name;\n    const uint32_t* code;\n    size_t size;\n};\n\n")
+        string(APPEND CONTENT "constexpr Entry entries[] = {\n${EMBED_TABLE}    {nullptr, nullptr, 0}\n};\n\n}\n")
+        file(WRITE "${HEADER}.tmp" "${CONTENT}")
+        configure_file("${HEADER}.tmp" "${HEADER}" COPYONLY)
+    endif()
+endfunction()
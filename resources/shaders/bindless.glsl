@@ -0,0 +1,14 @@
+//the bindless heap's set, see src/BindlessHeap.h. handles are indices into these arrays
+#extension GL_EXT_nonuniform_qualifier : require
+
+#define BINDLESS_SET 0
+#define BINDLESS_TEXTURE_BINDING 0
+#define BINDLESS_BUFFER_BINDING 1
+#define BINDLESS_STORAGE_IMAGE_BINDING 2
+#define INVALID_BINDLESS_HANDLE 0xffffffffu
+
+layout(set = BINDLESS_SET, binding = BINDLESS_TEXTURE_BINDING) uniform sampler2D bindlessTextures[];
+
+//storage buffers are declared where they are used, every block type gets its own runtime sized array
+//over BINDLESS_BUFFER_BINDING (see shader.vert). storage images are the same, one array per format over
+//BINDLESS_STORAGE_IMAGE_BINDING (see post.glsl), which is only in the set when the app asked for it
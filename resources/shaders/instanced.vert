@@ -0,0 +1,28 @@
+#version 450
+#include "bindless.glsl"
+#include "scene.glsl"
+
+layout(location = 0) out vec3 fragColor;
+
+layout(set = BINDLESS_SET, binding = BINDLESS_BUFFER_BINDING) readonly buffer VertexBuffer {
+    vec2 positions[];
+} vertexBuffers[];
+
+//matches DrawPushConstants in src/GpuScene.cpp
+layout(push_constant) uniform PushConstants {
+    vec4 view; //xy centre, zw 1 / half extent
+    uint instanceBuffer;
+    uint vertexBuffer;
+} pushConstants;
+
+void main() {
+    //each culled draw is one instance, its firstInstance is the index into the instance ring
+    Instance instance = instanceBuffers[pushConstants.instanceBuffer].instances[gl_InstanceIndex];
+    vec2 position = vertexBuffers[pushConstants.vertexBuffer].positions[gl_VertexIndex];
+
+    vec2 rotated = vec2(instance.rotation.x * position.x - instance.rotation.y * position.y,
+                        instance.rotation.y * position.x + instance.rotation.x * position.y);
+    vec2 world = rotated * instance.position.w + instance.position.xy;
+    gl_Position = vec4((world - pushConstants.view.xy) * pushConstants.view.zw, 0.0, 1.0);
+    fragColor = instance.color.rgb;
+}
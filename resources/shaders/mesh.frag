@@ -0,0 +1,3 @@
+#version 450
+#define TEXTURE_FEEDBACK 1
+#include "meshfrag.glsl"
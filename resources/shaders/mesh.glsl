@@ -0,0 +1,11 @@
+//shared by mesh.vert and the mesh fragment shaders, matches MeshPushConstants in src/StaticMesh.cpp
+layout(push_constant) uniform PushConstants {
+    vec4 boundingSphere; //xyz centre, w radius
+    vec4 rotation;       //cos and sin of the yaw, then of the pitch
+    vec2 scale;          //clip space per unit of model space
+    uint vertexBuffer;
+    uint texture;        //INVALID_BINDLESS_HANDLE until the streamer has the mip tail in
+    uint feedbackBuffer; //this frame's TextureStreamer feedback, INVALID_BINDLESS_HANDLE for none
+    uint textureId;      //the texture's slot in it
+    vec2 textureSize;    //of the full size texture, whatever is resident
+} pushConstants;
@@ -0,0 +1,39 @@
+#version 450
+#include "bindless.glsl"
+#include "mesh.glsl"
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragUv;
+
+//MeshVertex in src/MeshFile.h, 16 bytes read as one uvec4
+layout(set = BINDLESS_SET, binding = BINDLESS_BUFFER_BINDING) readonly buffer MeshVertexBuffer {
+    uvec4 vertices[];
+} meshVertexBuffers[];
+
+vec3 octahedralDecode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+vec3 rotate(vec3 v) {
+    vec4 r = pushConstants.rotation;
+    vec3 yawed = vec3(r.x * v.x + r.y * v.z, v.y, -r.y * v.x + r.x * v.z);
+    return vec3(yawed.x, r.z * yawed.y - r.w * yawed.z, r.w * yawed.y + r.z * yawed.z);
+}
+
+void main() {
+    uvec4 data = meshVertexBuffers[pushConstants.vertexBuffer].vertices[gl_VertexIndex];
+    vec3 position = vec3(unpackHalf2x16(data.x), unpackHalf2x16(data.y).x);
+    vec3 normal = octahedralDecode(unpackSnorm2x16(data.z));
+
+    //orthographic, y up like the file. no depth buffer, back faces are culled and that's it
+    vec3 view = rotate(position - pushConstants.boundingSphere.xyz);
+    gl_Position = vec4(view.x * pushConstants.scale.x, -view.y * pushConstants.scale.y, 0.5, 1.0);
+
+    float light = max(dot(rotate(normal), normalize(vec3(0.3, 0.5, 0.8))), 0.0);
+    fragColor = vec3(0.9, 0.8, 0.7) * (0.2 + 0.8 * light);
+    fragUv = unpackHalf2x16(data.w);
+}
@@ -0,0 +1,4 @@
+#version 450
+//for devices without fragmentStoresAndAtomics, the app tells the streamer what is in use instead
+#define TEXTURE_FEEDBACK 0
+#include "meshfrag.glsl"
@@ -0,0 +1,37 @@
+//body of mesh.frag and mesh_nofeedback.frag, TEXTURE_FEEDBACK picks whether it tells the streamer
+//which mip levels it wanted (storage writes from fragment shaders are an optional feature)
+#include "bindless.glsl"
+#include "mesh.glsl"
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragUv;
+
+layout(location = 0) out vec4 outColor;
+
+#if TEXTURE_FEEDBACK
+//one finest-level-wanted per streamed texture, see TextureStreamer::update
+layout(set = BINDLESS_SET, binding = BINDLESS_BUFFER_BINDING) buffer TextureFeedbackBuffer {
+    uint requestedLevels[];
+} textureFeedbackBuffers[];
+#endif
+
+void main() {
+    //in texels of the full size texture rather than the resident levels, so it's the level to stream.
+    //worked out up front, derivatives want the whole quad
+    vec2 texel = fragUv * pushConstants.textureSize;
+    vec2 dx = dFdx(texel);
+    vec2 dy = dFdy(texel);
+    float lod = max(0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1e-8)), 0.0);
+
+#if TEXTURE_FEEDBACK
+    //one pixel in 64 is plenty, and keeps the atomics on each texture's slot down
+    if( pushConstants.feedbackBuffer != INVALID_BINDLESS_HANDLE && (uint(gl_FragCoord.x) & 7u) == 0u && (uint(gl_FragCoord.y) & 7u) == 0u )
+        atomicMin(textureFeedbackBuffers[pushConstants.feedbackBuffer].requestedLevels[pushConstants.textureId], uint(lod));
+#endif
+
+    //the view starts at the finest resident level, so plain texture() picks the right one of those
+    vec3 albedo = vec3(1.0);
+    if( pushConstants.texture != INVALID_BINDLESS_HANDLE )
+        albedo = texture(bindlessTextures[pushConstants.texture], fragUv).rgb;
+    outColor = vec4(fragColor * albedo, 1.0);
+}
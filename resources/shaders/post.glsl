@@ -0,0 +1,42 @@
+//shared by the post chain's compute passes, see src/PostChain.cpp. every image is a storage image in the
+//bindless heap, read and written with imageLoad and imageStore, so there is no sampler and filtering
+//is done by hand
+#include "bindless.glsl"
+
+//matches POST_GROUP_SIZE in src/PostChain.cpp
+layout(local_size_x = 8, local_size_y = 8) in;
+
+//the scene and the bloom levels are one array, the tonemapped image before and after fxaa another
+layout(set = BINDLESS_SET, binding = BINDLESS_STORAGE_IMAGE_BINDING, rgba16f) uniform image2D hdrImages[];
+layout(set = BINDLESS_SET, binding = BINDLESS_STORAGE_IMAGE_BINDING, rgba8) uniform image2D ldrImages[];
+
+//matches the flags in src/PostChain.cpp
+#define POST_PREFILTER 1u
+#define POST_ENCODE_SRGB 2u
+
+//matches PostPushConstants in src/PostChain.cpp
+layout(push_constant) uniform PushConstants {
+    uint source;
+    uint secondSource; //INVALID_BINDLESS_HANDLE when the pass doesn't have one
+    uint destination;
+    uint flags;
+    vec4 params;
+} pushConstants;
+
+vec4 loadHdr(uint image, ivec2 pixel, ivec2 size) {
+    return imageLoad(hdrImages[image], clamp(pixel, ivec2(0), size - 1));
+}
+
+//position is in texels with texel centres at .5, like a sampler's unnormalised coordinates, clamped to the edge
+vec4 sampleHdr(uint image, vec2 position, ivec2 size) {
+    vec2 p = position - 0.5;
+    ivec2 base = ivec2(floor(p));
+    vec2 f = p - vec2(base);
+    vec4 top = mix(loadHdr(image, base, size), loadHdr(image, base + ivec2(1, 0), size), f.x);
+    vec4 bottom = mix(loadHdr(image, base + ivec2(0, 1), size), loadHdr(image, base + ivec2(1, 1), size), f.x);
+    return mix(top, bottom, f.y);
+}
+
+bool outside(ivec2 pixel, ivec2 size) {
+    return any(greaterThanEqual(pixel, size));
+}
@@ -0,0 +1,31 @@
+//the gpu driven scene's buffers, see src/GpuScene.h. include after bindless.glsl
+
+//matches GpuInstance
+struct Instance {
+    vec4 boundingSphere; //xyz centre, w radius
+    vec4 position;       //xyz, w scale
+    vec4 color;
+    uint mesh;
+    vec2 rotation; //cos, sin
+};
+
+//matches GpuMesh
+struct Mesh {
+    uint indexCount;
+    uint firstIndex;
+    int vertexOffset;
+    float radius;
+};
+
+//VkDrawIndexedIndirectCommand
+struct DrawCommand {
+    uint indexCount;
+    uint instanceCount;
+    uint firstIndex;
+    int vertexOffset;
+    uint firstInstance;
+};
+
+layout(set = BINDLESS_SET, binding = BINDLESS_BUFFER_BINDING) readonly buffer InstanceBuffer {
+    Instance instances[];
+} instanceBuffers[];
@@ -0,0 +1,39 @@
+#version 450
+#include "bindless.glsl"
+
+layout(location = 0) out vec3 fragColor;
+
+//matches DrawData in src/Application.h
+struct DrawData {
+    vec4 offsetScale; //xy offset, z scale
+    vec4 tint;
+};
+
+layout(set = BINDLESS_SET, binding = BINDLESS_BUFFER_BINDING) readonly buffer DrawDataBuffer {
+    DrawData draws[];
+} drawDataBuffers[];
+
+//matches DrawPushConstants in src/Application.h
+layout(push_constant) uniform PushConstants {
+    uint drawDataBuffer;
+    uint drawIndex;
+} pushConstants;
+
+vec2 positions[3] = vec2[](
+    vec2(0.0, -0.5),
+    vec2(0.5, 0.5),
+    vec2(-0.5, 0.5)
+);
+
+vec3 colors[3] = vec3[](
+    vec3(1.0, 0.0, 0.0),
+    vec3(0.0, 1.0, 0.0),
+    vec3(0.0, 0.0, 1.0)
+);
+
+void main() {
+    DrawData draw = drawDataBuffers[pushConstants.drawDataBuffer].draws[pushConstants.drawIndex];
+
+    gl_Position = vec4(positions[gl_VertexIndex] * draw.offsetScale.z + draw.offsetScale.xy, 0.0, 1.0);
+    fragColor = colors[gl_VertexIndex] * draw.tint.rgb;
+}
@@ -0,0 +1,3096 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include "BindlessHeap.h"
+#include "CapabilityCache.h"
+#include "DeviceQueues.h"
+#include "FrameArena.h"
+#include "FramePacing.h"
+#include "GpuAllocator.h"
+#include "GpuScene.h"
+#include "HeapStats.h"
+#include "ImageCompare.h"
+#include "JobSystem.h"
+#include "PipelineCache.h"
+#include "PostChain.h"
+#include "Profiler.h"
+#include "RenderGraph.h"
+#include "SceneStore.h"
+#include "ShaderLibrary.h"
+#include "ShaderReloader.h"
+#include "StaticMesh.h"
+#include "TextureFile.h"
+#include "TextureStreamer.h"
+#include "UploadRing.h"
+#include "ValidationLog.h"
+
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <functional>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <unordered_set>
+#include <cctype>
+#include <algorithm>
+#include <limits>
+#include <chrono>
+#include <string>
+#include <memory>
+#include <thread>
+#include <deque>
+#include <future>
+#include <cmath>
+#include <random>
+
+//Ready for this one:
+//https://vulkan-tutorial.com/en/Drawing_a_triangle/Graphics_pipeline_basics/Shader_modules
+
+const int WIDTH = 800;
+const int HEIGHT = 600;
+
+//headless mode renders into our own images instead of a swapchain
+const uint32_t OFFSCREEN_IMAGE_COUNT = 2;
+const uint32_t DEFAULT_HEADLESS_FRAMES = 100;
+//headless frames step the clock by a fixed amount instead of following the wall clock, so a given frame
+//number always renders the same image
+const double HEADLESS_FRAME_RATE = 60.0;
+
+//a headless frame matches its golden image (--golden) when no more than this share of its pixels have a
+//channel more than the tolerance off
+const uint32_t DEFAULT_GOLDEN_TOLERANCE = 4;
+const double DEFAULT_GOLDEN_MAX_DIFFERING_PERCENT = 0.1;
+
+//bindless storage image slots with --post, the post chain takes a dozen or so per frame slot
+const uint32_t POST_STORAGE_IMAGE_SLOTS = 256;
+
+//how many frames the cpu may record ahead of the gpu, by default the pacing mode decides
+const uint32_t MAX_FRAMES_IN_FLIGHT = 8;
+
+//frames before --check-allocations starts counting. by then every frame slot has come round twice, so
+//every pool, ring and profiler entry a steady frame needs has been made
+const uint32_t ALLOCATION_CHECK_WARMUP_FRAMES = 2 * MAX_FRAMES_IN_FLIGHT;
+
+//what streamed textures may keep resident unless --texture-budget says otherwise, and how long the mesh
+//shows each one before moving on to the next
+const uint32_t DEFAULT_TEXTURE_BUDGET_MIB = 256;
+const double TEXTURE_CYCLE_SECONDS = 4.0;
+
+//below this many draws it isn't worth another secondary command buffer
+const uint32_t MIN_DRAWS_PER_SECONDARY = 256;
+const VkDeviceSize UPLOAD_RING_SIZE = 16 * 1024 * 1024;
+const VkDeviceSize UPLOAD_BENCHMARK_BUFFER_SIZE = 64 * 1024 * 1024;
+const VkDeviceSize UPLOAD_BENCHMARK_CHUNK_SIZE = 64 * 1024;
+
+const std::vector<const char*> requestedValidationLayers = {
+    "VK_LAYER_KHRONOS_validation"
+};
+
+const std::vector<const char*> deviceExtensions = {
+    VK_KHR_SWAPCHAIN_EXTENSION_NAME
+};
+
+//needed headless or not, every resource is reached through the bindless heap (core in 1.2)
+const std::vector<const char*> bindlessDeviceExtensions = {
+    VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME
+};
+
+//enabled when the device has them, anything using one checks hasDeviceExtension first
+const std::vector<const char*> optionalDeviceExtensions = {
+    VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME,
+    VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME
+};
+
+const char* const DEFAULT_PIPELINE_CACHE_PATH = "pipeline_cache.bin";
+const char* const DEFAULT_CAPABILITY_CACHE_PATH = "capabilities.bin";
+
+
+//release builds leave validation out unless configured with VKL_ENABLE_VALIDATION, no layers are loaded and
+//no messenger is created so nothing is paid at runtime. builds that have it pick the level with --validation
+//or VKL_VALIDATION, defaulting to warnings
+#ifndef VKL_ENABLE_VALIDATION
+    #ifdef NDEBUG
+        #define VKL_ENABLE_VALIDATION 0
+    #else
+        #define VKL_ENABLE_VALIDATION 1
+    #endif
+#endif
+
+#if VKL_ENABLE_VALIDATION
+    const bool validationAvailable = true;
+    const ValidationLevel DEFAULT_VALIDATION_LEVEL = ValidationLevel::Warnings;
+#else
+    const bool validationAvailable = false;
+    const ValidationLevel DEFAULT_VALIDATION_LEVEL = ValidationLevel::Off;
+#endif
+
+inline VkResult CreateDebugUtilsMessengerEXT(VkInstance instance, const VkDebugUtilsMessengerCreateInfoEXT* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkDebugUtilsMessengerEXT* pMessenger)
+{
+    /*
+    VKAPI_ATTR VkResult VKAPI_CALL vkCreateDebugUtilsMessengerEXT(
+    VkInstance                                  instance,
+    const VkDebugUtilsMessengerCreateInfoEXT*   pCreateInfo,
+    const VkAllocationCallbacks*                pAllocator,
+    VkDebugUtilsMessengerEXT*                   pMessenger);
+    */
+    auto func = (PFN_vkCreateDebugUtilsMessengerEXT)vkGetInstanceProcAddr(instance, "vkCreateDebugUtilsMessengerEXT");
+    if( func != nullptr )
+    {
+        return func(instance, pCreateInfo, pAllocator, pMessenger);
+    }
+    else
+        return VK_ERROR_EXTENSION_NOT_PRESENT;
+}
+
+inline void DestroyDebugUtilsMessengerEXT(VkInstance instance, VkDebugUtilsMessengerEXT debugMessenger, const VkAllocationCallbacks* pAllocator) {
+    /*
+    VKAPI_ATTR void VKAPI_CALL vkDestroyDebugUtilsMessengerEXT(
+    VkInstance                                  instance,
+    VkDebugUtilsMessengerEXT                    messenger,
+    const VkAllocationCallbacks*                pAllocator);
+    */
+    auto func = (PFN_vkDestroyDebugUtilsMessengerEXT) vkGetInstanceProcAddr(instance, "vkDestroyDebugUtilsMessengerEXT");
+    if (func != nullptr) 
+    {
+        func(instance, debugMessenger, pAllocator);
+    }
+}
+
+inline void writeImagePPM(const std::string& filename, uint32_t width, uint32_t height, const std::vector<uint8_t>& rgbaPixels)
+{
+    std::ofstream file(filename, std::ios::binary);
+
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open " + filename + " for writing!");
+    }
+
+    file << "P6\n" << width << " " << height << "\n255\n";
+    for (size_t i = 0; i < static_cast<size_t>(width) * height; i++)
+        file.write(reinterpret_cast<const char*>(&rgbaPixels[i * 4]), 3);
+}
+
+struct AppOptions
+{
+    bool headless = false;
+    uint32_t frameCount = 0; //0 means run until the window closes (or DEFAULT_HEADLESS_FRAMES when headless)
+    std::string outputImage; //headless only, the last frame is read back and written here as a ppm
+    std::string deviceSelector; //device index or name, overrides VKL_DEVICE and the device scores
+    bool printMemoryStats = false; //dump allocator stats on exit, M does the same at any time in a window
+    uint32_t framesInFlight = 0; //0 takes it from the pacing mode
+    PacingMode pacingMode = PacingMode::Balanced; //present mode, swapchain image count and frames in flight
+    double fpsLimit = 0.0; //cpu side frame limiter, 0 leaves it to the present mode
+    bool printFrameStats = false; //a line per frame instead of a summary every second
+    uint32_t recordThreads = 0; //threads recording secondary command buffers, 0 picks from the core count
+    uint32_t drawCount = 1; //draws per frame, spread over the recording threads
+    bool measureRecordScaling = false; //time recording at 1..recordThreads threads before rendering
+    std::string pipelineCachePath = DEFAULT_PIPELINE_CACHE_PATH; //empty keeps the pipeline cache in memory only
+    std::string capabilityCachePath = DEFAULT_CAPABILITY_CACHE_PATH; //empty queries every capability on every run
+    uint32_t uploadBenchmarkKiB = 0; //streams this much through the upload ring every frame, in small chunks
+    bool printProfile = false; //per scope cpu/gpu breakdown with the once a second summary
+    std::string traceOutput; //chrome trace json of the whole run written here on exit
+    uint32_t instanceCount = 0; //culled and drawn on the gpu instead of the cpu recorded draws, 0 keeps those
+    bool cpuCull = false; //cull the instances on the cpu as well, the gpu only sees what's in view
+    std::string meshPath; //a mesh file from VKLearningMeshImport, drawn spinning instead of the cpu recorded draws
+    bool checkAllocations = false; //fail the run if any frame after the warmup allocates from the heap
+    std::vector<std::string> texturePaths; //textures from VKLearningTextureImport streamed onto the mesh in turn, needs meshPath
+    uint32_t textureBudgetMiB = DEFAULT_TEXTURE_BUDGET_MIB;
+    std::string validationLevel; //off, errors, warnings, info or verbose, overrides VKL_VALIDATION, empty takes the build's default
+    std::vector<std::string> validationMutedIds; //message ids (VUID names or 0x%08x numbers) counted but never printed
+    bool postProcess = false; //render to hdr and run bloom, tonemapping and fxaa as compute passes on the compute queue
+    bool postBloom = true;
+    bool postFxaa = true;
+    std::string goldenImage; //headless only, the last frame is compared with this ppm and the run fails if they differ
+    uint32_t goldenTolerance = DEFAULT_GOLDEN_TOLERANCE; //per channel, in 8 bit levels
+    double goldenMaxDifferingPercent = DEFAULT_GOLDEN_MAX_DIFFERING_PERCENT;
+    bool hotReload = false; //recompile shaders as their sources change and swap in the new pipelines
+};
+
+//command pools are externally synchronised, so each recording thread gets its own per frame
+struct ThreadCommandPool
+{
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    std::vector<VkCommandBuffer> secondaries; //grows on demand, handed out again after each reset
+    uint32_t used = 0;
+};
+
+//everything a frame needs that can't be touched again until its fence says the gpu is done with it
+struct FrameData
+{
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    std::vector<ThreadCommandPool> threadPools; //indexed by job system thread index
+    VkSemaphore imageAcquiredSemaphore = VK_NULL_HANDLE;
+    VkFence inFlightFence = VK_NULL_HANDLE; //signalled by the frame's last submit, the composite with --post
+
+    //with --post, the frame is three submits: geometry, the post chain on the compute queue, then the composite
+    VkCommandPool computeCommandPool = VK_NULL_HANDLE; //compute family
+    VkCommandBuffer computeCommandBuffer = VK_NULL_HANDLE;
+    VkCommandBuffer compositeCommandBuffer = VK_NULL_HANDLE; //from commandPool
+    VkSemaphore sceneRenderedSemaphore = VK_NULL_HANDLE;
+    VkSemaphore postCompleteSemaphore = VK_NULL_HANDLE;
+};
+
+//a frame whose post chain has gone to the compute queue but whose composite hasn't been submitted, it
+//waits for the next frame's geometry to go in first (see submitPostFrame)
+struct PendingComposite
+{
+    bool pending = false;
+    uint32_t frameSlot = 0;
+    uint64_t frameNumber = 0;
+};
+
+//a swapchain replaced by a resize, along with everything built on its images. kept until every frame
+//submitted before the swap has finished, so recreating never has to wait for the device to go idle
+struct RetiredSwapchain
+{
+    VkSwapchainKHR swapChain = VK_NULL_HANDLE;
+    std::vector<VkImageView> imageViews;
+    std::vector<VkFramebuffer> framebuffers;
+    std::vector<VkSemaphore> renderCompleteSemaphores;
+    uint64_t frameNumber = 0; //first frame rendered to the replacement
+};
+
+//every pipeline the frame records with, built together so a shader reload can replace them in one go
+struct PipelineSet
+{
+    VkPipeline graphics = VK_NULL_HANDLE;
+    VkPipeline instanced = VK_NULL_HANDLE; //gpu scene only
+    VkPipeline cull = VK_NULL_HANDLE;      //gpu scene only
+    VkPipeline mesh = VK_NULL_HANDLE;      //--mesh only
+    PostPipelines post;                    //--post only
+
+    std::vector<VkPipeline> all() const
+    {
+        std::vector<VkPipeline> pipelines;
+        for (auto pipeline : {graphics, instanced, cull, mesh, post.downsample, post.upsample, post.tonemap, post.fxaa})
+        {
+            if( pipeline != VK_NULL_HANDLE )
+                pipelines.push_back(pipeline);
+        }
+        return pipelines;
+    }
+};
+
+//replaced by a shader reload, destroyed once no frame in flight can still be using them
+struct RetiredPipelines
+{
+    PipelineSet pipelines;
+    uint64_t frameNumber = 0; //first frame recorded with the replacement
+};
+
+//per draw data read by shader.vert, matches DrawData there (std430)
+struct DrawData
+{
+    float offsetScale[4]; //xy offset in clip space, z scale
+    float tint[4];
+};
+
+//matches PushConstants in shader.vert
+struct DrawPushConstants
+{
+    BindlessHandle drawDataBuffer;
+    uint32_t drawIndex;
+};
+static_assert(sizeof(DrawPushConstants) <= BINDLESS_PUSH_CONSTANT_SIZE, "push constants don't fit in the bindless layout");
+
+struct FrameStats
+{
+    double cpuMs = 0.0;     //time spent in drawFrame, not counting waits on the gpu
+    double gpuWaitMs = 0.0; //time blocked waiting for the gpu to hand back a frame slot or image
+    uint64_t heapAllocations = 0; //global operator new calls during drawFrame, from any thread
+    bool streaming = false; //textures were loading, which allocates on the streamer's I/O thread
+};
+
+//wall time of one startup stage
+struct InitStageTiming
+{
+    const char* name = nullptr;
+    double ms = 0.0;
+};
+
+//where the time went in one run(), the benchmark reads this back after each run
+struct RunTimings
+{
+    std::string deviceName;
+    std::vector<InitStageTiming> initStages; //in the order they ran
+    double initMs = 0.0;          //sum of initStages
+    double frameLoopMs = 0.0;     //first frame until the device is idle after the last one
+    std::vector<double> frameMs;  //wall time of each drawFrame, waits included
+    double cleanupMs = 0.0;
+    bool capabilitiesCached = false; //every instance and device capability came from the capability cache
+    double capabilityMs = 0.0;    //loading the capability cache and asking vulkan for whatever wasn't in it
+};
+
+struct SwapChainSupportDetails 
+{
+    VkSurfaceCapabilitiesKHR capabilities;
+    std::vector<VkSurfaceFormatKHR> formats;
+    std::vector<VkPresentModeKHR> presentModes;
+};
+
+//a physical device with everything startup needs to know about it, asked for once in pickPhysicalDevice
+struct DeviceCandidate
+{
+    VkPhysicalDevice device = VK_NULL_HANDLE;
+    const DeviceCapabilities* capabilities = nullptr; //owned by the CapabilityCache
+    QueueFamilyIndices queueFamilies;
+    SwapChainSupportDetails swapChainSupport = {}; //empty when headless or the device can't present
+    int score = 0; //0 means the device can't run us at all
+};
+
+class HelloTriangleApplication {
+public:
+    void run(const char* title, const AppOptions& options = {}) 
+    {
+        _options = options;
+        _timings = {};
+
+        if( !_options.headless )
+            timeInitStage("initWindow", [&] { initWindow(WIDTH, HEIGHT, title); });
+        timeInitStage("createJobSystem", [&] { createJobSystem(); });
+        initVulkan();
+        if( _options.measureRecordScaling )
+            measureRecordingScaling();
+        //after the scaling run, which would otherwise show up in the first profile
+        timeInitStage("createProfiler", [&] { createProfiler(); });
+        mainLoop();
+
+        auto cleanupStart = std::chrono::high_resolution_clock::now();
+        cleanup();
+        _timings.cleanupMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - cleanupStart).count();
+    }
+
+    const RunTimings& timings() const { return _timings; }
+
+private:
+    AppOptions _options;
+    GLFWwindow* _window = nullptr;
+    VkInstance _instance = VK_NULL_HANDLE;
+    VkDebugUtilsMessengerEXT _debugMessenger = VK_NULL_HANDLE;
+    std::unique_ptr<ValidationLog> _validationLog; //null with validation off, outlives the instance
+    std::unique_ptr<CapabilityCache> _capabilities;
+    std::vector<const char*> _instanceLayers;
+    VkPhysicalDevice _physicalDevice = VK_NULL_HANDLE;
+    DeviceCandidate _selectedDevice; //_physicalDevice as pickPhysicalDevice found it
+    VkDevice _device = VK_NULL_HANDLE;
+    DeviceQueues _queues;
+    VkSurfaceKHR _surface = VK_NULL_HANDLE;
+    VkSwapchainKHR _swapChain = VK_NULL_HANDLE;
+    std::vector<VkImage> _swapChainImages;
+    std::vector<VkImageView> _swapChainImageViews;
+    VkFormat _swapChainImageFormat;
+    VkExtent2D _swapChainExtent;
+    std::unique_ptr<GpuAllocator> _allocator;
+    std::unique_ptr<UploadRing> _uploads;
+    VkBuffer _uploadBenchmarkBuffer = VK_NULL_HANDLE;
+    GpuAllocation _uploadBenchmarkMemory;
+    std::vector<uint8_t> _uploadBenchmarkData;
+    VkDeviceSize _uploadBenchmarkOffset = 0;
+    std::unique_ptr<JobSystem> _jobs;
+    std::unique_ptr<Profiler> _profiler;
+    std::unordered_set<std::string> _enabledDeviceExtensions;
+    std::unique_ptr<PipelineCache> _pipelineCache;
+    std::unique_ptr<BindlessHeap> _bindless;
+    VkBuffer _drawDataBuffer = VK_NULL_HANDLE;
+    GpuAllocation _drawDataMemory;
+    BindlessHandle _drawDataHandle = INVALID_BINDLESS_HANDLE;
+    PipelineSet _pipelines;
+    std::unique_ptr<ShaderReloader> _shaderReloader; //--hot-reload
+    std::vector<CompiledShader> _reloadedShaders;
+    std::future<PipelineSet> _pipelineRebuild;       //in flight while a reload's pipelines are being built
+    std::deque<RetiredPipelines> _retiredPipelines;
+    std::unique_ptr<RenderGraph> _renderGraph;
+    std::unique_ptr<GpuScene> _gpuScene;
+    std::unique_ptr<SceneStore> _scene; //what _gpuScene draws, rewritten into its instances every frame
+    std::vector<float> _clusterSpin; //radians per second of each root in _scene
+    float _sceneHalfExtent = 1.f;
+    SceneView _sceneView = {};
+    std::unique_ptr<StaticMesh> _mesh;
+    std::unique_ptr<TextureStreamer> _textures;
+    std::vector<StreamedTextureId> _textureIds; //in --texture order
+    bool _textureFeedback = false; //fragmentStoresAndAtomics, without it the cpu guesses the mip level for the streamer
+    std::unique_ptr<PostChain> _postChain;
+    std::unique_ptr<RenderGraph> _postGraph;      //the post chain's passes, executed on the compute queue
+    std::unique_ptr<RenderGraph> _compositeGraph; //its output into the backbuffer, back on the graphics queue
+    std::unique_ptr<Profiler> _postProfiler;      //timestamps written on the compute queue
+    PendingComposite _pendingComposite;
+    std::chrono::high_resolution_clock::time_point _sceneStart;
+    std::vector<GpuAllocation> _offscreenImageMemory; //headless only, backs the images in _swapChainImages
+    VkCommandPool _commandPool = VK_NULL_HANDLE; //one off commands, frames record out of their own pools
+    VkRenderPass _renderPass = VK_NULL_HANDLE;
+    std::vector<VkFramebuffer> _swapChainFramebuffers;
+    std::vector<FrameData> _frames;
+    FrameArena _frameArena; //the cpu side of recording a frame, reset once its slot's fence has signalled
+    std::vector<VkSemaphore> _renderCompleteSemaphores; //one per swapchain image
+    std::vector<VkFence> _imagesInFlight; //fence of the frame currently using each swapchain image
+    std::deque<RetiredSwapchain> _retiredSwapChains; //oldest first
+    bool _swapChainOutOfDate = false; //set by resizes and present results, recreated at the start of the next frame
+    uint32_t _currentFrame = 0;
+    uint64_t _frameNumber = 0;
+    FrameStats _lastFrameStats;
+    PacingPolicy _pacing;
+    FramePacer _pacer;
+    RunTimings _timings;
+    std::chrono::high_resolution_clock::time_point _statsWindowStart;
+    double _statsWindowCpuMs = 0.0;
+    double _statsWindowGpuWaitMs = 0.0;
+    uint64_t _statsWindowHeapAllocations = 0;
+    uint32_t _statsWindowFrames = 0;
+
+    void initWindow(int width, int height, const char* title) 
+    {
+        glfwInit();
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+        glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
+        _window = glfwCreateWindow(width, height, title, nullptr, nullptr);
+
+        glfwSetWindowUserPointer(_window, this);
+        glfwSetKeyCallback(_window, keyCallback);
+        glfwSetFramebufferSizeCallback(_window, framebufferSizeCallback);
+    }
+
+    //not every platform reports a resize through VK_ERROR_OUT_OF_DATE_KHR, so don't rely on it
+    static void framebufferSizeCallback(GLFWwindow* window, int, int)
+    {
+        auto app = reinterpret_cast<HelloTriangleApplication*>(glfwGetWindowUserPointer(window));
+        app->_swapChainOutOfDate = true;
+    }
+
+    static void keyCallback(GLFWwindow* window, int key, int, int action, int)
+    {
+        auto app = reinterpret_cast<HelloTriangleApplication*>(glfwGetWindowUserPointer(window));
+        if (key == GLFW_KEY_M && action == GLFW_PRESS && app->_allocator)
+            app->_allocator->printStats(std::cout);
+    }
+
+    void initVulkan() 
+    {
+        timeInitStage("loadCapabilityCache", [&] { loadCapabilityCache(); });
+        timeInitStage("createInstance", [&] { createInstance(); });
+        timeInitStage("setupDebugMessanger", [&] { setupDebugMessanger(); });
+        if( !_options.headless )
+            timeInitStage("createSurface", [&] { createSurface(); });
+        timeInitStage("pickPhysicalDevice", [&] { pickPhysicalDevice(); });
+        timeInitStage("configurePacing", [&] { configurePacing(); });
+        timeInitStage("createLogicalDevice", [&] { createLogicalDevice(); });
+        timeInitStage("createAllocator", [&] { createAllocator(); });
+        timeInitStage("createUploadRing", [&] { createUploadRing(); });
+        timeInitStage("createBindlessHeap", [&] { createBindlessHeap(); });
+        timeInitStage("createDrawData", [&] { createDrawData(); });
+        if( _options.instanceCount > 0 )
+            timeInitStage("createGpuScene", [&] { createGpuScene(); });
+        if( !_options.meshPath.empty() )
+            timeInitStage("loadMesh", [&] { loadMesh(); });
+        if( !_options.texturePaths.empty() )
+            timeInitStage("loadTextures", [&] { loadTextures(); });
+        if( _options.headless )
+            timeInitStage("createOffscreenTargets", [&] { createOffscreenTargets(); });
+        else
+            timeInitStage("createSwapChain", [&] { createSwapChain(); });
+        timeInitStage("createImageViews", [&] { createImageViews(); });
+        timeInitStage("createRenderPass", [&] { createRenderPass(); });
+        if( _options.postProcess )
+            timeInitStage("createPostChain", [&] { createPostChain(); });
+        timeInitStage("createPipelineCache", [&] { createPipelineCache(); });
+        timeInitStage("createGraphicsPipeline", [&] { createGraphicsPipeline(); });
+        if( _options.hotReload )
+            timeInitStage("createShaderReloader", [&] { createShaderReloader(); });
+        timeInitStage("createFramebuffers", [&] { createFramebuffers(); });
+        timeInitStage("createCommandPool", [&] { createCommandPool(); });
+        timeInitStage("createFrameResources", [&] { createFrameResources(); });
+        timeInitStage("createRenderGraph", [&] { createRenderGraph(); });
+    }
+
+    void timeInitStage(const char* name, const std::function<void()>& stage)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        stage();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        _timings.initStages.push_back({name, ms});
+        _timings.initMs += ms;
+    }
+
+    void createProfiler()
+    {
+        //timestamps are written on the graphics queue, the family decides whether they work at all
+        uint32_t timestampValidBits = deviceCapabilities().queueFamilies[_queues.family(QueueType::Graphics)].timestampValidBits;
+
+        _profiler = std::make_unique<Profiler>(_device, deviceCapabilities().properties, timestampValidBits, static_cast<uint32_t>(_frames.size()));
+        if( !_options.traceOutput.empty() )
+            _profiler->startTraceCapture();
+
+        //the post chain's passes are timed on the queue they run on, which may be a family without timestamps
+        if( _postChain )
+        {
+            uint32_t computeValidBits = deviceCapabilities().queueFamilies[_queues.family(QueueType::Compute)].timestampValidBits;
+            _postProfiler = std::make_unique<Profiler>(_device, deviceCapabilities().properties, computeValidBits, static_cast<uint32_t>(_frames.size()));
+        }
+    }
+
+    void createRenderPass()
+    {
+        //with the post chain the geometry goes into an hdr image and the backbuffer is only ever blitted to
+        VkAttachmentDescription colorAttachment = {};
+        colorAttachment.format = _options.postProcess ? PostChain::SCENE_FORMAT : _swapChainImageFormat;
+        colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+        colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        //the render graph moves the image in and out of this layout, along with everything else in the frame
+        colorAttachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+        VkAttachmentReference colorAttachmentRef = {};
+        colorAttachmentRef.attachment = 0;
+        colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+        VkSubpassDescription subpass = {};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = 1;
+        subpass.pColorAttachments = &colorAttachmentRef;
+
+        //no external dependencies, the graph's barriers either side of the pass order it with the rest
+        VkRenderPassCreateInfo renderPassInfo = {};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        renderPassInfo.attachmentCount = 1;
+        renderPassInfo.pAttachments = &colorAttachment;
+        renderPassInfo.subpassCount = 1;
+        renderPassInfo.pSubpasses = &subpass;
+
+        if (vkCreateRenderPass(_device, &renderPassInfo, nullptr, &_renderPass) != VK_SUCCESS)
+            throw std::runtime_error("failed to create render pass!");
+    }
+
+    void createFramebuffers()
+    {
+        //the post chain has a framebuffer per frame slot over its scene image instead
+        if( _postChain )
+            return;
+
+        _swapChainFramebuffers.resize(_swapChainImageViews.size());
+
+        for (size_t i = 0; i < _swapChainImageViews.size(); i++)
+        {
+            VkImageView attachments[] = { _swapChainImageViews[i] };
+
+            VkFramebufferCreateInfo framebufferInfo = {};
+            framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+            framebufferInfo.renderPass = _renderPass;
+            framebufferInfo.attachmentCount = 1;
+            framebufferInfo.pAttachments = attachments;
+            framebufferInfo.width = _swapChainExtent.width;
+            framebufferInfo.height = _swapChainExtent.height;
+            framebufferInfo.layers = 1;
+
+            if (vkCreateFramebuffer(_device, &framebufferInfo, nullptr, &_swapChainFramebuffers[i]) != VK_SUCCESS)
+                throw std::runtime_error("failed to create framebuffer!");
+        }
+    }
+
+    void createJobSystem()
+    {
+        uint32_t threadCount = _options.recordThreads;
+        if( threadCount == 0 )
+            threadCount = std::clamp(std::thread::hardware_concurrency(), 1u, 8u);
+
+        //the calling thread is thread 0, so one less worker than recording threads
+        _jobs = std::make_unique<JobSystem>(threadCount - 1);
+    }
+
+    ThreadCommandPool createThreadCommandPool()
+    {
+        const auto& indices = _selectedDevice.queueFamilies;
+
+        VkCommandPoolCreateInfo poolInfo = {};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        poolInfo.queueFamilyIndex = indices.graphicsFamily.value();
+
+        ThreadCommandPool threadPool;
+        if (vkCreateCommandPool(_device, &poolInfo, nullptr, &threadPool.commandPool) != VK_SUCCESS)
+            throw std::runtime_error("failed to create thread command pool!");
+
+        return threadPool;
+    }
+
+    VkCommandBuffer acquireSecondary(ThreadCommandPool& threadPool)
+    {
+        if( threadPool.used == threadPool.secondaries.size() )
+        {
+            VkCommandBufferAllocateInfo allocInfo = {};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.commandPool = threadPool.commandPool;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            allocInfo.commandBufferCount = 1;
+
+            VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+            if (vkAllocateCommandBuffers(_device, &allocInfo, &commandBuffer) != VK_SUCCESS)
+                throw std::runtime_error("failed to allocate secondary command buffer!");
+
+            threadPool.secondaries.push_back(commandBuffer);
+        }
+
+        return threadPool.secondaries[threadPool.used++];
+    }
+
+    void resetThreadCommandPool(ThreadCommandPool& threadPool)
+    {
+        vkResetCommandPool(_device, threadPool.commandPool, 0);
+        threadPool.used = 0;
+    }
+
+    void configurePacing()
+    {
+        //headless has no surface, only the frames in flight part of the policy applies. what pickPhysicalDevice
+        //found is still current, nothing has touched the window since
+        const SwapChainSupportDetails& swapChainSupport = _selectedDevice.swapChainSupport;
+
+        _pacing = choosePacingPolicy(_options.pacingMode, swapChainSupport.presentModes, swapChainSupport.capabilities);
+        if( _options.framesInFlight > 0 )
+            _pacing.framesInFlight = _options.framesInFlight;
+        _pacer.setFpsLimit(_options.fpsLimit);
+
+        std::cout << "Pacing: " << pacingModeName(_pacing.mode) << ", ";
+        if( !_options.headless )
+            std::cout << presentModeName(_pacing.presentMode) << " present, " << swapchainImageCount(_pacing, swapChainSupport.capabilities) << " images, ";
+        std::cout << _pacing.framesInFlight << " frames in flight";
+        if( _options.fpsLimit > 0.0 )
+            std::cout << ", limited to " << _options.fpsLimit << " fps";
+        std::cout << std::endl;
+    }
+
+    void createFrameResources()
+    {
+        const auto& indices = _selectedDevice.queueFamilies;
+
+        _frames.resize(_pacing.framesInFlight);
+        for (auto& frame : _frames)
+        {
+            //transient since the pool gets reset wholesale every time this frame slot comes round
+            VkCommandPoolCreateInfo poolInfo = {};
+            poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            poolInfo.queueFamilyIndex = indices.graphicsFamily.value();
+
+            if (vkCreateCommandPool(_device, &poolInfo, nullptr, &frame.commandPool) != VK_SUCCESS)
+                throw std::runtime_error("failed to create frame command pool!");
+
+            VkCommandBufferAllocateInfo allocInfo = {};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.commandPool = frame.commandPool;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandBufferCount = 1;
+
+            if (vkAllocateCommandBuffers(_device, &allocInfo, &frame.commandBuffer) != VK_SUCCESS)
+                throw std::runtime_error("failed to allocate frame command buffer!");
+
+            for (uint32_t i = 0; i < _jobs->threadCount(); i++)
+                frame.threadPools.push_back(createThreadCommandPool());
+
+            VkSemaphoreCreateInfo semaphoreInfo = {};
+            semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+            //signalled so the very first wait on each slot falls straight through
+            VkFenceCreateInfo fenceInfo = {};
+            fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+            fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+            if (vkCreateSemaphore(_device, &semaphoreInfo, nullptr, &frame.imageAcquiredSemaphore) != VK_SUCCESS ||
+                vkCreateFence(_device, &fenceInfo, nullptr, &frame.inFlightFence) != VK_SUCCESS)
+                throw std::runtime_error("failed to create frame synchronization objects!");
+
+            if( _postChain )
+                createPostFrameResources(frame);
+        }
+
+        createRenderCompleteSemaphores();
+    }
+
+    //the post chain is recorded on the compute family, its composite on the graphics family like the rest of the frame
+    void createPostFrameResources(FrameData& frame)
+    {
+        VkCommandPoolCreateInfo poolInfo = {};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        poolInfo.queueFamilyIndex = _queues.family(QueueType::Compute);
+
+        if (vkCreateCommandPool(_device, &poolInfo, nullptr, &frame.computeCommandPool) != VK_SUCCESS)
+            throw std::runtime_error("failed to create frame compute command pool!");
+
+        VkCommandBufferAllocateInfo allocInfo = {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = frame.computeCommandPool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = 1;
+
+        if (vkAllocateCommandBuffers(_device, &allocInfo, &frame.computeCommandBuffer) != VK_SUCCESS)
+            throw std::runtime_error("failed to allocate frame compute command buffer!");
+
+        allocInfo.commandPool = frame.commandPool;
+        if (vkAllocateCommandBuffers(_device, &allocInfo, &frame.compositeCommandBuffer) != VK_SUCCESS)
+            throw std::runtime_error("failed to allocate frame composite command buffer!");
+
+        VkSemaphoreCreateInfo semaphoreInfo = {};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+        if (vkCreateSemaphore(_device, &semaphoreInfo, nullptr, &frame.sceneRenderedSemaphore) != VK_SUCCESS ||
+            vkCreateSemaphore(_device, &semaphoreInfo, nullptr, &frame.postCompleteSemaphore) != VK_SUCCESS)
+            throw std::runtime_error("failed to create frame synchronization objects!");
+    }
+
+    //transient images are kept per frame slot, like everything else a frame in flight might still be using
+    void createRenderGraph()
+    {
+        _renderGraph = std::make_unique<RenderGraph>(_device, *_allocator, static_cast<uint32_t>(_frames.size()));
+        if( _postChain )
+        {
+            _postGraph = std::make_unique<RenderGraph>(_device, *_allocator, static_cast<uint32_t>(_frames.size()));
+            _compositeGraph = std::make_unique<RenderGraph>(_device, *_allocator, static_cast<uint32_t>(_frames.size()));
+        }
+    }
+
+    void createRenderCompleteSemaphores()
+    {
+        //render complete semaphores belong to the image, not the frame slot: the presentation engine
+        //holds on to them until that image is acquired again, which can be after this slot comes back round
+        _renderCompleteSemaphores.resize(_swapChainImages.size());
+        for (auto& semaphore : _renderCompleteSemaphores)
+        {
+            VkSemaphoreCreateInfo semaphoreInfo = {};
+            semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+            if (vkCreateSemaphore(_device, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS)
+                throw std::runtime_error("failed to create frame synchronization objects!");
+        }
+
+        _imagesInFlight.assign(_swapChainImages.size(), VK_NULL_HANDLE);
+    }
+
+    void createOffscreenTargets()
+    {
+        //stand in for the swapchain, these get the same treatment from createImageViews onwards
+        _swapChainImageFormat = VK_FORMAT_R8G8B8A8_UNORM;
+        _swapChainExtent = {WIDTH, HEIGHT};
+
+        _swapChainImages.resize(OFFSCREEN_IMAGE_COUNT);
+        _offscreenImageMemory.resize(OFFSCREEN_IMAGE_COUNT);
+
+        for (uint32_t i = 0; i < OFFSCREEN_IMAGE_COUNT; i++)
+        {
+            createImage(_swapChainExtent.width, _swapChainExtent.height, _swapChainImageFormat, VK_IMAGE_TILING_OPTIMAL,
+                VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, _swapChainImages[i], _offscreenImageMemory[i]);
+        }
+    }
+
+    void createCommandPool()
+    {
+        const auto& indices = _selectedDevice.queueFamilies;
+
+        VkCommandPoolCreateInfo poolInfo = {};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        poolInfo.queueFamilyIndex = indices.graphicsFamily.value();
+
+        if (vkCreateCommandPool(_device, &poolInfo, nullptr, &_commandPool) != VK_SUCCESS)
+            throw std::runtime_error("failed to create command pool!");
+    }
+
+    void createAllocator()
+    {
+        _allocator = std::make_unique<GpuAllocator>(deviceCapabilities().memoryProperties, GpuMemoryBackend::fromDevice(_device));
+    }
+
+    void createUploadRing()
+    {
+        _uploads = std::make_unique<UploadRing>(_device, _queues, *_allocator, UPLOAD_RING_SIZE);
+
+        if( _options.uploadBenchmarkKiB == 0 )
+            return;
+
+        //written from the transfer queue, which may be another family than the one that would read it
+        createBuffer(UPLOAD_BENCHMARK_BUFFER_SIZE, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, _uploadBenchmarkBuffer, _uploadBenchmarkMemory, uploadSharingFamilies());
+
+        _uploadBenchmarkData.resize(static_cast<size_t>(UPLOAD_BENCHMARK_CHUNK_SIZE));
+        for (size_t i = 0; i < _uploadBenchmarkData.size(); i++)
+            _uploadBenchmarkData[i] = static_cast<uint8_t>(i * 31);
+    }
+
+    void createBindlessHeap()
+    {
+        //released slots are held back until no frame in flight can still be reading them. storage images
+        //are only there for the post chain
+        uint32_t storageImages = _options.postProcess ? POST_STORAGE_IMAGE_SLOTS : 0;
+        _bindless = std::make_unique<BindlessHeap>(_device, _physicalDevice, _pacing.framesInFlight,
+            BINDLESS_DEFAULT_TEXTURES, BINDLESS_DEFAULT_BUFFERS, storageImages);
+    }
+
+    void createPostChain()
+    {
+        //storage images can't be srgb, so the tonemap encodes unless the blit into the backbuffer will
+        VkFormat format = _swapChainImageFormat;
+        bool srgbTarget = format == VK_FORMAT_B8G8R8A8_SRGB || format == VK_FORMAT_R8G8B8A8_SRGB || format == VK_FORMAT_A8B8G8R8_SRGB_PACK32;
+
+        PostChainSettings settings;
+        settings.bloom = _options.postBloom;
+        settings.fxaa = _options.postFxaa;
+        settings.encodeSrgb = !srgbTarget;
+
+        _postChain = std::make_unique<PostChain>(_device, *_allocator, *_bindless, _renderPass, postSharingFamilies(),
+            _pacing.framesInFlight, _swapChainExtent, settings);
+
+        std::cout << "Post chain: ";
+        if( settings.bloom )
+            std::cout << "bloom (" << _postChain->bloomLevels(_swapChainExtent) << " levels), ";
+        std::cout << "tonemap" << (settings.fxaa ? ", fxaa" : "") << " on the compute queue"
+                  << (_queues.isDedicated(QueueType::Compute) ? " (async)" : " (shared with graphics)") << std::endl;
+    }
+
+    //where each draw goes, laid out on a grid so they don't all land on top of each other.
+    //shaders find it through the bindless heap, the handle and draw index come in as push constants
+    void createDrawData()
+    {
+        uint32_t columns = std::max(1u, static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(_options.drawCount)))));
+        float cellSize = 2.f / columns;
+
+        std::vector<DrawData> draws(std::max(_options.drawCount, 1u));
+        for (uint32_t i = 0; i < draws.size(); i++)
+        {
+            float x = -1.f + cellSize * (i % columns + 0.5f);
+            float y = -1.f + cellSize * (i / columns + 0.5f);
+            float shade = 0.5f + 0.5f * static_cast<float>(i % 7) / 6.f;
+            draws[i] = {{x, y, 1.f / columns, 0.f}, {shade, shade, shade, 1.f}};
+        }
+
+        VkDeviceSize size = sizeof(DrawData) * draws.size();
+        createBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, _drawDataBuffer, _drawDataMemory, uploadSharingFamilies());
+
+        //written once up front, so waiting here is simpler than tracking when the first frame may read it
+        auto ticket = _uploads->uploadBuffer(_drawDataBuffer, 0, draws.data(), size);
+        _uploads->wait(ticket);
+
+        _drawDataHandle = _bindless->addBuffer(_drawDataBuffer);
+    }
+
+    void createGpuScene()
+    {
+        const VkPhysicalDeviceFeatures& features = deviceCapabilities().features;
+        if( !features.drawIndirectFirstInstance )
+            throw std::runtime_error("--instances needs drawIndirectFirstInstance!");
+
+        //without the count the whole command array is drawn, which needs more than one draw per indirect call
+        bool drawIndirectCount = hasDeviceExtension(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+        if( !drawIndirectCount && !features.multiDrawIndirect )
+            throw std::runtime_error("--instances needs VK_KHR_draw_indirect_count or multiDrawIndirect!");
+
+        const VkPhysicalDeviceProperties& properties = deviceCapabilities().properties;
+        //one command per instance, culled 64 to a workgroup
+        uint64_t maxInstances = std::min<uint64_t>(properties.limits.maxDrawIndirectCount, properties.limits.maxComputeWorkGroupCount[0] * 64ull);
+        uint32_t instanceCount = static_cast<uint32_t>(std::min<uint64_t>(_options.instanceCount, maxInstances));
+        if( instanceCount < _options.instanceCount )
+            std::cout << "Instances limited to " << instanceCount << " by the device" << std::endl;
+
+        _gpuScene = std::make_unique<GpuScene>(_device, *_allocator, *_uploads, *_bindless, uploadSharingFamilies(),
+            _pacing.framesInFlight, instanceCount, drawIndirectCount);
+        createSceneEntities(instanceCount);
+        _sceneStart = std::chrono::high_resolution_clock::now();
+
+        std::cout << "GPU scene: " << instanceCount << " instances, "
+                  << (drawIndirectCount ? "vkCmdDrawIndexedIndirectCount" : "vkCmdDrawIndexedIndirect")
+                  << (_options.cpuCull ? ", culled on the cpu first" : "") << std::endl;
+    }
+
+    void loadMesh()
+    {
+        auto file = MeshFile::open(_options.meshPath);
+        _mesh = std::make_unique<StaticMesh>(_device, *_allocator, *_uploads, *_bindless, uploadSharingFamilies(), *file);
+        _sceneStart = std::chrono::high_resolution_clock::now();
+
+        std::cout << "Mesh " << _options.meshPath << ": " << _mesh->vertexCount() << " vertices, " << _mesh->indexCount() / 3
+                  << " triangles, " << _mesh->meshletCount() << " meshlets, " << _mesh->gpuBytes() / 1024 << " KiB on the gpu" << std::endl;
+    }
+
+    //only the headers are read here, the mip tails load on the streamer's I/O thread while the rest of
+    //init carries on and the mesh is drawn untextured until they are in
+    void loadTextures()
+    {
+        if( !_mesh )
+            throw std::runtime_error("--texture needs a --mesh to be drawn on!");
+
+        VkDeviceSize budget = static_cast<VkDeviceSize>(_options.textureBudgetMiB) * 1024 * 1024;
+        _textures = std::make_unique<TextureStreamer>(_device, *_allocator, *_uploads, *_bindless, uploadSharingFamilies(),
+            _pacing.framesInFlight, budget);
+
+        for (auto& path : _options.texturePaths)
+        {
+            auto file = TextureFile::open(path);
+            std::cout << "Texture " << path << ": " << file->width() << "x" << file->height() << ", " << file->levelCount() << " levels" << std::endl;
+            _textureIds.push_back(_textures->add(std::move(file)));
+        }
+
+        std::cout << "Streaming " << _textureIds.size() << " texture(s) in a " << _options.textureBudgetMiB << " MiB budget, "
+                  << (_textureFeedback ? "gpu feedback" : "cpu estimated levels") << std::endl;
+    }
+
+    //clusters on a jittered grid, each a spinning root with a ring of children around it. roots all go in
+    //first, the store wants its entities breadth first
+    void createSceneEntities(uint32_t entityCount)
+    {
+        const uint32_t CLUSTER_SIZE = 16;
+        const float CLUSTER_SPACING = 12.f;
+
+        uint32_t clusterCount = (entityCount + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+        uint32_t columns = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(clusterCount))));
+        _sceneHalfExtent = 0.5f * columns * CLUSTER_SPACING;
+
+        std::mt19937 random(1);
+        std::uniform_real_distribution<float> unit(0.f, 1.f);
+        auto randomRenderable = [&]() {
+            Renderable renderable;
+            renderable.mesh = static_cast<uint32_t>(random() % _gpuScene->meshCount());
+            renderable.radius = _gpuScene->meshRadius(renderable.mesh);
+            renderable.color = 0xff000000;
+            for (uint32_t channel = 0; channel < 3; channel++)
+                renderable.color |= static_cast<uint32_t>(255.f * (0.3f + 0.7f * unit(random))) << (channel * 8);
+            return renderable;
+        };
+
+        _scene = std::make_unique<SceneStore>(entityCount);
+        _clusterSpin.resize(clusterCount);
+        for (uint32_t i = 0; i < clusterCount; i++)
+        {
+            Transform2D local;
+            local.x = -_sceneHalfExtent + CLUSTER_SPACING * (i % columns + 0.5f) + 2.f * (unit(random) - 0.5f);
+            local.y = -_sceneHalfExtent + CLUSTER_SPACING * (i / columns + 0.5f) + 2.f * (unit(random) - 0.5f);
+            local.scale = 2.f + unit(random);
+            _scene->create(local, randomRenderable());
+            _clusterSpin[i] = (unit(random) - 0.5f) * 2.f;
+        }
+
+        //the children are in their root's space, so they orbit as it spins
+        for (uint32_t i = clusterCount; i < entityCount; i++)
+        {
+            uint32_t root = (i - clusterCount) % clusterCount;
+            uint32_t ring = (i - clusterCount) / clusterCount;
+            float angle = 2.f * 3.14159265f * ring / (CLUSTER_SIZE - 1);
+
+            Transform2D local;
+            local.x = (1.4f + 0.3f * unit(random)) * std::cos(angle);
+            local.y = (1.4f + 0.3f * unit(random)) * std::sin(angle);
+            local.rotation = angle;
+            local.scale = 0.15f + 0.1f * unit(random);
+            _scene->create(local, randomRenderable(), root);
+        }
+    }
+
+    //slowly pans across the scene, showing a fraction of it
+    SceneView sceneViewAt(double seconds, float aspect) const
+    {
+        //a quarter of the scene's height, but never so little that a small scene fills the screen with one cluster
+        float halfHeight = std::max(0.25f * _sceneHalfExtent, 12.f);
+        float orbit = 0.5f * _sceneHalfExtent;
+        double angle = seconds * 0.1;
+
+        SceneView view = {};
+        view.centre[0] = orbit * static_cast<float>(std::cos(angle));
+        view.centre[1] = orbit * static_cast<float>(std::sin(angle));
+        view.halfExtent[0] = halfHeight * aspect;
+        view.halfExtent[1] = halfHeight;
+        return view;
+    }
+
+    //seconds since the scene was loaded, counted in frames when headless
+    double sceneSeconds() const
+    {
+        if( _options.headless )
+            return _frameNumber / HEADLESS_FRAME_RATE;
+        return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - _sceneStart).count();
+    }
+
+    //spins the roots, propagates the hierarchy and writes this frame slot's instances, all spread over
+    //the job system. only once the slot's fence has been waited on, the gpu reads the instances till then
+    void updateScene()
+    {
+        ProfileScope sceneScope(_profiler.get(), "scene update");
+
+        double seconds = sceneSeconds();
+        _sceneView = sceneViewAt(seconds, static_cast<float>(_swapChainExtent.width) / std::max(_swapChainExtent.height, 1u));
+
+        float time = static_cast<float>(seconds);
+        _jobs->parallelFor(static_cast<uint32_t>(_clusterSpin.size()), 4096, [&](uint32_t begin, uint32_t end, uint32_t) {
+            for (uint32_t i = begin; i < end; i++)
+                _scene->setLocalRotation(i, _clusterSpin[i] * time);
+        });
+        _scene->updateTransforms(*_jobs);
+
+        uint32_t count = _scene->writeInstances(*_jobs, _options.cpuCull ? &_sceneView : nullptr,
+            _gpuScene->instances(_currentFrame), _gpuScene->maxInstances());
+        _gpuScene->setInstanceCount(_currentFrame, count);
+    }
+
+    //families that need concurrent access to anything the upload ring writes and the frame reads
+    std::vector<uint32_t> uploadSharingFamilies() const
+    {
+        if( _queues.family(QueueType::Transfer) == _queues.family(QueueType::Graphics) )
+            return {};
+        return {_queues.family(QueueType::Graphics), _queues.family(QueueType::Transfer)};
+    }
+
+    //families reading and writing the post chain's scene and output images
+    std::vector<uint32_t> postSharingFamilies() const
+    {
+        if( _queues.family(QueueType::Compute) == _queues.family(QueueType::Graphics) )
+            return {};
+        return {_queues.family(QueueType::Graphics), _queues.family(QueueType::Compute)};
+    }
+
+    //stands in for geometry/texture streaming until there is some, lots of small uploads every frame
+    void streamUploadBenchmark()
+    {
+        VkDeviceSize remaining = static_cast<VkDeviceSize>(_options.uploadBenchmarkKiB) * 1024;
+        while( remaining > 0 )
+        {
+            VkDeviceSize size = std::min(remaining, UPLOAD_BENCHMARK_CHUNK_SIZE);
+            if( _uploadBenchmarkOffset + size > UPLOAD_BENCHMARK_BUFFER_SIZE )
+                _uploadBenchmarkOffset = 0;
+
+            _uploads->uploadBuffer(_uploadBenchmarkBuffer, _uploadBenchmarkOffset, _uploadBenchmarkData.data(), size);
+            _uploadBenchmarkOffset += size;
+            remaining -= size;
+        }
+    }
+
+    void createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, GpuAllocation& imageMemory)
+    {
+        VkImageCreateInfo imageInfo = {};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent.width = width;
+        imageInfo.extent.height = height;
+        imageInfo.extent.depth = 1;
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.format = format;
+        imageInfo.tiling = tiling;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.usage = usage;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        if (vkCreateImage(_device, &imageInfo, nullptr, &image) != VK_SUCCESS)
+            throw std::runtime_error("failed to create image!");
+
+        VkMemoryRequirements memoryRequirements = {};
+        vkGetImageMemoryRequirements(_device, image, &memoryRequirements);
+
+        //linear images share blocks with buffers, optimal ones get their own so granularity never bites
+        auto kind = tiling == VK_IMAGE_TILING_LINEAR ? GpuResourceKind::Buffer : GpuResourceKind::Image;
+        imageMemory = _allocator->allocate(memoryRequirements, properties, kind);
+
+        vkBindImageMemory(_device, image, imageMemory.memory, imageMemory.offset);
+    }
+
+    //sharedFamilies with more than one entry makes the buffer concurrent across them
+    void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, GpuAllocation& bufferMemory,
+        const std::vector<uint32_t>& sharedFamilies = {})
+    {
+        VkBufferCreateInfo bufferInfo = {};
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = size;
+        bufferInfo.usage = usage;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        if( sharedFamilies.size() > 1 )
+        {
+            bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+            bufferInfo.queueFamilyIndexCount = static_cast<uint32_t>(sharedFamilies.size());
+            bufferInfo.pQueueFamilyIndices = sharedFamilies.data();
+        }
+
+        if (vkCreateBuffer(_device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
+            throw std::runtime_error("failed to create buffer!");
+
+        VkMemoryRequirements memoryRequirements = {};
+        vkGetBufferMemoryRequirements(_device, buffer, &memoryRequirements);
+
+        bufferMemory = _allocator->allocate(memoryRequirements, properties, GpuResourceKind::Buffer);
+
+        vkBindBufferMemory(_device, buffer, bufferMemory.memory, bufferMemory.offset);
+    }
+
+    VkCommandBuffer beginSingleTimeCommands()
+    {
+        VkCommandBufferAllocateInfo allocInfo = {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandPool = _commandPool;
+        allocInfo.commandBufferCount = 1;
+
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        vkAllocateCommandBuffers(_device, &allocInfo, &commandBuffer);
+
+        VkCommandBufferBeginInfo beginInfo = {};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        vkBeginCommandBuffer(commandBuffer, &beginInfo);
+        return commandBuffer;
+    }
+
+    void endSingleTimeCommands(VkCommandBuffer commandBuffer)
+    {
+        vkEndCommandBuffer(commandBuffer);
+
+        VkSubmitInfo submitInfo = {};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &commandBuffer;
+
+        _queues.submit(QueueType::Graphics, 1, &submitInfo, VK_NULL_HANDLE);
+        _queues.waitIdle(QueueType::Graphics);
+
+        vkFreeCommandBuffers(_device, _commandPool, 1, &commandBuffer);
+    }
+
+    void transitionImageLayout(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout,
+        VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask, VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage)
+    {
+        VkImageMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = oldLayout;
+        barrier.newLayout = newLayout;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = 1;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = 1;
+        barrier.srcAccessMask = srcAccessMask;
+        barrier.dstAccessMask = dstAccessMask;
+
+        vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    }
+
+    //expects the image to be in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, returns tightly packed 4 byte pixels
+    std::vector<uint8_t> readbackImage(VkImage image)
+    {
+        VkDeviceSize imageSize = static_cast<VkDeviceSize>(_swapChainExtent.width) * _swapChainExtent.height * 4;
+
+        VkBuffer stagingBuffer = VK_NULL_HANDLE;
+        GpuAllocation stagingBufferMemory;
+        createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+
+        auto commandBuffer = beginSingleTimeCommands();
+
+        VkBufferImageCopy region = {};
+        region.bufferOffset = 0;
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = {0, 0, 0};
+        region.imageExtent = {_swapChainExtent.width, _swapChainExtent.height, 1};
+        vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, stagingBuffer, 1, &region);
+
+        endSingleTimeCommands(commandBuffer);
+
+        //host visible allocations come back persistently mapped
+        std::vector<uint8_t> pixels(static_cast<size_t>(imageSize));
+        memcpy(pixels.data(), stagingBufferMemory.mapped, pixels.size());
+
+        vkDestroyBuffer(_device, stagingBuffer, nullptr);
+        _allocator->free(stagingBufferMemory);
+
+        return pixels;
+    }
+
+    VkShaderModule createShaderModule(const AssetSpan& code)
+    {
+        VkShaderModuleCreateInfo createInfo = {};
+        createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        createInfo.codeSize = code.size();
+        createInfo.pCode = code.as<uint32_t>();
+
+        VkShaderModule shaderModule = VK_NULL_HANDLE;
+        if (vkCreateShaderModule(_device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS)
+            throw std::runtime_error("failed to create shader module!");
+
+        return shaderModule;
+    }
+
+    void createPipelineCache()
+    {
+        _pipelineCache = std::make_unique<PipelineCache>(_device, deviceCapabilities().properties, _options.pipelineCachePath,
+            hasDeviceExtension(VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME));
+    }
+
+    void createGraphicsPipeline() 
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        _pipelines = buildPipelines(*_jobs);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        std::cout << "Created " << _pipelines.all().size() << " pipeline(s) in " << ms << "ms" << std::endl;
+        _pipelineCache->printStats(std::cout);
+    }
+
+    //every pipeline from whatever ShaderLibrary has now. only reads what is fixed once init is done (the
+    //render pass, the heap's layout, which features are on), so a shader reload runs it off the frame loop
+    PipelineSet buildPipelines(JobSystem& jobs)
+    {
+        PipelineSet set;
+        std::vector<VkShaderModule> modules;
+        try
+        {
+            createPipelineSet(jobs, set, modules);
+        }
+        catch (...)
+        {
+            //a reloaded shader the driver rejects ends up here, nothing made before it may be left behind
+            destroyPipelines(set);
+            for (auto module : modules)
+                vkDestroyShaderModule(_device, module, nullptr);
+            throw;
+        }
+
+        for (auto module : modules)
+            vkDestroyShaderModule(_device, module, nullptr);
+        return set;
+    }
+
+    //fills in set as it goes, every shader module it creates is added to modules for the caller to destroy
+    void createPipelineSet(JobSystem& jobs, PipelineSet& set, std::vector<VkShaderModule>& modules)
+    {
+        //room for every module up front, so recording one can't throw once it has been created
+        modules.reserve(10);
+
+        //compiled by the build (see cmake/CompileShaders.cmake), or by the shader reloader since
+        auto loadShader = [&](const char* name) {
+            modules.push_back(createShaderModule(ShaderLibrary::load(name)));
+            return modules.back();
+        };
+        VkShaderModule vertShaderModule = loadShader("shader.vert");
+        VkShaderModule fragShaderModule = loadShader("shader.frag");
+
+        VkPipelineShaderStageCreateInfo shaderStages[2] = {};
+        shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+        shaderStages[0].module = vertShaderModule;
+        shaderStages[0].pName = "main";
+        shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+        shaderStages[1].module = fragShaderModule;
+        shaderStages[1].pName = "main";
+
+        //positions and colours are baked into the vertex shader
+        VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
+        vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+        VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+        inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+        inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+        //viewport and scissor are dynamic so the pipeline (and its cache entry) survives a resize
+        VkPipelineViewportStateCreateInfo viewportState = {};
+        viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+        viewportState.viewportCount = 1;
+        viewportState.scissorCount = 1;
+
+        VkPipelineRasterizationStateCreateInfo rasterizer = {};
+        rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+        rasterizer.depthClampEnable = VK_FALSE;
+        rasterizer.rasterizerDiscardEnable = VK_FALSE;
+        rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+        rasterizer.lineWidth = 1.0f;
+        rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
+        rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
+        rasterizer.depthBiasEnable = VK_FALSE;
+
+        VkPipelineMultisampleStateCreateInfo multisampling = {};
+        multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+        multisampling.sampleShadingEnable = VK_FALSE;
+        multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+        VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
+        colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+        colorBlendAttachment.blendEnable = VK_FALSE;
+
+        VkPipelineColorBlendStateCreateInfo colorBlending = {};
+        colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+        colorBlending.logicOpEnable = VK_FALSE;
+        colorBlending.attachmentCount = 1;
+        colorBlending.pAttachments = &colorBlendAttachment;
+
+        VkDynamicState dynamicStates[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+        VkPipelineDynamicStateCreateInfo dynamicState = {};
+        dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+        dynamicState.dynamicStateCount = 2;
+        dynamicState.pDynamicStates = dynamicStates;
+
+        VkGraphicsPipelineCreateInfo pipelineInfo = {};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        pipelineInfo.stageCount = 2;
+        pipelineInfo.pStages = shaderStages;
+        pipelineInfo.pVertexInputState = &vertexInputInfo;
+        pipelineInfo.pInputAssemblyState = &inputAssembly;
+        pipelineInfo.pViewportState = &viewportState;
+        pipelineInfo.pRasterizationState = &rasterizer;
+        pipelineInfo.pMultisampleState = &multisampling;
+        pipelineInfo.pColorBlendState = &colorBlending;
+        pipelineInfo.pDynamicState = &dynamicState;
+        //every pipeline shares the bindless heap's layout, so the set stays bound across pipeline changes
+        pipelineInfo.layout = _bindless->pipelineLayout();
+        pipelineInfo.renderPass = _renderPass;
+        pipelineInfo.subpass = 0;
+
+        std::vector<VkGraphicsPipelineCreateInfo> pipelineInfos = {pipelineInfo};
+
+        //the gpu scene's pipeline only differs in where the vertex shader gets its data from
+        VkShaderModule instancedShaderModule = VK_NULL_HANDLE;
+        VkPipelineShaderStageCreateInfo instancedStages[2] = {shaderStages[0], shaderStages[1]};
+        VkShaderModule cullShaderModule = VK_NULL_HANDLE;
+        if( _gpuScene )
+        {
+            instancedShaderModule = loadShader("instanced.vert");
+            instancedStages[0].module = instancedShaderModule;
+            pipelineInfos.push_back(pipelineInfo);
+            pipelineInfos.back().pStages = instancedStages;
+
+            cullShaderModule = loadShader("cull.comp");
+        }
+
+        //the mesh's vertices are pulled and unpacked in its vertex shader. it keeps the file's winding,
+        //counter clockwise seen from the front. its fragment shader writes texture streaming feedback if it can
+        VkShaderModule meshShaderModule = VK_NULL_HANDLE;
+        VkShaderModule meshFragShaderModule = VK_NULL_HANDLE;
+        VkPipelineShaderStageCreateInfo meshStages[2] = {shaderStages[0], shaderStages[1]};
+        VkPipelineRasterizationStateCreateInfo meshRasterizer = rasterizer;
+        size_t meshPipelineIndex = 0;
+        if( _mesh )
+        {
+            meshShaderModule = loadShader("mesh.vert");
+            meshFragShaderModule = loadShader(_textureFeedback ? "mesh.frag" : "mesh_nofeedback.frag");
+            meshStages[0].module = meshShaderModule;
+            meshStages[1].module = meshFragShaderModule;
+            meshRasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+            meshPipelineIndex = pipelineInfos.size();
+            pipelineInfos.push_back(pipelineInfo);
+            pipelineInfos.back().pStages = meshStages;
+            pipelineInfos.back().pRasterizationState = &meshRasterizer;
+        }
+
+        //every pipeline we know about up front goes through here so they compile in parallel
+        auto pipelines = _pipelineCache->createGraphicsPipelines(jobs, pipelineInfos);
+        set.graphics = pipelines[0];
+
+        if( _gpuScene )
+        {
+            set.instanced = pipelines[1];
+
+            VkComputePipelineCreateInfo cullInfo = {};
+            cullInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+            cullInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            cullInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+            cullInfo.stage.module = cullShaderModule;
+            cullInfo.stage.pName = "main";
+            cullInfo.layout = _bindless->pipelineLayout();
+
+            set.cull = _pipelineCache->createComputePipelines(jobs, {cullInfo})[0];
+        }
+        if( _mesh )
+            set.mesh = pipelines[meshPipelineIndex];
+        if( _postChain )
+        {
+            const char* postShaders[] = {"post_downsample.comp", "post_upsample.comp", "post_tonemap.comp", "post_fxaa.comp"};
+            std::vector<VkComputePipelineCreateInfo> postInfos;
+            for (auto shader : postShaders)
+            {
+                VkComputePipelineCreateInfo postInfo = {};
+                postInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+                postInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+                postInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+                postInfo.stage.module = loadShader(shader);
+                postInfo.stage.pName = "main";
+                postInfo.layout = _bindless->pipelineLayout();
+                postInfos.push_back(postInfo);
+            }
+
+            auto postPipelines = _pipelineCache->createComputePipelines(jobs, postInfos);
+            set.post.downsample = postPipelines[0];
+            set.post.upsample = postPipelines[1];
+            set.post.tonemap = postPipelines[2];
+            set.post.fxaa = postPipelines[3];
+        }
+    }
+
+    void createShaderReloader()
+    {
+        _shaderReloader = std::make_unique<ShaderReloader>();
+        std::cout << "Shader hot reload: watching " << _shaderReloader->sourceDir() << std::endl;
+    }
+
+    //called once the current slot's fence has been waited on. shaders the reloader has compiled are handed
+    //to ShaderLibrary and every pipeline is rebuilt from them on another thread, through the pipeline cache
+    //so the ones whose shaders didn't change come straight back out of it. the frame loop only ever looks
+    //to see whether the rebuild is done, and swaps the new set in ahead of recording when it is
+    void updateShaderReload()
+    {
+        while( !_retiredPipelines.empty() && _frameNumber + 1 >= _retiredPipelines.front().frameNumber + _frames.size() )
+        {
+            destroyPipelines(_retiredPipelines.front().pipelines);
+            _retiredPipelines.pop_front();
+        }
+
+        if( _pipelineRebuild.valid() )
+        {
+            if( _pipelineRebuild.wait_for(std::chrono::seconds(0)) != std::future_status::ready )
+                return;
+
+            try
+            {
+                PipelineSet rebuilt = _pipelineRebuild.get();
+                _retiredPipelines.push_back({_pipelines, _frameNumber});
+                _pipelines = rebuilt;
+                std::cout << "Shader reload: new pipelines in use from frame " << _frameNumber << std::endl;
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << "Shader reload: failed to rebuild pipelines, keeping the old ones: " << e.what() << std::endl;
+            }
+        }
+
+        //one rebuild at a time, anything compiled meanwhile waits for the next
+        if( !_shaderReloader->takeCompiled(_reloadedShaders) )
+            return;
+
+        for (auto& shader : _reloadedShaders)
+            ShaderLibrary::overrideSource(shader.name, shader.path);
+
+        //its own single threaded job system, the frame loop's is busy recording
+        _pipelineRebuild = std::async(std::launch::async, [this]() {
+            JobSystem jobs(0);
+            return buildPipelines(jobs);
+        });
+    }
+
+    void destroyPipelines(const PipelineSet& pipelines)
+    {
+        for (auto pipeline : pipelines.all())
+            vkDestroyPipeline(_device, pipeline, nullptr);
+    }
+
+    void createSurface() 
+    {
+        if (glfwCreateWindowSurface(_instance, _window, nullptr, &_surface) != VK_SUCCESS) 
+            throw std::runtime_error("failed to create window surface!");
+    }
+
+    void createImageViews() 
+    {
+        _swapChainImageViews.resize(_swapChainImages.size());
+
+        for (auto i = 0; i < _swapChainImages.size(); i++) 
+        {
+            VkImageViewCreateInfo createInfo = {};
+            createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            createInfo.image = _swapChainImages[i];
+
+            createInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            createInfo.format = _swapChainImageFormat;
+
+            //allows for remapping channels
+            createInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+            createInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+            createInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+            createInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+
+            createInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            createInfo.subresourceRange.baseMipLevel = 0;
+            createInfo.subresourceRange.levelCount = 1;
+            createInfo.subresourceRange.baseArrayLayer = 0;
+            createInfo.subresourceRange.layerCount = 1;
+
+            if (vkCreateImageView(_device, &createInfo, nullptr, &_swapChainImageViews[i]) != VK_SUCCESS) 
+                throw std::runtime_error("failed to create image views!");
+        }
+    }
+
+    void pickPhysicalDevice()
+    {
+        uint32_t deviceCount = 0;
+        vkEnumeratePhysicalDevices(_instance, &deviceCount, nullptr);
+        if( deviceCount == 0)
+            throw std::runtime_error("Unable to find any devices which support Vulkan.");
+
+        std::vector<VkPhysicalDevice> devices(deviceCount);
+        vkEnumeratePhysicalDevices(_instance, &deviceCount, devices.data());
+
+        //everything about each device is asked for once here, the rest of startup works from the candidates
+        std::vector<DeviceCandidate> candidates;
+        candidates.reserve(devices.size());
+        for(auto device : devices)
+            candidates.push_back(inspectDevice(device));
+
+        //an explicit selection wins over the scores, command line first then the environment
+        std::string selector = _options.deviceSelector;
+        if( selector.empty() )
+        {
+            const char* environmentSelector = std::getenv("VKL_DEVICE");
+            if( environmentSelector != nullptr )
+                selector = environmentSelector;
+        }
+
+        //stable so ties resolve in enumeration order, the same way every run
+        std::vector<const DeviceCandidate*> ranked;
+        for(const auto& candidate : candidates)
+            ranked.push_back(&candidate);
+        std::stable_sort(ranked.begin(), ranked.end(), [](const DeviceCandidate* a, const DeviceCandidate* b) { return a->score > b->score; });
+
+        std::cout << "Available Devices:" << std::endl;
+        for(auto candidate : ranked)
+            std::cout << "\t" << candidate->capabilities->properties.deviceName << " (score " << candidate->score << ")" << std::endl;
+
+        const DeviceCandidate* chosen = nullptr;
+        if( !selector.empty() )
+        {
+            chosen = &findDeviceBySelector(candidates, selector);
+            if( chosen->score == 0 )
+                throw std::runtime_error("Requested device \"" + selector + "\" is not suitable.");
+        }
+        else if( ranked.front()->score > 0 )
+            chosen = ranked.front();
+
+        if( chosen == nullptr )
+            throw std::runtime_error("Unable to find a suitable device.");
+
+        _selectedDevice = *chosen;
+        _physicalDevice = chosen->device;
+
+        std::cout << "Continuing with device: " << deviceCapabilities().properties.deviceName << std::endl;
+        _capabilities->printStats(std::cout);
+        _timings.deviceName = deviceCapabilities().properties.deviceName;
+        auto capabilityStats = _capabilities->stats();
+        _timings.capabilitiesCached = capabilityStats.instanceFromDisk && capabilityStats.devicesQueried == 0;
+        _timings.capabilityMs = capabilityStats.loadMs + capabilityStats.queryMs;
+    }
+
+    DeviceCandidate inspectDevice(VkPhysicalDevice device)
+    {
+        DeviceCandidate candidate;
+        candidate.device = device;
+        candidate.capabilities = &_capabilities->device(device, _instanceLayers);
+        candidate.queueFamilies = findQueueFamilies(device, *candidate.capabilities);
+
+        //the surface queries can't be cached, they depend on the window, but they are only made the once
+        if( !_options.headless && checkDeviceExtensionSupport(*candidate.capabilities) )
+            candidate.swapChainSupport = querySwapChainSupport(device);
+
+        candidate.score = rateDeviceSuitability(candidate);
+        return candidate;
+    }
+
+    //what pickPhysicalDevice settled on, valid from then until cleanup
+    const DeviceCapabilities& deviceCapabilities() const
+    {
+        return *_selectedDevice.capabilities;
+    }
+
+    //selector is either an index into the enumeration order or a case insensitive piece of the device name
+    const DeviceCandidate& findDeviceBySelector(const std::vector<DeviceCandidate>& candidates, const std::string& selector)
+    {
+        if( std::all_of(selector.begin(), selector.end(), [](char c) { return std::isdigit(static_cast<unsigned char>(c)); }) )
+        {
+            size_t index = std::stoul(selector);
+            if( index >= candidates.size() )
+                throw std::runtime_error("Requested device index " + selector + " is out of range.");
+            return candidates[index];
+        }
+
+        auto toLower = [](std::string value) {
+            std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            return value;
+        };
+
+        auto lowerSelector = toLower(selector);
+        for(const auto& candidate : candidates)
+        {
+            if( toLower(candidate.capabilities->properties.deviceName).find(lowerSelector) != std::string::npos )
+                return candidate;
+        }
+
+        throw std::runtime_error("No device matches \"" + selector + "\".");
+    }
+
+    void createLogicalDevice()
+    {
+        const DeviceCapabilities& capabilities = deviceCapabilities();
+
+        //one or more queues per family, see QueueLayout::build for how roles get spread over them
+        auto queueLayout = QueueLayout::build(_selectedDevice.queueFamilies);
+
+        //descriptor indexing goes on for the bindless heap, the indirect draw features for the gpu scene
+        //when the device has them (createGpuScene checks what it needs)
+        VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexingFeatures = {};
+        if( !checkBindlessSupport(capabilities.indexingFeatures, indexingFeatures) )
+            throw std::runtime_error("device doesn't support the descriptor indexing features needed for bindless!");
+        //the post chain's images are storage images in the heap, rewritten whenever they are recreated
+        if( _options.postProcess && !indexingFeatures.descriptorBindingStorageImageUpdateAfterBind )
+            throw std::runtime_error("--post needs descriptorBindingStorageImageUpdateAfterBind!");
+
+        const VkPhysicalDeviceFeatures& supportedFeatures = capabilities.features;
+
+        VkPhysicalDeviceFeatures2 deviceFeatures = {};
+        deviceFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        deviceFeatures.pNext = &indexingFeatures;
+        deviceFeatures.features.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+        deviceFeatures.features.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+        deviceFeatures.features.fragmentStoresAndAtomics = supportedFeatures.fragmentStoresAndAtomics;
+        _textureFeedback = supportedFeatures.fragmentStoresAndAtomics == VK_TRUE;
+
+        VkDeviceCreateInfo createInfo = {};
+        createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+        createInfo.pNext = &deviceFeatures;
+        createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueLayout.createInfos.size());
+        createInfo.pQueueCreateInfos = queueLayout.createInfos.data();
+        createInfo.pEnabledFeatures = nullptr; //given by deviceFeatures instead
+        auto extensions = getRequiredDeviceExtensions();
+        for (auto extension : optionalDeviceExtensions)
+        {
+            if( capabilities.hasExtension(extension) )
+                extensions.push_back(extension);
+        }
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+        createInfo.ppEnabledExtensionNames = extensions.data();
+
+        //device layers are ignored since 1.0.13 but older loaders still want them to match the instance's
+        createInfo.enabledLayerCount = static_cast<uint32_t>(_instanceLayers.size());
+        createInfo.ppEnabledLayerNames = _instanceLayers.empty() ? nullptr : _instanceLayers.data();
+
+        if(vkCreateDevice(_physicalDevice, &createInfo, nullptr, &_device) != VK_SUCCESS) 
+            throw std::runtime_error("Unable to create logical device...");
+
+        _enabledDeviceExtensions.insert(extensions.begin(), extensions.end());
+
+        _queues.init(_device, queueLayout);
+
+        std::cout << "Queues:" << std::endl;
+        std::cout << "\tgraphics family " << _queues.family(QueueType::Graphics) << std::endl;
+        std::cout << "\tcompute family " << _queues.family(QueueType::Compute) << (_queues.isDedicated(QueueType::Compute) ? " (async)" : " (shared with graphics)") << std::endl;
+        std::cout << "\ttransfer family " << _queues.family(QueueType::Transfer) << (_queues.isDedicated(QueueType::Transfer) ? " (async)" : " (shared with graphics)") << std::endl;
+    }
+
+    
+    void createSwapChain(VkSwapchainKHR oldSwapChain = VK_NULL_HANDLE) 
+    {
+        auto swapChainSupport = querySwapChainSupport(_physicalDevice);
+
+        auto surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
+        auto presentMode = _pacing.presentMode;
+        _swapChainExtent = chooseSwapExtent(swapChainSupport.capabilities);
+        _swapChainImageFormat = surfaceFormat.format;
+
+        //clamped again every time, the surface's limits can change with its size
+        uint32_t imageCount = swapchainImageCount(_pacing, swapChainSupport.capabilities);
+
+        VkSwapchainCreateInfoKHR createInfo = {};
+        createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+        createInfo.surface = _surface;
+        createInfo.minImageCount = imageCount;
+        createInfo.imageFormat = surfaceFormat.format;
+        createInfo.imageColorSpace = surfaceFormat.colorSpace;
+        createInfo.imageExtent = _swapChainExtent;
+        createInfo.imageArrayLayers = 1;
+        createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        if( _options.postProcess )
+        {
+            //the post chain's output is blitted in
+            if( !(swapChainSupport.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT) )
+                throw std::runtime_error("--post needs a swapchain that can be blitted to!");
+            createInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+        }
+        createInfo.preTransform = swapChainSupport.capabilities.currentTransform;
+        createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+        createInfo.presentMode = presentMode;
+        createInfo.clipped = VK_TRUE;
+        //lets the driver hand resources over from the swapchain being replaced, it is retired either way
+        createInfo.oldSwapchain = oldSwapChain;
+
+        const auto& indices = _selectedDevice.queueFamilies;
+        uint32_t queueFamilyIndices[] = {indices.graphicsFamily.value(), indices.presentFamily.value()};
+
+        if (indices.graphicsFamily != indices.presentFamily) 
+        {
+            createInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
+            createInfo.queueFamilyIndexCount = 2;
+            createInfo.pQueueFamilyIndices = queueFamilyIndices;
+        } 
+        else 
+        {
+            createInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            createInfo.queueFamilyIndexCount = 0; // Optional
+            createInfo.pQueueFamilyIndices = nullptr; // Optional
+        }
+
+        if( vkCreateSwapchainKHR(_device, &createInfo, nullptr, &_swapChain) != VK_SUCCESS )
+            throw std::runtime_error("Failed to create swap chain.");
+
+        vkGetSwapchainImagesKHR(_device, _swapChain, &imageCount, nullptr);
+        _swapChainImages.resize(imageCount);
+        vkGetSwapchainImagesKHR(_device, _swapChain, &imageCount, _swapChainImages.data());
+    }
+
+    bool isDeviceSuitable(const DeviceCandidate& candidate)
+    {
+        const DeviceCapabilities& capabilities = *candidate.capabilities;
+
+        bool extensionsSupported = checkDeviceExtensionSupport(capabilities);
+
+        bool swapChainAdequate = _options.headless
+            || (!candidate.swapChainSupport.formats.empty() && !candidate.swapChainSupport.presentModes.empty());
+
+        VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexingFeatures = {};
+        bool bindlessSupported = extensionsSupported && checkBindlessSupport(capabilities.indexingFeatures, indexingFeatures);
+
+        return candidate.queueFamilies.isComplete()
+            && extensionsSupported
+            && swapChainAdequate
+            && bindlessSupported;
+    }
+
+    //0 means the device can't run us at all, otherwise higher is better
+    int rateDeviceSuitability(const DeviceCandidate& candidate)
+    {
+        if( !isDeviceSuitable(candidate) )
+            return 0;
+
+        const DeviceCapabilities& capabilities = *candidate.capabilities;
+
+        //device type dominates, everything below only orders devices of the same type
+        int score = 0;
+        switch( capabilities.properties.deviceType )
+        {
+            case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:   score += 10000; break;
+            case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: score += 5000;  break;
+            case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:    score += 2000;  break;
+            case VK_PHYSICAL_DEVICE_TYPE_CPU:            score += 1000;  break;
+            default:                                     score += 500;   break;
+        }
+
+        //dedicated compute/transfer families let uploads and compute overlap with graphics
+        const auto& indices = candidate.queueFamilies;
+        if( indices.computeFamily.has_value() )
+            score += 500;
+        if( indices.transferFamily.has_value() )
+            score += 250;
+
+        if( indices.presentFamily.has_value() && indices.presentFamily == indices.graphicsFamily )
+            score += 100;
+
+        //one point per 64MiB of device local memory, capped so it can't outweigh the device type
+        const VkPhysicalDeviceMemoryProperties& memoryProperties = capabilities.memoryProperties;
+
+        VkDeviceSize deviceLocalBytes = 0;
+        for(uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++)
+        {
+            if( memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT )
+                deviceLocalBytes += memoryProperties.memoryHeaps[i].size;
+        }
+        score += static_cast<int>(std::min<VkDeviceSize>(deviceLocalBytes >> 26, 400));
+
+        score += static_cast<int>(capabilities.properties.limits.maxImageDimension2D / 1024);
+
+        return score;
+    }
+
+    VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats) 
+    {
+        for (const auto& availableFormat : availableFormats) 
+        {
+            if (availableFormat.format == VK_FORMAT_B8G8R8A8_UNORM && availableFormat.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) 
+                return availableFormat;
+        }
+
+        return availableFormats[0];
+    }
+
+    VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities) 
+    {
+        if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) 
+        {
+            return capabilities.currentExtent;
+        } 
+        else 
+        {
+            //window size is in screen coordinates, which on high dpi displays isn't pixels
+            int width = WIDTH, height = HEIGHT;
+            if( _window != nullptr )
+                glfwGetFramebufferSize(_window, &width, &height);
+
+            VkExtent2D actualExtent = {static_cast<uint32_t>(width), static_cast<uint32_t>(height)};
+
+            actualExtent.width = std::max(capabilities.minImageExtent.width, std::min(capabilities.maxImageExtent.width, actualExtent.width));
+            actualExtent.height = std::max(capabilities.minImageExtent.height, std::min(capabilities.maxImageExtent.height, actualExtent.height));
+
+            return actualExtent;
+        }
+    }
+
+    std::vector<const char*> getRequiredDeviceExtensions()
+    {
+        std::vector<const char*> extensions = bindlessDeviceExtensions;
+
+        //nothing to present to when headless, so the swapchain extension is not needed
+        if( !_options.headless )
+            extensions.insert(extensions.end(), deviceExtensions.begin(), deviceExtensions.end());
+
+        return extensions;
+    }
+
+    bool checkDeviceExtensionSupport(const DeviceCapabilities& capabilities)
+    {
+        for( auto extension : getRequiredDeviceExtensions() )
+        {
+            if( !capabilities.hasExtension(extension) )
+                return false;
+        }
+
+        return true;
+    }
+
+    bool hasDeviceExtension(const char* name) const
+    {
+        return _enabledDeviceExtensions.count(name) > 0;
+    }
+
+    SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device) 
+    {
+        SwapChainSupportDetails details = {};
+
+        vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, _surface, &details.capabilities);
+
+        uint32_t formatCount = 0;
+        vkGetPhysicalDeviceSurfaceFormatsKHR(device, _surface, &formatCount, nullptr);
+
+        if (formatCount != 0) 
+        {
+            details.formats.resize(formatCount);
+            vkGetPhysicalDeviceSurfaceFormatsKHR(device, _surface, &formatCount, details.formats.data());
+        }
+
+        uint32_t presentModeCount = 0;
+        vkGetPhysicalDeviceSurfacePresentModesKHR(device, _surface, &presentModeCount, nullptr);
+
+        if (presentModeCount != 0) 
+        {
+            details.presentModes.resize(presentModeCount);
+            vkGetPhysicalDeviceSurfacePresentModesKHR(device, _surface, &presentModeCount, details.presentModes.data());
+        }
+
+        return details;
+    }
+
+    //queue family properties come from the capabilities, only surface support is asked for
+    QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device, const DeviceCapabilities& capabilities) 
+    {
+        QueueFamilyIndices indices;
+        indices.requiresPresent = _surface != VK_NULL_HANDLE;
+        indices.properties = capabilities.queueFamilies;
+
+        //keep going after graphics/present are found, the dedicated families can be anywhere
+        uint32_t i = 0;
+        for(const auto& properties : indices.properties)
+        {
+            if( properties.queueCount == 0 )
+            {
+                i++;
+                continue;
+            }
+
+            bool graphics = properties.queueFlags & VK_QUEUE_GRAPHICS_BIT;
+            bool compute = properties.queueFlags & VK_QUEUE_COMPUTE_BIT;
+            bool transfer = properties.queueFlags & VK_QUEUE_TRANSFER_BIT;
+
+            if (graphics && !indices.graphicsFamily.has_value()) 
+                indices.graphicsFamily = i;
+
+            if (compute && !graphics && !indices.computeFamily.has_value())
+                indices.computeFamily = i;
+
+            if (transfer && !graphics && !compute && !indices.transferFamily.has_value())
+                indices.transferFamily = i;
+
+            if( indices.requiresPresent )
+            {
+                VkBool32 supportsSurface = false;
+                vkGetPhysicalDeviceSurfaceSupportKHR(device, i, _surface, &supportsSurface);
+
+                //presenting from the graphics family saves an ownership transfer, so prefer it
+                if(supportsSurface && (!indices.presentFamily.has_value() || indices.graphicsFamily == i))
+                    indices.presentFamily = i;
+            }
+
+            i++;
+        }
+
+        return indices;
+    }
+
+    //command line first, then the environment, then the build's default
+    ValidationLevel chooseValidationLevel()
+    {
+        std::string name = _options.validationLevel;
+        if( name.empty() )
+        {
+            const char* environmentLevel = std::getenv("VKL_VALIDATION");
+            if( environmentLevel != nullptr )
+                name = environmentLevel;
+        }
+        if( name.empty() )
+            return DEFAULT_VALIDATION_LEVEL;
+
+        ValidationLevel level;
+        if( !parseValidationLevel(name, level) )
+            throw std::runtime_error("unknown validation level: " + name);
+        if( level != ValidationLevel::Off && !validationAvailable )
+            throw std::runtime_error("validation was left out of this build, reconfigure with -DVKL_ENABLE_VALIDATION=ON!");
+        return level;
+    }
+
+    void setupDebugMessanger()
+    {
+        if( !_validationLog ) return;
+
+        VkDebugUtilsMessengerCreateInfoEXT createInfo = {};
+        _validationLog->fillMessengerCreateInfo(createInfo);
+
+        if (CreateDebugUtilsMessengerEXT(_instance, &createInfo, nullptr, &_debugMessenger) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to set up debug messenger!");
+        }
+    }
+
+    //cached lists can be older than the install, so anything missing is looked for again in a fresh query before giving up
+    bool hasInstanceCapability(const char* name, bool layer)
+    {
+        auto has = [&] {
+            const InstanceCapabilities& available = _capabilities->instance();
+            return layer ? available.hasLayer(name) : available.hasExtension(name);
+        };
+        return has() || (_capabilities->refreshInstance() && has());
+    }
+
+    void checkRequiredValidationLayers()
+    {
+        for(auto requestedLayer : requestedValidationLayers)
+        {
+            if( !hasInstanceCapability(requestedLayer, true) )
+                throw std::runtime_error(std::string("Missing a requested validation layer: ") + requestedLayer);
+        }
+
+        std::cout << "Continuing with validation layers:" << std::endl;
+        for( auto layer : requestedValidationLayers)
+            std::cout << "\t" << layer << std::endl;
+    }
+
+    std::vector<const char*> getRequiredExtensions(bool validation) 
+    {
+        //get the required extensions from glfw, headless runs never initialise glfw and need no surface extensions
+        std::vector<const char*> extensionsToLoad;
+        if( !_options.headless )
+        {
+            uint32_t glfwExtensionCount = 0;
+            auto glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+            extensionsToLoad.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        }
+
+        if(validation)
+            extensionsToLoad.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+
+        for(auto extensionToLoad : extensionsToLoad)
+        {
+            if( !hasInstanceCapability(extensionToLoad, false) )
+                throw std::runtime_error(std::string("Missing a required extension: ") + extensionToLoad);
+        }
+
+        const InstanceCapabilities& available = _capabilities->instance();
+        std::cout << "Instance: " << available.extensions.size() << " extensions, " << available.layers.size() << " layers available" << std::endl;
+        std::cout << "Continuing with extensions:" << std::endl;
+        for( auto extension : extensionsToLoad)
+            std::cout << "\t" << extension << std::endl;
+
+        return extensionsToLoad;
+    }
+
+    void loadCapabilityCache()
+    {
+        _capabilities = std::make_unique<CapabilityCache>(_options.capabilityCachePath);
+    }
+
+    void createInstance()
+    {
+        VkApplicationInfo applicationInfo = {}; //TODO: look this up, i am curious if it inits to empty
+        applicationInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+        applicationInfo.pApplicationName = "Vulkan Learning Application";
+        applicationInfo.applicationVersion = VK_MAKE_VERSION(1,0,0);
+        applicationInfo.pEngineName = "No Engine";
+        applicationInfo.engineVersion = VK_MAKE_VERSION(1,0,0);
+        applicationInfo.apiVersion = VK_API_VERSION_1_1;
+        
+        VkInstanceCreateInfo createInfo = {};
+        createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+        createInfo.pApplicationInfo = &applicationInfo;
+        createInfo.enabledLayerCount = 0;
+
+        ValidationLevel validationLevel = chooseValidationLevel();
+        bool validation = validationLevel != ValidationLevel::Off;
+
+        auto extensions = getRequiredExtensions(validation);
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+        createInfo.ppEnabledExtensionNames = extensions.data();
+
+        _instanceLayers.clear();
+        VkDebugUtilsMessengerCreateInfoEXT debugCreateInfo = {};
+        if( validation ) 
+        {
+            checkRequiredValidationLayers();
+            _instanceLayers = requestedValidationLayers;
+            createInfo.enabledLayerCount = static_cast<uint32_t>(_instanceLayers.size());
+            createInfo.ppEnabledLayerNames = _instanceLayers.data();
+
+            std::cout << "Validation level: " << validationLevelName(validationLevel) << std::endl;
+            _validationLog = std::make_unique<ValidationLog>(validationLevel, _options.validationMutedIds);
+            _validationLog->fillMessengerCreateInfo(debugCreateInfo);
+            createInfo.pNext = (VkDebugUtilsMessengerCreateInfoEXT*)&debugCreateInfo;
+        }
+        
+        VkResult result = vkCreateInstance(&createInfo, nullptr, &_instance);
+        //the cached lists said yes to something that has since gone, find out what and try once more if it wasn't needed
+        if( (result == VK_ERROR_LAYER_NOT_PRESENT || result == VK_ERROR_EXTENSION_NOT_PRESENT) && _capabilities->refreshInstance() )
+        {
+            getRequiredExtensions(validation);
+            if( validation )
+                checkRequiredValidationLayers();
+            result = vkCreateInstance(&createInfo, nullptr, &_instance);
+        }
+        if( result != VK_SUCCESS )
+            throw std::runtime_error("failed to create instance!");
+    }
+
+    void mainLoop()
+    {
+        uint32_t frameCount = _options.frameCount;
+        if( _options.headless && frameCount == 0 )
+            frameCount = DEFAULT_HEADLESS_FRAMES;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        _statsWindowStart = start;
+        _timings.frameMs.reserve(frameCount);
+
+        while ( frameCount == 0 || _frameNumber < frameCount ) 
+        {
+            //limit before input is sampled, so the frame reacts to the freshest input it can
+            _pacer.waitForNextFrame();
+
+            if( !_options.headless )
+            {
+                if( glfwWindowShouldClose(_window) )
+                    break;
+                _pacer.inputSampled();
+                glfwPollEvents();
+            }
+
+            auto frameStart = std::chrono::high_resolution_clock::now();
+            uint64_t frameNumber = _frameNumber;
+            drawFrame();
+            _timings.frameMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - frameStart).count());
+
+            //a frame that didn't make it to the end (out of date, minimised) hasn't reported anything
+            //nor has one the texture streamer was busy during, its I/O thread allocates as it builds images
+            if( _options.checkAllocations && _frameNumber > frameNumber && frameNumber >= ALLOCATION_CHECK_WARMUP_FRAMES
+                && !_lastFrameStats.streaming && _lastFrameStats.heapAllocations > 0 )
+                throw std::runtime_error("frame " + std::to_string(frameNumber) + " made " + std::to_string(_lastFrameStats.heapAllocations)
+                    + " heap allocations, steady state frames shouldn't make any!");
+        }
+
+        //nothing can be destroyed while the last frames are still in flight, the last of which may not be submitted yet
+        //the streamer's I/O thread submits uploads too, so it is stopped before anything waits on the queues
+        submitPendingComposite();
+        if( _textures )
+            _textures->stopLoading();
+        _queues.waitIdleAll();
+        _profiler->collectPending();
+        if( _postProfiler )
+            _postProfiler->collectPending();
+
+        auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        _timings.frameLoopMs = elapsed;
+        std::cout << "Rendered " << _frameNumber << " frames in " << elapsed << "ms ("
+            << (_frameNumber * 1000.0 / elapsed) << " fps)" << std::endl;
+
+        _uploads->waitIdle();
+        if( _uploads->stats().bytesStaged > 0 )
+            _uploads->printStats(std::cout);
+
+        if( !_options.traceOutput.empty() )
+        {
+            _profiler->writeChromeTrace(_options.traceOutput);
+            std::cout << "Wrote profile trace to " << _options.traceOutput << std::endl;
+        }
+
+        if( _postProfiler )
+        {
+            std::cout << "Post chain (compute queue):" << std::endl;
+            _postProfiler->printSummary(std::cout);
+        }
+
+        if( _options.headless && (!_options.outputImage.empty() || !_options.goldenImage.empty()) && _frameNumber > 0 )
+        {
+            //render pass (or composite) leaves headless targets in TRANSFER_SRC_OPTIMAL, ready to copy out
+            auto lastImage = static_cast<uint32_t>((_frameNumber - 1) % _swapChainImages.size());
+            auto pixels = readbackImage(_swapChainImages[lastImage]);
+            if( !_options.outputImage.empty() )
+            {
+                writeImagePPM(_options.outputImage, _swapChainExtent.width, _swapChainExtent.height, pixels);
+                std::cout << "Wrote last frame to " << _options.outputImage << std::endl;
+            }
+            if( !_options.goldenImage.empty() )
+                checkGoldenImage(pixels);
+        }
+    }
+
+    //headless frames are deterministic given the frame count and the options, so the last one can be held
+    //against a reference written by --output on a known good run. a few levels of difference are let through
+    //for drivers rounding differently
+    void checkGoldenImage(const std::vector<uint8_t>& pixels)
+    {
+        auto expected = readImagePPM(_options.goldenImage);
+        auto actual = rgbFromRgba(_swapChainExtent.width, _swapChainExtent.height, pixels);
+        auto difference = compareImages(expected, actual, _options.goldenTolerance);
+
+        double differingPercent = difference.pixels > 0 ? 100.0 * difference.differingPixels / difference.pixels : 0.0;
+        std::cout << "Golden image " << _options.goldenImage << ": " << difference.differingPixels << " pixels ("
+            << differingPercent << "%) more than " << _options.goldenTolerance << " levels off, max difference "
+            << difference.maxDifference << ", psnr " << difference.psnr << "dB" << std::endl;
+
+        if( differingPercent > _options.goldenMaxDifferingPercent )
+            throw std::runtime_error("last frame doesn't match golden image " + _options.goldenImage + "!");
+    }
+
+    //swaps in a swapchain matching the window without waiting on the gpu. the old one is handed to the
+    //driver as oldSwapchain and it and everything built on it is destroyed once the frames using it are done
+    //(see destroyFinishedSwapChains). false while the window is minimised, there is nothing to create then
+    bool recreateSwapChain()
+    {
+        int width = 0, height = 0;
+        glfwGetFramebufferSize(_window, &width, &height);
+        if( width == 0 || height == 0 )
+            return false;
+
+        ProfileScope scope(_profiler.get(), "recreate swapchain");
+
+        RetiredSwapchain retired;
+        retired.swapChain = _swapChain;
+        retired.imageViews = std::move(_swapChainImageViews);
+        retired.framebuffers = std::move(_swapChainFramebuffers);
+        retired.renderCompleteSemaphores = std::move(_renderCompleteSemaphores);
+        retired.frameNumber = _frameNumber;
+        _retiredSwapChains.push_back(std::move(retired));
+
+        //the render pass (and so every pipeline) was made for this format, only the size may change
+        auto imageFormat = _swapChainImageFormat;
+        createSwapChain(_retiredSwapChains.back().swapChain);
+        if( _swapChainImageFormat != imageFormat )
+            throw std::runtime_error("swap chain format changed on recreation!");
+
+        _swapChainImageViews.clear();
+        _swapChainFramebuffers.clear();
+        _renderCompleteSemaphores.clear();
+        createImageViews();
+        createFramebuffers();
+        createRenderCompleteSemaphores();
+
+        _swapChainOutOfDate = false;
+        return true;
+    }
+
+    //called once the current slot's fence has been waited on. a slot's fence covers the frame submitted
+    //framesInFlight frames ago, so once every slot has been waited on since a swapchain was retired all
+    //the frames that rendered to it are done. there is no way to ask whether the presentation engine has
+    //finished with its last presents without VK_EXT_swapchain_maintenance1, those completing alongside
+    //the frame fences is the usual assumption
+    void destroyFinishedSwapChains()
+    {
+        while( !_retiredSwapChains.empty() && _frameNumber + 1 >= _retiredSwapChains.front().frameNumber + _frames.size() )
+        {
+            destroyRetiredSwapChain(_retiredSwapChains.front());
+            _retiredSwapChains.pop_front();
+        }
+    }
+
+    void destroyRetiredSwapChain(RetiredSwapchain& retired)
+    {
+        for (auto framebuffer : retired.framebuffers)
+            vkDestroyFramebuffer(_device, framebuffer, nullptr);
+        for (auto imageView : retired.imageViews)
+            vkDestroyImageView(_device, imageView, nullptr);
+        for (auto semaphore : retired.renderCompleteSemaphores)
+            vkDestroySemaphore(_device, semaphore, nullptr);
+        vkDestroySwapchainKHR(_device, retired.swapChain, nullptr);
+    }
+
+    void drawFrame()
+    {
+        uint64_t allocationsStart = heapAllocationCount();
+        bool streaming = _textures && !_textures->idle();
+        ProfileScope frameScope(_profiler.get(), "drawFrame");
+        auto frameStart = std::chrono::high_resolution_clock::now();
+        auto& frame = _frames[_currentFrame];
+
+        //with one frame in flight the slot's fence is only signalled by the composite still waiting to go in
+        if( _pendingComposite.pending && _pendingComposite.frameSlot == _currentFrame )
+            submitPendingComposite();
+
+        //the cpu only ever gets framesInFlight frames ahead, this is where it waits for the gpu to catch up
+        auto waitStart = std::chrono::high_resolution_clock::now();
+        {
+            ProfileScope waitScope(_profiler.get(), "wait for frame slot");
+            vkWaitForFences(_device, 1, &frame.inFlightFence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+        }
+        double gpuWaitMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - waitStart).count();
+
+        //the last frame recorded with it has long been submitted
+        _frameArena.reset();
+        destroyFinishedSwapChains();
+        if( _shaderReloader )
+            updateShaderReload();
+        _bindless->collectGarbage(_frameNumber);
+        if( _gpuScene )
+            _gpuScene->collect(_currentFrame);
+        if( _textures )
+        {
+            ProfileScope streamScope(_profiler.get(), "texture streaming");
+            _textures->update(_currentFrame, _frameNumber);
+        }
+
+        uint32_t imageIndex = 0;
+        if( _options.headless )
+            imageIndex = static_cast<uint32_t>(_frameNumber % _swapChainImages.size());
+        else
+        {
+            //the fence isn't reset until an image is in hand, so bailing out here leaves the slot as it was
+            if( _swapChainOutOfDate && !recreateSwapChain() )
+            {
+                //minimised, nothing to draw into until the window comes back
+                glfwWaitEvents();
+                return;
+            }
+
+            //the post chain only needs the backbuffer for its composite and acquires it then
+            if( !_postChain )
+            {
+                ProfileScope acquireScope(_profiler.get(), "acquire");
+                VkResult result = vkAcquireNextImageKHR(_device, _swapChain, std::numeric_limits<uint64_t>::max(), frame.imageAcquiredSemaphore, VK_NULL_HANDLE, &imageIndex);
+                if (result == VK_ERROR_OUT_OF_DATE_KHR)
+                {
+                    //the semaphore isn't signalled when nothing was acquired, so the frame can just be tried again
+                    _swapChainOutOfDate = true;
+                    return;
+                }
+                if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+                    throw std::runtime_error("failed to acquire swap chain image!");
+
+                //suboptimal still presents fine, render this one and swap before the next
+                if (result == VK_SUBOPTIMAL_KHR)
+                    _swapChainOutOfDate = true;
+            }
+        }
+
+        if( _postChain )
+        {
+            //the fence is about to be reset and won't be submitted again until this frame's composite, so the
+            //images it guarded (all finished, it was just waited on) mustn't be waited on through it
+            for (auto& imageFence : _imagesInFlight)
+            {
+                if( imageFence == frame.inFlightFence )
+                    imageFence = VK_NULL_HANDLE;
+            }
+        }
+        else
+        {
+            //with more images than frames in flight an image can still be owned by an older frame slot
+            if( _imagesInFlight[imageIndex] != VK_NULL_HANDLE && _imagesInFlight[imageIndex] != frame.inFlightFence )
+            {
+                waitStart = std::chrono::high_resolution_clock::now();
+                vkWaitForFences(_device, 1, &_imagesInFlight[imageIndex], VK_TRUE, std::numeric_limits<uint64_t>::max());
+                gpuWaitMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - waitStart).count();
+            }
+            _imagesInFlight[imageIndex] = frame.inFlightFence;
+        }
+
+        vkResetFences(_device, 1, &frame.inFlightFence);
+
+        //hand back ring space from finished uploads, then send this frame's uploads off in one batch
+        {
+            ProfileScope uploadScope(_profiler.get(), "uploads");
+            _uploads->retire();
+            if( _options.uploadBenchmarkKiB > 0 )
+                streamUploadBenchmark();
+            _uploads->flush();
+        }
+
+        if( _gpuScene )
+            updateScene();
+
+        {
+            ProfileScope recordScope(_profiler.get(), "record");
+
+            //resetting the whole pool is cheaper than resetting individual buffers
+            vkResetCommandPool(_device, frame.commandPool, 0);
+            for (auto& threadPool : frame.threadPools)
+                resetThreadCommandPool(threadPool);
+            if( _postChain )
+            {
+                vkResetCommandPool(_device, frame.computeCommandPool, 0);
+                _postChain->beginFrame(_currentFrame, _swapChainExtent);
+            }
+            recordCommandBuffer(frame, imageIndex);
+            if( _postChain )
+                recordPostChain(frame);
+        }
+
+        if( _postChain )
+            submitPostFrame(frame);
+        else
+            submitFrame(frame, imageIndex);
+
+        _currentFrame = (_currentFrame + 1) % static_cast<uint32_t>(_frames.size());
+        _frameNumber++;
+
+        FrameStats stats;
+        stats.gpuWaitMs = gpuWaitMs;
+        stats.cpuMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - frameStart).count() - gpuWaitMs;
+        stats.heapAllocations = heapAllocationCount() - allocationsStart;
+        stats.streaming = streaming || (_textures && !_textures->idle());
+        reportFrameStats(stats);
+    }
+
+    //the whole frame in one submit on the graphics queue
+    void submitFrame(FrameData& frame, uint32_t imageIndex)
+    {
+        VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+
+        VkSubmitInfo submitInfo = {};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &frame.commandBuffer;
+        if( !_options.headless )
+        {
+            submitInfo.waitSemaphoreCount = 1;
+            submitInfo.pWaitSemaphores = &frame.imageAcquiredSemaphore;
+            submitInfo.pWaitDstStageMask = waitStages;
+            submitInfo.signalSemaphoreCount = 1;
+            submitInfo.pSignalSemaphores = &_renderCompleteSemaphores[imageIndex];
+        }
+
+        if (_queues.submit(QueueType::Graphics, 1, &submitInfo, frame.inFlightFence) != VK_SUCCESS)
+            throw std::runtime_error("failed to submit draw command buffer!");
+        _profiler->endFrame();
+
+        if( !_options.headless )
+            presentImage(imageIndex);
+    }
+
+    //the geometry and the post chain go in now, the composite only after the next frame's geometry. the
+    //graphics queue would otherwise sit on the composite's wait for the compute queue, this way it is drawing
+    //the next frame while this one is post processed
+    void submitPostFrame(FrameData& frame)
+    {
+        VkSubmitInfo sceneInfo = {};
+        sceneInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        sceneInfo.commandBufferCount = 1;
+        sceneInfo.pCommandBuffers = &frame.commandBuffer;
+        sceneInfo.signalSemaphoreCount = 1;
+        sceneInfo.pSignalSemaphores = &frame.sceneRenderedSemaphore;
+
+        if (_queues.submit(QueueType::Graphics, 1, &sceneInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+            throw std::runtime_error("failed to submit draw command buffer!");
+        _profiler->endFrame();
+
+        VkPipelineStageFlags postWaitStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+        VkSubmitInfo postInfo = {};
+        postInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        postInfo.waitSemaphoreCount = 1;
+        postInfo.pWaitSemaphores = &frame.sceneRenderedSemaphore;
+        postInfo.pWaitDstStageMask = &postWaitStage;
+        postInfo.commandBufferCount = 1;
+        postInfo.pCommandBuffers = &frame.computeCommandBuffer;
+        postInfo.signalSemaphoreCount = 1;
+        postInfo.pSignalSemaphores = &frame.postCompleteSemaphore;
+
+        if (_queues.submit(QueueType::Compute, 1, &postInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+            throw std::runtime_error("failed to submit post chain command buffer!");
+        _postProfiler->endFrame();
+
+        submitPendingComposite();
+        _pendingComposite.pending = true;
+        _pendingComposite.frameSlot = _currentFrame;
+        _pendingComposite.frameNumber = _frameNumber;
+    }
+
+    //acquires a backbuffer for the pending frame, blits its post chain output in and presents it. the frame
+    //is dropped if the swapchain has gone out of date since, its fence still has to be signalled
+    void submitPendingComposite()
+    {
+        if( !_pendingComposite.pending )
+            return;
+        _pendingComposite.pending = false;
+
+        auto& frame = _frames[_pendingComposite.frameSlot];
+
+        uint32_t imageIndex = 0;
+        bool acquired = true;
+        if( _options.headless )
+            imageIndex = static_cast<uint32_t>(_pendingComposite.frameNumber % _swapChainImages.size());
+        else if( _swapChainOutOfDate )
+            acquired = false;
+        else
+        {
+            ProfileScope acquireScope(_profiler.get(), "acquire");
+            VkResult result = vkAcquireNextImageKHR(_device, _swapChain, std::numeric_limits<uint64_t>::max(), frame.imageAcquiredSemaphore, VK_NULL_HANDLE, &imageIndex);
+            if (result == VK_ERROR_OUT_OF_DATE_KHR)
+            {
+                _swapChainOutOfDate = true;
+                acquired = false;
+            }
+            else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+                throw std::runtime_error("failed to acquire swap chain image!");
+
+            if (result == VK_SUBOPTIMAL_KHR)
+                _swapChainOutOfDate = true;
+        }
+
+        if( !acquired )
+        {
+            VkPipelineStageFlags dropWaitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+            VkSubmitInfo dropInfo = {};
+            dropInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            dropInfo.waitSemaphoreCount = 1;
+            dropInfo.pWaitSemaphores = &frame.postCompleteSemaphore;
+            dropInfo.pWaitDstStageMask = &dropWaitStage;
+
+            if (_queues.submit(QueueType::Graphics, 1, &dropInfo, frame.inFlightFence) != VK_SUCCESS)
+                throw std::runtime_error("failed to submit dropped frame!");
+            return;
+        }
+
+        //with more images than frames in flight an image can still be owned by an older frame slot
+        if( _imagesInFlight[imageIndex] != VK_NULL_HANDLE && _imagesInFlight[imageIndex] != frame.inFlightFence )
+            vkWaitForFences(_device, 1, &_imagesInFlight[imageIndex], VK_TRUE, std::numeric_limits<uint64_t>::max());
+        _imagesInFlight[imageIndex] = frame.inFlightFence;
+
+        recordComposite(frame, _pendingComposite.frameSlot, imageIndex);
+
+        VkSemaphore waitSemaphores[] = {frame.postCompleteSemaphore, frame.imageAcquiredSemaphore};
+        VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT};
+
+        VkSubmitInfo submitInfo = {};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.waitSemaphoreCount = _options.headless ? 1 : 2;
+        submitInfo.pWaitSemaphores = waitSemaphores;
+        submitInfo.pWaitDstStageMask = waitStages;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &frame.compositeCommandBuffer;
+        if( !_options.headless )
+        {
+            submitInfo.signalSemaphoreCount = 1;
+            submitInfo.pSignalSemaphores = &_renderCompleteSemaphores[imageIndex];
+        }
+
+        if (_queues.submit(QueueType::Graphics, 1, &submitInfo, frame.inFlightFence) != VK_SUCCESS)
+            throw std::runtime_error("failed to submit composite command buffer!");
+
+        if( !_options.headless )
+            presentImage(imageIndex);
+    }
+
+    void presentImage(uint32_t imageIndex)
+    {
+        ProfileScope presentScope(_profiler.get(), "present");
+
+        VkPresentInfoKHR presentInfo = {};
+        presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+        presentInfo.waitSemaphoreCount = 1;
+        presentInfo.pWaitSemaphores = &_renderCompleteSemaphores[imageIndex];
+        presentInfo.swapchainCount = 1;
+        presentInfo.pSwapchains = &_swapChain;
+        presentInfo.pImageIndices = &imageIndex;
+
+        VkResult result = _queues.present(presentInfo);
+        if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
+            _swapChainOutOfDate = true;
+        else if (result != VK_SUCCESS)
+            throw std::runtime_error("failed to present swap chain image!");
+
+        _pacer.presented();
+    }
+
+    //the post passes into the frame's compute command buffer, timed by their own profiler as they run on
+    //another queue
+    void recordPostChain(FrameData& frame)
+    {
+        auto commandBuffer = frame.computeCommandBuffer;
+
+        VkCommandBufferBeginInfo beginInfo = {};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+            throw std::runtime_error("failed to begin recording post chain command buffer!");
+
+        _postProfiler->beginFrame(commandBuffer, _currentFrame, _frameNumber);
+        _postProfiler->beginGpuScope(commandBuffer, "post chain");
+
+        _postGraph->beginFrame(_currentFrame);
+        _postChain->addPasses(*_postGraph, _currentFrame, _pipelines.post);
+        _postGraph->compile();
+        _postChain->bindTransients(*_postGraph, _currentFrame);
+        _postGraph->execute(commandBuffer, _postProfiler.get());
+
+        _postProfiler->endGpuScope(commandBuffer);
+
+        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+            throw std::runtime_error("failed to record post chain command buffer!");
+    }
+
+    //recorded once the backbuffer is known, which is after the frame slot has moved on. the composite graph
+    //is still per slot, it was the pending frame's slot that was last waited on for it
+    void recordComposite(FrameData& frame, uint32_t frameSlot, uint32_t imageIndex)
+    {
+        auto commandBuffer = frame.compositeCommandBuffer;
+
+        VkCommandBufferBeginInfo beginInfo = {};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+            throw std::runtime_error("failed to begin recording composite command buffer!");
+
+        //the acquire semaphore is waited on at transfer here
+        _compositeGraph->beginFrame(frameSlot);
+        RenderGraphState acquired = {};
+        acquired.stages = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        auto backbuffer = _compositeGraph->importImage("backbuffer", _swapChainImages[imageIndex], _swapChainImageViews[imageIndex],
+            _swapChainImageFormat, _swapChainExtent, acquired);
+        _compositeGraph->exportResource(backbuffer, _options.headless ? RenderGraphAccess::TransferRead : RenderGraphAccess::Present);
+
+        _postChain->addComposite(*_compositeGraph, frameSlot, backbuffer, _swapChainImages[imageIndex], _swapChainExtent);
+        _compositeGraph->compile();
+        _compositeGraph->execute(commandBuffer, nullptr);
+
+        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+            throw std::runtime_error("failed to record composite command buffer!");
+    }
+
+    void recordCommandBuffer(FrameData& frame, uint32_t imageIndex)
+    {
+        auto commandBuffer = frame.commandBuffer;
+
+        VkCommandBufferBeginInfo beginInfo = {};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+            throw std::runtime_error("failed to begin recording command buffer!");
+
+        //the slot's fence has been waited on, so last time round's timestamps can be read back now
+        _profiler->beginFrame(commandBuffer, _currentFrame, _frameNumber);
+        _profiler->beginGpuScope(commandBuffer, "frame");
+
+        //until there is something to draw, a cycling clear colour proves frames are making it through
+        float t = static_cast<float>(_frameNumber % 256) / 255.f;
+        VkClearValue clearColor = {};
+        clearColor.color = {{t, 0.2f, 1.f - t, 1.f}};
+
+        VkRenderPassBeginInfo renderPassInfo = {};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassInfo.renderPass = _renderPass;
+        renderPassInfo.framebuffer = mainFramebuffer(imageIndex);
+        renderPassInfo.renderArea.offset = {0, 0};
+        renderPassInfo.renderArea.extent = _swapChainExtent;
+        renderPassInfo.clearValueCount = 1;
+        renderPassInfo.pClearValues = &clearColor;
+
+        //everything in the frame is a render graph pass, the graph puts in the barriers between them.
+        //the acquire semaphore is waited on at colour attachment output, so that is where the image becomes ours
+        _renderGraph->beginFrame(_currentFrame);
+        RenderGraphResource backbuffer = INVALID_RENDER_GRAPH_RESOURCE;
+        if( _postChain )
+            backbuffer = _postChain->declareScene(*_renderGraph, _currentFrame);
+        else
+        {
+            RenderGraphState acquired = {};
+            acquired.stages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+            backbuffer = _renderGraph->importImage("backbuffer", _swapChainImages[imageIndex], _swapChainImageViews[imageIndex],
+                _swapChainImageFormat, _swapChainExtent, acquired);
+            //headless frames get copied out rather than presented
+            _renderGraph->exportResource(backbuffer, _options.headless ? RenderGraphAccess::TransferRead : RenderGraphAccess::Present);
+        }
+
+        //the gpu scene culls ahead of the pass and is drawn by one indirect call, the cpu draws are
+        //recorded into secondaries in parallel. either way the primary just stitches them together in order
+        ArenaVector<VkCommandBuffer> secondaries{ArenaAllocator<VkCommandBuffer>(_frameArena)};
+        RenderGraphResource sceneDraws = INVALID_RENDER_GRAPH_RESOURCE;
+        if( _gpuScene )
+        {
+            sceneDraws = _gpuScene->addPasses(*_renderGraph, _currentFrame, _pipelines.cull, _sceneView);
+
+            secondaries.push_back(acquireSecondary(frame.threadPools[0]));
+            recordGpuScene(secondaries.back(), mainFramebuffer(imageIndex), _sceneView);
+        }
+        if( _mesh )
+        {
+            secondaries.push_back(acquireSecondary(frame.threadPools[0]));
+            recordMesh(secondaries.back(), mainFramebuffer(imageIndex));
+        }
+        if( !_gpuScene && !_mesh )
+            secondaries = recordDrawsParallel(*_jobs, frame.threadPools, mainFramebuffer(imageIndex), _frameArena);
+
+        //a subpass that executes secondaries can't have anything else in it, so the graph's barriers and
+        //timestamps land either side of the render pass
+        auto mainPass = _renderGraph->addPass("main pass", [&](VkCommandBuffer commandBuffer) {
+            vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+            vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(secondaries.size()), secondaries.data());
+            vkCmdEndRenderPass(commandBuffer);
+        });
+        mainPass.use(backbuffer, RenderGraphAccess::ColorAttachmentWrite);
+        if( sceneDraws != INVALID_RENDER_GRAPH_RESOURCE )
+            mainPass.use(sceneDraws, RenderGraphAccess::IndirectRead);
+
+        //the mesh's fragment shader leaves texture feedback here, read back once this slot's fence is next waited on
+        if( _textures && _textureFeedback )
+        {
+            auto feedback = _renderGraph->importBuffer("texture feedback", _textures->feedbackBuffer(_currentFrame));
+            mainPass.use(feedback, RenderGraphAccess::FragmentStorageReadWrite);
+            _renderGraph->exportResource(feedback, RenderGraphAccess::HostRead);
+        }
+
+        _renderGraph->compile();
+        _renderGraph->execute(commandBuffer, _profiler.get());
+
+        _profiler->endGpuScope(commandBuffer);
+
+        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+            throw std::runtime_error("failed to record command buffer!");
+    }
+
+    //what the geometry draws into, the post chain's scene image when there is one
+    VkFramebuffer mainFramebuffer(uint32_t imageIndex) const
+    {
+        if( _postChain )
+            return _postChain->sceneFramebuffer(_currentFrame);
+        return _swapChainFramebuffers[imageIndex];
+    }
+
+    //the secondaries live in arena, so can't outlive its next reset
+    ArenaVector<VkCommandBuffer> recordDrawsParallel(JobSystem& jobs, std::vector<ThreadCommandPool>& threadPools, VkFramebuffer framebuffer,
+        FrameArena& arena)
+    {
+        uint32_t drawCount = _options.drawCount;
+        uint32_t secondaryCount = std::clamp(drawCount / MIN_DRAWS_PER_SECONDARY, 1u, jobs.threadCount() * 2);
+        uint32_t drawsPerSecondary = (drawCount + secondaryCount - 1) / secondaryCount;
+
+        ArenaVector<VkCommandBuffer> secondaries(secondaryCount, VK_NULL_HANDLE, ArenaAllocator<VkCommandBuffer>(arena));
+        jobs.parallelFor(secondaryCount, 1, [&](uint32_t begin, uint32_t end, uint32_t threadIndex) {
+            ProfileScope scope(_profiler.get(), "record draws");
+            for (uint32_t i = begin; i < end; i++)
+            {
+                uint32_t firstDraw = i * drawsPerSecondary;
+                uint32_t count = std::min(drawsPerSecondary, drawCount - std::min(drawCount, firstDraw));
+
+                secondaries[i] = acquireSecondary(threadPools[threadIndex]);
+                recordDrawRange(secondaries[i], framebuffer, firstDraw, count);
+            }
+        });
+
+        return secondaries;
+    }
+
+    void beginSecondary(VkCommandBuffer commandBuffer, VkFramebuffer framebuffer)
+    {
+        VkCommandBufferInheritanceInfo inheritanceInfo = {};
+        inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritanceInfo.renderPass = _renderPass;
+        inheritanceInfo.subpass = 0;
+        inheritanceInfo.framebuffer = framebuffer;
+
+        VkCommandBufferBeginInfo beginInfo = {};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+            throw std::runtime_error("failed to begin recording secondary command buffer!");
+    }
+
+    //secondaries don't inherit dynamic state, every one has to set its own
+    void setViewportAndScissor(VkCommandBuffer commandBuffer)
+    {
+        VkViewport viewport = {0.f, 0.f, static_cast<float>(_swapChainExtent.width), static_cast<float>(_swapChainExtent.height), 0.f, 1.f};
+        VkRect2D scissor = {{0, 0}, _swapChainExtent};
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+    }
+
+    void recordDrawRange(VkCommandBuffer commandBuffer, VkFramebuffer framebuffer, uint32_t firstDraw, uint32_t drawCount)
+    {
+        beginSecondary(commandBuffer, framebuffer);
+
+        if( _pipelines.graphics != VK_NULL_HANDLE )
+        {
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipelines.graphics);
+            _bindless->bind(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS);
+            setViewportAndScissor(commandBuffer);
+
+            //the only per draw state is an index into the draw data, no descriptor sets change between draws
+            DrawPushConstants pushConstants = {};
+            pushConstants.drawDataBuffer = _drawDataHandle;
+            for (uint32_t draw = firstDraw; draw < firstDraw + drawCount; draw++)
+            {
+                pushConstants.drawIndex = draw;
+                vkCmdPushConstants(commandBuffer, _bindless->pipelineLayout(), VK_SHADER_STAGE_ALL, 0, sizeof(pushConstants), &pushConstants);
+                vkCmdDraw(commandBuffer, 3, 1, 0, draw);
+            }
+        }
+
+        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+            throw std::runtime_error("failed to record secondary command buffer!");
+    }
+
+    //the same few commands whatever the instance count, the culling pass wrote the draws
+    void recordGpuScene(VkCommandBuffer commandBuffer, VkFramebuffer framebuffer, const SceneView& view)
+    {
+        beginSecondary(commandBuffer, framebuffer);
+
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipelines.instanced);
+        _bindless->bind(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS);
+        setViewportAndScissor(commandBuffer);
+        _gpuScene->recordDraw(commandBuffer, _currentFrame, view);
+
+        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+            throw std::runtime_error("failed to record secondary command buffer!");
+    }
+
+    void recordMesh(VkCommandBuffer commandBuffer, VkFramebuffer framebuffer)
+    {
+        beginSecondary(commandBuffer, framebuffer);
+
+        double seconds = sceneSeconds();
+        MeshView view;
+        view.yaw = static_cast<float>(0.5 * seconds);
+        view.pitch = 0.3f;
+        view.aspect = static_cast<float>(_swapChainExtent.width) / std::max(_swapChainExtent.height, 1u);
+
+        if( _textures )
+        {
+            //one at a time, so the ones off screen age out of the cache as the budget fills up
+            StreamedTextureId id = _textureIds[static_cast<size_t>(seconds / TEXTURE_CYCLE_SECONDS) % _textureIds.size()];
+            const TextureFile& file = _textures->file(id);
+            view.texture = _textures->handle(id);
+            view.textureSize[0] = static_cast<float>(file.width());
+            view.textureSize[1] = static_cast<float>(file.height());
+
+            if( _textureFeedback )
+            {
+                view.feedbackBuffer = _textures->feedbackHandle(_currentFrame);
+                view.feedbackIndex = id;
+            }
+            else
+            {
+                //the mesh fills most of the screen's height, take the texture as wrapped over it once
+                float texelsPerPixel = std::max(file.width(), file.height()) / (0.9f * std::max(_swapChainExtent.height, 1u));
+                _textures->markUsed(id, static_cast<uint32_t>(std::max(std::log2(texelsPerPixel), 0.f)), _frameNumber);
+            }
+        }
+
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipelines.mesh);
+        _bindless->bind(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS);
+        setViewportAndScissor(commandBuffer);
+        _mesh->recordDraw(commandBuffer, view);
+
+        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+            throw std::runtime_error("failed to record secondary command buffer!");
+    }
+
+    //records (without submitting) the frame's draws at increasing thread counts to show how recording scales
+    void measureRecordingScaling()
+    {
+        const uint32_t iterations = 20;
+        uint32_t maxThreads = _jobs->threadCount();
+
+        std::cout << "Recording scaling (" << _options.drawCount << " draws, " << iterations << " iterations):" << std::endl;
+
+        double singleThreadMs = 0.0;
+        for (uint32_t threads = 1; threads <= maxThreads; threads = threads < maxThreads ? std::min(threads * 2, maxThreads) : threads + 1)
+        {
+            JobSystem jobs(threads - 1);
+            std::vector<ThreadCommandPool> threadPools;
+            for (uint32_t i = 0; i < threads; i++)
+                threadPools.push_back(createThreadCommandPool());
+
+            FrameArena arena;
+            auto start = std::chrono::high_resolution_clock::now();
+            for (uint32_t i = 0; i < iterations; i++)
+            {
+                for (auto& threadPool : threadPools)
+                    resetThreadCommandPool(threadPool);
+                arena.reset();
+                recordDrawsParallel(jobs, threadPools, mainFramebuffer(0), arena);
+            }
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / iterations;
+
+            if( threads == 1 )
+                singleThreadMs = ms;
+
+            std::cout << "\t" << threads << " threads: " << ms << "ms, " << (_options.drawCount / ms) << " draws/ms, "
+                << (singleThreadMs / ms) << "x" << std::endl;
+
+            for (auto& threadPool : threadPools)
+                vkDestroyCommandPool(_device, threadPool.commandPool, nullptr);
+        }
+    }
+
+    void reportFrameStats(const FrameStats& stats)
+    {
+        _lastFrameStats = stats;
+
+        if( _options.printFrameStats )
+        {
+            std::cout << "Frame " << _frameNumber << ": cpu " << stats.cpuMs << "ms, gpu wait " << stats.gpuWaitMs << "ms, "
+                << stats.heapAllocations << " heap allocations" << std::endl;
+            return;
+        }
+
+        //otherwise a summary roughly once a second
+        _statsWindowCpuMs += stats.cpuMs;
+        _statsWindowGpuWaitMs += stats.gpuWaitMs;
+        _statsWindowHeapAllocations += stats.heapAllocations;
+        _statsWindowFrames++;
+
+        auto now = std::chrono::high_resolution_clock::now();
+        double windowMs = std::chrono::duration<double, std::milli>(now - _statsWindowStart).count();
+        if( windowMs < 1000.0 )
+            return;
+
+        std::cout << "Frame " << _frameNumber << ": " << (_statsWindowFrames * 1000.0 / windowMs) << " fps, avg cpu "
+            << (_statsWindowCpuMs / _statsWindowFrames) << "ms, avg gpu wait " << (_statsWindowGpuWaitMs / _statsWindowFrames) << "ms, "
+            << (static_cast<double>(_statsWindowHeapAllocations) / _statsWindowFrames) << " heap allocs/frame";
+
+        auto uploadStats = _uploads->stats();
+        if( uploadStats.bytesStaged > 0 )
+            std::cout << ", uploads " << uploadStats.bandwidthMBps() << " MB/s (" << uploadStats.stalls << " stalls)";
+
+        if( _gpuScene )
+        {
+            auto sceneStats = _gpuScene->stats();
+            std::cout << ", visible " << sceneStats.visible << "/" << sceneStats.instances;
+        }
+
+        if( _textures )
+        {
+            auto textureStats = _textures->stats();
+            std::cout << ", textures " << (textureStats.residentBytes / (1024.0 * 1024.0)) << "/" << (textureStats.budget / (1024.0 * 1024.0))
+                << " MiB (" << textureStats.evictions << " evictions)";
+        }
+
+        auto pacingStats = _pacer.takeStats();
+        if( pacingStats.frames > 0 )
+            std::cout << ", input to present " << pacingStats.averageLatencyMs << "ms (max " << pacingStats.maxLatencyMs << "ms)";
+        if( _pacer.fpsLimit() > 0.0 )
+            std::cout << ", limiter " << (pacingStats.limiterSleepMs / _statsWindowFrames) << "ms/frame";
+        std::cout << std::endl;
+
+        if( _options.printProfile )
+        {
+            _profiler->printSummary(std::cout);
+            if( _postProfiler )
+                _postProfiler->printSummary(std::cout);
+        }
+
+        _statsWindowStart = now;
+        _statsWindowCpuMs = 0.0;
+        _statsWindowGpuWaitMs = 0.0;
+        _statsWindowHeapAllocations = 0;
+        _statsWindowFrames = 0;
+    }
+
+    void cleanup() 
+    {
+        //stops its thread, nothing more gets compiled
+        _shaderReloader.reset();
+
+        for (auto& frame : _frames) {
+            for (auto& threadPool : frame.threadPools)
+                vkDestroyCommandPool(_device, threadPool.commandPool, nullptr);
+            vkDestroyCommandPool(_device, frame.commandPool, nullptr);
+            vkDestroySemaphore(_device, frame.imageAcquiredSemaphore, nullptr);
+            vkDestroyFence(_device, frame.inFlightFence, nullptr);
+            if( frame.computeCommandPool != VK_NULL_HANDLE )
+            {
+                vkDestroyCommandPool(_device, frame.computeCommandPool, nullptr);
+                vkDestroySemaphore(_device, frame.sceneRenderedSemaphore, nullptr);
+                vkDestroySemaphore(_device, frame.postCompleteSemaphore, nullptr);
+            }
+        }
+
+        for (auto& retired : _retiredSwapChains)
+            destroyRetiredSwapChain(retired);
+        _retiredSwapChains.clear();
+
+        for (auto semaphore : _renderCompleteSemaphores) {
+            vkDestroySemaphore(_device, semaphore, nullptr);
+        }
+
+        if( _commandPool != VK_NULL_HANDLE )
+            vkDestroyCommandPool(_device, _commandPool, nullptr);
+
+        for (auto framebuffer : _swapChainFramebuffers) {
+            vkDestroyFramebuffer(_device, framebuffer, nullptr);
+        }
+
+        //a rebuild still going has to finish before what it made can be destroyed
+        if( _pipelineRebuild.valid() )
+        {
+            try
+            {
+                destroyPipelines(_pipelineRebuild.get());
+            }
+            catch (const std::exception&)
+            {
+                //its failure was never going to be used anyway
+            }
+        }
+        for (auto& retired : _retiredPipelines)
+            destroyPipelines(retired.pipelines);
+        _retiredPipelines.clear();
+        destroyPipelines(_pipelines);
+
+        //hand their slots back to the heap, so go first
+        _gpuScene.reset();
+        _scene.reset();
+        _mesh.reset();
+        if( _textures && _options.printMemoryStats )
+            _textures->printStats(std::cout);
+        _textures.reset();
+        _postChain.reset();
+
+        if( _renderGraph && _options.printMemoryStats )
+            _renderGraph->printStats(std::cout);
+        _renderGraph.reset();
+        if( _postGraph && _options.printMemoryStats )
+            _postGraph->printStats(std::cout);
+        _postGraph.reset();
+        _compositeGraph.reset();
+
+        if( _bindless && _options.printMemoryStats )
+            _bindless->printStats(std::cout);
+        _bindless.reset();
+
+        if( _drawDataBuffer != VK_NULL_HANDLE )
+        {
+            vkDestroyBuffer(_device, _drawDataBuffer, nullptr);
+            _allocator->free(_drawDataMemory);
+        }
+
+        //saved on the way out so the next launch starts warm
+        if( _pipelineCache )
+        {
+            _pipelineCache->save();
+            _pipelineCache.reset();
+        }
+
+        if( _capabilities )
+        {
+            _capabilities->save();
+            _selectedDevice = {};
+            _capabilities.reset();
+        }
+
+        if( _renderPass != VK_NULL_HANDLE )
+            vkDestroyRenderPass(_device, _renderPass, nullptr);
+
+        for (auto imageView : _swapChainImageViews) {
+            vkDestroyImageView(_device, imageView, nullptr);
+        }
+
+        _profiler.reset();
+        _postProfiler.reset();
+
+        if( _uploadBenchmarkBuffer != VK_NULL_HANDLE )
+        {
+            vkDestroyBuffer(_device, _uploadBenchmarkBuffer, nullptr);
+            _allocator->free(_uploadBenchmarkMemory);
+        }
+
+        _uploads.reset();
+
+        //headless targets are ours to destroy, swapchain images belong to the swapchain
+        for (size_t i = 0; i < _offscreenImageMemory.size(); i++) {
+            vkDestroyImage(_device, _swapChainImages[i], nullptr);
+            _allocator->free(_offscreenImageMemory[i]);
+        }
+
+        if( _allocator )
+        {
+            if( _options.printMemoryStats )
+                _allocator->printStats(std::cout);
+            _allocator.reset();
+        }
+
+        if ( _swapChain != VK_NULL_HANDLE )
+            vkDestroySwapchainKHR(_device, _swapChain, nullptr);
+        
+        if( _device != VK_NULL_HANDLE )
+            vkDestroyDevice(_device, nullptr);
+
+        if( _debugMessenger != VK_NULL_HANDLE )
+        {
+            DestroyDebugUtilsMessengerEXT(_instance, _debugMessenger, nullptr);
+            _debugMessenger = VK_NULL_HANDLE;
+        }
+
+         if( _surface != VK_NULL_HANDLE )
+             vkDestroySurfaceKHR(_instance, _surface, nullptr);
+
+        vkDestroyInstance(_instance, nullptr);
+
+        //the instance's own messenger reports up to the end of vkDestroyInstance, only now is nothing left calling in
+        if( _validationLog )
+        {
+            _validationLog->printStats(std::cout);
+            _validationLog.reset();
+        }
+
+        if( _window != nullptr)
+        {
+            glfwDestroyWindow(_window);
+            _window = nullptr;
+        }
+            
+        glfwTerminate();
+
+        _jobs.reset();
+    }
+};
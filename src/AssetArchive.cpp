@@ -0,0 +1,177 @@
+#include "AssetArchive.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace
+{
+    uint64_t alignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+}
+
+AssetArchive::AssetArchive(std::shared_ptr<const MappedFile> file)
+    : _file(std::move(file))
+{
+    const std::string& path = _file->path();
+    if( _file->size() < sizeof(AssetArchiveHeader) )
+        throw std::runtime_error(path + " is too small to be an asset archive!");
+
+    _header = reinterpret_cast<const AssetArchiveHeader*>(_file->data());
+    if( _header->magic != ASSET_ARCHIVE_MAGIC || _header->version != ASSET_ARCHIVE_VERSION )
+        throw std::runtime_error(path + " is not a version " + std::to_string(ASSET_ARCHIVE_VERSION) + " asset archive!");
+    if( _header->fileSize != _file->size() )
+        throw std::runtime_error(path + " is truncated!");
+
+    uint64_t fileSize = _file->size();
+    uint64_t tocEnd = sizeof(AssetArchiveHeader) + static_cast<uint64_t>(_header->entryCount) * sizeof(AssetArchiveEntry);
+    if( tocEnd > fileSize )
+        throw std::runtime_error(path + " has a corrupt table of contents!");
+
+    _entries = reinterpret_cast<const AssetArchiveEntry*>(_file->data() + sizeof(AssetArchiveHeader));
+
+    //check everything once here so lookups can trust the toc
+    for( uint32_t i = 0; i < _header->entryCount; i++ )
+    {
+        const auto& entry = _entries[i];
+        if( entry.nameOffset > fileSize || entry.nameLength > fileSize - entry.nameOffset
+            || entry.dataOffset > fileSize || entry.dataSize > fileSize - entry.dataOffset
+            || entry.dataOffset % ASSET_ARCHIVE_ALIGNMENT != 0 )
+            throw std::runtime_error(path + " has a corrupt table of contents!");
+
+        if( i > 0 && !(entryName(_entries[i - 1]) < entryName(entry)) )
+            throw std::runtime_error(path + " has an unsorted table of contents!");
+    }
+}
+
+std::shared_ptr<const AssetArchive> AssetArchive::open(const std::string& path)
+{
+    return std::shared_ptr<const AssetArchive>(new AssetArchive(MappedFile::open(path)));
+}
+
+std::string AssetArchive::entryName(const AssetArchiveEntry& entry) const
+{
+    return std::string(reinterpret_cast<const char*>(_file->data() + entry.nameOffset), entry.nameLength);
+}
+
+const AssetArchiveEntry* AssetArchive::findEntry(const std::string& name) const
+{
+    const AssetArchiveEntry* begin = _entries;
+    const AssetArchiveEntry* end = _entries + _header->entryCount;
+
+    auto compare = [this](const AssetArchiveEntry& entry, const std::string& value) {
+        const char* entryChars = reinterpret_cast<const char*>(_file->data() + entry.nameOffset);
+        return std::lexicographical_compare(entryChars, entryChars + entry.nameLength, value.begin(), value.end());
+    };
+
+    auto it = std::lower_bound(begin, end, name, compare);
+    if( it == end || it->nameLength != name.size() || std::memcmp(_file->data() + it->nameOffset, name.data(), name.size()) != 0 )
+        return nullptr;
+
+    return it;
+}
+
+AssetSpan AssetArchive::find(const std::string& name) const
+{
+    const AssetArchiveEntry* entry = findEntry(name);
+    if( entry == nullptr )
+        return AssetSpan();
+
+    return _file->span(static_cast<size_t>(entry->dataOffset), static_cast<size_t>(entry->dataSize));
+}
+
+AssetSpan AssetArchive::get(const std::string& name) const
+{
+    if( findEntry(name) == nullptr )
+        throw std::runtime_error("no asset named " + name + " in " + _file->path() + "!");
+
+    return find(name);
+}
+
+std::vector<std::string> AssetArchive::names() const
+{
+    std::vector<std::string> result;
+    for( uint32_t i = 0; i < _header->entryCount; i++ )
+        result.push_back(entryName(_entries[i]));
+    return result;
+}
+
+void AssetArchive::Writer::add(const std::string& name, const void* data, size_t size)
+{
+    for( const auto& entry : _entries )
+    {
+        if( entry.name == name )
+            throw std::runtime_error("asset " + name + " added to the archive twice!");
+    }
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    _entries.push_back({name, std::vector<uint8_t>(bytes, bytes + size)});
+}
+
+void AssetArchive::Writer::addFile(const std::string& path, const std::string& name)
+{
+    auto file = MappedFile::open(path);
+
+    std::string entryName = name;
+    if( entryName.empty() )
+    {
+        size_t slash = path.find_last_of("/\\");
+        entryName = slash == std::string::npos ? path : path.substr(slash + 1);
+    }
+
+    add(entryName, file->data(), file->size());
+}
+
+void AssetArchive::Writer::write(const std::string& path) const
+{
+    std::vector<const Pending*> sorted;
+    for( const auto& entry : _entries )
+        sorted.push_back(&entry);
+    std::sort(sorted.begin(), sorted.end(), [](const Pending* a, const Pending* b) { return a->name < b->name; });
+
+    std::vector<AssetArchiveEntry> toc(sorted.size());
+    uint64_t offset = sizeof(AssetArchiveHeader) + sorted.size() * sizeof(AssetArchiveEntry);
+
+    for( size_t i = 0; i < sorted.size(); i++ )
+    {
+        toc[i] = {};
+        toc[i].nameOffset = offset;
+        toc[i].nameLength = static_cast<uint32_t>(sorted[i]->name.size());
+        offset += sorted[i]->name.size();
+    }
+
+    for( size_t i = 0; i < sorted.size(); i++ )
+    {
+        offset = alignUp(offset, ASSET_ARCHIVE_ALIGNMENT);
+        toc[i].dataOffset = offset;
+        toc[i].dataSize = sorted[i]->data.size();
+        offset += sorted[i]->data.size();
+    }
+
+    AssetArchiveHeader header = {};
+    header.magic = ASSET_ARCHIVE_MAGIC;
+    header.version = ASSET_ARCHIVE_VERSION;
+    header.entryCount = static_cast<uint32_t>(sorted.size());
+    header.fileSize = offset;
+
+    std::vector<uint8_t> bytes(static_cast<size_t>(offset), 0);
+    std::memcpy(bytes.data(), &header, sizeof(header));
+    if( !toc.empty() )
+        std::memcpy(bytes.data() + sizeof(header), toc.data(), toc.size() * sizeof(AssetArchiveEntry));
+    for( size_t i = 0; i < sorted.size(); i++ )
+    {
+        std::memcpy(bytes.data() + toc[i].nameOffset, sorted[i]->name.data(), sorted[i]->name.size());
+        if( !sorted[i]->data.empty() )
+            std::memcpy(bytes.data() + toc[i].dataOffset, sorted[i]->data.data(), sorted[i]->data.size());
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if( !file.is_open() )
+        throw std::runtime_error("failed to open " + path + " for writing!");
+    file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    if( !file )
+        throw std::runtime_error("failed to write " + path + "!");
+}
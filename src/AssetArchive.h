@@ -0,0 +1,82 @@
+#pragma once
+
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+//many assets packed into one file so a single mapping serves all of them. layout:
+//
+//  AssetArchiveHeader
+//  AssetArchiveEntry[entryCount]   sorted by name, lookups binary search it in place
+//  name bytes                      not null terminated, entries hold offset + length
+//  asset data                      each entry starts on an ASSET_ARCHIVE_ALIGNMENT boundary
+//
+//everything is little endian and offsets are from the start of the file
+const uint32_t ASSET_ARCHIVE_MAGIC = 0x4b504b56; //"VKPK"
+const uint32_t ASSET_ARCHIVE_VERSION = 1;
+const uint64_t ASSET_ARCHIVE_ALIGNMENT = 16;
+
+struct AssetArchiveHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t reserved;
+    uint64_t fileSize;
+};
+
+struct AssetArchiveEntry
+{
+    uint64_t nameOffset;
+    uint64_t dataOffset;
+    uint64_t dataSize;
+    uint32_t nameLength;
+    uint32_t reserved;
+};
+
+class AssetArchive
+{
+public:
+    //maps the archive and validates the toc, throws if anything points outside the file
+    static std::shared_ptr<const AssetArchive> open(const std::string& path);
+
+    //empty span when there is no such asset
+    AssetSpan find(const std::string& name) const;
+    //same but throws when it's missing
+    AssetSpan get(const std::string& name) const;
+
+    bool contains(const std::string& name) const { return findEntry(name) != nullptr; }
+    uint32_t size() const { return _header->entryCount; }
+    std::vector<std::string> names() const;
+
+    //builds an archive in memory then writes it out in one go
+    class Writer
+    {
+    public:
+        void add(const std::string& name, const void* data, size_t size);
+        //reads the file through a mapping, name defaults to the file name without its directory
+        void addFile(const std::string& path, const std::string& name = "");
+        void write(const std::string& path) const;
+
+    private:
+        struct Pending
+        {
+            std::string name;
+            std::vector<uint8_t> data;
+        };
+        std::vector<Pending> _entries;
+    };
+
+private:
+    explicit AssetArchive(std::shared_ptr<const MappedFile> file);
+
+    const AssetArchiveEntry* findEntry(const std::string& name) const;
+    std::string entryName(const AssetArchiveEntry& entry) const;
+
+    std::shared_ptr<const MappedFile> _file;
+    const AssetArchiveHeader* _header = nullptr;
+    const AssetArchiveEntry* _entries = nullptr;
+};
@@ -0,0 +1,371 @@
+#include "BindlessHeap.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+bool checkBindlessSupport(const VkPhysicalDeviceDescriptorIndexingFeaturesEXT& supportedFeatures, VkPhysicalDeviceDescriptorIndexingFeaturesEXT& enabledFeatures)
+{
+    //runtime sized arrays that don't have to be fully written and can be written while in use.
+    //non uniform indexing isn't asked for: handles come in through push constants, which are uniform
+    enabledFeatures = {};
+    enabledFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+    enabledFeatures.runtimeDescriptorArray = VK_TRUE;
+    enabledFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+    enabledFeatures.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+    enabledFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+    enabledFeatures.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+    enabledFeatures.descriptorBindingStorageImageUpdateAfterBind = supportedFeatures.descriptorBindingStorageImageUpdateAfterBind;
+
+    return supportedFeatures.runtimeDescriptorArray
+        && supportedFeatures.descriptorBindingPartiallyBound
+        && supportedFeatures.descriptorBindingUpdateUnusedWhilePending
+        && supportedFeatures.descriptorBindingSampledImageUpdateAfterBind
+        && supportedFeatures.descriptorBindingStorageBufferUpdateAfterBind;
+}
+
+BindlessHeap::BindlessHeap(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t framesInFlight, uint32_t maxTextures, uint32_t maxBuffers,
+    uint32_t maxStorageImages)
+    : _device(device), _framesInFlight(framesInFlight)
+{
+    //update after bind descriptors have their own, usually much larger, limits
+    VkPhysicalDeviceDescriptorIndexingPropertiesEXT indexingProperties = {};
+    indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+
+    VkPhysicalDeviceProperties2 properties = {};
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties.pNext = &indexingProperties;
+    vkGetPhysicalDeviceProperties2(physicalDevice, &properties);
+
+    _textures.capacity = std::min({maxTextures, indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages,
+        indexingProperties.maxDescriptorSetUpdateAfterBindSamplers, indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+        indexingProperties.maxPerStageDescriptorUpdateAfterBindSamplers});
+    _buffers.capacity = std::min({maxBuffers, indexingProperties.maxDescriptorSetUpdateAfterBindStorageBuffers,
+        indexingProperties.maxPerStageDescriptorUpdateAfterBindStorageBuffers});
+    _storageImages.capacity = std::min({maxStorageImages, indexingProperties.maxDescriptorSetUpdateAfterBindStorageImages,
+        indexingProperties.maxPerStageDescriptorUpdateAfterBindStorageImages});
+
+    //all the arrays also come out of one shared budget. storage images are few and taken off the top,
+    //textures and buffers split what is left evenly if they don't fit together
+    uint32_t totalLimit = std::min(indexingProperties.maxPerStageUpdateAfterBindResources, indexingProperties.maxUpdateAfterBindDescriptorsInAllPools);
+    _storageImages.capacity = std::min(_storageImages.capacity, totalLimit / 4);
+    totalLimit -= _storageImages.capacity;
+    if( static_cast<uint64_t>(_textures.capacity) + _buffers.capacity > totalLimit )
+    {
+        _textures.capacity = std::min(_textures.capacity, totalLimit / 2);
+        _buffers.capacity = std::min(_buffers.capacity, totalLimit - _textures.capacity);
+    }
+
+    if( _textures.capacity == 0 || _buffers.capacity == 0 || (maxStorageImages > 0 && _storageImages.capacity == 0) )
+        throw std::runtime_error("device has no room for update after bind descriptors!");
+
+    //sized once, so handing out and releasing slots never allocates
+    _textures.live.resize(_textures.capacity);
+    _buffers.live.resize(_buffers.capacity);
+    _storageImages.live.resize(_storageImages.capacity);
+
+    uint32_t bindingCount = hasStorageImages() ? 3 : 2;
+
+    VkDescriptorSetLayoutBinding bindings[3] = {};
+    bindings[0].binding = BINDLESS_TEXTURE_BINDING;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[0].descriptorCount = _textures.capacity;
+    bindings[0].stageFlags = VK_SHADER_STAGE_ALL;
+    bindings[1].binding = BINDLESS_BUFFER_BINDING;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[1].descriptorCount = _buffers.capacity;
+    bindings[1].stageFlags = VK_SHADER_STAGE_ALL;
+    bindings[2].binding = BINDLESS_STORAGE_IMAGE_BINDING;
+    bindings[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    bindings[2].descriptorCount = _storageImages.capacity;
+    bindings[2].stageFlags = VK_SHADER_STAGE_ALL;
+
+    VkDescriptorBindingFlagsEXT bindingFlags[3] = {};
+    for (auto& flags : bindingFlags)
+    {
+        flags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT
+            | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT
+            | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT;
+    }
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsInfo = {};
+    bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+    bindingFlagsInfo.bindingCount = bindingCount;
+    bindingFlagsInfo.pBindingFlags = bindingFlags;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.pNext = &bindingFlagsInfo;
+    layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+    layoutInfo.bindingCount = bindingCount;
+    layoutInfo.pBindings = bindings;
+
+    if (vkCreateDescriptorSetLayout(_device, &layoutInfo, nullptr, &_setLayout) != VK_SUCCESS)
+        throw std::runtime_error("failed to create bindless descriptor set layout!");
+
+    VkDescriptorPoolSize poolSizes[3] = {};
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSizes[0].descriptorCount = _textures.capacity;
+    poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSizes[1].descriptorCount = _buffers.capacity;
+    poolSizes[2].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    poolSizes[2].descriptorCount = _storageImages.capacity;
+
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = bindingCount;
+    poolInfo.pPoolSizes = poolSizes;
+
+    if (vkCreateDescriptorPool(_device, &poolInfo, nullptr, &_pool) != VK_SUCCESS)
+        throw std::runtime_error("failed to create bindless descriptor pool!");
+
+    VkDescriptorSetAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = _pool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &_setLayout;
+
+    if (vkAllocateDescriptorSets(_device, &allocInfo, &_set) != VK_SUCCESS)
+        throw std::runtime_error("failed to allocate bindless descriptor set!");
+
+    VkPushConstantRange pushConstantRange = {};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_ALL;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = BINDLESS_PUSH_CONSTANT_SIZE;
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &_setLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+    if (vkCreatePipelineLayout(_device, &pipelineLayoutInfo, nullptr, &_pipelineLayout) != VK_SUCCESS)
+        throw std::runtime_error("failed to create bindless pipeline layout!");
+}
+
+BindlessHeap::~BindlessHeap()
+{
+    vkDestroyPipelineLayout(_device, _pipelineLayout, nullptr);
+    //the set goes with its pool
+    vkDestroyDescriptorPool(_device, _pool, nullptr);
+    vkDestroyDescriptorSetLayout(_device, _setLayout, nullptr);
+}
+
+uint32_t BindlessHeap::SlotAllocator::allocate(const char* what)
+{
+    if( !freeSlots.empty() )
+    {
+        uint32_t slot = freeSlots.back();
+        freeSlots.pop_back();
+        live[slot] = true;
+        return slot;
+    }
+
+    if( highWater == capacity )
+        throw std::runtime_error(std::string("bindless heap is out of ") + what + " slots!");
+
+    live[highWater] = true;
+    return highWater++;
+}
+
+void BindlessHeap::SlotAllocator::release(uint32_t slot, uint64_t frameNumber)
+{
+    if( slot >= highWater )
+        throw std::runtime_error("released a bindless handle that was never handed out!");
+    //a second release would put the slot on the free list twice and hand it to two owners
+    if( !live[slot] )
+        throw std::runtime_error("released a bindless handle that is already free!");
+
+    live[slot] = false;
+    retired.push_back({slot, frameNumber});
+}
+
+void BindlessHeap::SlotAllocator::collect(uint64_t safeFrame)
+{
+    //not necessarily in frame order, teardown releases with frame 0 after slots released by later frames.
+    //the ones still pending are kept in order in place
+    size_t kept = 0;
+    for (size_t i = 0; i < retired.size(); i++)
+    {
+        if( retired[i].frameNumber < safeFrame )
+            freeSlots.push_back(retired[i].slot);
+        else
+            retired[kept++] = retired[i];
+    }
+
+    retired.resize(kept);
+}
+
+BindlessHandle BindlessHeap::addTexture(VkImageView imageView, VkSampler sampler, VkImageLayout layout)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    uint32_t slot = _textures.allocate("texture");
+    writeTexture(slot, imageView, sampler, layout);
+    return slot;
+}
+
+BindlessHandle BindlessHeap::addBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    uint32_t slot = _buffers.allocate("buffer");
+    writeBuffer(slot, buffer, offset, range);
+    return slot;
+}
+
+BindlessHandle BindlessHeap::addStorageImage(VkImageView imageView)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    uint32_t slot = _storageImages.allocate("storage image");
+    writeStorageImage(slot, imageView);
+    return slot;
+}
+
+void BindlessHeap::updateTexture(BindlessHandle handle, VkImageView imageView, VkSampler sampler, VkImageLayout layout)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    writeTexture(handle, imageView, sampler, layout);
+}
+
+void BindlessHeap::updateBuffer(BindlessHandle handle, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    writeBuffer(handle, buffer, offset, range);
+}
+
+void BindlessHeap::updateStorageImage(BindlessHandle handle, VkImageView imageView)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    writeStorageImage(handle, imageView);
+}
+
+void BindlessHeap::releaseTexture(BindlessHandle handle, uint64_t frameNumber)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _textures.release(handle, frameNumber);
+}
+
+void BindlessHeap::releaseBuffer(BindlessHandle handle, uint64_t frameNumber)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _buffers.release(handle, frameNumber);
+}
+
+void BindlessHeap::releaseStorageImage(BindlessHandle handle, uint64_t frameNumber)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _storageImages.release(handle, frameNumber);
+}
+
+void BindlessHeap::collectGarbage(uint64_t frameNumber)
+{
+    //the fence just waited on covers frame frameNumber - framesInFlight and everything before it
+    if( frameNumber < _framesInFlight )
+        return;
+
+    uint64_t safeFrame = frameNumber - _framesInFlight + 1;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _textures.collect(safeFrame);
+    _buffers.collect(safeFrame);
+    _storageImages.collect(safeFrame);
+}
+
+void BindlessHeap::bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint) const
+{
+    vkCmdBindDescriptorSets(commandBuffer, bindPoint, _pipelineLayout, BINDLESS_SET, 1, &_set, 0, nullptr);
+}
+
+void BindlessHeap::writeTexture(uint32_t slot, VkImageView imageView, VkSampler sampler, VkImageLayout layout)
+{
+    if( slot >= _textures.highWater )
+        throw std::runtime_error("invalid bindless texture handle!");
+
+    VkDescriptorImageInfo imageInfo = {};
+    imageInfo.sampler = sampler;
+    imageInfo.imageView = imageView;
+    imageInfo.imageLayout = layout;
+
+    VkWriteDescriptorSet write = {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = _set;
+    write.dstBinding = BINDLESS_TEXTURE_BINDING;
+    write.dstArrayElement = slot;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo = &imageInfo;
+
+    vkUpdateDescriptorSets(_device, 1, &write, 0, nullptr);
+}
+
+void BindlessHeap::writeBuffer(uint32_t slot, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+{
+    if( slot >= _buffers.highWater )
+        throw std::runtime_error("invalid bindless buffer handle!");
+
+    VkDescriptorBufferInfo bufferInfo = {};
+    bufferInfo.buffer = buffer;
+    bufferInfo.offset = offset;
+    bufferInfo.range = range;
+
+    VkWriteDescriptorSet write = {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = _set;
+    write.dstBinding = BINDLESS_BUFFER_BINDING;
+    write.dstArrayElement = slot;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.pBufferInfo = &bufferInfo;
+
+    vkUpdateDescriptorSets(_device, 1, &write, 0, nullptr);
+}
+
+void BindlessHeap::writeStorageImage(uint32_t slot, VkImageView imageView)
+{
+    if( slot >= _storageImages.highWater )
+        throw std::runtime_error("invalid bindless storage image handle!");
+
+    VkDescriptorImageInfo imageInfo = {};
+    imageInfo.imageView = imageView;
+    imageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+    VkWriteDescriptorSet write = {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = _set;
+    write.dstBinding = BINDLESS_STORAGE_IMAGE_BINDING;
+    write.dstArrayElement = slot;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    write.pImageInfo = &imageInfo;
+
+    vkUpdateDescriptorSets(_device, 1, &write, 0, nullptr);
+}
+
+BindlessHeapStats BindlessHeap::stats() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    BindlessHeapStats stats;
+    stats.textureCapacity = _textures.capacity;
+    stats.texturesInUse = _textures.inUse();
+    stats.bufferCapacity = _buffers.capacity;
+    stats.buffersInUse = _buffers.inUse();
+    stats.storageImageCapacity = _storageImages.capacity;
+    stats.storageImagesInUse = _storageImages.inUse();
+    return stats;
+}
+
+void BindlessHeap::printStats(std::ostream& out) const
+{
+    auto s = stats();
+    out << "Bindless heap: " << s.texturesInUse << "/" << s.textureCapacity << " textures, "
+        << s.buffersInUse << "/" << s.bufferCapacity << " buffers";
+    if( s.storageImageCapacity > 0 )
+        out << ", " << s.storageImagesInUse << "/" << s.storageImageCapacity << " storage images";
+    out << std::endl;
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+//index of a resource in the bindless heap, what shaders get handed (usually through a push constant)
+using BindlessHandle = uint32_t;
+const BindlessHandle INVALID_BINDLESS_HANDLE = UINT32_MAX;
+
+//binding numbers of the heap's set, resources/shaders/bindless.glsl declares the same
+const uint32_t BINDLESS_TEXTURE_BINDING = 0;
+const uint32_t BINDLESS_BUFFER_BINDING = 1;
+const uint32_t BINDLESS_STORAGE_IMAGE_BINDING = 2; //only there when the heap was made with storage images
+const uint32_t BINDLESS_SET = 0;
+
+const uint32_t BINDLESS_DEFAULT_TEXTURES = 16384;
+const uint32_t BINDLESS_DEFAULT_BUFFERS = 16384;
+
+//every pipeline layout made by the heap has this much push constant space, the guaranteed minimum
+const uint32_t BINDLESS_PUSH_CONSTANT_SIZE = 128;
+
+//fills in the device features needed, chained into VkDeviceCreateInfo. false if supportedFeatures (what
+//vkGetPhysicalDeviceFeatures2 reported, see DeviceCapabilities) is missing any of them. storage images
+//are optional, descriptorBindingStorageImageUpdateAfterBind is enabled when supported and doesn't count
+bool checkBindlessSupport(const VkPhysicalDeviceDescriptorIndexingFeaturesEXT& supportedFeatures, VkPhysicalDeviceDescriptorIndexingFeaturesEXT& enabledFeatures);
+
+struct BindlessHeapStats
+{
+    uint32_t textureCapacity = 0;
+    uint32_t texturesInUse = 0;
+    uint32_t bufferCapacity = 0;
+    uint32_t buffersInUse = 0;
+    uint32_t storageImageCapacity = 0;
+    uint32_t storageImagesInUse = 0;
+};
+
+//one descriptor set holding big arrays of every texture and storage buffer, bound once per command
+//buffer and indexed from shaders. resources are written into a free slot when added and keep that
+//index as their handle until released, so recording a draw is a push constant instead of a descriptor
+//set bind.
+//
+//the set is update-after-bind with partially bound arrays, so slots can be written while command
+//buffers that use the set are pending, as long as those command buffers don't use the slot being
+//written. released slots are therefore only reused once every frame that might still read them has
+//finished: release() takes the current frame number and collectGarbage() is called once the fence of
+//the oldest frame in flight has been waited on
+class BindlessHeap
+{
+public:
+    //maxStorageImages of 0 leaves BINDLESS_STORAGE_IMAGE_BINDING out of the set, anything else needs
+    //descriptorBindingStorageImageUpdateAfterBind enabled
+    BindlessHeap(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t framesInFlight,
+        uint32_t maxTextures = BINDLESS_DEFAULT_TEXTURES, uint32_t maxBuffers = BINDLESS_DEFAULT_BUFFERS, uint32_t maxStorageImages = 0);
+    ~BindlessHeap();
+
+    BindlessHeap(const BindlessHeap&) = delete;
+    BindlessHeap& operator=(const BindlessHeap&) = delete;
+
+    //thread safe, throws when the heap is full
+    BindlessHandle addTexture(VkImageView imageView, VkSampler sampler, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    BindlessHandle addBuffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+    //storage images are always in GENERAL when a shader gets at them
+    BindlessHandle addStorageImage(VkImageView imageView);
+
+    //points an existing handle at something else, e.g. a texture that finished streaming in a higher mip.
+    //the previous resource must stay alive until frames in flight that may have read it are done
+    void updateTexture(BindlessHandle handle, VkImageView imageView, VkSampler sampler, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    void updateBuffer(BindlessHandle handle, VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+    void updateStorageImage(BindlessHandle handle, VkImageView imageView);
+
+    //the slot is handed out again once frameNumber is no longer in flight
+    void releaseTexture(BindlessHandle handle, uint64_t frameNumber);
+    void releaseBuffer(BindlessHandle handle, uint64_t frameNumber);
+    void releaseStorageImage(BindlessHandle handle, uint64_t frameNumber);
+
+    //call with the frame about to be recorded, after its frame slot's fence has been waited on
+    void collectGarbage(uint64_t frameNumber);
+
+    //the heap's set, bound at BINDLESS_SET, with BINDLESS_PUSH_CONSTANT_SIZE bytes of push constants
+    //visible to every stage. shared by every pipeline so one bind per command buffer covers them all
+    VkPipelineLayout pipelineLayout() const { return _pipelineLayout; }
+    VkDescriptorSetLayout setLayout() const { return _setLayout; }
+    void bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint) const;
+
+    bool hasStorageImages() const { return _storageImages.capacity > 0; }
+
+    BindlessHeapStats stats() const;
+    void printStats(std::ostream& out) const;
+
+private:
+    struct RetiredSlot
+    {
+        uint32_t slot;
+        uint64_t frameNumber;
+    };
+
+    //a free list over one binding's array, slots handed out in increasing order until the first release
+    struct SlotAllocator
+    {
+        uint32_t capacity = 0;
+        uint32_t highWater = 0;
+        std::vector<uint32_t> freeSlots;
+        std::vector<RetiredSlot> retired;
+        std::vector<bool> live; //per slot, handed out and not yet released
+
+        uint32_t allocate(const char* what);
+        void release(uint32_t slot, uint64_t frameNumber);
+        void collect(uint64_t safeFrame);
+        uint32_t inUse() const { return highWater - static_cast<uint32_t>(freeSlots.size() + retired.size()); }
+    };
+
+    void writeTexture(uint32_t slot, VkImageView imageView, VkSampler sampler, VkImageLayout layout);
+    void writeBuffer(uint32_t slot, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range);
+    void writeStorageImage(uint32_t slot, VkImageView imageView);
+
+    VkDevice _device;
+    uint32_t _framesInFlight;
+
+    VkDescriptorSetLayout _setLayout = VK_NULL_HANDLE;
+    VkDescriptorPool _pool = VK_NULL_HANDLE;
+    VkDescriptorSet _set = VK_NULL_HANDLE;
+    VkPipelineLayout _pipelineLayout = VK_NULL_HANDLE;
+
+    mutable std::mutex _mutex;
+    SlotAllocator _textures;
+    SlotAllocator _buffers;
+    SlotAllocator _storageImages;
+};
@@ -0,0 +1,449 @@
+#include "CapabilityCache.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <type_traits>
+
+namespace
+{
+    //same idea as the pipeline cache file, our header catches a truncated or corrupted file before any of it is trusted
+    const uint32_t CACHE_FILE_MAGIC = 0x43434b56; //"VKCC"
+    const uint32_t CACHE_FILE_VERSION = 1;
+
+    struct CacheFileHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t layoutHash; //the vulkan structs are stored as they are, headers of another size can't read them
+        uint32_t reserved;
+        uint64_t dataSize;
+        uint64_t dataHash;
+    };
+
+    //far more than any device has, only there to stop a bad count allocating the world
+    const uint32_t MAX_QUEUE_FAMILIES = 64;
+
+    //what the loader reads to find drivers and layers, any change to these can change the instance lists
+    const char* const LOADER_ENVIRONMENT[] = {
+        "VK_ICD_FILENAMES", "VK_DRIVER_FILES", "VK_ADD_DRIVER_FILES", "VK_LOADER_DRIVERS_SELECT", "VK_LOADER_DRIVERS_DISABLE",
+        "VK_LAYER_PATH", "VK_ADD_LAYER_PATH", "VK_INSTANCE_LAYERS", "VK_LOADER_LAYERS_ENABLE", "VK_LOADER_LAYERS_DISABLE"
+    };
+
+    uint64_t fnv1a(const char* data, size_t size, uint64_t hash = 14695981039346656037ull)
+    {
+        for( size_t i = 0; i < size; i++ )
+        {
+            hash ^= static_cast<uint8_t>(data[i]);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    uint32_t layoutHash()
+    {
+        const uint64_t sizes[] = {
+            sizeof(VkPhysicalDeviceProperties), sizeof(VkPhysicalDeviceFeatures), sizeof(VkPhysicalDeviceDescriptorIndexingFeaturesEXT),
+            sizeof(VkPhysicalDeviceMemoryProperties), sizeof(VkQueueFamilyProperties)
+        };
+        return static_cast<uint32_t>(fnv1a(reinterpret_cast<const char*>(sizes), sizeof(sizes)));
+    }
+
+    double millisecondsSince(std::chrono::high_resolution_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    class Writer
+    {
+    public:
+        template<typename T>
+        void write(const T& value)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "only plain structs go in as they are");
+            const char* bytes = reinterpret_cast<const char*>(&value);
+            data.insert(data.end(), bytes, bytes + sizeof(T));
+        }
+
+        void writeNames(const std::unordered_set<std::string>& names)
+        {
+            write(static_cast<uint32_t>(names.size()));
+            for (const auto& name : names)
+            {
+                write(static_cast<uint32_t>(name.size()));
+                data.insert(data.end(), name.begin(), name.end());
+            }
+        }
+
+        std::vector<char> data;
+    };
+
+    //every read is bounds checked, once one fails the rest do too and ok() says so
+    class Reader
+    {
+    public:
+        Reader(const char* data, size_t size) : _data(data), _size(size) {}
+
+        template<typename T>
+        bool read(T& value)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "only plain structs come out as they are");
+            if( !_ok || _size - _offset < sizeof(T) )
+                return _ok = false;
+            std::memcpy(&value, _data + _offset, sizeof(T));
+            _offset += sizeof(T);
+            return true;
+        }
+
+        bool readNames(std::unordered_set<std::string>& names)
+        {
+            uint32_t count = 0;
+            if( !read(count) )
+                return false;
+            for (uint32_t i = 0; i < count; i++)
+            {
+                uint32_t length = 0;
+                if( !read(length) || _size - _offset < length )
+                    return _ok = false;
+                names.emplace(_data + _offset, length);
+                _offset += length;
+            }
+            return true;
+        }
+
+        bool ok() const { return _ok; }
+        bool atEnd() const { return _offset == _size; }
+
+    private:
+        const char* _data;
+        size_t _size;
+        size_t _offset = 0;
+        bool _ok = true;
+    };
+}
+
+bool CapabilityCache::DeviceKey::operator==(const DeviceKey& other) const
+{
+    return vendorID == other.vendorID && deviceID == other.deviceID && driverVersion == other.driverVersion
+        && apiVersion == other.apiVersion && layersHash == other.layersHash
+        && std::memcmp(pipelineCacheUUID, other.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+CapabilityCache::CapabilityCache(const std::string& path)
+    : _path(path)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    load();
+    _stats.loadMs = millisecondsSince(start);
+}
+
+uint64_t CapabilityCache::instanceKey()
+{
+    uint32_t loaderVersion = VK_API_VERSION_1_0;
+    vkEnumerateInstanceVersion(&loaderVersion);
+
+    uint64_t key = fnv1a(reinterpret_cast<const char*>(&loaderVersion), sizeof(loaderVersion));
+    for (const char* name : LOADER_ENVIRONMENT)
+    {
+        //name=value, with unset and empty kept apart
+        const char* value = std::getenv(name);
+        key = fnv1a(name, std::strlen(name), key);
+        if( value != nullptr )
+            key = fnv1a(value, std::strlen(value) + 1, key);
+    }
+    return key;
+}
+
+const InstanceCapabilities& CapabilityCache::instance()
+{
+    //the key is checked every run, it is what makes a cached instance safe to hand out
+    uint64_t key = instanceKey();
+    if( !_hasInstance || key != _instanceKey )
+    {
+        _stats.instanceFromDisk = false;
+        _instanceKey = key;
+        queryInstance();
+    }
+    return _instance;
+}
+
+bool CapabilityCache::refreshInstance()
+{
+    if( !_stats.instanceFromDisk )
+        return false;
+
+    _stats.instanceFromDisk = false;
+    queryInstance();
+    return true;
+}
+
+void CapabilityCache::queryInstance()
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    _instance = {};
+    vkEnumerateInstanceVersion(&_instance.apiVersion);
+
+    uint32_t extensionCount = 0;
+    vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> extensions(extensionCount);
+    vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, extensions.data());
+    for (uint32_t i = 0; i < extensionCount; i++)
+        _instance.extensions.insert(extensions[i].extensionName);
+
+    uint32_t layerCount = 0;
+    vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
+    std::vector<VkLayerProperties> layers(layerCount);
+    vkEnumerateInstanceLayerProperties(&layerCount, layers.data());
+    for (uint32_t i = 0; i < layerCount; i++)
+        _instance.layers.insert(layers[i].layerName);
+
+    _hasInstance = true;
+    _dirty = true;
+    _stats.queryMs += millisecondsSince(start);
+}
+
+const DeviceCapabilities& CapabilityCache::device(VkPhysicalDevice device, const std::vector<const char*>& enabledLayers)
+{
+    auto resolved = _resolved.find(device);
+    if( resolved != _resolved.end() )
+        return *resolved->second;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    //the properties are the key, so they are always asked for. it's a copy out of the driver, cheap next to the rest
+    VkPhysicalDeviceProperties properties = {};
+    vkGetPhysicalDeviceProperties(device, &properties);
+
+    DeviceKey key = {};
+    key.vendorID = properties.vendorID;
+    key.deviceID = properties.deviceID;
+    key.driverVersion = properties.driverVersion;
+    key.apiVersion = properties.apiVersion;
+    std::memcpy(key.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+    key.layersHash = fnv1a(nullptr, 0);
+    for (const char* layer : enabledLayers)
+        key.layersHash = fnv1a(layer, std::strlen(layer) + 1, key.layersHash);
+
+    for (const auto& entry : _devices)
+    {
+        if( entry->key == key )
+        {
+            entry->used = true;
+            _stats.devicesFromDisk++;
+            _stats.queryMs += millisecondsSince(start);
+            _resolved[device] = &entry->capabilities;
+            return entry->capabilities;
+        }
+    }
+
+    auto entry = std::make_unique<DeviceEntry>();
+    entry->key = key;
+    entry->used = true;
+    DeviceCapabilities& capabilities = entry->capabilities;
+    capabilities.properties = properties;
+
+    capabilities.indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+    VkPhysicalDeviceFeatures2 features = {};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &capabilities.indexingFeatures;
+    vkGetPhysicalDeviceFeatures2(device, &features);
+    capabilities.features = features.features;
+    capabilities.indexingFeatures.pNext = nullptr;
+
+    vkGetPhysicalDeviceMemoryProperties(device, &capabilities.memoryProperties);
+
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(device, &familyCount, nullptr);
+    capabilities.queueFamilies.resize(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(device, &familyCount, capabilities.queueFamilies.data());
+
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> extensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, extensions.data());
+    for (uint32_t i = 0; i < extensionCount; i++)
+        capabilities.extensions.insert(extensions[i].extensionName);
+
+    _devices.push_back(std::move(entry));
+    _dirty = true;
+    _stats.devicesQueried++;
+    _stats.queryMs += millisecondsSince(start);
+
+    _resolved[device] = &capabilities;
+    return capabilities;
+}
+
+void CapabilityCache::load()
+{
+    if( _path.empty() )
+        return;
+
+    std::ifstream file(_path, std::ios::binary | std::ios::ate);
+    if( !file.is_open() )
+        return;
+
+    size_t fileSize = static_cast<size_t>(file.tellg());
+    CacheFileHeader fileHeader = {};
+    file.seekg(0);
+    if( fileSize < sizeof(fileHeader) || !file.read(reinterpret_cast<char*>(&fileHeader), sizeof(fileHeader)) )
+    {
+        std::cerr << "capability cache " << _path << " is truncated, ignoring it" << std::endl;
+        return;
+    }
+
+    if( fileHeader.magic != CACHE_FILE_MAGIC || fileHeader.version != CACHE_FILE_VERSION || fileHeader.layoutHash != layoutHash()
+        || fileHeader.dataSize != fileSize - sizeof(fileHeader) )
+    {
+        std::cerr << "capability cache " << _path << " has an unknown format, ignoring it" << std::endl;
+        return;
+    }
+
+    std::vector<char> data(static_cast<size_t>(fileHeader.dataSize));
+    file.read(data.data(), data.size());
+    if( !file || fnv1a(data.data(), data.size()) != fileHeader.dataHash )
+    {
+        std::cerr << "capability cache " << _path << " is corrupt, ignoring it" << std::endl;
+        return;
+    }
+
+    Reader reader(data.data(), data.size());
+
+    uint8_t hasInstance = 0;
+    InstanceCapabilities instance;
+    uint64_t key = 0;
+    if( reader.read(hasInstance) && hasInstance )
+    {
+        reader.read(key);
+        reader.read(instance.apiVersion);
+        reader.readNames(instance.extensions);
+        reader.readNames(instance.layers);
+    }
+
+    std::vector<std::unique_ptr<DeviceEntry>> devices;
+    uint32_t deviceCount = 0;
+    reader.read(deviceCount);
+    for (uint32_t i = 0; i < deviceCount && reader.ok(); i++)
+    {
+        auto entry = std::make_unique<DeviceEntry>();
+        DeviceCapabilities& capabilities = entry->capabilities;
+        uint32_t familyCount = 0;
+        reader.read(entry->key);
+        reader.read(capabilities.properties);
+        reader.read(capabilities.features);
+        reader.read(capabilities.indexingFeatures);
+        reader.read(capabilities.memoryProperties);
+        if( !reader.read(familyCount) || familyCount > MAX_QUEUE_FAMILIES )
+            break;
+        capabilities.queueFamilies.resize(familyCount);
+        for (auto& family : capabilities.queueFamilies)
+            reader.read(family);
+        reader.readNames(capabilities.extensions);
+        capabilities.indexingFeatures.pNext = nullptr;
+        devices.push_back(std::move(entry));
+    }
+
+    //the hash matched, so this only fails on a file we didn't write
+    if( !reader.ok() || !reader.atEnd() || devices.size() != deviceCount )
+    {
+        std::cerr << "capability cache " << _path << " is corrupt, ignoring it" << std::endl;
+        return;
+    }
+
+    _hasInstance = hasInstance != 0;
+    _instanceKey = key;
+    _instance = std::move(instance);
+    _devices = std::move(devices);
+    _stats.loadedFromDisk = true;
+    _stats.instanceFromDisk = _hasInstance;
+}
+
+void CapabilityCache::save() const
+{
+    if( _path.empty() || !_dirty )
+        return;
+
+    Writer writer;
+    writer.write(static_cast<uint8_t>(_hasInstance ? 1 : 0));
+    if( _hasInstance )
+    {
+        writer.write(_instanceKey);
+        writer.write(_instance.apiVersion);
+        writer.writeNames(_instance.extensions);
+        writer.writeNames(_instance.layers);
+    }
+
+    //entries for devices this run didn't see are kept, they may just be on another ICD selection
+    auto superseded = [&](const DeviceEntry& entry) {
+        for (const auto& other : _devices)
+        {
+            if( !entry.used && other->used && other->key.vendorID == entry.key.vendorID && other->key.deviceID == entry.key.deviceID
+                && other->key.layersHash == entry.key.layersHash )
+                return true;
+        }
+        return false;
+    };
+
+    std::vector<const DeviceEntry*> kept;
+    for (const auto& entry : _devices)
+    {
+        if( !superseded(*entry) )
+            kept.push_back(entry.get());
+    }
+
+    writer.write(static_cast<uint32_t>(kept.size()));
+    for (const DeviceEntry* entry : kept)
+    {
+        const DeviceCapabilities& capabilities = entry->capabilities;
+        writer.write(entry->key);
+        writer.write(capabilities.properties);
+        writer.write(capabilities.features);
+        writer.write(capabilities.indexingFeatures);
+        writer.write(capabilities.memoryProperties);
+        writer.write(static_cast<uint32_t>(capabilities.queueFamilies.size()));
+        for (const auto& family : capabilities.queueFamilies)
+            writer.write(family);
+        writer.writeNames(capabilities.extensions);
+    }
+
+    CacheFileHeader fileHeader = {};
+    fileHeader.magic = CACHE_FILE_MAGIC;
+    fileHeader.version = CACHE_FILE_VERSION;
+    fileHeader.layoutHash = layoutHash();
+    fileHeader.dataSize = writer.data.size();
+    fileHeader.dataHash = fnv1a(writer.data.data(), writer.data.size());
+
+    //written aside and renamed over, like the pipeline cache
+    std::string tempPath = _path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if( !file.is_open() )
+        {
+            std::cerr << "failed to open " << tempPath << " for writing, capability cache not saved" << std::endl;
+            return;
+        }
+
+        file.write(reinterpret_cast<const char*>(&fileHeader), sizeof(fileHeader));
+        file.write(writer.data.data(), writer.data.size());
+        if( !file )
+        {
+            std::cerr << "failed to write " << tempPath << ", capability cache not saved" << std::endl;
+            return;
+        }
+    }
+
+    std::remove(_path.c_str());
+    if( std::rename(tempPath.c_str(), _path.c_str()) != 0 )
+        std::cerr << "failed to move " << tempPath << " to " << _path << ", capability cache not saved" << std::endl;
+}
+
+void CapabilityCache::printStats(std::ostream& out) const
+{
+    bool warm = _stats.instanceFromDisk && _stats.devicesQueried == 0;
+    out << "Capabilities: " << (warm ? "warm" : "cold") << ", instance " << (_stats.instanceFromDisk ? "cached" : "queried")
+        << ", " << _stats.devicesFromDisk << " devices cached, " << _stats.devicesQueried << " queried ("
+        << _stats.loadMs << "ms loading, " << _stats.queryMs << "ms querying)" << std::endl;
+}
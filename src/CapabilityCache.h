@@ -0,0 +1,113 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+//what the loader offers before there is an instance
+struct InstanceCapabilities
+{
+    uint32_t apiVersion = VK_API_VERSION_1_0;
+    std::unordered_set<std::string> extensions;
+    std::unordered_set<std::string> layers;
+
+    bool hasExtension(const char* name) const { return extensions.count(name) > 0; }
+    bool hasLayer(const char* name) const { return layers.count(name) > 0; }
+};
+
+//everything startup asks of a physical device that only a driver update can change. surface queries
+//aren't in here, they depend on the window
+struct DeviceCapabilities
+{
+    VkPhysicalDeviceProperties properties = {};
+    VkPhysicalDeviceFeatures features = {};
+    VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexingFeatures = {}; //pNext is always null
+    VkPhysicalDeviceMemoryProperties memoryProperties = {};
+    std::vector<VkQueueFamilyProperties> queueFamilies;
+    std::unordered_set<std::string> extensions;
+
+    bool hasExtension(const char* name) const { return extensions.count(name) > 0; }
+};
+
+struct CapabilityCacheStats
+{
+    bool loadedFromDisk = false;
+    bool instanceFromDisk = false;
+    uint32_t devicesFromDisk = 0;
+    uint32_t devicesQueried = 0;
+    double loadMs = 0.0;  //reading and checking the file
+    double queryMs = 0.0; //asking vulkan for whatever wasn't in it
+};
+
+//instance and device capabilities, queried at most once per run and kept on disk between runs.
+//
+//device entries are keyed by vendor, device, driver version and pipeline cache uuid, so a driver update
+//misses and queries afresh. the instance entry is keyed by the loader version and the environment
+//variables that change what the loader finds, installing a layer changes neither so anyone finding a
+//cached list short of something should refreshInstance() before giving up on it
+class CapabilityCache
+{
+public:
+    //an empty path keeps it in memory only
+    explicit CapabilityCache(const std::string& path);
+
+    CapabilityCache(const CapabilityCache&) = delete;
+    CapabilityCache& operator=(const CapabilityCache&) = delete;
+
+    //vkEnumerateInstanceExtensionProperties and vkEnumerateInstanceLayerProperties, or the last run's answer
+    const InstanceCapabilities& instance();
+    //throws away what the file said and queries again, true when the instance came from disk before
+    bool refreshInstance();
+
+    //enabledLayers are the instance layers the device is reached through, layers add device extensions too
+    const DeviceCapabilities& device(VkPhysicalDevice device, const std::vector<const char*>& enabledLayers);
+
+    //writes the file back if this run had to query anything
+    void save() const;
+
+    CapabilityCacheStats stats() const { return _stats; }
+    void printStats(std::ostream& out) const;
+
+private:
+    struct DeviceKey
+    {
+        uint32_t vendorID;
+        uint32_t deviceID;
+        uint32_t driverVersion;
+        uint32_t apiVersion;
+        uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+        uint64_t layersHash;
+
+        bool operator==(const DeviceKey& other) const;
+    };
+
+    struct DeviceEntry
+    {
+        DeviceKey key;
+        DeviceCapabilities capabilities;
+        bool used = false; //by this run, an unused entry for the same device is from an older driver
+    };
+
+    static uint64_t instanceKey();
+    void queryInstance();
+    void load();
+
+    std::string _path;
+    bool _dirty = false;
+
+    bool _hasInstance = false;
+    uint64_t _instanceKey = 0;
+    InstanceCapabilities _instance;
+
+    //unique_ptr so references handed out stay put as entries are added
+    std::vector<std::unique_ptr<DeviceEntry>> _devices;
+    std::unordered_map<VkPhysicalDevice, const DeviceCapabilities*> _resolved; //this run's handles
+
+    CapabilityCacheStats _stats;
+};
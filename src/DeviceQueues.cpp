@@ -0,0 +1,135 @@
+#include "DeviceQueues.h"
+
+#include <map>
+#include <stdexcept>
+
+QueueLayout QueueLayout::build(const QueueFamilyIndices& indices)
+{
+    if( !indices.graphicsFamily.has_value() )
+        throw std::runtime_error("Can't lay out queues without a graphics family.");
+
+    QueueLayout layout;
+    std::map<uint32_t, std::vector<float>> familyPriorities;
+
+    //hands out the next queue in the family, once the family runs out the role shares its last queue
+    auto request = [&](QueueType type, uint32_t familyIndex, float priority) {
+        auto& priorities = familyPriorities[familyIndex];
+        uint32_t available = familyIndex < indices.properties.size() ? indices.properties[familyIndex].queueCount : 1;
+
+        QueueAssignment assignment = {};
+        assignment.familyIndex = familyIndex;
+        if( priorities.size() < available )
+        {
+            assignment.queueIndex = static_cast<uint32_t>(priorities.size());
+            priorities.push_back(priority);
+        }
+        else
+            assignment.queueIndex = static_cast<uint32_t>(priorities.size() - 1);
+
+        layout.assignments[static_cast<size_t>(type)] = assignment;
+    };
+
+    uint32_t graphicsFamily = indices.graphicsFamily.value();
+    request(QueueType::Graphics, graphicsFamily, 1.f);
+
+    //when there is no dedicated family we still try for a second queue out of the graphics family,
+    //lower priority so it yields to the frame
+    request(QueueType::Compute, indices.computeFamily.value_or(graphicsFamily), 0.75f);
+    request(QueueType::Transfer, indices.transferFamily.value_or(indices.computeFamily.value_or(graphicsFamily)), 0.5f);
+
+    if( indices.presentFamily.has_value() )
+    {
+        if( indices.presentFamily == indices.graphicsFamily )
+            layout.assignments[static_cast<size_t>(QueueType::Present)] = layout.assignments[static_cast<size_t>(QueueType::Graphics)];
+        else
+            request(QueueType::Present, indices.presentFamily.value(), 1.f);
+    }
+
+    //priorities are fully populated now, so the pointers taken below stay put
+    for( auto& family : familyPriorities )
+        layout.priorities.push_back(family.second);
+
+    size_t i = 0;
+    for( const auto& family : familyPriorities )
+    {
+        VkDeviceQueueCreateInfo queueCreateInfo = {};
+        queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+        queueCreateInfo.queueFamilyIndex = family.first;
+        queueCreateInfo.queueCount = static_cast<uint32_t>(layout.priorities[i].size());
+        queueCreateInfo.pQueuePriorities = layout.priorities[i].data();
+        layout.createInfos.push_back(queueCreateInfo);
+        i++;
+    }
+
+    return layout;
+}
+
+void DeviceQueues::init(VkDevice device, const QueueLayout& layout)
+{
+    _device = device;
+    std::map<VkQueue, std::mutex*> mutexByQueue;
+
+    for( size_t i = 0; i < _entries.size(); i++ )
+    {
+        const auto& assignment = layout.assignments[i];
+        if( !assignment.has_value() )
+            continue;
+
+        auto& entry = _entries[i];
+        entry.familyIndex = assignment->familyIndex;
+        vkGetDeviceQueue(device, assignment->familyIndex, assignment->queueIndex, &entry.queue);
+
+        auto found = mutexByQueue.find(entry.queue);
+        if( found == mutexByQueue.end() )
+        {
+            _mutexes.push_back(std::make_unique<std::mutex>());
+            found = mutexByQueue.emplace(entry.queue, _mutexes.back().get()).first;
+        }
+        entry.mutex = found->second;
+    }
+}
+
+bool DeviceQueues::isDedicated(QueueType type) const
+{
+    return has(type) && queue(type) != queue(QueueType::Graphics);
+}
+
+VkResult DeviceQueues::submit(QueueType type, uint32_t submitCount, const VkSubmitInfo* submits, VkFence fence)
+{
+    const auto& entry = _entries[static_cast<size_t>(type)];
+    std::lock_guard<std::mutex> lock(*entry.mutex);
+    return vkQueueSubmit(entry.queue, submitCount, submits, fence);
+}
+
+VkResult DeviceQueues::submit(QueueType type, VkCommandBuffer commandBuffer, VkFence fence)
+{
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+
+    return submit(type, 1, &submitInfo, fence);
+}
+
+VkResult DeviceQueues::present(const VkPresentInfoKHR& presentInfo)
+{
+    const auto& entry = _entries[static_cast<size_t>(QueueType::Present)];
+    std::lock_guard<std::mutex> lock(*entry.mutex);
+    return vkQueuePresentKHR(entry.queue, &presentInfo);
+}
+
+VkResult DeviceQueues::waitIdleAll()
+{
+    //taken in one order, and submitters only ever hold one, so this can't deadlock with them
+    std::vector<std::unique_lock<std::mutex>> locks;
+    for (auto& mutex : _mutexes)
+        locks.emplace_back(*mutex);
+    return vkDeviceWaitIdle(_device);
+}
+
+VkResult DeviceQueues::waitIdle(QueueType type)
+{
+    const auto& entry = _entries[static_cast<size_t>(type)];
+    std::lock_guard<std::mutex> lock(*entry.mutex);
+    return vkQueueWaitIdle(entry.queue);
+}
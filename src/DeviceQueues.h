@@ -0,0 +1,84 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+struct QueueFamilyIndices
+{
+    std::optional<uint32_t> graphicsFamily;
+    std::optional<uint32_t> presentFamily;
+    std::optional<uint32_t> computeFamily;  //only set for a compute family without graphics
+    std::optional<uint32_t> transferFamily; //only set for a transfer family without graphics or compute
+    bool requiresPresent = true; //false when running headless, there is no surface to present to
+    std::vector<VkQueueFamilyProperties> properties;
+
+    bool isComplete() const {
+        return graphicsFamily.has_value() && (presentFamily.has_value() || !requiresPresent);
+    }
+};
+
+enum class QueueType
+{
+    Graphics,
+    Compute,
+    Transfer,
+    Present,
+    Count
+};
+
+//the queue we ended up with for each role, several roles may share a family or even a VkQueue
+struct QueueAssignment
+{
+    uint32_t familyIndex = 0;
+    uint32_t queueIndex = 0;
+};
+
+//works out which queues to create, fills in the create infos and where each role lives
+//priorities must outlive the create infos, they point into it
+struct QueueLayout
+{
+    std::array<std::optional<QueueAssignment>, static_cast<size_t>(QueueType::Count)> assignments;
+    std::vector<VkDeviceQueueCreateInfo> createInfos;
+    std::vector<std::vector<float>> priorities;
+
+    static QueueLayout build(const QueueFamilyIndices& indices);
+};
+
+//owns the device queues after creation, submissions go through here so that roles sharing
+//a VkQueue are externally synchronised as the spec requires
+class DeviceQueues
+{
+public:
+    void init(VkDevice device, const QueueLayout& layout);
+
+    VkQueue queue(QueueType type) const { return _entries[static_cast<size_t>(type)].queue; }
+    uint32_t family(QueueType type) const { return _entries[static_cast<size_t>(type)].familyIndex; }
+    bool has(QueueType type) const { return _entries[static_cast<size_t>(type)].queue != VK_NULL_HANDLE; }
+
+    //true when the role got its own VkQueue rather than falling back onto graphics
+    bool isDedicated(QueueType type) const;
+
+    VkResult submit(QueueType type, uint32_t submitCount, const VkSubmitInfo* submits, VkFence fence);
+    VkResult submit(QueueType type, VkCommandBuffer commandBuffer, VkFence fence);
+    VkResult present(const VkPresentInfoKHR& presentInfo);
+    VkResult waitIdle(QueueType type);
+    //vkDeviceWaitIdle, with every queue locked as it requires
+    VkResult waitIdleAll();
+
+private:
+    struct Entry
+    {
+        VkQueue queue = VK_NULL_HANDLE;
+        uint32_t familyIndex = 0;
+        std::mutex* mutex = nullptr;
+    };
+
+    VkDevice _device = VK_NULL_HANDLE;
+    std::array<Entry, static_cast<size_t>(QueueType::Count)> _entries;
+    std::vector<std::unique_ptr<std::mutex>> _mutexes;
+};
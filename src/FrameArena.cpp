@@ -0,0 +1,67 @@
+#include "FrameArena.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+FrameArena::FrameArena(size_t blockSize)
+    : _blockSize(std::max<size_t>(blockSize, 256))
+{
+    addBlock(_blockSize);
+}
+
+void FrameArena::addBlock(size_t minimumSize)
+{
+    Block block;
+    block.size = std::max(minimumSize, _blockSize);
+    block.data.reset(new uint8_t[block.size]);
+    _blocks.push_back(std::move(block));
+
+    _stats.capacity += _blocks.back().size;
+    _stats.blockAllocations++;
+}
+
+void* FrameArena::allocate(size_t size, size_t alignment)
+{
+    if( alignment == 0 || (alignment & (alignment - 1)) != 0 )
+        throw std::runtime_error("frame arena alignment must be a power of two!");
+
+    //new[] only promises max_align_t, so the offset alone can't be trusted to align the pointer
+    auto alignedOffset = [&](const Block& block, size_t offset) {
+        uintptr_t base = reinterpret_cast<uintptr_t>(block.data.get());
+        return static_cast<size_t>(((base + offset + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1)) - base);
+    };
+
+    size_t offset = alignedOffset(_blocks[_current], _offset);
+    if( offset + size > _blocks[_current].size )
+    {
+        //whatever is left at the end of the full block goes to waste until the reset
+        addBlock(size + alignment);
+        _current = _blocks.size() - 1;
+        _offset = 0;
+        offset = alignedOffset(_blocks[_current], 0);
+    }
+
+    _stats.bytes += offset + size - _offset;
+    _stats.allocations++;
+    _offset = offset + size;
+    return _blocks[_current].data.get() + offset;
+}
+
+void FrameArena::reset()
+{
+    _stats.peakBytes = std::max(_stats.peakBytes, _stats.bytes);
+
+    //the frame spilled over, next time it all fits in one
+    if( _blocks.size() > 1 )
+    {
+        size_t total = _stats.capacity;
+        _blocks.clear();
+        _stats.capacity = 0;
+        addBlock(total);
+    }
+
+    _current = 0;
+    _offset = 0;
+    _stats.bytes = 0;
+    _stats.allocations = 0;
+}
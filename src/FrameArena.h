@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+struct FrameArenaStats
+{
+    size_t bytes = 0;            //handed out since the last reset, alignment padding included
+    size_t peakBytes = 0;        //most bytes any one frame has needed
+    size_t capacity = 0;         //across every block
+    uint64_t allocations = 0;    //since the last reset
+    uint64_t blockAllocations = 0; //times the arena itself has gone to the heap, flat once it is warm
+};
+
+//bump allocator for data that only lives until the end of a frame. allocating is a pointer bump, nothing
+//is freed on its own, reset() drops everything at once. running out of room chains another block on,
+//and the next reset() swaps the chain for one block big enough for the whole frame, so after the first
+//few frames a frame never touches the heap.
+//
+//not thread safe, give each thread its own
+class FrameArena
+{
+public:
+    explicit FrameArena(size_t blockSize = 64 * 1024);
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    //uninitialised storage for count Ts, T has to be fine with never having its destructor run
+    template<typename T>
+    T* allocateArray(size_t count)
+    {
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    //everything allocated so far is gone, once the frame that used it is done with it
+    void reset();
+
+    const FrameArenaStats& stats() const { return _stats; }
+
+private:
+    struct Block
+    {
+        std::unique_ptr<uint8_t[]> data;
+        size_t size = 0;
+    };
+
+    void addBlock(size_t minimumSize);
+
+    size_t _blockSize;
+    std::vector<Block> _blocks;
+    size_t _current = 0; //block being bumped through
+    size_t _offset = 0;  //into it
+    FrameArenaStats _stats;
+};
+
+//lets standard containers live in a FrameArena. deallocate does nothing, so a vector that grows leaves its
+//old storage behind until the reset, reserve up front where the size is known
+template<typename T>
+class ArenaAllocator
+{
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(FrameArena& arena) noexcept : _arena(&arena) {}
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : _arena(other.arena()) {}
+
+    T* allocate(size_t count) { return _arena->allocateArray<T>(count); }
+    void deallocate(T*, size_t) noexcept {}
+
+    FrameArena* arena() const { return _arena; }
+
+private:
+    FrameArena* _arena;
+};
+
+template<typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) { return a.arena() == b.arena(); }
+template<typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) { return a.arena() != b.arena(); }
+
+//has to be gone (or at least never touched again) before its arena is reset
+template<typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
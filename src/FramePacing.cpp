@@ -0,0 +1,174 @@
+#include "FramePacing.h"
+
+#include <algorithm>
+#include <initializer_list>
+#include <thread>
+
+bool parsePacingMode(const std::string& name, PacingMode& mode)
+{
+    if( name == "balanced" )
+        mode = PacingMode::Balanced;
+    else if( name == "low-latency" )
+        mode = PacingMode::LowLatency;
+    else if( name == "power-saving" )
+        mode = PacingMode::PowerSaving;
+    else if( name == "throughput" )
+        mode = PacingMode::Throughput;
+    else
+        return false;
+
+    return true;
+}
+
+const char* pacingModeName(PacingMode mode)
+{
+    switch( mode )
+    {
+        case PacingMode::Balanced:    return "balanced";
+        case PacingMode::LowLatency:  return "low-latency";
+        case PacingMode::PowerSaving: return "power-saving";
+        case PacingMode::Throughput:  return "throughput";
+    }
+    return "unknown";
+}
+
+const char* presentModeName(VkPresentModeKHR presentMode)
+{
+    switch( presentMode )
+    {
+        case VK_PRESENT_MODE_IMMEDIATE_KHR:    return "immediate";
+        case VK_PRESENT_MODE_MAILBOX_KHR:      return "mailbox";
+        case VK_PRESENT_MODE_FIFO_KHR:         return "fifo";
+        case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "fifo relaxed";
+        default:                               return "other";
+    }
+}
+
+//first of preferred the surface supports, fifo is always there
+static VkPresentModeKHR pickPresentMode(const std::vector<VkPresentModeKHR>& available, std::initializer_list<VkPresentModeKHR> preferred)
+{
+    for (auto presentMode : preferred)
+    {
+        if( std::find(available.begin(), available.end(), presentMode) != available.end() )
+            return presentMode;
+    }
+
+    return VK_PRESENT_MODE_FIFO_KHR;
+}
+
+PacingPolicy choosePacingPolicy(PacingMode mode, const std::vector<VkPresentModeKHR>& presentModes, const VkSurfaceCapabilitiesKHR& capabilities)
+{
+    PacingPolicy policy;
+    policy.mode = mode;
+
+    uint32_t minImages = std::max(capabilities.minImageCount, 2u);
+
+    switch( mode )
+    {
+        case PacingMode::Balanced:
+            policy.presentMode = pickPresentMode(presentModes, {VK_PRESENT_MODE_MAILBOX_KHR});
+            policy.imageCount = minImages + 1;
+            policy.framesInFlight = 2;
+            break;
+
+        //mailbox replaces a queued image rather than waiting behind it, so a newer frame is what gets
+        //shown. under fifo every extra image is another refresh of queueing, so keep to the minimum.
+        //one frame in flight means the cpu never starts on input the gpu is still a frame behind on
+        case PacingMode::LowLatency:
+            policy.presentMode = pickPresentMode(presentModes, {VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR});
+            policy.imageCount = policy.presentMode == VK_PRESENT_MODE_FIFO_KHR ? minImages : minImages + 1;
+            policy.framesInFlight = 1;
+            break;
+
+        //fifo blocks at the refresh rate, so nothing is rendered only to be thrown away as in mailbox
+        case PacingMode::PowerSaving:
+            policy.presentMode = VK_PRESENT_MODE_FIFO_KHR;
+            policy.imageCount = minImages;
+            policy.framesInFlight = 2;
+            break;
+
+        //never wait on the display, and keep enough in flight that the gpu never runs dry
+        case PacingMode::Throughput:
+            policy.presentMode = pickPresentMode(presentModes, {VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR});
+            policy.imageCount = std::max(minImages + 1, 3u);
+            policy.framesInFlight = 3;
+            break;
+    }
+
+    return policy;
+}
+
+uint32_t swapchainImageCount(const PacingPolicy& policy, const VkSurfaceCapabilitiesKHR& capabilities)
+{
+    uint32_t imageCount = std::max(policy.imageCount, capabilities.minImageCount);
+    if( capabilities.maxImageCount > 0 )
+        imageCount = std::min(imageCount, capabilities.maxImageCount);
+    return imageCount;
+}
+
+FramePacer::FramePacer(double fpsLimit)
+{
+    setFpsLimit(fpsLimit);
+}
+
+void FramePacer::setFpsLimit(double fpsLimit)
+{
+    _fpsLimit = std::max(fpsLimit, 0.0);
+    _framePeriod = _fpsLimit > 0.0
+        ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / _fpsLimit))
+        : Clock::duration::zero();
+    _nextFrame = Clock::now();
+}
+
+void FramePacer::waitForNextFrame()
+{
+    if( _framePeriod == Clock::duration::zero() )
+        return;
+
+    auto start = Clock::now();
+
+    //sleep gets within a scheduler tick, the last stretch is spun out so frames land on time
+    const auto spinThreshold = std::chrono::milliseconds(2);
+    if( _nextFrame - start > spinThreshold )
+        std::this_thread::sleep_for(_nextFrame - start - spinThreshold);
+    while( Clock::now() < _nextFrame )
+        std::this_thread::yield();
+
+    auto now = Clock::now();
+    _stats.limiterSleepMs += std::chrono::duration<double, std::milli>(now - start).count();
+
+    //stays on the cadence unless a frame ran more than a whole period long, then the schedule moves
+    //rather than letting the next few run back to back to catch up
+    _nextFrame += _framePeriod;
+    if( _nextFrame < now )
+        _nextFrame = now + _framePeriod;
+}
+
+void FramePacer::inputSampled()
+{
+    _inputSampled = Clock::now();
+    _hasSample = true;
+}
+
+void FramePacer::presented()
+{
+    if( !_hasSample )
+        return;
+
+    double latencyMs = std::chrono::duration<double, std::milli>(Clock::now() - _inputSampled).count();
+    _hasSample = false;
+
+    _stats.frames++;
+    _totalLatencyMs += latencyMs;
+    _stats.maxLatencyMs = std::max(_stats.maxLatencyMs, latencyMs);
+}
+
+FramePacingStats FramePacer::takeStats()
+{
+    FramePacingStats stats = _stats;
+    stats.averageLatencyMs = stats.frames > 0 ? _totalLatencyMs / stats.frames : 0.0;
+
+    _stats = {};
+    _totalLatencyMs = 0.0;
+    return stats;
+}
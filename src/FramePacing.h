@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//what the swapchain and frame loop are tuned for
+enum class PacingMode
+{
+    Balanced,    //mailbox if there is one, otherwise vsync, two frames in flight
+    LowLatency,  //as little queued up between input and the display as possible
+    PowerSaving, //vsync, nothing rendered that won't be shown
+    Throughput   //as many frames as the gpu can manage, tearing allowed
+};
+
+bool parsePacingMode(const std::string& name, PacingMode& mode);
+const char* pacingModeName(PacingMode mode);
+
+struct PacingPolicy
+{
+    PacingMode mode = PacingMode::Balanced;
+    VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
+    uint32_t imageCount = 0;     //before clamping to the surface, see swapchainImageCount
+    uint32_t framesInFlight = 2;
+};
+
+//presentModes empty when there is no surface (headless), only framesInFlight means anything then
+PacingPolicy choosePacingPolicy(PacingMode mode, const std::vector<VkPresentModeKHR>& presentModes, const VkSurfaceCapabilitiesKHR& capabilities);
+
+//the policy's image count within what the surface allows, capabilities can change on a resize
+uint32_t swapchainImageCount(const PacingPolicy& policy, const VkSurfaceCapabilitiesKHR& capabilities);
+
+const char* presentModeName(VkPresentModeKHR presentMode);
+
+struct FramePacingStats
+{
+    uint32_t frames = 0;
+    double averageLatencyMs = 0.0; //input sampled to present queued
+    double maxLatencyMs = 0.0;
+    double limiterSleepMs = 0.0;   //total time the limiter held frames back
+};
+
+//cpu side frame limiter plus input to present latency tracking. the limiter waits before input is
+//sampled rather than after the frame is submitted, so the time spent waiting doesn't end up as extra
+//latency on the frame that follows it. latency is measured to vkQueuePresentKHR returning: the image
+//still sits in the presentation engine for up to a refresh per queued image after that, which needs
+//VK_GOOGLE_display_timing or VK_KHR_present_wait to see
+class FramePacer
+{
+public:
+    //0 leaves the frame rate to the present mode
+    explicit FramePacer(double fpsLimit = 0.0);
+
+    void setFpsLimit(double fpsLimit);
+    double fpsLimit() const { return _fpsLimit; }
+
+    //blocks until the next frame is due, returns straight away when there is no limit
+    void waitForNextFrame();
+
+    //call right before polling events, the frame being started reacts to input up to this point
+    void inputSampled();
+    //call once the frame that sampled input has been queued for present
+    void presented();
+
+    //since the last call
+    FramePacingStats takeStats();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    double _fpsLimit = 0.0;
+    Clock::duration _framePeriod = Clock::duration::zero();
+    Clock::time_point _nextFrame;
+    bool _hasSample = false;
+    Clock::time_point _inputSampled;
+
+    FramePacingStats _stats;
+    double _totalLatencyMs = 0.0;
+};
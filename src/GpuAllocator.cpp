@@ -0,0 +1,515 @@
+#include "GpuAllocator.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <stdexcept>
+
+static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+}
+
+static double toMiB(VkDeviceSize bytes)
+{
+    return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+GpuMemoryBackend GpuMemoryBackend::fromDevice(VkDevice device)
+{
+    GpuMemoryBackend backend;
+
+    backend.allocate = [device](uint32_t memoryTypeIndex, VkDeviceSize size, VkDeviceMemory* memory) {
+        VkMemoryAllocateInfo allocInfo = {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = size;
+        allocInfo.memoryTypeIndex = memoryTypeIndex;
+        return vkAllocateMemory(device, &allocInfo, nullptr, memory);
+    };
+    backend.free = [device](VkDeviceMemory memory) {
+        vkFreeMemory(device, memory, nullptr);
+    };
+    backend.map = [device](VkDeviceMemory memory, void** data) {
+        return vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, data);
+    };
+    backend.unmap = [device](VkDeviceMemory memory) {
+        vkUnmapMemory(device, memory);
+    };
+
+    return backend;
+}
+
+GpuAllocator::GpuAllocator(const VkPhysicalDeviceMemoryProperties& memoryProperties, GpuMemoryBackend backend, VkDeviceSize preferredBlockSize)
+    : _memoryProperties(memoryProperties)
+    , _backend(std::move(backend))
+    , _blockSize(MIN_ALLOCATION_SIZE)
+{
+    //buddy blocks have to be a power of two
+    while( _blockSize < preferredBlockSize )
+        _blockSize <<= 1;
+}
+
+GpuAllocator::~GpuAllocator()
+{
+    for( uint32_t i = 0; i < _blocks.size(); i++ )
+    {
+        if( _blocks[i] )
+            releaseBlock(i);
+    }
+
+    for( auto& dedicated : _dedicatedAllocations )
+    {
+        if( dedicated.second.mapped != nullptr )
+            _backend.unmap(dedicated.first);
+        _backend.free(dedicated.first);
+    }
+}
+
+uint32_t GpuAllocator::findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred) const
+{
+    uint32_t best = UINT32_MAX;
+    int bestScore = -1;
+
+    for( uint32_t i = 0; i < _memoryProperties.memoryTypeCount; i++ )
+    {
+        VkMemoryPropertyFlags flags = _memoryProperties.memoryTypes[i].propertyFlags;
+        if( !(typeBits & (1u << i)) || (flags & required) != required )
+            continue;
+
+        //count matching preferred bits, the spec orders types so the first of equal score is the better one
+        int score = 0;
+        for( VkMemoryPropertyFlags bit = 1; bit != 0 && bit <= preferred; bit <<= 1 )
+        {
+            if( (preferred & bit) && (flags & bit) )
+                score++;
+        }
+
+        if( score > bestScore )
+        {
+            best = i;
+            bestScore = score;
+        }
+    }
+
+    if( best == UINT32_MAX )
+        throw std::runtime_error("failed to find suitable memory type!");
+
+    return best;
+}
+
+uint32_t GpuAllocator::orderForSize(VkDeviceSize size)
+{
+    uint32_t order = 0;
+    VkDeviceSize rangeSize = MIN_ALLOCATION_SIZE;
+    while( rangeSize < size )
+    {
+        rangeSize <<= 1;
+        order++;
+    }
+    return order;
+}
+
+bool GpuAllocator::isHostVisible(uint32_t memoryTypeIndex) const
+{
+    return (_memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+}
+
+GpuAllocation GpuAllocator::allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags required, GpuResourceKind kind,
+    VkMemoryPropertyFlags preferred, uint64_t userData)
+{
+    uint32_t memoryTypeIndex = findMemoryType(requirements.memoryTypeBits, required, preferred);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    //big resources would waste most of a block to internal fragmentation, give them their own memory
+    VkDeviceSize rangeSize = MIN_ALLOCATION_SIZE << orderForSize(std::max(requirements.size, requirements.alignment));
+    if( rangeSize > _blockSize / 2 )
+        return allocateDedicated(memoryTypeIndex, requirements.size, userData);
+
+    GpuAllocation allocation;
+    for( uint32_t i = 0; i < _blocks.size(); i++ )
+    {
+        const auto& block = _blocks[i];
+        if( !block || block->memoryTypeIndex != memoryTypeIndex || block->kind != kind )
+            continue;
+
+        if( allocateFromBlock(i, requirements.size, requirements.alignment, userData, allocation) )
+            return allocation;
+    }
+
+    uint32_t blockIndex = createBlock(memoryTypeIndex, kind);
+    if( !allocateFromBlock(blockIndex, requirements.size, requirements.alignment, userData, allocation) )
+        throw std::runtime_error("failed to sub-allocate from a fresh memory block!");
+
+    return allocation;
+}
+
+void GpuAllocator::free(GpuAllocation& allocation)
+{
+    if( !allocation.isValid() )
+        return;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if( allocation.dedicated )
+    {
+        if( allocation.mapped != nullptr )
+            _backend.unmap(allocation.memory);
+        _backend.free(allocation.memory);
+        _dedicatedAllocations.erase(allocation.memory);
+    }
+    else
+    {
+        freeFromBlock(allocation);
+
+        //keep one empty block per memory type around so a free/allocate pair doesn't thrash vkAllocateMemory,
+        //this one only goes if another is already empty
+        auto& block = _blocks[allocation.blockIndex];
+        if( block->allocations.empty() )
+        {
+            for( uint32_t i = 0; i < _blocks.size(); i++ )
+            {
+                if( i != allocation.blockIndex && _blocks[i] && _blocks[i]->memoryTypeIndex == block->memoryTypeIndex && _blocks[i]->kind == block->kind
+                    && _blocks[i]->allocations.empty() )
+                {
+                    releaseBlock(allocation.blockIndex);
+                    break;
+                }
+            }
+        }
+    }
+
+    allocation = GpuAllocation();
+}
+
+uint32_t GpuAllocator::createBlock(uint32_t memoryTypeIndex, GpuResourceKind kind)
+{
+    auto block = std::make_unique<Block>();
+    block->memoryTypeIndex = memoryTypeIndex;
+    block->kind = kind;
+    block->size = _blockSize;
+    block->maxOrder = orderForSize(_blockSize);
+    block->freeLists.resize(block->maxOrder + 1);
+    block->freeLists[block->maxOrder].insert(0);
+
+    if( _backend.allocate(memoryTypeIndex, block->size, &block->memory) != VK_SUCCESS )
+        throw std::runtime_error("failed to allocate memory block!");
+
+    //host visible blocks stay mapped for their whole life, mapping per allocation is not allowed to overlap anyway
+    if( isHostVisible(memoryTypeIndex) && _backend.map(block->memory, &block->mapped) != VK_SUCCESS )
+        throw std::runtime_error("failed to map memory block!");
+
+    for( uint32_t i = 0; i < _blocks.size(); i++ )
+    {
+        if( !_blocks[i] )
+        {
+            _blocks[i] = std::move(block);
+            return i;
+        }
+    }
+
+    _blocks.push_back(std::move(block));
+    return static_cast<uint32_t>(_blocks.size() - 1);
+}
+
+void GpuAllocator::releaseBlock(uint32_t blockIndex)
+{
+    auto& block = _blocks[blockIndex];
+    if( block->mapped != nullptr )
+        _backend.unmap(block->memory);
+    _backend.free(block->memory);
+    block.reset();
+}
+
+bool GpuAllocator::allocateFromBlock(uint32_t blockIndex, VkDeviceSize size, VkDeviceSize alignment, uint64_t userData, GpuAllocation& allocation)
+{
+    auto& block = *_blocks[blockIndex];
+
+    //ranges sit on multiples of their own size, so rounding up to the alignment is all it takes to satisfy it
+    uint32_t order = orderForSize(std::max(size, alignment));
+    if( order > block.maxOrder )
+        return false;
+
+    uint32_t foundOrder = order;
+    while( foundOrder <= block.maxOrder && block.freeLists[foundOrder].empty() )
+        foundOrder++;
+
+    if( foundOrder > block.maxOrder )
+        return false;
+
+    //lowest offset first keeps allocations packed towards the start of the block
+    VkDeviceSize offset = *block.freeLists[foundOrder].begin();
+    block.freeLists[foundOrder].erase(block.freeLists[foundOrder].begin());
+
+    //split down to the size we want, handing the upper halves back as free buddies
+    while( foundOrder > order )
+    {
+        foundOrder--;
+        block.freeLists[foundOrder].insert(offset + (MIN_ALLOCATION_SIZE << foundOrder));
+    }
+
+    allocation = GpuAllocation();
+    allocation.memory = block.memory;
+    allocation.offset = offset;
+    allocation.size = size;
+    allocation.mapped = block.mapped != nullptr ? static_cast<char*>(block.mapped) + offset : nullptr;
+    allocation.memoryTypeIndex = block.memoryTypeIndex;
+    allocation.userData = userData;
+    allocation.blockIndex = blockIndex;
+    allocation.order = order;
+
+    block.allocations[offset] = allocation;
+    block.reservedBytes += MIN_ALLOCATION_SIZE << order;
+
+    return true;
+}
+
+void GpuAllocator::freeFromBlock(const GpuAllocation& allocation)
+{
+    auto& block = *_blocks[allocation.blockIndex];
+
+    if( block.allocations.erase(allocation.offset) == 0 )
+        throw std::runtime_error("freeing memory that was not allocated from this block!");
+
+    block.reservedBytes -= MIN_ALLOCATION_SIZE << allocation.order;
+
+    //merge with the buddy for as long as it is free too
+    VkDeviceSize offset = allocation.offset;
+    uint32_t order = allocation.order;
+    while( order < block.maxOrder )
+    {
+        VkDeviceSize buddy = offset ^ (MIN_ALLOCATION_SIZE << order);
+        if( block.freeLists[order].erase(buddy) == 0 )
+            break;
+
+        offset = std::min(offset, buddy);
+        order++;
+    }
+
+    block.freeLists[order].insert(offset);
+}
+
+GpuAllocation GpuAllocator::allocateDedicated(uint32_t memoryTypeIndex, VkDeviceSize size, uint64_t userData)
+{
+    GpuAllocation allocation;
+    allocation.size = size;
+    allocation.memoryTypeIndex = memoryTypeIndex;
+    allocation.userData = userData;
+    allocation.dedicated = true;
+
+    if( _backend.allocate(memoryTypeIndex, size, &allocation.memory) != VK_SUCCESS )
+        throw std::runtime_error("failed to allocate dedicated memory!");
+
+    if( isHostVisible(memoryTypeIndex) && _backend.map(allocation.memory, &allocation.mapped) != VK_SUCCESS )
+        throw std::runtime_error("failed to map dedicated memory!");
+
+    _dedicatedAllocations[allocation.memory] = allocation;
+    return allocation;
+}
+
+std::vector<GpuDefragMove> GpuAllocator::defragment(VkDeviceSize maxBytesToMove)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    std::vector<GpuDefragMove> moves;
+    VkDeviceSize bytesMoved = 0;
+
+    //blocks only ever trade allocations with blocks of the same memory type and resource kind
+    std::map<std::pair<uint32_t, GpuResourceKind>, std::vector<uint32_t>> groups;
+    for( uint32_t i = 0; i < _blocks.size(); i++ )
+    {
+        if( _blocks[i] )
+            groups[std::make_pair(_blocks[i]->memoryTypeIndex, _blocks[i]->kind)].push_back(i);
+    }
+
+    for( auto& group : groups )
+    {
+        auto& blockIndices = group.second;
+        if( blockIndices.size() < 2 )
+            continue;
+
+        std::sort(blockIndices.begin(), blockIndices.end(), [this](uint32_t a, uint32_t b) {
+            return _blocks[a]->reservedBytes < _blocks[b]->reservedBytes;
+        });
+
+        //drain the emptiest blocks into the fullest ones, never the other way round. a block that has been
+        //given allocations this pass can't be a source too, its new ones aren't copied in yet and moving
+        //them again would chain copies
+        std::set<uint32_t> received;
+        for( size_t source = 0; source + 1 < blockIndices.size(); source++ )
+        {
+            if( received.count(blockIndices[source]) > 0 )
+                continue;
+
+            auto& sourceBlock = *_blocks[blockIndices[source]];
+
+            //copy, the destination allocations below don't touch this block but we still iterate a snapshot
+            std::vector<GpuAllocation> candidates;
+            for( const auto& entry : sourceBlock.allocations )
+                candidates.push_back(entry.second);
+
+            std::sort(candidates.begin(), candidates.end(), [](const GpuAllocation& a, const GpuAllocation& b) {
+                return a.order > b.order;
+            });
+
+            for( const auto& candidate : candidates )
+            {
+                if( bytesMoved + candidate.size > maxBytesToMove )
+                    return moves;
+
+                for( size_t destination = blockIndices.size() - 1; destination > source; destination-- )
+                {
+                    GpuAllocation moved;
+                    if( allocateFromBlock(blockIndices[destination], candidate.size, MIN_ALLOCATION_SIZE << candidate.order, candidate.userData, moved) )
+                    {
+                        moves.push_back({candidate, moved});
+                        bytesMoved += candidate.size;
+                        received.insert(blockIndices[destination]);
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    return moves;
+}
+
+void GpuAllocator::commitDefragmentation(const std::vector<GpuDefragMove>& moves)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for( const auto& move : moves )
+        freeFromBlock(move.from);
+
+    //whatever got fully drained can go back to the driver, keeping one spare per memory type like free() does
+    std::set<std::pair<uint32_t, GpuResourceKind>> keptEmpty;
+    for( uint32_t i = 0; i < _blocks.size(); i++ )
+    {
+        if( !_blocks[i] || !_blocks[i]->allocations.empty() )
+            continue;
+
+        auto key = std::make_pair(_blocks[i]->memoryTypeIndex, _blocks[i]->kind);
+        if( !keptEmpty.insert(key).second )
+            releaseBlock(i);
+    }
+}
+
+GpuAllocatorStats GpuAllocator::stats() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    GpuAllocatorStats stats;
+    VkDeviceSize totalFree = 0;
+    double weightedFragmentation = 0.0;
+
+    for( const auto& block : _blocks )
+    {
+        if( !block )
+            continue;
+
+        stats.blockCount++;
+        stats.blockBytes += block->size;
+        stats.reservedBytes += block->reservedBytes;
+        stats.allocationCount += static_cast<uint32_t>(block->allocations.size());
+        for( const auto& entry : block->allocations )
+            stats.usedBytes += entry.second.size;
+
+        VkDeviceSize largestFree = 0;
+        for( uint32_t order = 0; order <= block->maxOrder; order++ )
+        {
+            if( !block->freeLists[order].empty() )
+                largestFree = MIN_ALLOCATION_SIZE << order;
+        }
+
+        VkDeviceSize blockFree = block->size - block->reservedBytes;
+        if( blockFree > 0 )
+            weightedFragmentation += (1.0 - static_cast<double>(largestFree) / static_cast<double>(blockFree)) * static_cast<double>(blockFree);
+
+        totalFree += blockFree;
+        stats.largestFreeRange = std::max(stats.largestFreeRange, largestFree);
+    }
+
+    for( const auto& dedicated : _dedicatedAllocations )
+    {
+        stats.dedicatedAllocationCount++;
+        stats.dedicatedBytes += dedicated.second.size;
+        stats.usedBytes += dedicated.second.size;
+        stats.reservedBytes += dedicated.second.size;
+    }
+    stats.allocationCount += stats.dedicatedAllocationCount;
+
+    if( totalFree > 0 )
+        stats.fragmentation = static_cast<float>(weightedFragmentation / static_cast<double>(totalFree));
+
+    return stats;
+}
+
+void GpuAllocator::printStats(std::ostream& out) const
+{
+    auto current = stats();
+
+    out << std::fixed << std::setprecision(1);
+    out << "GPU Memory:" << std::endl;
+    out << "\tblocks: " << current.blockCount << " (" << toMiB(current.blockBytes) << " MiB), dedicated: "
+        << current.dedicatedAllocationCount << " (" << toMiB(current.dedicatedBytes) << " MiB)" << std::endl;
+    out << "\tallocations: " << current.allocationCount << ", used " << toMiB(current.usedBytes) << " MiB, reserved "
+        << toMiB(current.reservedBytes) << " MiB" << std::endl;
+    out << "\tlargest free range: " << toMiB(current.largestFreeRange) << " MiB, fragmentation: "
+        << (current.fragmentation * 100.f) << "%" << std::endl;
+    out << std::defaultfloat;
+}
+
+GpuLinearPool::GpuLinearPool(GpuAllocator& allocator, VkDeviceSize capacity, uint32_t memoryTypeIndex)
+    : _allocator(allocator)
+    , _capacity(alignUp(capacity, GpuAllocator::MIN_ALLOCATION_SIZE))
+{
+    VkMemoryRequirements requirements = {};
+    requirements.size = _capacity;
+    requirements.alignment = GpuAllocator::MIN_ALLOCATION_SIZE;
+    requirements.memoryTypeBits = 1u << memoryTypeIndex;
+
+    _block = _allocator.allocate(requirements, 0, GpuResourceKind::Buffer);
+}
+
+GpuLinearPool::~GpuLinearPool()
+{
+    _allocator.free(_block);
+}
+
+bool GpuLinearPool::allocate(VkDeviceSize size, VkDeviceSize alignment, GpuAllocation& allocation)
+{
+    if( size > _capacity )
+        return false;
+
+    VkDeviceSize offset = static_cast<VkDeviceSize>(_head % _capacity);
+    uint64_t lapStart = _head - offset;
+
+    offset = alignUp(offset, alignment);
+    if( offset + size > _capacity )
+    {
+        //doesn't fit before the end, skip the tail of this lap and start again at the front
+        lapStart += _capacity;
+        offset = 0;
+
+        //with nothing in use the skipped tail isn't in anyone's way
+        if( _tail == _head )
+            _tail = lapStart;
+    }
+
+    uint64_t start = lapStart + offset;
+    if( start + size - _tail > _capacity )
+        return false;
+
+    _head = start + size;
+
+    allocation = _block;
+    allocation.offset = _block.offset + offset;
+    allocation.size = size;
+    allocation.mapped = _block.mapped != nullptr ? static_cast<char*>(_block.mapped) + offset : nullptr;
+    return true;
+}
+
+void GpuLinearPool::releaseUpTo(uint64_t marker)
+{
+    _tail = std::max(_tail, std::min(marker, _head));
+}
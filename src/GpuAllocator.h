@@ -0,0 +1,158 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <set>
+#include <vector>
+
+//the only place the allocator touches the device, swap it out to run the allocator without a GPU
+struct GpuMemoryBackend
+{
+    std::function<VkResult(uint32_t memoryTypeIndex, VkDeviceSize size, VkDeviceMemory* memory)> allocate;
+    std::function<void(VkDeviceMemory memory)> free;
+    std::function<VkResult(VkDeviceMemory memory, void** data)> map;
+    std::function<void(VkDeviceMemory memory)> unmap;
+
+    static GpuMemoryBackend fromDevice(VkDevice device);
+};
+
+//buffers and optimal images are kept in separate blocks so bufferImageGranularity never matters
+enum class GpuResourceKind
+{
+    Buffer,
+    Image
+};
+
+struct GpuAllocation
+{
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    void* mapped = nullptr; //already offset, null unless the memory is host visible
+    uint32_t memoryTypeIndex = 0;
+    uint64_t userData = 0;
+
+    //bookkeeping for free(), don't touch
+    uint32_t blockIndex = 0;
+    uint32_t order = 0;
+    bool dedicated = false;
+
+    bool isValid() const { return memory != VK_NULL_HANDLE; }
+};
+
+//a proposed relocation from defragment(), copy the contents from -> to then commit
+struct GpuDefragMove
+{
+    GpuAllocation from;
+    GpuAllocation to;
+};
+
+struct GpuAllocatorStats
+{
+    uint32_t blockCount = 0;
+    uint32_t allocationCount = 0;
+    uint32_t dedicatedAllocationCount = 0;
+    VkDeviceSize blockBytes = 0;      //memory held in sub-allocated blocks
+    VkDeviceSize dedicatedBytes = 0;  //memory held by dedicated allocations
+    VkDeviceSize usedBytes = 0;       //what callers asked for
+    VkDeviceSize reservedBytes = 0;   //what that cost after rounding up to buddy sizes
+    VkDeviceSize largestFreeRange = 0;
+    float fragmentation = 0.f;        //0 when all free space in a block is one range, approaches 1 as it splinters
+};
+
+//sub-allocates resources out of large per memory type blocks using a buddy allocator,
+//anything bigger than half a block gets its own vkAllocateMemory
+class GpuAllocator
+{
+public:
+    static const VkDeviceSize MIN_ALLOCATION_SIZE = 256;
+    static const VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+    GpuAllocator(const VkPhysicalDeviceMemoryProperties& memoryProperties, GpuMemoryBackend backend, VkDeviceSize preferredBlockSize = DEFAULT_BLOCK_SIZE);
+    ~GpuAllocator();
+
+    GpuAllocator(const GpuAllocator&) = delete;
+    GpuAllocator& operator=(const GpuAllocator&) = delete;
+
+    //picks a memory type with all of the required flags, favouring ones that also have the preferred flags
+    uint32_t findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred = 0) const;
+
+    GpuAllocation allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags required, GpuResourceKind kind,
+        VkMemoryPropertyFlags preferred = 0, uint64_t userData = 0);
+    void free(GpuAllocation& allocation);
+
+    //moves allocations out of the emptiest blocks into fuller ones, up to maxBytesToMove.
+    //nothing is freed until commitDefragmentation, so the caller has time to copy and rebind
+    std::vector<GpuDefragMove> defragment(VkDeviceSize maxBytesToMove);
+    void commitDefragmentation(const std::vector<GpuDefragMove>& moves);
+
+    GpuAllocatorStats stats() const;
+    void printStats(std::ostream& out) const;
+
+    const VkPhysicalDeviceMemoryProperties& memoryProperties() const { return _memoryProperties; }
+
+private:
+    struct Block
+    {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        void* mapped = nullptr;
+        VkDeviceSize size = 0;
+        uint32_t memoryTypeIndex = 0;
+        GpuResourceKind kind = GpuResourceKind::Buffer;
+        uint32_t maxOrder = 0;
+        std::vector<std::set<VkDeviceSize>> freeLists; //one per order, offsets of free ranges of MIN_ALLOCATION_SIZE << order
+        std::map<VkDeviceSize, GpuAllocation> allocations;
+        VkDeviceSize reservedBytes = 0;
+    };
+
+    uint32_t createBlock(uint32_t memoryTypeIndex, GpuResourceKind kind);
+    void releaseBlock(uint32_t blockIndex);
+    bool allocateFromBlock(uint32_t blockIndex, VkDeviceSize size, VkDeviceSize alignment, uint64_t userData, GpuAllocation& allocation);
+    void freeFromBlock(const GpuAllocation& allocation);
+    GpuAllocation allocateDedicated(uint32_t memoryTypeIndex, VkDeviceSize size, uint64_t userData);
+    bool isHostVisible(uint32_t memoryTypeIndex) const;
+    static uint32_t orderForSize(VkDeviceSize size);
+
+    VkPhysicalDeviceMemoryProperties _memoryProperties;
+    GpuMemoryBackend _backend;
+    VkDeviceSize _blockSize;
+    std::vector<std::unique_ptr<Block>> _blocks; //null slots are reused
+    std::map<VkDeviceMemory, GpuAllocation> _dedicatedAllocations;
+    mutable std::mutex _mutex;
+};
+
+//bump allocator over one block of memory for per frame transient data.
+//positions only ever grow, so it doubles as a ring: remember marker() at the end of a frame
+//and releaseUpTo() it once that frame's fence has signalled
+class GpuLinearPool
+{
+public:
+    GpuLinearPool(GpuAllocator& allocator, VkDeviceSize capacity, uint32_t memoryTypeIndex);
+    ~GpuLinearPool();
+
+    GpuLinearPool(const GpuLinearPool&) = delete;
+    GpuLinearPool& operator=(const GpuLinearPool&) = delete;
+
+    //false when the pool is full, ranges never straddle the end of the pool
+    bool allocate(VkDeviceSize size, VkDeviceSize alignment, GpuAllocation& allocation);
+
+    uint64_t marker() const { return _head; }
+    void releaseUpTo(uint64_t marker);
+    void reset() { _tail = _head; }
+
+    VkDeviceSize capacity() const { return _capacity; }
+    VkDeviceSize usedBytes() const { return static_cast<VkDeviceSize>(_head - _tail); }
+    const GpuAllocation& block() const { return _block; }
+
+private:
+    GpuAllocator& _allocator;
+    GpuAllocation _block;
+    VkDeviceSize _capacity;
+    uint64_t _head = 0;
+    uint64_t _tail = 0;
+};
@@ -0,0 +1,328 @@
+#include "GpuScene.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    //cull.comp's local_size_x
+    const uint32_t CULL_GROUP_SIZE = 64;
+
+    //the draw count sits in front of the commands, padded so they start 16 byte aligned
+    const VkDeviceSize DRAW_COMMANDS_OFFSET = 16;
+
+    const uint32_t MIN_MESH_SIDES = 3;
+    const uint32_t MAX_MESH_SIDES = 8;
+
+    //matches the push constants in cull.comp
+    struct CullPushConstants
+    {
+        float planes[6][4]; //xyz inward normal, w distance
+        BindlessHandle instanceBuffer;
+        BindlessHandle meshBuffer;
+        BindlessHandle drawBuffer;
+        uint32_t instanceCount;
+        uint32_t firstInstance; //of this frame's range of the instance ring
+    };
+
+    //matches the push constants in instanced.vert
+    struct DrawPushConstants
+    {
+        float view[4]; //xy centre, zw 1 / half extent
+        BindlessHandle instanceBuffer;
+        BindlessHandle vertexBuffer;
+    };
+
+    static_assert(sizeof(CullPushConstants) <= BINDLESS_PUSH_CONSTANT_SIZE, "cull push constants don't fit");
+    static_assert(sizeof(DrawPushConstants) <= BINDLESS_PUSH_CONSTANT_SIZE, "draw push constants don't fit");
+
+    void setPlane(float plane[4], float x, float y, float z, float w)
+    {
+        plane[0] = x;
+        plane[1] = y;
+        plane[2] = z;
+        plane[3] = w;
+    }
+}
+
+GpuScene::GpuScene(VkDevice device, GpuAllocator& allocator, UploadRing& uploads, BindlessHeap& bindless,
+    const std::vector<uint32_t>& sharedFamilies, uint32_t frameSlots, uint32_t maxInstances, bool drawIndirectCount)
+    : _device(device), _allocator(allocator), _uploads(uploads), _bindless(bindless), _sharedFamilies(sharedFamilies),
+      _maxInstances(std::max(maxInstances, 1u))
+{
+    if( drawIndirectCount )
+    {
+        _drawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(vkGetDeviceProcAddr(_device, "vkCmdDrawIndexedIndirectCountKHR"));
+        if( _drawIndexedIndirectCount == nullptr )
+            throw std::runtime_error("failed to load vkCmdDrawIndexedIndirectCountKHR!");
+    }
+
+    std::vector<float> vertices;
+    std::vector<uint32_t> indices;
+    createMeshes(vertices, indices);
+
+    VkDeviceSize vertexSize = vertices.size() * sizeof(float);
+    VkDeviceSize indexSize = indices.size() * sizeof(uint32_t);
+    VkDeviceSize meshSize = _meshes.size() * sizeof(GpuMesh);
+
+    //vertices are pulled in the shader through the heap, only the indices go through the fixed function path
+    _vertexBuffer = createBuffer(vertexSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, _vertexMemory);
+    _indexBuffer = createBuffer(indexSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, _indexMemory);
+    _meshBuffer = createBuffer(meshSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, _meshMemory);
+
+    _uploads.uploadBuffer(_vertexBuffer, 0, vertices.data(), vertexSize);
+    _uploads.uploadBuffer(_indexBuffer, 0, indices.data(), indexSize);
+    _uploads.uploadBuffer(_meshBuffer, 0, _meshes.data(), meshSize);
+
+    //instances are written by the cpu every frame, each frame takes a range of a ring big enough for every
+    //slot's worst case at once. it lives in device local memory where the host can map it (resizable bar),
+    //otherwise wherever the gpu reads it over the bus
+    createInstanceRing(frameSlots);
+
+    //every frame slot culls into its own commands, sized for the worst case of everything visible
+    VkDeviceSize drawBufferSize = DRAW_COMMANDS_OFFSET + static_cast<VkDeviceSize>(_maxInstances) * sizeof(VkDrawIndexedIndirectCommand);
+    _slots.resize(frameSlots);
+    for (auto& slot : _slots)
+    {
+        slot.drawBuffer = createBuffer(drawBufferSize,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, slot.drawMemory);
+        slot.drawHandle = _bindless.addBuffer(slot.drawBuffer);
+    }
+
+    //cached where there is such a thing, this is only ever read by the cpu
+    _readbackBuffer = createBuffer(sizeof(uint32_t) * frameSlots, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, _readbackMemory, VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+
+    _vertexHandle = _bindless.addBuffer(_vertexBuffer);
+    _meshHandle = _bindless.addBuffer(_meshBuffer);
+
+    //all static, waiting once here beats tracking when each buffer is first safe to read
+    _uploads.waitIdle();
+}
+
+GpuScene::~GpuScene()
+{
+    //only destroyed once the device is idle, so the handles can go straight back
+    _bindless.releaseBuffer(_vertexHandle, 0);
+    _bindless.releaseBuffer(_meshHandle, 0);
+
+    _bindless.releaseBuffer(_instanceHandle, 0);
+    vkDestroyBuffer(_device, _instanceBuffer, nullptr);
+    _instancePool.reset();
+
+    for (auto& slot : _slots)
+    {
+        _bindless.releaseBuffer(slot.drawHandle, 0);
+        vkDestroyBuffer(_device, slot.drawBuffer, nullptr);
+        _allocator.free(slot.drawMemory);
+    }
+
+    for (auto buffer : {_vertexBuffer, _indexBuffer, _meshBuffer, _readbackBuffer})
+        vkDestroyBuffer(_device, buffer, nullptr);
+    for (auto* memory : {&_vertexMemory, &_indexMemory, &_meshMemory, &_readbackMemory})
+        _allocator.free(*memory);
+}
+
+VkBuffer GpuScene::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, GpuAllocation& memory,
+    VkMemoryPropertyFlags preferred)
+{
+    VkBufferCreateInfo bufferInfo = {};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = size;
+    bufferInfo.usage = usage;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    //anything the upload ring writes may be written from another family than the one reading it
+    if( (usage & VK_BUFFER_USAGE_TRANSFER_DST_BIT) && _sharedFamilies.size() > 1 )
+    {
+        bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        bufferInfo.queueFamilyIndexCount = static_cast<uint32_t>(_sharedFamilies.size());
+        bufferInfo.pQueueFamilyIndices = _sharedFamilies.data();
+    }
+
+    VkBuffer buffer = VK_NULL_HANDLE;
+    if (vkCreateBuffer(_device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
+        throw std::runtime_error("failed to create scene buffer!");
+
+    VkMemoryRequirements memoryRequirements = {};
+    vkGetBufferMemoryRequirements(_device, buffer, &memoryRequirements);
+
+    memory = _allocator.allocate(memoryRequirements, properties, GpuResourceKind::Buffer, preferred);
+    vkBindBufferMemory(_device, buffer, memory.memory, memory.offset);
+    return buffer;
+}
+
+void GpuScene::createInstanceRing(uint32_t frameSlots)
+{
+    //whole multiples of the pool's granularity, so the pool never hands out a range past the end of the buffer
+    VkDeviceSize bytes = static_cast<VkDeviceSize>(frameSlots) * _maxInstances * sizeof(GpuInstance);
+    bytes = (bytes + GpuAllocator::MIN_ALLOCATION_SIZE - 1) / GpuAllocator::MIN_ALLOCATION_SIZE * GpuAllocator::MIN_ALLOCATION_SIZE;
+
+    VkBufferCreateInfo bufferInfo = {};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = bytes;
+    bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateBuffer(_device, &bufferInfo, nullptr, &_instanceBuffer) != VK_SUCCESS)
+        throw std::runtime_error("failed to create scene instance buffer!");
+
+    VkMemoryRequirements memoryRequirements = {};
+    vkGetBufferMemoryRequirements(_device, _instanceBuffer, &memoryRequirements);
+    uint32_t memoryType = _allocator.findMemoryType(memoryRequirements.memoryTypeBits,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    _instancePool = std::make_unique<GpuLinearPool>(_allocator, bytes, memoryType);
+    const GpuAllocation& block = _instancePool->block();
+    if( memoryRequirements.size > _instancePool->capacity() || block.offset % memoryRequirements.alignment != 0 )
+        throw std::runtime_error("scene instance ring doesn't meet the buffer's memory requirements!");
+
+    vkBindBufferMemory(_device, _instanceBuffer, block.memory, block.offset);
+    _instanceHandle = _bindless.addBuffer(_instanceBuffer);
+}
+
+//regular polygons with 3 to 8 sides, fanned from their first vertex. wound the same way as the
+//tutorial triangle, clockwise on screen
+void GpuScene::createMeshes(std::vector<float>& vertices, std::vector<uint32_t>& indices)
+{
+    const float pi = 3.14159265358979f;
+
+    for (uint32_t sides = MIN_MESH_SIDES; sides <= MAX_MESH_SIDES; sides++)
+    {
+        GpuMesh mesh = {};
+        mesh.firstIndex = static_cast<uint32_t>(indices.size());
+        mesh.vertexOffset = static_cast<int32_t>(vertices.size() / 2);
+        mesh.radius = 1.f;
+
+        for (uint32_t i = 0; i < sides; i++)
+        {
+            float angle = -0.5f * pi + 2.f * pi * i / sides;
+            vertices.push_back(std::cos(angle));
+            vertices.push_back(std::sin(angle));
+        }
+
+        for (uint32_t i = 1; i + 1 < sides; i++)
+        {
+            indices.push_back(0);
+            indices.push_back(i);
+            indices.push_back(i + 1);
+        }
+
+        mesh.indexCount = static_cast<uint32_t>(indices.size()) - mesh.firstIndex;
+        _meshes.push_back(mesh);
+    }
+}
+
+GpuInstance* GpuScene::instances(uint32_t frameSlot)
+{
+    return static_cast<GpuInstance*>(_slots[frameSlot].instances.mapped);
+}
+
+void GpuScene::setInstanceCount(uint32_t frameSlot, uint32_t count)
+{
+    _slots[frameSlot].instanceCount = std::min(count, _maxInstances);
+}
+
+void GpuScene::collect(uint32_t frameSlot)
+{
+    auto& slot = _slots[frameSlot];
+    if( slot.submitted )
+    {
+        std::memcpy(&_lastVisible, static_cast<const uint8_t*>(_readbackMemory.mapped) + frameSlot * sizeof(uint32_t), sizeof(uint32_t));
+        _lastInstances = slot.instanceCount;
+        slot.submitted = false;
+
+        //frames finish in the order they were submitted, so everything taken up to this slot's range is done with
+        _instancePool->releaseUpTo(slot.instanceMarker);
+        slot.instances = GpuAllocation();
+    }
+
+    //a frame that gave up before submitting keeps the range it already has
+    if( !slot.instances.isValid() )
+    {
+        if( !_instancePool->allocate(static_cast<VkDeviceSize>(_maxInstances) * sizeof(GpuInstance), sizeof(GpuInstance), slot.instances) )
+            throw std::runtime_error("scene instance ring is full!");
+        slot.instanceMarker = _instancePool->marker();
+        slot.firstInstance = static_cast<uint32_t>((slot.instances.offset - _instancePool->block().offset) / sizeof(GpuInstance));
+    }
+}
+
+RenderGraphResource GpuScene::addPasses(RenderGraph& graph, uint32_t frameSlot, VkPipeline pipeline, const SceneView& view)
+{
+    auto& slot = _slots[frameSlot];
+    slot.submitted = true;
+
+    //the slot's previous frame is done with both, its fence has been waited on
+    auto drawBuffer = graph.importBuffer("scene draws", slot.drawBuffer);
+    auto readbackBuffer = graph.importBuffer("scene readback", _readbackBuffer);
+    graph.exportResource(readbackBuffer, RenderGraphAccess::HostRead);
+
+    //without a count the draw reads every command, so the ones not written this frame have to be empty
+    VkBuffer drawVkBuffer = slot.drawBuffer;
+    VkDeviceSize clearSize = _drawIndexedIndirectCount ? DRAW_COMMANDS_OFFSET : VK_WHOLE_SIZE;
+    graph.addPass("clear draws", [=](VkCommandBuffer commandBuffer) {
+        vkCmdFillBuffer(commandBuffer, drawVkBuffer, 0, clearSize, 0);
+    }).use(drawBuffer, RenderGraphAccess::TransferWrite);
+
+    //inward facing planes around the view, z is flat but gets its planes so the test stays a general one
+    CullPushConstants pushConstants = {};
+    setPlane(pushConstants.planes[0], 1.f, 0.f, 0.f, -(view.centre[0] - view.halfExtent[0]));
+    setPlane(pushConstants.planes[1], -1.f, 0.f, 0.f, view.centre[0] + view.halfExtent[0]);
+    setPlane(pushConstants.planes[2], 0.f, 1.f, 0.f, -(view.centre[1] - view.halfExtent[1]));
+    setPlane(pushConstants.planes[3], 0.f, -1.f, 0.f, view.centre[1] + view.halfExtent[1]);
+    setPlane(pushConstants.planes[4], 0.f, 0.f, 1.f, 1.f);
+    setPlane(pushConstants.planes[5], 0.f, 0.f, -1.f, 1.f);
+    pushConstants.instanceBuffer = _instanceHandle;
+    pushConstants.meshBuffer = _meshHandle;
+    pushConstants.drawBuffer = slot.drawHandle;
+    pushConstants.instanceCount = slot.instanceCount;
+    pushConstants.firstInstance = slot.firstInstance;
+
+    graph.addPass("cull", [this, pipeline, pushConstants](VkCommandBuffer commandBuffer) {
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+        _bindless.bind(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE);
+        vkCmdPushConstants(commandBuffer, _bindless.pipelineLayout(), VK_SHADER_STAGE_ALL, 0, sizeof(pushConstants), &pushConstants);
+        if( pushConstants.instanceCount > 0 )
+            vkCmdDispatch(commandBuffer, (pushConstants.instanceCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+    }).use(drawBuffer, RenderGraphAccess::StorageReadWrite);
+
+    VkBufferCopy region = {};
+    region.srcOffset = 0;
+    region.dstOffset = frameSlot * sizeof(uint32_t);
+    region.size = sizeof(uint32_t);
+    VkBuffer readbackVkBuffer = _readbackBuffer;
+    graph.addPass("read back count", [=](VkCommandBuffer commandBuffer) {
+        vkCmdCopyBuffer(commandBuffer, drawVkBuffer, readbackVkBuffer, 1, &region);
+    }).use(drawBuffer, RenderGraphAccess::TransferRead).use(readbackBuffer, RenderGraphAccess::TransferWrite);
+
+    return drawBuffer;
+}
+
+void GpuScene::recordDraw(VkCommandBuffer commandBuffer, uint32_t frameSlot, const SceneView& view)
+{
+    auto& slot = _slots[frameSlot];
+
+    DrawPushConstants pushConstants = {};
+    setPlane(pushConstants.view, view.centre[0], view.centre[1], 1.f / view.halfExtent[0], 1.f / view.halfExtent[1]);
+    pushConstants.instanceBuffer = _instanceHandle;
+    pushConstants.vertexBuffer = _vertexHandle;
+    vkCmdPushConstants(commandBuffer, _bindless.pipelineLayout(), VK_SHADER_STAGE_ALL, 0, sizeof(pushConstants), &pushConstants);
+
+    vkCmdBindIndexBuffer(commandBuffer, _indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+
+    uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+    if( _drawIndexedIndirectCount )
+        _drawIndexedIndirectCount(commandBuffer, slot.drawBuffer, DRAW_COMMANDS_OFFSET, slot.drawBuffer, 0, slot.instanceCount, stride);
+    else if( slot.instanceCount > 0 )
+        vkCmdDrawIndexedIndirect(commandBuffer, slot.drawBuffer, DRAW_COMMANDS_OFFSET, slot.instanceCount, stride);
+}
+
+GpuSceneStats GpuScene::stats() const
+{
+    GpuSceneStats stats;
+    stats.instances = _lastInstances;
+    stats.visible = _lastVisible;
+    return stats;
+}
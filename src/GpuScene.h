@@ -0,0 +1,135 @@
+#pragma once
+
+#include "BindlessHeap.h"
+#include "GpuAllocator.h"
+#include "RenderGraph.h"
+#include "UploadRing.h"
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+//matches Instance in resources/shaders/scene.glsl (std430)
+struct GpuInstance
+{
+    float boundingSphere[4]; //xyz centre, w radius
+    float position[4];       //xyz, w scale
+    float color[4];
+    uint32_t mesh;
+    uint32_t padding;
+    float rotation[2]; //cos, sin
+};
+
+//matches Mesh in resources/shaders/scene.glsl
+struct GpuMesh
+{
+    uint32_t indexCount;
+    uint32_t firstIndex;
+    int32_t vertexOffset;
+    float radius; //of the mesh at scale 1, around the origin
+};
+
+//what the camera sees this frame, an orthographic window onto the scene
+struct SceneView
+{
+    float centre[2];
+    float halfExtent[2];
+};
+
+struct GpuSceneStats
+{
+    uint32_t instances = 0;
+    uint32_t visible = 0; //as of the last frame read back
+};
+
+//a scene drawn entirely from the gpu. every frame takes its instances from a ring (a GpuLinearPool over one
+//storage buffer), written by the cpu (see SceneStore) straight into mapped memory, a compute shader
+//frustum culls them every frame and appends a VkDrawIndexedIndirectCommand per visible instance, and
+//one vkCmdDrawIndexedIndirectCount draws whatever survived. the cpu records the same handful of
+//commands however many instances there are.
+//
+//the command buffers (and their counts) are per frame slot, so culling for one frame never races the
+//draws of another still in flight. each frame's count is copied to a host readback buffer and picked
+//up once the slot comes round again, for stats only
+class GpuScene
+{
+public:
+    //drawIndirectCount is whether VK_KHR_draw_indirect_count is enabled, without it every slot's whole
+    //command array is zeroed each frame and drawn with vkCmdDrawIndexedIndirect (needs multiDrawIndirect)
+    GpuScene(VkDevice device, GpuAllocator& allocator, UploadRing& uploads, BindlessHeap& bindless,
+        const std::vector<uint32_t>& sharedFamilies, uint32_t frameSlots, uint32_t maxInstances, bool drawIndirectCount);
+    ~GpuScene();
+
+    GpuScene(const GpuScene&) = delete;
+    GpuScene& operator=(const GpuScene&) = delete;
+
+    uint32_t maxInstances() const { return _maxInstances; }
+    uint32_t meshCount() const { return static_cast<uint32_t>(_meshes.size()); }
+    float meshRadius(uint32_t mesh) const { return _meshes[mesh].radius; }
+
+    //the slot's mapped instances for this frame, maxInstances long. only write them between collect() and
+    //recording the slot's commands, the gpu reads them until then
+    GpuInstance* instances(uint32_t frameSlot);
+    void setInstanceCount(uint32_t frameSlot, uint32_t count);
+
+    //call once the slot's fence has been waited on, before its commands are recorded again
+    void collect(uint32_t frameSlot);
+
+    //declares clearing the slot's commands, culling into them and reading the count back. pipeline is the
+    //cull.comp compute pipeline on the bindless layout. returns the slot's command buffer, the pass that
+    //draws it has to use it as RenderGraphAccess::IndirectRead
+    RenderGraphResource addPasses(RenderGraph& graph, uint32_t frameSlot, VkPipeline pipeline, const SceneView& view);
+    //inside the render pass, with the instanced.vert pipeline and the bindless set already bound
+    void recordDraw(VkCommandBuffer commandBuffer, uint32_t frameSlot, const SceneView& view);
+
+    GpuSceneStats stats() const;
+
+private:
+    struct FrameSlot
+    {
+        GpuAllocation instances;     //this frame's range of the instance ring, invalid once released
+        uint64_t instanceMarker = 0; //the ring's marker() after taking it
+        uint32_t firstInstance = 0;  //where the range starts in _instanceBuffer
+        uint32_t instanceCount = 0;
+
+        VkBuffer drawBuffer = VK_NULL_HANDLE; //count then commands
+        GpuAllocation drawMemory;
+        BindlessHandle drawHandle = INVALID_BINDLESS_HANDLE;
+        bool submitted = false;
+    };
+
+    VkBuffer createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, GpuAllocation& memory,
+        VkMemoryPropertyFlags preferred = 0);
+    void createInstanceRing(uint32_t frameSlots);
+    void createMeshes(std::vector<float>& vertices, std::vector<uint32_t>& indices);
+
+    VkDevice _device;
+    GpuAllocator& _allocator;
+    UploadRing& _uploads;
+    BindlessHeap& _bindless;
+    std::vector<uint32_t> _sharedFamilies;
+    uint32_t _maxInstances;
+    PFN_vkCmdDrawIndexedIndirectCountKHR _drawIndexedIndirectCount = nullptr;
+
+    std::vector<GpuMesh> _meshes;
+
+    VkBuffer _vertexBuffer = VK_NULL_HANDLE;
+    GpuAllocation _vertexMemory;
+    BindlessHandle _vertexHandle = INVALID_BINDLESS_HANDLE;
+    VkBuffer _indexBuffer = VK_NULL_HANDLE;
+    GpuAllocation _indexMemory;
+    VkBuffer _meshBuffer = VK_NULL_HANDLE;
+    GpuAllocation _meshMemory;
+    BindlessHandle _meshHandle = INVALID_BINDLESS_HANDLE;
+
+    std::vector<FrameSlot> _slots;
+    std::unique_ptr<GpuLinearPool> _instancePool; //room for every slot's instances at once
+    VkBuffer _instanceBuffer = VK_NULL_HANDLE;    //over all of _instancePool
+    BindlessHandle _instanceHandle = INVALID_BINDLESS_HANDLE;
+    VkBuffer _readbackBuffer = VK_NULL_HANDLE; //one uint32_t count per slot
+    GpuAllocation _readbackMemory;
+    uint32_t _lastVisible = 0;
+    uint32_t _lastInstances = 0;
+};
@@ -0,0 +1,105 @@
+#include "HeapStats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+//replacing these is allowed by the standard, every new/delete expression in the program ends up here.
+//the counter is relaxed, it only has to add up, not order anything
+namespace
+{
+    std::atomic<uint64_t> g_allocations{0};
+
+    void* allocateCounted(size_t size)
+    {
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+
+        //malloc(0) may return null, new never does
+        size = size > 0 ? size : 1;
+        while( true )
+        {
+            if( void* memory = std::malloc(size) )
+                return memory;
+
+            std::new_handler handler = std::get_new_handler();
+            if( handler == nullptr )
+                return nullptr;
+            handler();
+        }
+    }
+
+    void* allocateCountedAligned(size_t size, std::align_val_t alignment)
+    {
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+
+        size_t align = static_cast<size_t>(alignment);
+        //aligned_alloc wants the size to be a multiple of the alignment
+        size = (std::max<size_t>(size, 1) + align - 1) & ~(align - 1);
+        while( true )
+        {
+#ifdef _WIN32
+            void* memory = _aligned_malloc(size, align);
+#else
+            void* memory = std::aligned_alloc(align, size);
+#endif
+            if( memory != nullptr )
+                return memory;
+
+            std::new_handler handler = std::get_new_handler();
+            if( handler == nullptr )
+                return nullptr;
+            handler();
+        }
+    }
+
+    void freeAligned(void* memory)
+    {
+#ifdef _WIN32
+        _aligned_free(memory);
+#else
+        std::free(memory);
+#endif
+    }
+
+    template<typename... Args>
+    void* allocateOrThrow(void* (*allocate)(Args...), Args... args)
+    {
+        if( void* memory = allocate(args...) )
+            return memory;
+        throw std::bad_alloc();
+    }
+}
+
+uint64_t heapAllocationCount()
+{
+    return g_allocations.load(std::memory_order_relaxed);
+}
+
+void* operator new(size_t size) { return allocateOrThrow(allocateCounted, size); }
+void* operator new[](size_t size) { return allocateOrThrow(allocateCounted, size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return allocateCounted(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return allocateCounted(size); }
+
+void* operator new(size_t size, std::align_val_t alignment) { return allocateOrThrow(allocateCountedAligned, size, alignment); }
+void* operator new[](size_t size, std::align_val_t alignment) { return allocateOrThrow(allocateCountedAligned, size, alignment); }
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocateCountedAligned(size, alignment); }
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocateCountedAligned(size, alignment); }
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, size_t) noexcept { std::free(memory); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept { std::free(memory); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept { std::free(memory); }
+
+void operator delete(void* memory, std::align_val_t) noexcept { freeAligned(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { freeAligned(memory); }
+void operator delete(void* memory, size_t, std::align_val_t) noexcept { freeAligned(memory); }
+void operator delete[](void* memory, size_t, std::align_val_t) noexcept { freeAligned(memory); }
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept { freeAligned(memory); }
+void operator delete[](void* memory, std::align_val_t, const std::nothrow_t&) noexcept { freeAligned(memory); }
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstdint>
+
+//every global operator new since the program started, from any thread. HeapStats.cpp replaces the global
+//operator new and delete to keep count, and since it lives in the static library it is only linked into
+//programs that call this. only C++ allocations are seen, the driver's own mallocs aren't
+uint64_t heapAllocationCount();
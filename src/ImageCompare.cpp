@@ -0,0 +1,107 @@
+#include "ImageCompare.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+    //the next whitespace separated number, skipping # comments to the end of their line
+    uint32_t readHeaderNumber(std::istream& file, const std::string& filename)
+    {
+        while( true )
+        {
+            int c = file.peek();
+            if( c == '#' )
+                file.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            else if( c == ' ' || c == '\t' || c == '\n' || c == '\r' )
+                file.get();
+            else
+                break;
+        }
+
+        uint32_t value = 0;
+        if( !(file >> value) )
+            throw std::runtime_error(filename + " has a broken ppm header!");
+        return value;
+    }
+}
+
+RgbImage readImagePPM(const std::string& filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if( !file.is_open() )
+        throw std::runtime_error("failed to open " + filename + "!");
+
+    char magic[2] = {};
+    file.read(magic, 2);
+    if( !file || magic[0] != 'P' || magic[1] != '6' )
+        throw std::runtime_error(filename + " isn't a binary ppm!");
+
+    RgbImage image;
+    image.width = readHeaderNumber(file, filename);
+    image.height = readHeaderNumber(file, filename);
+    uint32_t maxValue = readHeaderNumber(file, filename);
+    if( maxValue != 255 || image.width == 0 || image.height == 0 )
+        throw std::runtime_error(filename + " isn't an 8 bit ppm!");
+
+    //exactly one whitespace character between the header and the pixels
+    file.get();
+
+    image.pixels.resize(static_cast<size_t>(image.width) * image.height * 3);
+    file.read(reinterpret_cast<char*>(image.pixels.data()), static_cast<std::streamsize>(image.pixels.size()));
+    if( !file )
+        throw std::runtime_error(filename + " is truncated!");
+
+    return image;
+}
+
+RgbImage rgbFromRgba(uint32_t width, uint32_t height, const std::vector<uint8_t>& rgbaPixels)
+{
+    RgbImage image;
+    image.width = width;
+    image.height = height;
+    image.pixels.resize(static_cast<size_t>(width) * height * 3);
+    for (size_t i = 0; i < static_cast<size_t>(width) * height; i++)
+    {
+        image.pixels[i * 3 + 0] = rgbaPixels[i * 4 + 0];
+        image.pixels[i * 3 + 1] = rgbaPixels[i * 4 + 1];
+        image.pixels[i * 3 + 2] = rgbaPixels[i * 4 + 2];
+    }
+    return image;
+}
+
+ImageDifference compareImages(const RgbImage& expected, const RgbImage& actual, uint32_t tolerance)
+{
+    if( expected.width != actual.width || expected.height != actual.height )
+    {
+        throw std::runtime_error("expected a " + std::to_string(expected.width) + "x" + std::to_string(expected.height) + " image, got "
+            + std::to_string(actual.width) + "x" + std::to_string(actual.height) + "!");
+    }
+
+    ImageDifference difference;
+    difference.pixels = static_cast<uint64_t>(expected.width) * expected.height;
+
+    uint64_t squaredError = 0;
+    for (uint64_t i = 0; i < difference.pixels; i++)
+    {
+        uint32_t pixelMax = 0;
+        for (uint32_t channel = 0; channel < 3; channel++)
+        {
+            auto d = static_cast<uint32_t>(std::abs(int(expected.pixels[i * 3 + channel]) - int(actual.pixels[i * 3 + channel])));
+            pixelMax = std::max(pixelMax, d);
+            squaredError += d * d;
+        }
+
+        difference.maxDifference = std::max(difference.maxDifference, pixelMax);
+        if( pixelMax > tolerance )
+            difference.differingPixels++;
+    }
+
+    double meanSquaredError = static_cast<double>(squaredError) / (difference.pixels * 3);
+    difference.psnr = meanSquaredError > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / meanSquaredError) : std::numeric_limits<double>::infinity();
+    return difference;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//an 8 bit rgb image, what headless runs write with --output
+struct RgbImage
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<uint8_t> pixels; //rgb, rows top to bottom
+};
+
+//binary (P6) ppm with a maxval of 255, comments allowed in the header
+RgbImage readImagePPM(const std::string& filename);
+//drops the alpha of a frame read back from the gpu
+RgbImage rgbFromRgba(uint32_t width, uint32_t height, const std::vector<uint8_t>& rgbaPixels);
+
+struct ImageDifference
+{
+    uint64_t pixels = 0;
+    uint64_t differingPixels = 0; //with a channel more than the tolerance off
+    uint32_t maxDifference = 0;   //of any channel, in levels
+    double psnr = 0.0;            //in dB, infinite when the images are the same
+};
+
+//images of different sizes throw. tolerance is per channel, gpus are allowed to round differently
+ImageDifference compareImages(const RgbImage& expected, const RgbImage& actual, uint32_t tolerance);
@@ -0,0 +1,179 @@
+#include "JobSystem.h"
+
+//which job system (if any) owns the current thread and its index in it
+static thread_local const JobSystem* t_owner = nullptr;
+static thread_local uint32_t t_threadIndex = 0;
+
+//a few frames' worth of parallelFor batches without growing
+static const size_t INITIAL_QUEUE_CAPACITY = 256;
+
+void JobSystem::Queue::pushBack(Task task)
+{
+    if( count == tasks.size() )
+    {
+        std::vector<Task> grown(tasks.empty() ? INITIAL_QUEUE_CAPACITY : tasks.size() * 2);
+        for( size_t i = 0; i < count; i++ )
+            grown[i] = std::move(tasks[(head + i) & (tasks.size() - 1)]);
+        tasks.swap(grown);
+        head = 0;
+    }
+
+    tasks[(head + count) & (tasks.size() - 1)] = std::move(task);
+    count++;
+}
+
+JobSystem::Task JobSystem::Queue::popBack()
+{
+    count--;
+    return std::move(tasks[(head + count) & (tasks.size() - 1)]);
+}
+
+JobSystem::Task JobSystem::Queue::popFront()
+{
+    Task task = std::move(tasks[head]);
+    head = (head + 1) & (tasks.size() - 1);
+    count--;
+    return task;
+}
+
+JobSystem::JobSystem(uint32_t workerCount)
+{
+    for( uint32_t i = 0; i < workerCount + 1; i++ )
+        _queues.push_back(std::make_unique<Queue>());
+
+    for( uint32_t i = 1; i <= workerCount; i++ )
+        _workers.emplace_back(&JobSystem::workerMain, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+        _running = false;
+    }
+    _wake.notify_all();
+
+    for( auto& worker : _workers )
+        worker.join();
+}
+
+uint32_t JobSystem::currentThreadIndex() const
+{
+    return t_owner == this ? t_threadIndex : 0;
+}
+
+void JobSystem::submit(Job job, JobCounter& counter)
+{
+    Task task;
+    task.job = std::move(job);
+    push(std::move(task), counter);
+}
+
+void JobSystem::push(Task task, JobCounter& counter)
+{
+    task.counter = &counter;
+    counter.pending.fetch_add(1, std::memory_order_relaxed);
+
+    //workers keep what they spawn local, anyone else spreads work round all the queues
+    uint32_t queueIndex = t_owner == this ? t_threadIndex : _nextQueue.fetch_add(1, std::memory_order_relaxed) % threadCount();
+    {
+        auto& queue = *_queues[queueIndex];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.pushBack(std::move(task));
+    }
+    _queuedJobs.fetch_add(1, std::memory_order_release);
+
+    //taking the lock orders us after any worker that is between checking for work and going to sleep
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+    }
+    _wake.notify_one();
+}
+
+bool JobSystem::tryRunJob(uint32_t threadIndex)
+{
+    Task task;
+    bool found = false;
+
+    {
+        auto& own = *_queues[threadIndex];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if( own.count > 0 )
+        {
+            task = own.popBack();
+            found = true;
+        }
+    }
+
+    for( uint32_t i = 1; !found && i < threadCount(); i++ )
+    {
+        auto& victim = *_queues[(threadIndex + i) % threadCount()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if( victim.count > 0 )
+        {
+            task = victim.popFront();
+            found = true;
+        }
+    }
+
+    if( !found )
+        return false;
+
+    _queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+    if( task.range != nullptr )
+        task.range(task.context, task.begin, task.end, threadIndex);
+    else
+        task.job(threadIndex);
+    task.counter->pending.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+void JobSystem::workerMain(uint32_t threadIndex)
+{
+    t_owner = this;
+    t_threadIndex = threadIndex;
+
+    while( _running.load(std::memory_order_acquire) )
+    {
+        if( tryRunJob(threadIndex) )
+            continue;
+
+        std::unique_lock<std::mutex> lock(_sleepMutex);
+        _wake.wait(lock, [this]() {
+            return _queuedJobs.load(std::memory_order_acquire) > 0 || !_running.load(std::memory_order_acquire);
+        });
+    }
+}
+
+void JobSystem::wait(JobCounter& counter)
+{
+    uint32_t threadIndex = currentThreadIndex();
+
+    while( !counter.done() )
+    {
+        if( !tryRunJob(threadIndex) )
+            std::this_thread::yield();
+    }
+}
+
+void JobSystem::runParallelFor(uint32_t count, uint32_t batchSize, RangeFunction function, const void* context)
+{
+    if( count == 0 )
+        return;
+
+    batchSize = batchSize > 0 ? batchSize : 1;
+
+    JobCounter counter;
+    for( uint32_t begin = 0; begin < count; begin += batchSize )
+    {
+        uint32_t end = begin + batchSize < count ? begin + batchSize : count;
+        Task task;
+        task.range = function;
+        task.context = context;
+        task.begin = begin;
+        task.end = end;
+        push(std::move(task), counter);
+    }
+
+    wait(counter);
+}
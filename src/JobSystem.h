@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//jobs bump this on submit and drop it when they finish, wait() on it to join a batch of jobs
+struct JobCounter
+{
+    std::atomic<uint32_t> pending{0};
+
+    bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+};
+
+//work stealing job system: every thread owns a deque, pops its own work from the back and steals
+//from the front of everyone else's when it runs dry. thread index 0 is whoever calls wait(),
+//workers are 1..threadCount()-1, which makes the index usable for per thread resources like command pools
+class JobSystem
+{
+public:
+    using Job = std::function<void(uint32_t threadIndex)>;
+
+    //0 workers is valid, everything then runs on the waiting thread
+    explicit JobSystem(uint32_t workerCount);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    uint32_t threadCount() const { return static_cast<uint32_t>(_queues.size()); }
+
+    void submit(Job job, JobCounter& counter);
+
+    //helps out with queued jobs until the counter drains
+    void wait(JobCounter& counter);
+
+    //splits [0, count) into batches of batchSize and blocks until all of them have run.
+    //body(begin, end, threadIndex) is called through a function pointer rather than a std::function,
+    //which would go to the heap every call once the lambda captures more than a couple of things
+    template<typename Body>
+    void parallelFor(uint32_t count, uint32_t batchSize, const Body& body)
+    {
+        runParallelFor(count, batchSize, [](const void* context, uint32_t begin, uint32_t end, uint32_t threadIndex) {
+            (*static_cast<const Body*>(context))(begin, end, threadIndex);
+        }, &body);
+    }
+
+private:
+    using RangeFunction = void (*)(const void* context, uint32_t begin, uint32_t end, uint32_t threadIndex);
+
+    //either a submitted job or one batch of a parallelFor
+    struct Task
+    {
+        Job job;
+        RangeFunction range = nullptr;
+        const void* context = nullptr;
+        uint32_t begin = 0;
+        uint32_t end = 0;
+        JobCounter* counter = nullptr;
+    };
+
+    //ring buffer with a power of two capacity that only ever grows, a deque frees and reallocates its
+    //blocks as jobs come and go
+    struct Queue
+    {
+        std::mutex mutex;
+        std::vector<Task> tasks;
+        size_t head = 0;
+        size_t count = 0;
+
+        void pushBack(Task task);
+        Task popBack();
+        Task popFront();
+    };
+
+    void push(Task task, JobCounter& counter);
+    void runParallelFor(uint32_t count, uint32_t batchSize, RangeFunction function, const void* context);
+    void workerMain(uint32_t threadIndex);
+    bool tryRunJob(uint32_t threadIndex);
+    uint32_t currentThreadIndex() const;
+
+    std::vector<std::unique_ptr<Queue>> _queues;
+    std::vector<std::thread> _workers;
+    std::atomic<uint32_t> _queuedJobs{0};
+    std::atomic<uint32_t> _nextQueue{0};
+    std::atomic<bool> _running{true};
+    std::mutex _sleepMutex;
+    std::condition_variable _wake;
+};
@@ -0,0 +1,106 @@
+#include "MappedFile.h"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+AssetSpan AssetSpan::slice(size_t offset, size_t size) const
+{
+    if( offset > _size || size > _size - offset )
+        throw std::runtime_error("asset slice is out of range!");
+
+    return AssetSpan(_data + offset, size, _owner);
+}
+
+std::shared_ptr<const MappedFile> MappedFile::open(const std::string& path)
+{
+    //private constructor, so no make_shared
+    std::shared_ptr<MappedFile> file(new MappedFile());
+    file->_path = path;
+
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if( handle == INVALID_HANDLE_VALUE )
+        throw std::runtime_error("failed to open " + path + "!");
+    file->_fileHandle = handle;
+
+    LARGE_INTEGER size = {};
+    if( !GetFileSizeEx(handle, &size) )
+        throw std::runtime_error("failed to get the size of " + path + "!");
+    file->_size = static_cast<size_t>(size.QuadPart);
+
+    //mapping an empty file is an error on both platforms, an empty span does the job
+    if( file->_size == 0 )
+        return file;
+
+    HANDLE mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if( mapping == nullptr )
+        throw std::runtime_error("failed to map " + path + "!");
+    file->_mappingHandle = mapping;
+
+    file->_data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if( file->_data == nullptr )
+        throw std::runtime_error("failed to map " + path + "!");
+#else
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if( fd < 0 )
+        throw std::runtime_error("failed to open " + path + "!");
+
+    struct stat info = {};
+    if( fstat(fd, &info) != 0 )
+    {
+        ::close(fd);
+        throw std::runtime_error("failed to get the size of " + path + "!");
+    }
+    file->_size = static_cast<size_t>(info.st_size);
+
+    if( file->_size == 0 )
+    {
+        ::close(fd);
+        return file;
+    }
+
+    //the mapping keeps its own reference to the file, the descriptor isn't needed past this
+    void* data = mmap(nullptr, file->_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if( data == MAP_FAILED )
+        throw std::runtime_error("failed to map " + path + "!");
+    file->_data = static_cast<const uint8_t*>(data);
+#endif
+
+    return file;
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef _WIN32
+    if( _data != nullptr )
+        UnmapViewOfFile(_data);
+    if( _mappingHandle != nullptr )
+        CloseHandle(_mappingHandle);
+    if( _fileHandle != nullptr )
+        CloseHandle(_fileHandle);
+#else
+    if( _data != nullptr )
+        munmap(const_cast<uint8_t*>(_data), _size);
+#endif
+}
+
+AssetSpan MappedFile::span() const
+{
+    return AssetSpan(_data, _size, shared_from_this());
+}
+
+AssetSpan MappedFile::span(size_t offset, size_t size) const
+{
+    return span().slice(offset, size);
+}
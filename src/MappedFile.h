@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+class MappedFile;
+
+//read only view of asset bytes. holds a reference on whatever backs it (a mapping, or nothing for
+//data compiled into the executable) so the pointer stays valid for as long as the span is around
+class AssetSpan
+{
+public:
+    AssetSpan() = default;
+    AssetSpan(const void* data, size_t size, std::shared_ptr<const MappedFile> owner = nullptr)
+        : _data(static_cast<const uint8_t*>(data)), _size(size), _owner(std::move(owner)) {}
+
+    const uint8_t* data() const { return _data; }
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+
+    //throws when the data isn't aligned for T, archive entries and mappings always are for anything up to 16 bytes
+    template<typename T>
+    const T* as() const
+    {
+        if( reinterpret_cast<uintptr_t>(_data) % alignof(T) != 0 )
+            throw std::runtime_error("asset data is misaligned!");
+        return reinterpret_cast<const T*>(_data);
+    }
+
+    //the same bytes, keeping the same owner alive
+    AssetSpan slice(size_t offset, size_t size) const;
+
+private:
+    const uint8_t* _data = nullptr;
+    size_t _size = 0;
+    std::shared_ptr<const MappedFile> _owner;
+};
+
+//a whole file mapped read only, unmapped when the last reference (including any AssetSpan) goes away.
+//pages are only read in as they are touched, there is no copy into a heap buffer
+class MappedFile : public std::enable_shared_from_this<MappedFile>
+{
+public:
+    //throws if the file can't be opened or mapped
+    static std::shared_ptr<const MappedFile> open(const std::string& path);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* data() const { return _data; }
+    size_t size() const { return _size; }
+    const std::string& path() const { return _path; }
+
+    AssetSpan span() const;
+    AssetSpan span(size_t offset, size_t size) const;
+
+private:
+    MappedFile() = default;
+
+    std::string _path;
+    const uint8_t* _data = nullptr;
+    size_t _size = 0;
+#ifdef _WIN32
+    void* _fileHandle = nullptr;
+    void* _mappingHandle = nullptr;
+#endif
+};
@@ -0,0 +1,47 @@
+#include "MeshFile.h"
+
+#include <stdexcept>
+
+namespace
+{
+    //a section is size bytes at offset, checked against the file without overflowing
+    bool sectionFits(uint64_t offset, uint64_t count, uint64_t stride, uint64_t fileSize)
+    {
+        if( offset % MESH_FILE_ALIGNMENT != 0 || offset > fileSize )
+            return false;
+        return count <= (fileSize - offset) / stride;
+    }
+}
+
+MeshFile::MeshFile(std::shared_ptr<const MappedFile> file)
+    : _file(std::move(file))
+{
+    const std::string& path = _file->path();
+    if( _file->size() < sizeof(MeshFileHeader) )
+        throw std::runtime_error(path + " is too small to be a mesh!");
+
+    _header = reinterpret_cast<const MeshFileHeader*>(_file->data());
+    if( _header->magic != MESH_FILE_MAGIC || _header->version != MESH_FILE_VERSION )
+        throw std::runtime_error(path + " is not a version " + std::to_string(MESH_FILE_VERSION) + " mesh!");
+    if( _header->fileSize != _file->size() )
+        throw std::runtime_error(path + " is truncated!");
+    if( _header->indexSize != 2 && _header->indexSize != 4 )
+        throw std::runtime_error(path + " has an unsupported index size!");
+    if( _header->indexCount % 3 != 0 )
+        throw std::runtime_error(path + " isn't a triangle list!");
+
+    uint64_t fileSize = _file->size();
+    if( !sectionFits(_header->vertexOffset, _header->vertexCount, sizeof(MeshVertex), fileSize)
+        || !sectionFits(_header->indexOffset, _header->indexCount, _header->indexSize, fileSize)
+        || !sectionFits(_header->meshletOffset, _header->meshletCount, sizeof(MeshMeshlet), fileSize) )
+        throw std::runtime_error(path + " has a section outside the file!");
+
+    _vertices = _file->span(static_cast<size_t>(_header->vertexOffset), static_cast<size_t>(_header->vertexCount) * sizeof(MeshVertex));
+    _indices = _file->span(static_cast<size_t>(_header->indexOffset), static_cast<size_t>(_header->indexCount) * _header->indexSize);
+    _meshlets = _file->span(static_cast<size_t>(_header->meshletOffset), static_cast<size_t>(_header->meshletCount) * sizeof(MeshMeshlet));
+}
+
+std::shared_ptr<const MeshFile> MeshFile::open(const std::string& path)
+{
+    return std::shared_ptr<const MeshFile>(new MeshFile(MappedFile::open(path)));
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+//a mesh ready to go straight into gpu buffers, written by VKLearningMeshImport (see MeshImport.h).
+//layout:
+//
+//  MeshFileHeader
+//  MeshVertex[vertexCount]      in order of first use by the indices
+//  indices[indexCount]          uint16 or uint32 (indexSize), triangle lists grouped by meshlet
+//  MeshMeshlet[meshletCount]
+//
+//every section starts on a MESH_FILE_ALIGNMENT boundary. everything is little endian and offsets are
+//from the start of the file
+const uint32_t MESH_FILE_MAGIC = 0x534d4b56; //"VKMS"
+const uint32_t MESH_FILE_VERSION = 1;
+const uint64_t MESH_FILE_ALIGNMENT = 16;
+
+//meshlet limits, small enough for mesh shaders and for cluster culling to be worth it
+const uint32_t MESHLET_MAX_VERTICES = 64;
+const uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+struct MeshFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t meshletCount;
+    uint32_t indexSize; //2 or 4
+    float boundingSphere[4]; //xyz centre, w radius
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    uint64_t meshletOffset;
+    uint64_t fileSize;
+};
+
+//16 bytes against 32 for float position, normal and uv. matches unpackVertex in resources/shaders/mesh.vert
+struct MeshVertex
+{
+    uint16_t position[4]; //half floats, w unused
+    int16_t normal[2];    //octahedral, snorm16
+    uint16_t uv[2];       //half floats
+};
+
+//a run of whole triangles in the index buffer touching at most MESHLET_MAX_VERTICES vertices, drawable
+//on its own with vkCmdDrawIndexed(indexCount, 1, firstIndex, 0, 0)
+struct MeshMeshlet
+{
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    uint32_t vertexCount; //distinct vertices it references
+    uint32_t padding;
+    float boundingSphere[4]; //xyz centre, w radius
+    float cone[4]; //xyz axis, w cos of the widest angle between it and any triangle's normal, <= 0 for no cone
+};
+
+static_assert(sizeof(MeshFileHeader) == 72, "MeshFileHeader layout");
+static_assert(sizeof(MeshVertex) == 16, "MeshVertex layout");
+static_assert(sizeof(MeshMeshlet) == 48, "MeshMeshlet layout");
+
+//a mapped mesh file. the sections are views into the mapping, hand them to the upload ring as they are
+class MeshFile
+{
+public:
+    //maps the file and validates the header, throws if any section falls outside it. the indices
+    //themselves aren't checked against the vertex count, that would mean reading all of them
+    static std::shared_ptr<const MeshFile> open(const std::string& path);
+
+    const MeshFileHeader& header() const { return *_header; }
+    uint32_t vertexCount() const { return _header->vertexCount; }
+    uint32_t indexCount() const { return _header->indexCount; }
+    uint32_t meshletCount() const { return _header->meshletCount; }
+    uint32_t indexSize() const { return _header->indexSize; }
+
+    AssetSpan vertices() const { return _vertices; }
+    AssetSpan indices() const { return _indices; }
+    AssetSpan meshlets() const { return _meshlets; }
+
+private:
+    explicit MeshFile(std::shared_ptr<const MappedFile> file);
+
+    std::shared_ptr<const MappedFile> _file;
+    const MeshFileHeader* _header = nullptr;
+    AssetSpan _vertices;
+    AssetSpan _indices;
+    AssetSpan _meshlets;
+};
@@ -0,0 +1,714 @@
+#include "MeshImport.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace
+{
+    //the cache Forsyth's scores are tuned for, bigger than any real one so it works well on all of them
+    const uint32_t VERTEX_CACHE_SIZE = 32;
+    const float CACHE_DECAY_POWER = 1.5f;
+    const float LAST_TRIANGLE_SCORE = 0.75f;
+    const float VALENCE_BOOST_SCALE = 2.f;
+    const float VALENCE_BOOST_POWER = 0.5f;
+    //valences above this all score the same, which keeps the table small
+    const uint32_t MAX_SCORED_VALENCE = 32;
+
+    uint64_t alignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    //an obj face corner, 1 based with 0 for missing like the file has it
+    struct ObjCorner
+    {
+        int64_t position = 0;
+        int64_t uv = 0;
+        int64_t normal = 0;
+
+        bool operator==(const ObjCorner& other) const { return position == other.position && uv == other.uv && normal == other.normal; }
+    };
+
+    struct ObjCornerHash
+    {
+        size_t operator()(const ObjCorner& corner) const
+        {
+            uint64_t hash = static_cast<uint64_t>(corner.position) * 0x9e3779b97f4a7c15ull;
+            hash ^= static_cast<uint64_t>(corner.uv) * 0xc2b2ae3d27d4eb4full + (hash << 6) + (hash >> 2);
+            hash ^= static_cast<uint64_t>(corner.normal) * 0x165667b19e3779f9ull + (hash << 6) + (hash >> 2);
+            return static_cast<size_t>(hash);
+        }
+    };
+
+    const char* skipSpaces(const char* c)
+    {
+        while( *c == ' ' || *c == '\t' )
+            c++;
+        return c;
+    }
+
+    const char* nextLine(const char* c)
+    {
+        while( *c != '\0' && *c != '\n' )
+            c++;
+        return *c == '\n' ? c + 1 : c;
+    }
+
+    void parseFloats(const char* c, float* values, uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            char* end = nullptr;
+            values[i] = std::strtof(c, &end);
+            c = end;
+        }
+    }
+
+    //negative indices count back from the last element, resolves to 1 based or 0 when missing
+    int64_t resolveObjIndex(int64_t index, size_t count)
+    {
+        if( index < 0 )
+            return static_cast<int64_t>(count) + index + 1;
+        return index;
+    }
+
+    void cross(const float* a, const float* b, const float* c, float normal[3])
+    {
+        float ab[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+        float ac[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+        normal[0] = ab[1] * ac[2] - ab[2] * ac[1];
+        normal[1] = ab[2] * ac[0] - ab[0] * ac[2];
+        normal[2] = ab[0] * ac[1] - ab[1] * ac[0];
+    }
+
+    bool normalize(float v[3])
+    {
+        float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+        if( length <= 1e-20f )
+            return false;
+        v[0] /= length;
+        v[1] /= length;
+        v[2] /= length;
+        return true;
+    }
+
+    //centre of the bounding box and the furthest point from it, not the tightest sphere but close enough
+    void boundingSphere(const float* positions, const uint32_t* vertices, uint32_t count, float sphere[4])
+    {
+        float low[3] = {INFINITY, INFINITY, INFINITY};
+        float high[3] = {-INFINITY, -INFINITY, -INFINITY};
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const float* p = positions + 3 * (vertices ? vertices[i] : i);
+            for (uint32_t axis = 0; axis < 3; axis++)
+            {
+                low[axis] = std::min(low[axis], p[axis]);
+                high[axis] = std::max(high[axis], p[axis]);
+            }
+        }
+
+        float radiusSquared = 0.f;
+        for (uint32_t axis = 0; axis < 3; axis++)
+            sphere[axis] = count > 0 ? 0.5f * (low[axis] + high[axis]) : 0.f;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const float* p = positions + 3 * (vertices ? vertices[i] : i);
+            float dx = p[0] - sphere[0], dy = p[1] - sphere[1], dz = p[2] - sphere[2];
+            radiusSquared = std::max(radiusSquared, dx * dx + dy * dy + dz * dz);
+        }
+        sphere[3] = std::sqrt(radiusSquared);
+    }
+}
+
+ImportedMesh loadObj(const std::string& path)
+{
+    //one read into a null terminated string, strtof needs the terminator a mapping doesn't have
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if( !file.is_open() )
+        throw std::runtime_error("failed to open " + path + "!");
+    std::string text(static_cast<size_t>(file.tellg()), '\0');
+    file.seekg(0);
+    file.read(&text[0], static_cast<std::streamsize>(text.size()));
+
+    std::vector<float> positions;
+    std::vector<float> uvs;
+    std::vector<float> normals;
+    std::vector<ObjCorner> corners; //three per triangle
+
+    std::vector<ObjCorner> face;
+    for (const char* line = text.c_str(); *line != '\0'; line = nextLine(line))
+    {
+        const char* c = skipSpaces(line);
+        if( c[0] == 'v' && (c[1] == ' ' || c[1] == '\t') )
+        {
+            float value[3] = {};
+            parseFloats(c + 2, value, 3);
+            positions.insert(positions.end(), value, value + 3);
+        }
+        else if( c[0] == 'v' && c[1] == 't' && (c[2] == ' ' || c[2] == '\t') )
+        {
+            float value[2] = {};
+            parseFloats(c + 3, value, 2);
+            uvs.insert(uvs.end(), value, value + 2);
+        }
+        else if( c[0] == 'v' && c[1] == 'n' && (c[2] == ' ' || c[2] == '\t') )
+        {
+            float value[3] = {};
+            parseFloats(c + 3, value, 3);
+            normals.insert(normals.end(), value, value + 3);
+        }
+        else if( c[0] == 'f' && (c[1] == ' ' || c[1] == '\t') )
+        {
+            //v, v/vt, v//vn or v/vt/vn per corner
+            face.clear();
+            c = skipSpaces(c + 2);
+            while( *c != '\0' && *c != '\n' && *c != '\r' && *c != '#' )
+            {
+                char* end = nullptr;
+                ObjCorner corner;
+                corner.position = resolveObjIndex(std::strtoll(c, &end, 10), positions.size() / 3);
+                if( end == c )
+                    throw std::runtime_error(path + " has a malformed face!");
+                c = end;
+                if( *c == '/' )
+                {
+                    c++;
+                    if( *c != '/' )
+                    {
+                        corner.uv = resolveObjIndex(std::strtoll(c, &end, 10), uvs.size() / 2);
+                        c = end;
+                    }
+                    if( *c == '/' )
+                    {
+                        corner.normal = resolveObjIndex(std::strtoll(c + 1, &end, 10), normals.size() / 3);
+                        c = end;
+                    }
+                }
+
+                if( corner.position <= 0 || corner.position > static_cast<int64_t>(positions.size() / 3)
+                    || corner.uv < 0 || corner.uv > static_cast<int64_t>(uvs.size() / 2)
+                    || corner.normal < 0 || corner.normal > static_cast<int64_t>(normals.size() / 3) )
+                    throw std::runtime_error(path + " has a face with an index out of range!");
+
+                face.push_back(corner);
+                c = skipSpaces(c);
+            }
+
+            for (size_t i = 2; i < face.size(); i++)
+            {
+                corners.push_back(face[0]);
+                corners.push_back(face[i - 1]);
+                corners.push_back(face[i]);
+            }
+        }
+    }
+
+    if( corners.empty() )
+        throw std::runtime_error(path + " has no faces!");
+
+    ImportedMesh mesh;
+    mesh.indices.reserve(corners.size());
+    std::unordered_map<ObjCorner, uint32_t, ObjCornerHash> vertexOf;
+    std::vector<int64_t> positionOf; //obj position of each vertex, for smoothing missing normals
+    bool missingNormals = false;
+
+    for (auto& corner : corners)
+    {
+        auto inserted = vertexOf.emplace(corner, mesh.vertexCount());
+        if( inserted.second )
+        {
+            const float* p = &positions[3 * (corner.position - 1)];
+            mesh.positions.insert(mesh.positions.end(), p, p + 3);
+
+            //obj has v up, vulkan samples with v down
+            float uv[2] = {0.f, 0.f};
+            if( corner.uv > 0 )
+            {
+                uv[0] = uvs[2 * (corner.uv - 1)];
+                uv[1] = 1.f - uvs[2 * (corner.uv - 1) + 1];
+            }
+            mesh.uvs.insert(mesh.uvs.end(), uv, uv + 2);
+
+            float n[3] = {0.f, 0.f, 0.f};
+            if( corner.normal > 0 )
+                std::memcpy(n, &normals[3 * (corner.normal - 1)], sizeof(n));
+            missingNormals |= corner.normal == 0;
+            mesh.normals.insert(mesh.normals.end(), n, n + 3);
+            positionOf.push_back(corner.position - 1);
+        }
+        mesh.indices.push_back(inserted.first->second);
+    }
+
+    //area weighted face normals summed per obj position, so uv seams don't crease the shading
+    if( missingNormals )
+    {
+        std::vector<float> smooth(positions.size(), 0.f);
+        for (size_t i = 0; i < corners.size(); i += 3)
+        {
+            float n[3];
+            cross(&positions[3 * (corners[i].position - 1)], &positions[3 * (corners[i + 1].position - 1)],
+                &positions[3 * (corners[i + 2].position - 1)], n);
+            for (size_t corner = i; corner < i + 3; corner++)
+                for (uint32_t axis = 0; axis < 3; axis++)
+                    smooth[3 * (corners[corner].position - 1) + axis] += n[axis];
+        }
+
+        for (uint32_t v = 0; v < mesh.vertexCount(); v++)
+        {
+            float* n = &mesh.normals[3 * v];
+            if( n[0] != 0.f || n[1] != 0.f || n[2] != 0.f )
+                continue;
+            std::memcpy(n, &smooth[3 * positionOf[v]], 3 * sizeof(float));
+            if( !normalize(n) )
+                n[2] = 1.f;
+        }
+    }
+
+    return mesh;
+}
+
+void optimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount)
+{
+    uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+    if( triangleCount == 0 )
+        return;
+
+    //scores by cache position and by how many triangles a vertex still has, looked up rather than powf'd
+    float cacheScores[VERTEX_CACHE_SIZE];
+    for (uint32_t i = 0; i < VERTEX_CACHE_SIZE; i++)
+    {
+        if( i < 3 )
+            cacheScores[i] = LAST_TRIANGLE_SCORE;
+        else
+            cacheScores[i] = std::pow(1.f - static_cast<float>(i - 3) / (VERTEX_CACHE_SIZE - 3), CACHE_DECAY_POWER);
+    }
+    float valenceScores[MAX_SCORED_VALENCE + 1];
+    valenceScores[0] = 0.f;
+    for (uint32_t i = 1; i <= MAX_SCORED_VALENCE; i++)
+        valenceScores[i] = VALENCE_BOOST_SCALE * std::pow(static_cast<float>(i), -VALENCE_BOOST_POWER);
+
+    //triangles of each vertex, the live ones kept at the front of each vertex's run
+    std::vector<uint32_t> liveTriangles(vertexCount, 0);
+    for (uint32_t index : indices)
+        liveTriangles[index]++;
+    std::vector<uint32_t> adjacencyStart(vertexCount + 1, 0);
+    for (uint32_t v = 0; v < vertexCount; v++)
+        adjacencyStart[v + 1] = adjacencyStart[v] + liveTriangles[v];
+    std::vector<uint32_t> adjacency(indices.size());
+    {
+        std::vector<uint32_t> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+        for (uint32_t t = 0; t < triangleCount; t++)
+            for (uint32_t corner = 0; corner < 3; corner++)
+                adjacency[fill[indices[3 * t + corner]]++] = t;
+    }
+
+    std::vector<int32_t> cachePosition(vertexCount, -1);
+    auto vertexScore = [&](uint32_t v) {
+        uint32_t live = liveTriangles[v];
+        if( live == 0 )
+            return -1.f;
+        float score = valenceScores[std::min(live, MAX_SCORED_VALENCE)];
+        if( cachePosition[v] >= 0 )
+            score += cacheScores[cachePosition[v]];
+        return score;
+    };
+
+    std::vector<float> vertexScores(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; v++)
+        vertexScores[v] = vertexScore(v);
+    std::vector<float> triangleScores(triangleCount);
+    for (uint32_t t = 0; t < triangleCount; t++)
+        triangleScores[t] = vertexScores[indices[3 * t]] + vertexScores[indices[3 * t + 1]] + vertexScores[indices[3 * t + 2]];
+
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+
+    //three extra slots for the triangle being pushed in before the tail falls off
+    uint32_t cache[VERTEX_CACHE_SIZE + 3];
+    uint32_t cacheSize = 0;
+    uint32_t nextUnemitted = 0;
+
+    uint32_t best = 0;
+    for (uint32_t t = 1; t < triangleCount; t++)
+        if( triangleScores[t] > triangleScores[best] )
+            best = t;
+
+    for (uint32_t emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+    {
+        //dead end, nothing in the cache has triangles left. start again from the next in input order
+        if( best == UINT32_MAX )
+        {
+            while( emitted[nextUnemitted] )
+                nextUnemitted++;
+            best = nextUnemitted;
+        }
+
+        const uint32_t* triangle = &indices[3 * best];
+        emitted[best] = true;
+        output.insert(output.end(), triangle, triangle + 3);
+
+        //drop the triangle from its vertices' live lists
+        for (uint32_t corner = 0; corner < 3; corner++)
+        {
+            uint32_t v = triangle[corner];
+            uint32_t* list = &adjacency[adjacencyStart[v]];
+            uint32_t live = liveTriangles[v];
+            for (uint32_t i = 0; i < live; i++)
+            {
+                if( list[i] == best )
+                {
+                    std::swap(list[i], list[live - 1]);
+                    break;
+                }
+            }
+            liveTriangles[v]--;
+        }
+
+        //the triangle's vertices go to the front of the cache, everything else shuffles back
+        uint32_t newCache[VERTEX_CACHE_SIZE + 3];
+        uint32_t newSize = 0;
+        for (uint32_t corner = 0; corner < 3; corner++)
+        {
+            //degenerate triangles repeat a vertex, it still only takes one slot
+            bool repeated = (corner > 0 && triangle[corner] == triangle[0]) || (corner > 1 && triangle[corner] == triangle[1]);
+            if( !repeated )
+                newCache[newSize++] = triangle[corner];
+        }
+        for (uint32_t i = 0; i < cacheSize; i++)
+        {
+            uint32_t v = cache[i];
+            if( v != triangle[0] && v != triangle[1] && v != triangle[2] )
+                newCache[newSize++] = v;
+        }
+
+        //everything that moved (or fell out) rescores, and so do its remaining triangles
+        best = UINT32_MAX;
+        float bestScore = -1.f;
+        for (uint32_t i = 0; i < newSize; i++)
+        {
+            uint32_t v = newCache[i];
+            cachePosition[v] = i < VERTEX_CACHE_SIZE ? static_cast<int32_t>(i) : -1;
+            float score = vertexScore(v);
+            float delta = score - vertexScores[v];
+            vertexScores[v] = score;
+
+            const uint32_t* list = &adjacency[adjacencyStart[v]];
+            for (uint32_t j = 0; j < liveTriangles[v]; j++)
+            {
+                uint32_t t = list[j];
+                triangleScores[t] += delta;
+                if( triangleScores[t] > bestScore )
+                {
+                    bestScore = triangleScores[t];
+                    best = t;
+                }
+            }
+        }
+
+        cacheSize = std::min(newSize, VERTEX_CACHE_SIZE);
+        std::copy(newCache, newCache + cacheSize, cache);
+    }
+
+    indices.swap(output);
+}
+
+std::vector<MeshMeshlet> buildMeshlets(const ImportedMesh& mesh)
+{
+    std::vector<MeshMeshlet> meshlets;
+    uint32_t triangleCount = mesh.triangleCount();
+
+    //which meshlet last took each vertex, saves clearing a set between meshlets
+    std::vector<uint32_t> owner(mesh.vertexCount(), UINT32_MAX);
+    std::vector<uint32_t> vertices;
+    vertices.reserve(MESHLET_MAX_VERTICES);
+
+    auto finish = [&](uint32_t firstTriangle, uint32_t endTriangle) {
+        MeshMeshlet meshlet = {};
+        meshlet.firstIndex = 3 * firstTriangle;
+        meshlet.indexCount = 3 * (endTriangle - firstTriangle);
+        meshlet.vertexCount = static_cast<uint32_t>(vertices.size());
+        boundingSphere(mesh.positions.data(), vertices.data(), meshlet.vertexCount, meshlet.boundingSphere);
+
+        //the cone holds every triangle's normal, a meshlet whose cone faces away from the camera is all back faces
+        float axis[3] = {0.f, 0.f, 0.f};
+        std::vector<float> normals;
+        for (uint32_t t = firstTriangle; t < endTriangle; t++)
+        {
+            float n[3];
+            cross(&mesh.positions[3 * mesh.indices[3 * t]], &mesh.positions[3 * mesh.indices[3 * t + 1]],
+                &mesh.positions[3 * mesh.indices[3 * t + 2]], n);
+            if( !normalize(n) )
+                continue;
+            normals.insert(normals.end(), n, n + 3);
+            for (uint32_t i = 0; i < 3; i++)
+                axis[i] += n[i];
+        }
+
+        meshlet.cone[3] = -1.f;
+        if( normalize(axis) )
+        {
+            float cutoff = 1.f;
+            for (size_t i = 0; i < normals.size(); i += 3)
+                cutoff = std::min(cutoff, axis[0] * normals[i] + axis[1] * normals[i + 1] + axis[2] * normals[i + 2]);
+            std::copy(axis, axis + 3, meshlet.cone);
+            meshlet.cone[3] = cutoff;
+        }
+
+        meshlets.push_back(meshlet);
+        vertices.clear();
+    };
+
+    uint32_t first = 0;
+    for (uint32_t t = 0; t < triangleCount; t++)
+    {
+        const uint32_t* triangle = &mesh.indices[3 * t];
+        uint32_t meshletIndex = static_cast<uint32_t>(meshlets.size());
+
+        uint32_t newVertices = 0;
+        for (uint32_t corner = 0; corner < 3; corner++)
+            newVertices += owner[triangle[corner]] != meshletIndex;
+        //a repeated vertex in a degenerate triangle counts twice, which only errs on the small side
+
+        if( vertices.size() + newVertices > MESHLET_MAX_VERTICES || t - first >= MESHLET_MAX_TRIANGLES )
+        {
+            finish(first, t);
+            first = t;
+            meshletIndex++;
+        }
+
+        for (uint32_t corner = 0; corner < 3; corner++)
+        {
+            uint32_t v = triangle[corner];
+            if( owner[v] != meshletIndex )
+            {
+                owner[v] = meshletIndex;
+                vertices.push_back(v);
+            }
+        }
+    }
+    if( first < triangleCount )
+        finish(first, triangleCount);
+
+    return meshlets;
+}
+
+void optimizeOverdraw(ImportedMesh& mesh, std::vector<MeshMeshlet>& meshlets)
+{
+    float centre[4];
+    boundingSphere(mesh.positions.data(), nullptr, mesh.vertexCount(), centre);
+
+    //how far out along its own normal a meshlet sits, meshlets without a cone face every way and go last
+    std::vector<float> keys(meshlets.size());
+    for (size_t i = 0; i < meshlets.size(); i++)
+    {
+        auto& meshlet = meshlets[i];
+        keys[i] = -INFINITY;
+        if( meshlet.cone[3] > -1.f )
+        {
+            keys[i] = (meshlet.boundingSphere[0] - centre[0]) * meshlet.cone[0] + (meshlet.boundingSphere[1] - centre[1]) * meshlet.cone[1]
+                + (meshlet.boundingSphere[2] - centre[2]) * meshlet.cone[2];
+        }
+    }
+
+    std::vector<uint32_t> order(meshlets.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return keys[a] > keys[b]; });
+
+    std::vector<uint32_t> indices;
+    indices.reserve(mesh.indices.size());
+    std::vector<MeshMeshlet> sorted;
+    sorted.reserve(meshlets.size());
+    for (uint32_t i : order)
+    {
+        MeshMeshlet meshlet = meshlets[i];
+        auto begin = mesh.indices.begin() + meshlet.firstIndex;
+        meshlet.firstIndex = static_cast<uint32_t>(indices.size());
+        indices.insert(indices.end(), begin, begin + meshlet.indexCount);
+        sorted.push_back(meshlet);
+    }
+
+    mesh.indices.swap(indices);
+    meshlets.swap(sorted);
+}
+
+void optimizeVertexFetch(ImportedMesh& mesh)
+{
+    std::vector<uint32_t> remap(mesh.vertexCount(), UINT32_MAX);
+    ImportedMesh fetched;
+    fetched.positions.reserve(mesh.positions.size());
+    fetched.normals.reserve(mesh.normals.size());
+    fetched.uvs.reserve(mesh.uvs.size());
+
+    for (uint32_t& index : mesh.indices)
+    {
+        if( remap[index] == UINT32_MAX )
+        {
+            remap[index] = fetched.vertexCount();
+            fetched.positions.insert(fetched.positions.end(), &mesh.positions[3 * index], &mesh.positions[3 * index] + 3);
+            fetched.normals.insert(fetched.normals.end(), &mesh.normals[3 * index], &mesh.normals[3 * index] + 3);
+            fetched.uvs.insert(fetched.uvs.end(), &mesh.uvs[2 * index], &mesh.uvs[2 * index] + 2);
+        }
+        index = remap[index];
+    }
+
+    mesh.positions.swap(fetched.positions);
+    mesh.normals.swap(fetched.normals);
+    mesh.uvs.swap(fetched.uvs);
+}
+
+float cacheMissRatio(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize)
+{
+    if( indices.empty() )
+        return 0.f;
+
+    //when each vertex went in, it's still cached while fewer than cacheSize misses have happened since
+    std::vector<uint64_t> insertedAt(vertexCount, 0);
+    uint64_t misses = 0;
+    for (uint32_t index : indices)
+    {
+        if( insertedAt[index] == 0 || misses - insertedAt[index] >= cacheSize )
+        {
+            misses++;
+            insertedAt[index] = misses;
+        }
+    }
+
+    return static_cast<float>(misses) / (indices.size() / 3);
+}
+
+uint16_t floatToHalf(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000;
+    uint32_t magnitude = bits & 0x7fffffff;
+
+    //inf and nan, then anything that rounds past the largest half
+    if( magnitude >= 0x7f800000 )
+        return static_cast<uint16_t>(sign | 0x7c00 | (magnitude > 0x7f800000 ? 0x200 : 0));
+    if( magnitude >= 0x477ff000 )
+        return static_cast<uint16_t>(sign | 0x7c00);
+
+    //below the smallest normal half, a count of 2^-24 steps
+    if( magnitude < 0x38800000 )
+    {
+        float absolute;
+        std::memcpy(&absolute, &magnitude, sizeof(absolute));
+        return static_cast<uint16_t>(sign | static_cast<uint32_t>(std::nearbyint(absolute * 16777216.f)));
+    }
+
+    //rebias the exponent and round the 13 dropped mantissa bits to nearest even
+    uint32_t half = magnitude - 0x38000000;
+    half = (half + 0x0fff + ((half >> 13) & 1)) >> 13;
+    return static_cast<uint16_t>(sign | half);
+}
+
+void encodeOctahedral(const float normal[3], int16_t encoded[2])
+{
+    float length = std::fabs(normal[0]) + std::fabs(normal[1]) + std::fabs(normal[2]);
+    float x = length > 0.f ? normal[0] / length : 0.f;
+    float y = length > 0.f ? normal[1] / length : 0.f;
+
+    //the lower half folds out over the corners
+    if( normal[2] < 0.f )
+    {
+        float foldedX = (1.f - std::fabs(y)) * (x >= 0.f ? 1.f : -1.f);
+        float foldedY = (1.f - std::fabs(x)) * (y >= 0.f ? 1.f : -1.f);
+        x = foldedX;
+        y = foldedY;
+    }
+
+    encoded[0] = static_cast<int16_t>(std::lround(std::clamp(x, -1.f, 1.f) * 32767.f));
+    encoded[1] = static_cast<int16_t>(std::lround(std::clamp(y, -1.f, 1.f) * 32767.f));
+}
+
+uint64_t writeMeshFile(const std::string& path, const ImportedMesh& mesh, const std::vector<MeshMeshlet>& meshlets)
+{
+    uint32_t vertexCount = mesh.vertexCount();
+    uint32_t indexSize = vertexCount <= 65536 ? 2 : 4;
+
+    MeshFileHeader header = {};
+    header.magic = MESH_FILE_MAGIC;
+    header.version = MESH_FILE_VERSION;
+    header.vertexCount = vertexCount;
+    header.indexCount = static_cast<uint32_t>(mesh.indices.size());
+    header.meshletCount = static_cast<uint32_t>(meshlets.size());
+    header.indexSize = indexSize;
+    boundingSphere(mesh.positions.data(), nullptr, vertexCount, header.boundingSphere);
+    header.vertexOffset = alignUp(sizeof(MeshFileHeader), MESH_FILE_ALIGNMENT);
+    header.indexOffset = alignUp(header.vertexOffset + static_cast<uint64_t>(vertexCount) * sizeof(MeshVertex), MESH_FILE_ALIGNMENT);
+    header.meshletOffset = alignUp(header.indexOffset + static_cast<uint64_t>(header.indexCount) * indexSize, MESH_FILE_ALIGNMENT);
+    header.fileSize = header.meshletOffset + static_cast<uint64_t>(header.meshletCount) * sizeof(MeshMeshlet);
+
+    std::vector<uint8_t> data(static_cast<size_t>(header.fileSize), 0);
+    std::memcpy(data.data(), &header, sizeof(header));
+
+    auto* vertices = reinterpret_cast<MeshVertex*>(data.data() + header.vertexOffset);
+    for (uint32_t v = 0; v < vertexCount; v++)
+    {
+        MeshVertex vertex = {};
+        for (uint32_t axis = 0; axis < 3; axis++)
+            vertex.position[axis] = floatToHalf(mesh.positions[3 * v + axis]);
+        encodeOctahedral(&mesh.normals[3 * v], vertex.normal);
+        vertex.uv[0] = floatToHalf(mesh.uvs[2 * v]);
+        vertex.uv[1] = floatToHalf(mesh.uvs[2 * v + 1]);
+        vertices[v] = vertex;
+    }
+
+    uint8_t* indices = data.data() + header.indexOffset;
+    for (size_t i = 0; i < mesh.indices.size(); i++)
+    {
+        if( indexSize == 2 )
+        {
+            uint16_t index = static_cast<uint16_t>(mesh.indices[i]);
+            std::memcpy(indices + 2 * i, &index, sizeof(index));
+        }
+        else
+            std::memcpy(indices + 4 * i, &mesh.indices[i], sizeof(uint32_t));
+    }
+
+    if( !meshlets.empty() )
+        std::memcpy(data.data() + header.meshletOffset, meshlets.data(), meshlets.size() * sizeof(MeshMeshlet));
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if( !file.is_open() )
+        throw std::runtime_error("failed to open " + path + " for writing!");
+    file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    if( !file )
+        throw std::runtime_error("failed to write " + path + "!");
+
+    return header.fileSize;
+}
+
+MeshImportStats importMesh(const std::string& inputPath, const std::string& outputPath)
+{
+    //the cache most current hardware behaves like, for the before and after numbers only
+    const uint32_t REPORTED_CACHE_SIZE = 16;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    MeshImportStats stats;
+
+    ImportedMesh mesh = loadObj(inputPath);
+    stats.acmrBefore = cacheMissRatio(mesh.indices, mesh.vertexCount(), REPORTED_CACHE_SIZE);
+
+    optimizeVertexCache(mesh.indices, mesh.vertexCount());
+    auto meshlets = buildMeshlets(mesh);
+    optimizeOverdraw(mesh, meshlets);
+    optimizeVertexFetch(mesh);
+
+    stats.acmrAfter = cacheMissRatio(mesh.indices, mesh.vertexCount(), REPORTED_CACHE_SIZE);
+    stats.vertices = mesh.vertexCount();
+    stats.triangles = mesh.triangleCount();
+    stats.meshlets = static_cast<uint32_t>(meshlets.size());
+    stats.fileBytes = writeMeshFile(outputPath, mesh, meshlets);
+    stats.ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    return stats;
+}
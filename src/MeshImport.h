@@ -0,0 +1,64 @@
+#pragma once
+
+#include "MeshFile.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//an indexed triangle mesh with full precision attributes, what the importer works on before it gets
+//quantised into a MeshFile
+struct ImportedMesh
+{
+    std::vector<float> positions; //xyz per vertex
+    std::vector<float> normals;   //xyz per vertex
+    std::vector<float> uvs;       //uv per vertex, v down
+    std::vector<uint32_t> indices;
+
+    uint32_t vertexCount() const { return static_cast<uint32_t>(positions.size() / 3); }
+    uint32_t triangleCount() const { return static_cast<uint32_t>(indices.size() / 3); }
+};
+
+struct MeshImportStats
+{
+    uint32_t vertices = 0;
+    uint32_t triangles = 0;
+    uint32_t meshlets = 0;
+    float acmrBefore = 0.f; //average post transform cache misses per triangle, see cacheMissRatio
+    float acmrAfter = 0.f;
+    uint64_t fileBytes = 0;
+    double ms = 0.0;
+};
+
+//wavefront obj: v, vt, vn and f (polygons are fanned into triangles), everything else is skipped.
+//vertices are deduplicated by their position/uv/normal triple, missing normals are smoothed from the faces
+ImportedMesh loadObj(const std::string& path);
+
+//reorders triangles for the post transform vertex cache (Forsyth's linear speed algorithm)
+void optimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount);
+
+//splits the triangles, in their current order, into runs of at most MESHLET_MAX_VERTICES distinct
+//vertices and MESHLET_MAX_TRIANGLES triangles, with a bounding sphere and normal cone each
+std::vector<MeshMeshlet> buildMeshlets(const ImportedMesh& mesh);
+
+//puts the meshlets facing out from the mesh's centre first, they are the most likely to occlude the rest.
+//rewrites the indices to match, each meshlet keeps its triangles in the same order
+void optimizeOverdraw(ImportedMesh& mesh, std::vector<MeshMeshlet>& meshlets);
+
+//renumbers vertices in order of first use, so the vertex fetches walk forwards through memory. vertices
+//no triangle uses are dropped
+void optimizeVertexFetch(ImportedMesh& mesh);
+
+//misses per triangle through a FIFO cache of cacheSize vertices, 0.5 is the best a big mesh can do and 3
+//the worst
+float cacheMissRatio(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize);
+
+//quantises the vertices and writes the mesh and its meshlets out in the MeshFile format
+uint64_t writeMeshFile(const std::string& path, const ImportedMesh& mesh, const std::vector<MeshMeshlet>& meshlets);
+
+//the whole pipeline: load, optimise, build meshlets, write
+MeshImportStats importMesh(const std::string& inputPath, const std::string& outputPath);
+
+uint16_t floatToHalf(float value);
+//unit vector to two snorm16s on the octahedron
+void encodeOctahedral(const float normal[3], int16_t encoded[2]);
@@ -0,0 +1,337 @@
+#include "PipelineCache.h"
+#include "JobSystem.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+namespace
+{
+    //our own header goes in front of the driver's data so a truncated or corrupted file is caught
+    //before the driver ever sees it, some drivers crash on garbage instead of ignoring it
+    const uint32_t CACHE_FILE_MAGIC = 0x43504b56; //"VKPC"
+    const uint32_t CACHE_FILE_VERSION = 1;
+
+    struct CacheFileHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t driverVersion;
+        uint32_t reserved;
+        uint64_t dataSize;
+        uint64_t dataHash;
+    };
+
+    uint64_t fnv1a(const char* data, size_t size)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for( size_t i = 0; i < size; i++ )
+        {
+            hash ^= static_cast<uint8_t>(data[i]);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    double millisecondsSince(std::chrono::high_resolution_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+}
+
+PipelineCache::PipelineCache(VkDevice device, const VkPhysicalDeviceProperties& properties, const std::string& path, bool creationFeedbackEnabled)
+    : _device(device), _properties(properties), _path(path), _creationFeedbackEnabled(creationFeedbackEnabled)
+{
+    std::vector<char> initialData = loadValidated();
+    _loadedBytes = initialData.size();
+
+    VkPipelineCacheCreateInfo createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    createInfo.initialDataSize = initialData.size();
+    createInfo.pInitialData = initialData.empty() ? nullptr : initialData.data();
+
+    if( vkCreatePipelineCache(_device, &createInfo, nullptr, &_cache) != VK_SUCCESS )
+    {
+        //the spec says bad initial data is ignored but not every driver agrees, retry with an empty cache
+        createInfo.initialDataSize = 0;
+        createInfo.pInitialData = nullptr;
+        _loadedBytes = 0;
+
+        if( vkCreatePipelineCache(_device, &createInfo, nullptr, &_cache) != VK_SUCCESS )
+            throw std::runtime_error("failed to create pipeline cache!");
+    }
+}
+
+PipelineCache::~PipelineCache()
+{
+    vkDestroyPipelineCache(_device, _cache, nullptr);
+}
+
+std::vector<char> PipelineCache::loadValidated() const
+{
+    if( _path.empty() )
+        return {};
+
+    std::ifstream file(_path, std::ios::binary | std::ios::ate);
+    if( !file.is_open() )
+        return {};
+
+    size_t fileSize = static_cast<size_t>(file.tellg());
+    if( fileSize < sizeof(CacheFileHeader) )
+    {
+        std::cerr << "pipeline cache " << _path << " is truncated, ignoring it" << std::endl;
+        return {};
+    }
+
+    CacheFileHeader fileHeader;
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(&fileHeader), sizeof(fileHeader));
+
+    if( fileHeader.magic != CACHE_FILE_MAGIC || fileHeader.version != CACHE_FILE_VERSION || fileHeader.dataSize != fileSize - sizeof(fileHeader) )
+    {
+        std::cerr << "pipeline cache " << _path << " has an unknown format, ignoring it" << std::endl;
+        return {};
+    }
+
+    //a driver update keeps vendor, device and usually the uuid but can still change the binaries
+    if( fileHeader.driverVersion != _properties.driverVersion )
+    {
+        std::cout << "pipeline cache was written by a different driver version, rebuilding it" << std::endl;
+        return {};
+    }
+
+    std::vector<char> data(static_cast<size_t>(fileHeader.dataSize));
+    file.read(data.data(), data.size());
+
+    if( !file || fnv1a(data.data(), data.size()) != fileHeader.dataHash )
+    {
+        std::cerr << "pipeline cache " << _path << " is corrupt, ignoring it" << std::endl;
+        return {};
+    }
+
+    VkPipelineCacheHeaderVersionOne driverHeader;
+    if( data.size() < sizeof(driverHeader) )
+        return {};
+    std::memcpy(&driverHeader, data.data(), sizeof(driverHeader));
+
+    if( driverHeader.headerSize < sizeof(driverHeader) || driverHeader.headerSize > data.size()
+        || driverHeader.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+        || driverHeader.vendorID != _properties.vendorID
+        || driverHeader.deviceID != _properties.deviceID
+        || std::memcmp(driverHeader.pipelineCacheUUID, _properties.pipelineCacheUUID, VK_UUID_SIZE) != 0 )
+    {
+        std::cout << "pipeline cache was written for a different device, rebuilding it" << std::endl;
+        return {};
+    }
+
+    return data;
+}
+
+void PipelineCache::save() const
+{
+    if( _path.empty() )
+        return;
+
+    size_t dataSize = 0;
+    if( vkGetPipelineCacheData(_device, _cache, &dataSize, nullptr) != VK_SUCCESS )
+        throw std::runtime_error("failed to query pipeline cache size!");
+
+    std::vector<char> data(dataSize);
+    if( vkGetPipelineCacheData(_device, _cache, &dataSize, data.data()) != VK_SUCCESS )
+        throw std::runtime_error("failed to read pipeline cache data!");
+    data.resize(dataSize);
+
+    CacheFileHeader fileHeader = {};
+    fileHeader.magic = CACHE_FILE_MAGIC;
+    fileHeader.version = CACHE_FILE_VERSION;
+    fileHeader.driverVersion = _properties.driverVersion;
+    fileHeader.dataSize = data.size();
+    fileHeader.dataHash = fnv1a(data.data(), data.size());
+
+    //write next to the real file and rename over it so a crash mid write never leaves a half cache behind
+    std::string tempPath = _path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if( !file.is_open() )
+        {
+            std::cerr << "failed to open " << tempPath << " for writing, pipeline cache not saved" << std::endl;
+            return;
+        }
+
+        file.write(reinterpret_cast<const char*>(&fileHeader), sizeof(fileHeader));
+        file.write(data.data(), data.size());
+        if( !file )
+        {
+            std::cerr << "failed to write " << tempPath << ", pipeline cache not saved" << std::endl;
+            return;
+        }
+    }
+
+    std::remove(_path.c_str());
+    if( std::rename(tempPath.c_str(), _path.c_str()) != 0 )
+        std::cerr << "failed to move pipeline cache into place at " << _path << std::endl;
+}
+
+void PipelineCache::recordFeedback(const VkPipelineCreationFeedbackEXT& feedback, double ms)
+{
+    _creationMicroseconds.fetch_add(static_cast<uint64_t>(ms * 1000.0), std::memory_order_relaxed);
+
+    if( !_creationFeedbackEnabled || !(feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT_EXT) )
+        _unknown.fetch_add(1, std::memory_order_relaxed);
+    else if( feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT_EXT )
+        _hits.fetch_add(1, std::memory_order_relaxed);
+    else
+        _misses.fetch_add(1, std::memory_order_relaxed);
+}
+
+VkPipeline PipelineCache::createGraphicsPipeline(const VkGraphicsPipelineCreateInfo& createInfo)
+{
+    VkPipelineCreationFeedbackEXT feedback = {};
+    VkPipelineCreationFeedbackCreateInfoEXT feedbackInfo = {};
+    VkGraphicsPipelineCreateInfo chainedInfo = createInfo;
+
+    if( _creationFeedbackEnabled )
+    {
+        feedbackInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO_EXT;
+        feedbackInfo.pNext = createInfo.pNext;
+        feedbackInfo.pPipelineCreationFeedback = &feedback;
+        chainedInfo.pNext = &feedbackInfo;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    if( vkCreateGraphicsPipelines(_device, _cache, 1, &chainedInfo, nullptr, &pipeline) != VK_SUCCESS )
+        throw std::runtime_error("failed to create graphics pipeline!");
+
+    recordFeedback(feedback, millisecondsSince(start));
+    return pipeline;
+}
+
+VkPipeline PipelineCache::createComputePipeline(const VkComputePipelineCreateInfo& createInfo)
+{
+    VkPipelineCreationFeedbackEXT feedback = {};
+    VkPipelineCreationFeedbackCreateInfoEXT feedbackInfo = {};
+    VkComputePipelineCreateInfo chainedInfo = createInfo;
+
+    if( _creationFeedbackEnabled )
+    {
+        feedbackInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO_EXT;
+        feedbackInfo.pNext = createInfo.pNext;
+        feedbackInfo.pPipelineCreationFeedback = &feedback;
+        chainedInfo.pNext = &feedbackInfo;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    if( vkCreateComputePipelines(_device, _cache, 1, &chainedInfo, nullptr, &pipeline) != VK_SUCCESS )
+        throw std::runtime_error("failed to create compute pipeline!");
+
+    recordFeedback(feedback, millisecondsSince(start));
+    return pipeline;
+}
+
+std::vector<VkPipeline> PipelineCache::createGraphicsPipelines(JobSystem& jobs, const std::vector<VkGraphicsPipelineCreateInfo>& createInfos)
+{
+    std::vector<VkPipeline> pipelines(createInfos.size(), VK_NULL_HANDLE);
+    std::vector<std::string> errors(createInfos.size());
+
+    jobs.parallelFor(static_cast<uint32_t>(createInfos.size()), 1, [&](uint32_t begin, uint32_t end, uint32_t) {
+        for( uint32_t i = begin; i < end; i++ )
+        {
+            try
+            {
+                pipelines[i] = createGraphicsPipeline(createInfos[i]);
+            }
+            catch( const std::exception& e )
+            {
+                errors[i] = e.what();
+            }
+        }
+    });
+
+    //rethrow on this thread once everything has finished, after cleaning up whatever did get created
+    for( const auto& error : errors )
+    {
+        if( error.empty() )
+            continue;
+
+        for( auto pipeline : pipelines )
+            vkDestroyPipeline(_device, pipeline, nullptr);
+        throw std::runtime_error(error);
+    }
+
+    return pipelines;
+}
+
+std::vector<VkPipeline> PipelineCache::createComputePipelines(JobSystem& jobs, const std::vector<VkComputePipelineCreateInfo>& createInfos)
+{
+    std::vector<VkPipeline> pipelines(createInfos.size(), VK_NULL_HANDLE);
+    std::vector<std::string> errors(createInfos.size());
+
+    jobs.parallelFor(static_cast<uint32_t>(createInfos.size()), 1, [&](uint32_t begin, uint32_t end, uint32_t) {
+        for( uint32_t i = begin; i < end; i++ )
+        {
+            try
+            {
+                pipelines[i] = createComputePipeline(createInfos[i]);
+            }
+            catch( const std::exception& e )
+            {
+                errors[i] = e.what();
+            }
+        }
+    });
+
+    for( const auto& error : errors )
+    {
+        if( error.empty() )
+            continue;
+
+        for( auto pipeline : pipelines )
+            vkDestroyPipeline(_device, pipeline, nullptr);
+        throw std::runtime_error(error);
+    }
+
+    return pipelines;
+}
+
+PipelineCacheStats PipelineCache::stats() const
+{
+    PipelineCacheStats result;
+    result.loadedFromDisk = _loadedBytes > 0;
+    result.loadedBytes = _loadedBytes;
+    result.hits = _hits.load(std::memory_order_relaxed);
+    result.misses = _misses.load(std::memory_order_relaxed);
+    result.unknown = _unknown.load(std::memory_order_relaxed);
+    result.creationMs = _creationMicroseconds.load(std::memory_order_relaxed) / 1000.0;
+    return result;
+}
+
+void PipelineCache::printStats(std::ostream& out) const
+{
+    PipelineCacheStats s = stats();
+    uint32_t total = s.hits + s.misses + s.unknown;
+
+    out << "pipeline cache: " << (s.loadedFromDisk ? "warm (" + std::to_string(s.loadedBytes) + " bytes loaded)" : std::string("cold")) << std::endl;
+    out << "  pipelines created: " << total << " in " << s.creationMs << " ms (summed over threads)" << std::endl;
+
+    if( total == 0 )
+        return;
+
+    if( s.unknown == total )
+    {
+        out << "  hit rate: unknown, " << VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME << " not available" << std::endl;
+        return;
+    }
+
+    out << "  hits: " << s.hits << " (" << (100.0 * s.hits / total) << "%)"
+        << ", misses: " << s.misses << " (" << (100.0 * s.misses / total) << "%)";
+    if( s.unknown > 0 )
+        out << ", unknown: " << s.unknown;
+    out << std::endl;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <atomic>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class JobSystem;
+
+struct PipelineCacheStats
+{
+    bool loadedFromDisk = false;
+    size_t loadedBytes = 0;
+    uint32_t hits = 0;
+    uint32_t misses = 0;
+    uint32_t unknown = 0; //created without VK_EXT_pipeline_creation_feedback, so we can't tell
+    double creationMs = 0.0;
+};
+
+//a VkPipelineCache that is loaded from and saved back to disk. data from a different driver or
+//device is thrown away instead of handed to the driver, and hits/misses are counted through
+//VK_EXT_pipeline_creation_feedback when the device has it
+class PipelineCache
+{
+public:
+    //an empty path keeps the cache in memory only
+    PipelineCache(VkDevice device, const VkPhysicalDeviceProperties& properties, const std::string& path, bool creationFeedbackEnabled);
+    ~PipelineCache();
+
+    PipelineCache(const PipelineCache&) = delete;
+    PipelineCache& operator=(const PipelineCache&) = delete;
+
+    VkPipelineCache handle() const { return _cache; }
+
+    VkPipeline createGraphicsPipeline(const VkGraphicsPipelineCreateInfo& createInfo);
+    VkPipeline createComputePipeline(const VkComputePipelineCreateInfo& createInfo);
+
+    //one job per pipeline, VkPipelineCache is internally synchronised so they can all share it
+    std::vector<VkPipeline> createGraphicsPipelines(JobSystem& jobs, const std::vector<VkGraphicsPipelineCreateInfo>& createInfos);
+    std::vector<VkPipeline> createComputePipelines(JobSystem& jobs, const std::vector<VkComputePipelineCreateInfo>& createInfos);
+
+    void save() const;
+
+    PipelineCacheStats stats() const;
+    void printStats(std::ostream& out) const;
+
+private:
+    std::vector<char> loadValidated() const;
+    void recordFeedback(const VkPipelineCreationFeedbackEXT& feedback, double ms);
+
+    VkDevice _device;
+    VkPhysicalDeviceProperties _properties;
+    std::string _path;
+    bool _creationFeedbackEnabled;
+    VkPipelineCache _cache = VK_NULL_HANDLE;
+    size_t _loadedBytes = 0;
+    std::atomic<uint32_t> _hits{0};
+    std::atomic<uint32_t> _misses{0};
+    std::atomic<uint32_t> _unknown{0};
+    std::atomic<uint64_t> _creationMicroseconds{0};
+};
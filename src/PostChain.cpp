@@ -0,0 +1,343 @@
+#include "PostChain.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+    //local_size_x and local_size_y in post.glsl
+    const uint32_t POST_GROUP_SIZE = 8;
+
+    //levels smaller than this on either side add nothing but dispatches
+    const uint32_t MIN_BLOOM_LEVEL_SIZE = 4;
+
+    //the flags in post.glsl
+    const uint32_t POST_PREFILTER = 1;
+    const uint32_t POST_ENCODE_SRGB = 2;
+
+    //matches the push constants in post.glsl
+    struct PostPushConstants
+    {
+        BindlessHandle source;
+        BindlessHandle secondSource;
+        BindlessHandle destination;
+        uint32_t flags;
+        float params[4];
+    };
+
+    static_assert(sizeof(PostPushConstants) <= BINDLESS_PUSH_CONSTANT_SIZE, "post push constants don't fit");
+
+    VkExtent2D bloomExtent(VkExtent2D extent, uint32_t level)
+    {
+        return {std::max(extent.width >> (level + 1), 1u), std::max(extent.height >> (level + 1), 1u)};
+    }
+}
+
+PostChain::PostChain(VkDevice device, GpuAllocator& allocator, BindlessHeap& bindless, VkRenderPass renderPass,
+    const std::vector<uint32_t>& sharedFamilies, uint32_t frameSlots, VkExtent2D extent, const PostChainSettings& settings)
+    : _device(device), _allocator(allocator), _bindless(bindless), _renderPass(renderPass), _sharedFamilies(sharedFamilies),
+      _settings(settings), _slots(frameSlots)
+{
+    if( !_bindless.hasStorageImages() )
+        throw std::runtime_error("the post chain needs storage images in the bindless heap!");
+
+    _settings.bloomLevels = std::min(_settings.bloomLevels, POST_MAX_BLOOM_LEVELS);
+
+    for (auto& slot : _slots)
+        createSlotImages(slot, extent);
+}
+
+PostChain::~PostChain()
+{
+    //only destroyed once the device is idle, so nothing is waiting out frames in flight
+    for (auto& slot : _slots)
+    {
+        destroySlotImages(slot);
+        _bindless.releaseStorageImage(slot.sceneHandle, 0);
+        _bindless.releaseStorageImage(slot.outputHandle, 0);
+
+        for (auto& binding : slot.bloom)
+        {
+            if( binding.handle != INVALID_BINDLESS_HANDLE )
+                _bindless.releaseStorageImage(binding.handle, 0);
+        }
+        if( slot.ldr.handle != INVALID_BINDLESS_HANDLE )
+            _bindless.releaseStorageImage(slot.ldr.handle, 0);
+    }
+}
+
+uint32_t PostChain::bloomLevels(VkExtent2D extent) const
+{
+    uint32_t levels = 0;
+    while( levels < _settings.bloomLevels && std::min(extent.width, extent.height) >> (levels + 1) >= MIN_BLOOM_LEVEL_SIZE )
+        levels++;
+    return levels;
+}
+
+void PostChain::beginFrame(uint32_t frameSlot, VkExtent2D extent)
+{
+    auto& slot = _slots[frameSlot];
+    if( slot.extent.width == extent.width && slot.extent.height == extent.height )
+        return;
+
+    //the slot's last frame is done, its fence has been waited on. the handles stay, other slots' frames
+    //may still be reading theirs but never this slot's
+    destroySlotImages(slot);
+    createSlotImages(slot, extent);
+}
+
+void PostChain::createSlotImages(FrameSlot& slot, VkExtent2D extent)
+{
+    slot.extent = extent;
+
+    createImage(extent, SCENE_FORMAT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_STORAGE_BIT,
+        slot.sceneImage, slot.sceneView, slot.sceneMemory);
+    createImage(extent, OUTPUT_FORMAT, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+        slot.outputImage, slot.outputView, slot.outputMemory);
+
+    VkFramebufferCreateInfo framebufferInfo = {};
+    framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    framebufferInfo.renderPass = _renderPass;
+    framebufferInfo.attachmentCount = 1;
+    framebufferInfo.pAttachments = &slot.sceneView;
+    framebufferInfo.width = extent.width;
+    framebufferInfo.height = extent.height;
+    framebufferInfo.layers = 1;
+
+    if (vkCreateFramebuffer(_device, &framebufferInfo, nullptr, &slot.framebuffer) != VK_SUCCESS)
+        throw std::runtime_error("failed to create post scene framebuffer!");
+
+    if( slot.sceneHandle == INVALID_BINDLESS_HANDLE )
+    {
+        slot.sceneHandle = _bindless.addStorageImage(slot.sceneView);
+        slot.outputHandle = _bindless.addStorageImage(slot.outputView);
+    }
+    else
+    {
+        _bindless.updateStorageImage(slot.sceneHandle, slot.sceneView);
+        _bindless.updateStorageImage(slot.outputHandle, slot.outputView);
+    }
+}
+
+void PostChain::destroySlotImages(FrameSlot& slot)
+{
+    vkDestroyFramebuffer(_device, slot.framebuffer, nullptr);
+    vkDestroyImageView(_device, slot.sceneView, nullptr);
+    vkDestroyImage(_device, slot.sceneImage, nullptr);
+    _allocator.free(slot.sceneMemory);
+    vkDestroyImageView(_device, slot.outputView, nullptr);
+    vkDestroyImage(_device, slot.outputImage, nullptr);
+    _allocator.free(slot.outputMemory);
+
+    slot.framebuffer = VK_NULL_HANDLE;
+    slot.sceneView = VK_NULL_HANDLE;
+    slot.sceneImage = VK_NULL_HANDLE;
+    slot.outputView = VK_NULL_HANDLE;
+    slot.outputImage = VK_NULL_HANDLE;
+}
+
+void PostChain::createImage(VkExtent2D extent, VkFormat format, VkImageUsageFlags usage, VkImage& image, VkImageView& view, GpuAllocation& memory)
+{
+    //written on one queue and read on the other every frame
+    VkImageCreateInfo imageInfo = {};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = format;
+    imageInfo.extent = {extent.width, extent.height, 1};
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = usage;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    if( _sharedFamilies.size() > 1 )
+    {
+        imageInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        imageInfo.queueFamilyIndexCount = static_cast<uint32_t>(_sharedFamilies.size());
+        imageInfo.pQueueFamilyIndices = _sharedFamilies.data();
+    }
+
+    if (vkCreateImage(_device, &imageInfo, nullptr, &image) != VK_SUCCESS)
+        throw std::runtime_error("failed to create post image!");
+
+    VkMemoryRequirements memoryRequirements = {};
+    vkGetImageMemoryRequirements(_device, image, &memoryRequirements);
+    memory = _allocator.allocate(memoryRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, GpuResourceKind::Image);
+    vkBindImageMemory(_device, image, memory.memory, memory.offset);
+
+    VkImageViewCreateInfo viewInfo = {};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = format;
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.layerCount = 1;
+
+    if (vkCreateImageView(_device, &viewInfo, nullptr, &view) != VK_SUCCESS)
+        throw std::runtime_error("failed to create post image view!");
+}
+
+RenderGraphResource PostChain::declareScene(RenderGraph& graph, uint32_t frameSlot)
+{
+    auto& slot = _slots[frameSlot];
+
+    //the slot's last post chain is done with it, the geometry clears it anyway
+    auto scene = graph.importImage("post scene", slot.sceneImage, slot.sceneView, SCENE_FORMAT, slot.extent, {});
+    graph.exportResource(scene, RenderGraphAccess::StorageRead);
+    return scene;
+}
+
+void PostChain::addPasses(RenderGraph& graph, uint32_t frameSlot, const PostPipelines& pipelines)
+{
+    auto& slot = _slots[frameSlot];
+
+    //the geometry left the scene in GENERAL and the semaphore the compute queue waits on makes it visible
+    RenderGraphState rendered = {};
+    rendered.layout = VK_IMAGE_LAYOUT_GENERAL;
+    auto scene = graph.importImage("post scene", slot.sceneImage, slot.sceneView, SCENE_FORMAT, slot.extent, rendered);
+
+    //whatever the last composite read out of the output is written over
+    auto output = graph.importImage("post output", slot.outputImage, slot.outputView, OUTPUT_FORMAT, slot.extent, {});
+    graph.exportResource(output, RenderGraphAccess::TransferRead);
+
+    //pass callbacks look the handles up when they run, the transients' only exist after compile()
+    auto dispatch = [this](VkCommandBuffer commandBuffer, VkPipeline pipeline, const PostPushConstants& pushConstants, VkExtent2D extent) {
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+        _bindless.bind(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE);
+        vkCmdPushConstants(commandBuffer, _bindless.pipelineLayout(), VK_SHADER_STAGE_ALL, 0, sizeof(pushConstants), &pushConstants);
+        vkCmdDispatch(commandBuffer, (extent.width + POST_GROUP_SIZE - 1) / POST_GROUP_SIZE, (extent.height + POST_GROUP_SIZE - 1) / POST_GROUP_SIZE, 1);
+    };
+
+    slot.bloomLevels = _settings.bloom ? bloomLevels(slot.extent) : 0;
+    for (uint32_t level = 0; level < POST_MAX_BLOOM_LEVELS; level++)
+    {
+        slot.bloom[level].resource = INVALID_RENDER_GRAPH_RESOURCE;
+        if( level < slot.bloomLevels )
+            slot.bloom[level].resource = graph.createImage("bloom", {SCENE_FORMAT, bloomExtent(slot.extent, level), 0});
+    }
+
+    //down the chain, the first level keeps only what is over the threshold
+    for (uint32_t level = 0; level < slot.bloomLevels; level++)
+    {
+        VkExtent2D extent = bloomExtent(slot.extent, level);
+        auto execute = [=](VkCommandBuffer commandBuffer) {
+            auto& s = _slots[frameSlot];
+            PostPushConstants pushConstants = {};
+            pushConstants.source = level == 0 ? s.sceneHandle : s.bloom[level - 1].handle;
+            pushConstants.secondSource = INVALID_BINDLESS_HANDLE;
+            pushConstants.destination = s.bloom[level].handle;
+            pushConstants.flags = level == 0 ? POST_PREFILTER : 0;
+            pushConstants.params[0] = _settings.bloomThreshold;
+            pushConstants.params[1] = _settings.bloomKnee;
+            dispatch(commandBuffer, pipelines.downsample, pushConstants, extent);
+        };
+
+        auto source = level == 0 ? scene : slot.bloom[level - 1].resource;
+        graph.addPass(level == 0 ? "bloom prefilter" : "bloom downsample", execute)
+            .use(source, RenderGraphAccess::StorageRead)
+            .use(slot.bloom[level].resource, RenderGraphAccess::StorageWrite);
+    }
+
+    //and back up, each level adding in the one below it
+    for (uint32_t smaller = slot.bloomLevels; smaller > 1; smaller--)
+    {
+        uint32_t level = smaller - 2;
+        VkExtent2D extent = bloomExtent(slot.extent, level);
+        graph.addPass("bloom upsample", [=](VkCommandBuffer commandBuffer) {
+            auto& s = _slots[frameSlot];
+            PostPushConstants pushConstants = {};
+            pushConstants.source = s.bloom[level + 1].handle;
+            pushConstants.secondSource = INVALID_BINDLESS_HANDLE;
+            pushConstants.destination = s.bloom[level].handle;
+            dispatch(commandBuffer, pipelines.upsample, pushConstants, extent);
+        }).use(slot.bloom[level + 1].resource, RenderGraphAccess::StorageRead)
+            .use(slot.bloom[level].resource, RenderGraphAccess::StorageReadWrite);
+    }
+
+    //without fxaa the tonemap writes the output directly
+    slot.ldr.resource = output;
+    if( _settings.fxaa )
+        slot.ldr.resource = graph.createImage("tonemapped", {OUTPUT_FORMAT, slot.extent, 0});
+
+    bool bloom = slot.bloomLevels > 0;
+    bool fxaa = _settings.fxaa;
+    auto tonemap = graph.addPass("tonemap", [=](VkCommandBuffer commandBuffer) {
+        auto& s = _slots[frameSlot];
+        PostPushConstants pushConstants = {};
+        pushConstants.source = s.sceneHandle;
+        pushConstants.secondSource = bloom ? s.bloom[0].handle : INVALID_BINDLESS_HANDLE;
+        pushConstants.destination = fxaa ? s.ldr.handle : s.outputHandle;
+        pushConstants.flags = _settings.encodeSrgb ? POST_ENCODE_SRGB : 0;
+        pushConstants.params[0] = _settings.exposure;
+        pushConstants.params[1] = _settings.bloomStrength;
+        dispatch(commandBuffer, pipelines.tonemap, pushConstants, s.extent);
+    });
+    tonemap.use(scene, RenderGraphAccess::StorageRead).use(slot.ldr.resource, RenderGraphAccess::StorageWrite);
+    if( bloom )
+        tonemap.use(slot.bloom[0].resource, RenderGraphAccess::StorageRead);
+
+    if( fxaa )
+    {
+        graph.addPass("fxaa", [=](VkCommandBuffer commandBuffer) {
+            auto& s = _slots[frameSlot];
+            PostPushConstants pushConstants = {};
+            pushConstants.source = s.ldr.handle;
+            pushConstants.secondSource = INVALID_BINDLESS_HANDLE;
+            pushConstants.destination = s.outputHandle;
+            dispatch(commandBuffer, pipelines.fxaa, pushConstants, s.extent);
+        }).use(slot.ldr.resource, RenderGraphAccess::StorageRead).use(output, RenderGraphAccess::StorageWrite);
+    }
+}
+
+void PostChain::bindTransients(const RenderGraph& graph, uint32_t frameSlot)
+{
+    auto& slot = _slots[frameSlot];
+    for (uint32_t level = 0; level < slot.bloomLevels; level++)
+        bindTransient(graph, slot.bloom[level]);
+    if( _settings.fxaa )
+        bindTransient(graph, slot.ldr);
+}
+
+void PostChain::bindTransient(const RenderGraph& graph, TransientBinding& binding)
+{
+    //the graph keeps a slot's transients until its shape changes, so this is almost always a no-op. the
+    //handle is the slot's own, no other frame in flight reads it
+    VkImageView view = graph.imageView(binding.resource);
+    if( view == binding.view )
+        return;
+
+    if( binding.handle == INVALID_BINDLESS_HANDLE )
+        binding.handle = _bindless.addStorageImage(view);
+    else
+        _bindless.updateStorageImage(binding.handle, view);
+    binding.view = view;
+}
+
+void PostChain::addComposite(RenderGraph& graph, uint32_t frameSlot, RenderGraphResource target, VkImage targetImage, VkExtent2D targetExtent)
+{
+    auto& slot = _slots[frameSlot];
+
+    //the compute graph left it as TransferRead, the semaphore the graphics queue waits on makes it visible
+    RenderGraphState posted = {};
+    posted.layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    auto output = graph.importImage("post output", slot.outputImage, slot.outputView, OUTPUT_FORMAT, slot.extent, posted);
+
+    //a blit rather than a copy, it converts to the target's format (and srgb encodes, if the target does)
+    VkImageBlit region = {};
+    region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.srcSubresource.layerCount = 1;
+    region.srcOffsets[1] = {static_cast<int32_t>(slot.extent.width), static_cast<int32_t>(slot.extent.height), 1};
+    region.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.dstSubresource.layerCount = 1;
+    region.dstOffsets[1] = {static_cast<int32_t>(targetExtent.width), static_cast<int32_t>(targetExtent.height), 1};
+
+    bool sameSize = slot.extent.width == targetExtent.width && slot.extent.height == targetExtent.height;
+    VkFilter filter = sameSize ? VK_FILTER_NEAREST : VK_FILTER_LINEAR;
+    VkImage outputImage = slot.outputImage;
+    graph.addPass("composite", [=](VkCommandBuffer commandBuffer) {
+        vkCmdBlitImage(commandBuffer, outputImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, targetImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            1, &region, filter);
+    }).use(output, RenderGraphAccess::TransferRead).use(target, RenderGraphAccess::TransferWrite);
+}
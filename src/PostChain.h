@@ -0,0 +1,121 @@
+#pragma once
+
+#include "BindlessHeap.h"
+#include "GpuAllocator.h"
+#include "RenderGraph.h"
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+const uint32_t POST_MAX_BLOOM_LEVELS = 8;
+
+struct PostChainSettings
+{
+    bool bloom = true;
+    bool fxaa = true;
+    float exposure = 1.f;
+    float bloomThreshold = 0.8f; //brightest channel, what is under it doesn't bloom
+    float bloomKnee = 0.4f;      //how far under the threshold the bloom fades in
+    float bloomStrength = 0.3f;
+    uint32_t bloomLevels = 5;    //each half the size of the one before, fewer on small targets
+    bool encodeSrgb = true;      //the tonemap writes srgb, for targets that don't encode on write
+};
+
+//the post chain's compute pipelines, all on the bindless pipeline layout and owned by whoever made them
+struct PostPipelines
+{
+    VkPipeline downsample = VK_NULL_HANDLE; //post_downsample.comp
+    VkPipeline upsample = VK_NULL_HANDLE;   //post_upsample.comp
+    VkPipeline tonemap = VK_NULL_HANDLE;    //post_tonemap.comp
+    VkPipeline fxaa = VK_NULL_HANDLE;       //post_fxaa.comp
+};
+
+//post processing as compute passes over storage images in the bindless heap: bloom (a prefiltered
+//downsample chain added back up in place), tonemapping and fxaa.
+//
+//a frame goes through three graphs. the geometry renders into the slot's hdr scene image on the graphics
+//queue (declareScene), the post passes run on the compute queue (addPasses) and leave the slot's ldr output,
+//and a composite back on the graphics queue blits that into the backbuffer (addComposite). the queue
+//submissions between them are synchronised with semaphores by the caller, which is what lets one frame's
+//post chain overlap the next frame's geometry. the scene and output images are the only ones crossing
+//queues and are concurrent across both families, so there are no ownership transfers.
+//
+//the bloom levels and the tonemapped image in front of fxaa are transients of the compute graph. their
+//bindless handles are per frame slot and only rewritten when the graph rebuilds them
+class PostChain
+{
+public:
+    static const VkFormat SCENE_FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
+    static const VkFormat OUTPUT_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+
+    //renderPass is what the geometry draws with, its one attachment is SCENE_FORMAT. sharedFamilies are
+    //the graphics and compute families, the bindless heap needs storage images
+    PostChain(VkDevice device, GpuAllocator& allocator, BindlessHeap& bindless, VkRenderPass renderPass,
+        const std::vector<uint32_t>& sharedFamilies, uint32_t frameSlots, VkExtent2D extent, const PostChainSettings& settings);
+    ~PostChain();
+
+    PostChain(const PostChain&) = delete;
+    PostChain& operator=(const PostChain&) = delete;
+
+    const PostChainSettings& settings() const { return _settings; }
+    uint32_t bloomLevels(VkExtent2D extent) const;
+
+    //once the slot's fence has been waited on. recreates the slot's images if the extent changed
+    void beginFrame(uint32_t frameSlot, VkExtent2D extent);
+
+    //the geometry graph's render target, wants RenderGraphAccess::ColorAttachmentWrite with sceneFramebuffer()
+    RenderGraphResource declareScene(RenderGraph& graph, uint32_t frameSlot);
+    VkFramebuffer sceneFramebuffer(uint32_t frameSlot) const { return _slots[frameSlot].framebuffer; }
+
+    //the post passes, into a graph executed on the compute queue once the geometry is done. call
+    //bindTransients() between the graph's compile() and execute()
+    void addPasses(RenderGraph& graph, uint32_t frameSlot, const PostPipelines& pipelines);
+    void bindTransients(const RenderGraph& graph, uint32_t frameSlot);
+
+    //blits the slot's output into target (a backbuffer declared to graph), once the post passes are done
+    void addComposite(RenderGraph& graph, uint32_t frameSlot, RenderGraphResource target, VkImage targetImage, VkExtent2D targetExtent);
+
+private:
+    //a transient of the compute graph and the storage image handle pointing at it
+    struct TransientBinding
+    {
+        RenderGraphResource resource = INVALID_RENDER_GRAPH_RESOURCE;
+        VkImageView view = VK_NULL_HANDLE;
+        BindlessHandle handle = INVALID_BINDLESS_HANDLE;
+    };
+
+    struct FrameSlot
+    {
+        VkExtent2D extent = {0, 0};
+        VkImage sceneImage = VK_NULL_HANDLE;
+        VkImageView sceneView = VK_NULL_HANDLE;
+        GpuAllocation sceneMemory;
+        VkFramebuffer framebuffer = VK_NULL_HANDLE;
+        VkImage outputImage = VK_NULL_HANDLE;
+        VkImageView outputView = VK_NULL_HANDLE;
+        GpuAllocation outputMemory;
+        BindlessHandle sceneHandle = INVALID_BINDLESS_HANDLE;
+        BindlessHandle outputHandle = INVALID_BINDLESS_HANDLE;
+
+        uint32_t bloomLevels = 0; //this frame's
+        std::array<TransientBinding, POST_MAX_BLOOM_LEVELS> bloom;
+        TransientBinding ldr; //tonemapped, before fxaa
+    };
+
+    void createSlotImages(FrameSlot& slot, VkExtent2D extent);
+    void destroySlotImages(FrameSlot& slot);
+    void createImage(VkExtent2D extent, VkFormat format, VkImageUsageFlags usage, VkImage& image, VkImageView& view, GpuAllocation& memory);
+    void bindTransient(const RenderGraph& graph, TransientBinding& binding);
+
+    VkDevice _device;
+    GpuAllocator& _allocator;
+    BindlessHeap& _bindless;
+    VkRenderPass _renderPass;
+    std::vector<uint32_t> _sharedFamilies;
+    PostChainSettings _settings;
+
+    std::vector<FrameSlot> _slots;
+};
@@ -0,0 +1,349 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+namespace
+{
+    //roughly a minute of a busy frame at 60fps, after that the capture just stops growing
+    const size_t MAX_TRACE_EVENTS = 1 << 20;
+
+    thread_local uint32_t t_cpuScopeDepth = 0;
+
+    void writeJsonString(std::ostream& out, const char* value)
+    {
+        out << '"';
+        for (const char* c = value; *c != '\0'; c++)
+        {
+            if( *c == '"' || *c == '\\' )
+                out << '\\';
+            out << *c;
+        }
+        out << '"';
+    }
+}
+
+Profiler::Profiler(VkDevice device, const VkPhysicalDeviceProperties& properties, uint32_t timestampValidBits, uint32_t frameSlots,
+    uint32_t maxScopesPerFrame)
+    : _device(device), _start(std::chrono::steady_clock::now())
+{
+    _slots.resize(frameSlots);
+
+    //timestampPeriod of 0 means the device can't do timestamps at all
+    _gpuEnabled = timestampValidBits > 0 && properties.limits.timestampPeriod > 0.f;
+    if( !_gpuEnabled )
+        return;
+
+    _nanosecondsPerTick = properties.limits.timestampPeriod;
+    _timestampMask = timestampValidBits >= 64 ? ~0ull : (1ull << timestampValidBits) - 1;
+    _maxQueries = maxScopesPerFrame * 2;
+
+    for (auto& slot : _slots)
+    {
+        VkQueryPoolCreateInfo createInfo = {};
+        createInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        createInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        createInfo.queryCount = _maxQueries;
+
+        if (vkCreateQueryPool(_device, &createInfo, nullptr, &slot.queryPool) != VK_SUCCESS)
+            throw std::runtime_error("failed to create timestamp query pool!");
+    }
+}
+
+Profiler::~Profiler()
+{
+    for (auto& slot : _slots)
+    {
+        if( slot.queryPool != VK_NULL_HANDLE )
+            vkDestroyQueryPool(_device, slot.queryPool, nullptr);
+    }
+}
+
+void Profiler::startTraceCapture()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _capturing = true;
+}
+
+double Profiler::microsecondsSinceStart(std::chrono::steady_clock::time_point time) const
+{
+    return std::chrono::duration<double, std::micro>(time - _start).count();
+}
+
+void Profiler::beginFrame(VkCommandBuffer commandBuffer, uint32_t frameSlot, uint64_t frameNumber)
+{
+    if( !_openScopes.empty() )
+        throw std::runtime_error("gpu profiler scopes left open at the end of a frame!");
+
+    FrameSlot& slot = _slots[frameSlot];
+    if( slot.submitted )
+        collect(slot);
+
+    slot.scopes.clear();
+    slot.queriesUsed = 0;
+    slot.frameNumber = frameNumber;
+    slot.submitted = false;
+    _currentSlot = &slot;
+
+    if( _gpuEnabled )
+        vkCmdResetQueryPool(commandBuffer, slot.queryPool, 0, _maxQueries);
+}
+
+void Profiler::endFrame()
+{
+    if( _currentSlot == nullptr )
+        return;
+
+    if( !_openScopes.empty() )
+        throw std::runtime_error("gpu profiler scopes left open at the end of a frame!");
+
+    _currentSlot->submitUs = microsecondsSinceStart(std::chrono::steady_clock::now());
+    _currentSlot->submitted = true;
+    _currentSlot = nullptr;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _summaryFrames++;
+}
+
+void Profiler::collectPending()
+{
+    std::vector<FrameSlot*> pending;
+    for (auto& slot : _slots)
+    {
+        if( slot.submitted )
+            pending.push_back(&slot);
+    }
+
+    std::sort(pending.begin(), pending.end(), [](const FrameSlot* a, const FrameSlot* b) { return a->frameNumber < b->frameNumber; });
+    for (auto* slot : pending)
+    {
+        collect(*slot);
+        slot->submitted = false;
+    }
+}
+
+void Profiler::beginGpuScope(VkCommandBuffer commandBuffer, const char* name)
+{
+    if( !_gpuEnabled || _currentSlot == nullptr )
+        return;
+
+    //out of queries, remember that there is nothing to end
+    if( _currentSlot->queriesUsed + 2 > _maxQueries )
+    {
+        _droppedScopes++;
+        _openScopes.push_back(UINT32_MAX);
+        return;
+    }
+
+    PendingScope scope = {};
+    scope.name = name;
+    scope.depth = static_cast<uint32_t>(_openScopes.size());
+    scope.beginQuery = _currentSlot->queriesUsed++;
+    scope.endQuery = _currentSlot->queriesUsed++;
+
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, _currentSlot->queryPool, scope.beginQuery);
+
+    _openScopes.push_back(static_cast<uint32_t>(_currentSlot->scopes.size()));
+    _currentSlot->scopes.push_back(scope);
+}
+
+void Profiler::endGpuScope(VkCommandBuffer commandBuffer)
+{
+    if( !_gpuEnabled || _currentSlot == nullptr )
+        return;
+
+    if( _openScopes.empty() )
+        throw std::runtime_error("endGpuScope without a matching beginGpuScope!");
+
+    uint32_t index = _openScopes.back();
+    _openScopes.pop_back();
+    if( index == UINT32_MAX )
+        return;
+
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, _currentSlot->queryPool, _currentSlot->scopes[index].endQuery);
+}
+
+void Profiler::collect(FrameSlot& slot)
+{
+    if( !_gpuEnabled || slot.queriesUsed == 0 )
+        return;
+
+    _ticks.resize(slot.queriesUsed);
+
+    //the slot's fence has been waited on, so this doesn't block. NOT_READY would mean a frame was skipped
+    VkResult result = vkGetQueryPoolResults(_device, slot.queryPool, 0, slot.queriesUsed, _ticks.size() * sizeof(uint64_t),
+        _ticks.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    if( result != VK_SUCCESS )
+        return;
+
+    uint64_t frameStart = _ticks[0] & _timestampMask;
+    auto ticksToMs = [this](uint64_t from, uint64_t to) {
+        return static_cast<double>((to - from) & _timestampMask) * _nanosecondsPerTick / 1e6;
+    };
+
+    _timings.clear();
+    for (const auto& scope : slot.scopes)
+    {
+        GpuScopeTiming timing;
+        timing.name = scope.name;
+        timing.depth = scope.depth;
+        timing.startMs = ticksToMs(frameStart, _ticks[scope.beginQuery] & _timestampMask);
+        timing.durationMs = ticksToMs(_ticks[scope.beginQuery] & _timestampMask, _ticks[scope.endQuery] & _timestampMask);
+        _timings.push_back(timing);
+    }
+
+    //gpu ticks aren't in the cpu's time domain, so the trace places each frame's gpu work at its submit
+    //time, or straight after the previous frame's gpu work if that ran later. good enough to line passes
+    //up against the cpu side, VK_EXT_calibrated_timestamps would make it exact
+    double frameDurationUs = 0.0;
+    for (const auto& timing : _timings)
+        frameDurationUs = std::max(frameDurationUs, (timing.startMs + timing.durationMs) * 1000.0);
+    double frameStartUs = std::max(slot.submitUs, _lastGpuEndUs);
+    _lastGpuEndUs = frameStartUs + frameDurationUs;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (const auto& timing : _timings)
+    {
+        //scopes arrive parent first, so the parent's path is always the prefix left at this depth
+        _keyLengths.resize(timing.depth);
+        _key.resize(timing.depth > 0 ? _keyLengths.back() : 0);
+        _key += '/';
+        _key += timing.name;
+        _keyLengths.push_back(_key.size());
+
+        accumulate(_gpuSummary, _gpuSummaryOrder, _key, timing.depth, timing.name, timing.durationMs);
+
+        if( _capturing )
+            addTraceEvent({timing.name, true, 0, frameStartUs + timing.startMs * 1000.0, timing.durationMs * 1000.0});
+    }
+
+    _gpuSummaryFrames++;
+    //both keep their capacity
+    _lastGpuFrame.swap(_timings);
+}
+
+void Profiler::accumulate(Summary& summary, std::vector<std::string>& order, std::string_view key, uint32_t depth, const char* name, double ms)
+{
+    auto it = summary.find(key);
+    if( it == summary.end() )
+    {
+        it = summary.emplace(std::string(key), SummaryEntry{std::string(depth * 2, ' ') + name, 0.0}).first;
+        order.emplace_back(key);
+    }
+    it->second.totalMs += ms;
+}
+
+void Profiler::addTraceEvent(const TraceEvent& event)
+{
+    if( _trace.size() < MAX_TRACE_EVENTS )
+        _trace.push_back(event);
+}
+
+uint32_t Profiler::threadNumber()
+{
+    auto id = std::this_thread::get_id();
+    auto it = _threadNumbers.find(id);
+    if( it != _threadNumbers.end() )
+        return it->second;
+
+    uint32_t number = static_cast<uint32_t>(_threadNumbers.size());
+    _threadNumbers[id] = number;
+    return number;
+}
+
+void Profiler::recordCpuScope(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end, uint32_t depth)
+{
+    double startUs = microsecondsSinceStart(start);
+    double durationUs = std::chrono::duration<double, std::micro>(end - start).count();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    accumulate(_cpuSummary, _cpuSummaryOrder, name, depth, name, durationUs / 1000.0);
+
+    if( _capturing )
+        addTraceEvent({name, false, threadNumber(), startUs, durationUs});
+}
+
+std::vector<GpuScopeTiming> Profiler::lastGpuFrame() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _lastGpuFrame;
+}
+
+void Profiler::printSummary(std::ostream& out)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    //gpu results trail the cpu by the frames in flight, so each side is averaged over its own frame count
+    uint32_t frames = std::max(_summaryFrames, 1u);
+    uint32_t gpuFrames = std::max(_gpuSummaryFrames, 1u);
+
+    out << std::fixed << std::setprecision(3);
+    if( _gpuEnabled )
+    {
+        out << "  gpu (ms/frame over " << _gpuSummaryFrames << " frames):" << std::endl;
+        for (const auto& key : _gpuSummaryOrder)
+            out << "    " << std::left << std::setw(32) << _gpuSummary[key].label << std::right << std::setw(9) << _gpuSummary[key].totalMs / gpuFrames << std::endl;
+        if( _droppedScopes > 0 )
+            out << "    (" << _droppedScopes << " scopes dropped, out of queries)" << std::endl;
+    }
+    else
+        out << "  gpu: timestamps not supported on this queue" << std::endl;
+
+    //a profiler used for one queue's command buffers only (see the post chain's) has no cpu scopes
+    if( !_cpuSummaryOrder.empty() )
+    {
+        out << "  cpu (ms/frame over " << _summaryFrames << " frames):" << std::endl;
+        for (const auto& key : _cpuSummaryOrder)
+            out << "    " << std::left << std::setw(32) << _cpuSummary[key].label << std::right << std::setw(9) << _cpuSummary[key].totalMs / frames << std::endl;
+    }
+    out << std::defaultfloat << std::setprecision(6);
+
+    for (auto& entry : _gpuSummary)
+        entry.second.totalMs = 0.0;
+    for (auto& entry : _cpuSummary)
+        entry.second.totalMs = 0.0;
+    _summaryFrames = 0;
+    _gpuSummaryFrames = 0;
+    _droppedScopes = 0;
+}
+
+void Profiler::writeChromeTrace(const std::string& path) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    std::ofstream file(path, std::ios::trunc);
+    if( !file.is_open() )
+        throw std::runtime_error("failed to open " + path + " for writing!");
+
+    //pid 1 is the cpu with a track per thread, pid 2 the graphics queue. nested scopes stack up within a track
+    file << std::fixed << std::setprecision(3);
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" << std::endl;
+    file << "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":1,\"args\":{\"name\":\"CPU\"}}," << std::endl;
+    file << "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":2,\"args\":{\"name\":\"GPU\"}}";
+
+    for (const auto& event : _trace)
+    {
+        file << "," << std::endl << "{\"ph\":\"X\",\"name\":";
+        writeJsonString(file, event.name);
+        file << ",\"pid\":" << (event.gpu ? 2 : 1) << ",\"tid\":" << event.thread
+            << ",\"ts\":" << event.startUs << ",\"dur\":" << event.durationUs << "}";
+    }
+
+    file << std::endl << "]}" << std::endl;
+}
+
+ProfileScope::ProfileScope(Profiler* profiler, const char* name)
+    : _profiler(profiler), _name(name), _depth(t_cpuScopeDepth++), _start(std::chrono::steady_clock::now())
+{
+}
+
+ProfileScope::~ProfileScope()
+{
+    t_cpuScopeDepth--;
+    if( _profiler != nullptr )
+        _profiler->recordCpuScope(_name, _start, std::chrono::steady_clock::now(), _depth);
+}
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+//a finished gpu scope, times in ms relative to the first timestamp of its frame
+struct GpuScopeTiming
+{
+    const char* name = nullptr;
+    uint32_t depth = 0;
+    double startMs = 0.0;
+    double durationMs = 0.0;
+};
+
+//cpu scoped timers plus gpu timestamp scopes, with running averages for a console breakdown and an
+//optional capture of every scope for chrome://tracing (or https://ui.perfetto.dev).
+//
+//gpu scopes are written into one VkQueryPool region per frame slot. a slot is only read back when the
+//frame that used it comes round again, by which point its fence has been waited on, so reading the
+//results never stalls. scope names are kept by pointer, they must outlive the profiler (string literals)
+class Profiler
+{
+public:
+    //timestampValidBits of the queue family the frames are submitted on, 0 turns the gpu side off
+    Profiler(VkDevice device, const VkPhysicalDeviceProperties& properties, uint32_t timestampValidBits, uint32_t frameSlots,
+        uint32_t maxScopesPerFrame = 128);
+    ~Profiler();
+
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    bool gpuEnabled() const { return _gpuEnabled; }
+
+    //everything from here on is kept for writeChromeTrace, up to a fixed number of events
+    void startTraceCapture();
+
+    //call first thing in the frame's primary command buffer, outside a render pass, once the slot's
+    //fence has signalled. collects the slot's previous results then resets its queries
+    void beginFrame(VkCommandBuffer commandBuffer, uint32_t frameSlot, uint64_t frameNumber);
+    //after the frame's command buffer has been submitted
+    void endFrame();
+    //reads back every frame still waiting, only once the device is idle
+    void collectPending();
+
+    void beginGpuScope(VkCommandBuffer commandBuffer, const char* name);
+    void endGpuScope(VkCommandBuffer commandBuffer);
+
+    //thread safe, ProfileScope is the usual way in
+    void recordCpuScope(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end, uint32_t depth);
+
+    //gpu scopes of the most recent frame that has been read back
+    std::vector<GpuScopeTiming> lastGpuFrame() const;
+
+    //average time per frame of every scope since the last call, then starts a new window
+    void printSummary(std::ostream& out);
+
+    void writeChromeTrace(const std::string& path) const;
+
+private:
+    struct PendingScope
+    {
+        const char* name;
+        uint32_t depth;
+        uint32_t beginQuery;
+        uint32_t endQuery;
+    };
+
+    struct FrameSlot
+    {
+        VkQueryPool queryPool = VK_NULL_HANDLE;
+        std::vector<PendingScope> scopes;
+        uint32_t queriesUsed = 0;
+        uint64_t frameNumber = 0;
+        double submitUs = 0.0;
+        bool submitted = false;
+    };
+
+    struct SummaryEntry
+    {
+        std::string label; //indented by depth
+        double totalMs = 0.0;
+    };
+
+    struct TraceEvent
+    {
+        const char* name;
+        bool gpu;
+        uint32_t thread;
+        double startUs;
+        double durationUs;
+    };
+
+    void collect(FrameSlot& slot);
+    //std::less<> so lookups take the key as a string_view, only a scope seen for the first time builds strings
+    using Summary = std::map<std::string, SummaryEntry, std::less<>>;
+
+    void accumulate(Summary& summary, std::vector<std::string>& order, std::string_view key, uint32_t depth, const char* name, double ms);
+    void addTraceEvent(const TraceEvent& event);
+    double microsecondsSinceStart(std::chrono::steady_clock::time_point time) const;
+    uint32_t threadNumber();
+
+    VkDevice _device;
+    bool _gpuEnabled = false;
+    double _nanosecondsPerTick = 1.0;
+    uint64_t _timestampMask = ~0ull;
+    uint32_t _maxQueries = 0;
+
+    std::vector<FrameSlot> _slots;
+    FrameSlot* _currentSlot = nullptr;
+    std::vector<uint32_t> _openScopes; //indices into _currentSlot->scopes
+    uint32_t _droppedScopes = 0;
+
+    std::vector<GpuScopeTiming> _lastGpuFrame;
+    double _lastGpuEndUs = 0.0;
+    //reused by collect() so reading back a frame doesn't allocate
+    std::vector<uint64_t> _ticks;
+    std::vector<GpuScopeTiming> _timings;
+    std::string _key;                 //"/parent/child" path of the scope being summed
+    std::vector<size_t> _keyLengths;  //length of _key at each depth
+
+    std::chrono::steady_clock::time_point _start;
+
+    mutable std::mutex _mutex; //guards everything below, cpu scopes arrive from any thread
+    Summary _gpuSummary;
+    std::vector<std::string> _gpuSummaryOrder;
+    Summary _cpuSummary;
+    std::vector<std::string> _cpuSummaryOrder;
+    uint32_t _summaryFrames = 0;
+    uint32_t _gpuSummaryFrames = 0;
+    bool _capturing = false;
+    std::vector<TraceEvent> _trace;
+    std::map<std::thread::id, uint32_t> _threadNumbers;
+};
+
+//times the enclosing block on the cpu, nesting is tracked per thread
+class ProfileScope
+{
+public:
+    ProfileScope(Profiler* profiler, const char* name);
+    ~ProfileScope();
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    Profiler* _profiler;
+    const char* _name;
+    uint32_t _depth;
+    std::chrono::steady_clock::time_point _start;
+};
+
+//a gpu scope around everything recorded into commandBuffer while it is alive
+class GpuProfileScope
+{
+public:
+    GpuProfileScope(Profiler* profiler, VkCommandBuffer commandBuffer, const char* name)
+        : _profiler(profiler), _commandBuffer(commandBuffer)
+    {
+        if( _profiler != nullptr )
+            _profiler->beginGpuScope(_commandBuffer, name);
+    }
+
+    ~GpuProfileScope()
+    {
+        if( _profiler != nullptr )
+            _profiler->endGpuScope(_commandBuffer);
+    }
+
+    GpuProfileScope(const GpuProfileScope&) = delete;
+    GpuProfileScope& operator=(const GpuProfileScope&) = delete;
+
+private:
+    Profiler* _profiler;
+    VkCommandBuffer _commandBuffer;
+};
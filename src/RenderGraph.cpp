@@ -0,0 +1,587 @@
+#include "RenderGraph.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+    const VkAccessFlags WRITE_ACCESS = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT
+        | VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+    bool overlaps(uint32_t firstA, uint32_t lastA, uint32_t firstB, uint32_t lastB)
+    {
+        return firstA <= lastB && firstB <= lastA;
+    }
+}
+
+RenderGraph::AccessInfo RenderGraph::accessInfo(RenderGraphAccess access)
+{
+    switch( access )
+    {
+        case RenderGraphAccess::ColorAttachmentWrite:
+            return {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, true};
+        case RenderGraphAccess::SampledRead:
+            return {VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT, false};
+        case RenderGraphAccess::StorageRead:
+            return {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT, false};
+        case RenderGraphAccess::StorageWrite:
+            return {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT, true};
+        case RenderGraphAccess::StorageReadWrite:
+            return {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT, true};
+        case RenderGraphAccess::FragmentStorageReadWrite:
+            return {VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT, true};
+        case RenderGraphAccess::IndirectRead:
+            return {VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, 0, false};
+        case RenderGraphAccess::TransferRead:
+            return {VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT, false};
+        case RenderGraphAccess::TransferWrite:
+            return {VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT, true};
+        case RenderGraphAccess::HostRead:
+            return {VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, 0, false};
+        case RenderGraphAccess::Present:
+            return {VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, 0, false};
+    }
+    return {};
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::use(RenderGraphResource resource, RenderGraphAccess access)
+{
+    if( resource >= _graph._resources.size() )
+        throw std::runtime_error("render graph pass uses an unknown resource!");
+
+    _graph._passes[_pass].uses.push_back({resource, access});
+    return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::sideEffects()
+{
+    _graph._passes[_pass].sideEffects = true;
+    return *this;
+}
+
+RenderGraph::RenderGraph(VkDevice device, GpuAllocator& allocator, uint32_t frameSlots)
+    : _device(device), _allocator(allocator), _slots(frameSlots)
+{
+    _exportBarriers.name = "export";
+}
+
+RenderGraph::~RenderGraph()
+{
+    releasePasses();
+    for (auto& slot : _slots)
+        destroyTransients(slot);
+}
+
+void RenderGraph::beginFrame(uint32_t frameSlot)
+{
+    _frameSlot = frameSlot;
+    _resources.clear();
+    releasePasses();
+    _arena.reset();
+    _compiled = false;
+}
+
+//last frame's command buffer has been recorded, nothing will call its passes again
+void RenderGraph::releasePasses()
+{
+    for (auto& pass : _passes)
+    {
+        pass.execute.destroy(pass.execute.callable);
+        pass.execute = {};
+        _sparePasses.push_back(std::move(pass));
+    }
+    _passes.clear();
+}
+
+RenderGraphResource RenderGraph::importImage(const char* name, VkImage image, VkImageView view, VkFormat format, VkExtent2D extent,
+    const RenderGraphState& initial)
+{
+    Resource resource = {};
+    resource.name = name;
+    resource.isImage = true;
+    resource.image = image;
+    resource.view = view;
+    resource.desc.format = format;
+    resource.desc.extent = extent;
+    resource.state = initial;
+    _resources.push_back(resource);
+    return static_cast<RenderGraphResource>(_resources.size() - 1);
+}
+
+RenderGraphResource RenderGraph::importBuffer(const char* name, VkBuffer buffer, const RenderGraphState& initial)
+{
+    Resource resource = {};
+    resource.name = name;
+    resource.buffer = buffer;
+    resource.state = initial;
+    _resources.push_back(resource);
+    return static_cast<RenderGraphResource>(_resources.size() - 1);
+}
+
+RenderGraphResource RenderGraph::createImage(const char* name, const TransientImageDesc& desc)
+{
+    Resource resource = {};
+    resource.name = name;
+    resource.isImage = true;
+    resource.transient = true;
+    resource.desc = desc;
+    _resources.push_back(resource);
+    return static_cast<RenderGraphResource>(_resources.size() - 1);
+}
+
+void RenderGraph::exportResource(RenderGraphResource resource, RenderGraphAccess finalAccess)
+{
+    if( _resources[resource].transient )
+        throw std::runtime_error("transient render graph images can't be exported!");
+
+    _resources[resource].exported = true;
+    _resources[resource].finalAccess = finalAccess;
+}
+
+RenderGraph::PassBuilder RenderGraph::addPassCallback(const char* name, const PassCallback& execute)
+{
+    Pass pass;
+    if( !_sparePasses.empty() )
+    {
+        pass = std::move(_sparePasses.back());
+        _sparePasses.pop_back();
+        pass.uses.clear();
+        pass.sideEffects = false;
+        pass.culled = false;
+    }
+    pass.name = name;
+    pass.execute = execute;
+    _passes.push_back(std::move(pass));
+    return PassBuilder(*this, static_cast<uint32_t>(_passes.size() - 1));
+}
+
+//walking backwards from the exports, a pass survives if something still needed comes out of it
+void RenderGraph::cullPasses()
+{
+    ArenaVector<bool> needed(_resources.size(), false, ArenaAllocator<bool>(_arena));
+    for (size_t i = 0; i < _resources.size(); i++)
+        needed[i] = _resources[i].exported;
+
+    for (auto pass = _passes.rbegin(); pass != _passes.rend(); ++pass)
+    {
+        bool alive = pass->sideEffects;
+        for (auto& use : pass->uses)
+            alive = alive || (accessInfo(use.access).write && needed[use.resource]);
+
+        pass->culled = !alive;
+        if( !alive )
+            continue;
+
+        //attachments count as read too, a render pass may load them
+        for (auto& use : pass->uses)
+        {
+            if( !accessInfo(use.access).write || use.access == RenderGraphAccess::StorageReadWrite
+                || use.access == RenderGraphAccess::FragmentStorageReadWrite || use.access == RenderGraphAccess::ColorAttachmentWrite )
+                needed[use.resource] = true;
+        }
+    }
+}
+
+void RenderGraph::compile()
+{
+    _stats = {};
+    _stats.passes = static_cast<uint32_t>(_passes.size());
+
+    cullPasses();
+
+    //lifetimes over the surviving passes, and every usage a transient will need
+    for (uint32_t i = 0; i < _passes.size(); i++)
+    {
+        if( _passes[i].culled )
+        {
+            _stats.culledPasses++;
+            continue;
+        }
+
+        for (auto& use : _passes[i].uses)
+        {
+            auto& resource = _resources[use.resource];
+            resource.firstPass = std::min(resource.firstPass, i);
+            resource.lastPass = std::max(resource.lastPass, i);
+            if( resource.transient )
+                resource.desc.usage |= accessInfo(use.access).usage;
+        }
+    }
+
+    placeTransients();
+
+    for (auto& resource : _resources)
+    {
+        resource.writeStages = resource.state.stages;
+        resource.writeAccess = resource.state.access;
+    }
+
+    ArenaVector<std::pair<RenderGraphResource, AccessInfo>> merged{ArenaAllocator<std::pair<RenderGraphResource, AccessInfo>>(_arena)};
+    for (uint32_t passIndex = 0; passIndex < _passes.size(); passIndex++)
+    {
+        auto& pass = _passes[passIndex];
+        pass.srcStages = pass.dstStages = 0;
+        pass.imageBarriers.clear();
+        pass.bufferBarriers.clear();
+        if( pass.culled )
+            continue;
+
+        //a resource used more than once in a pass is one combined use, a barrier between them would
+        //have to sit inside the pass
+        merged.clear();
+        for (auto& use : pass.uses)
+        {
+            auto info = accessInfo(use.access);
+            auto existing = std::find_if(merged.begin(), merged.end(), [&](const auto& other) { return other.first == use.resource; });
+            if( existing == merged.end() )
+            {
+                merged.push_back({use.resource, info});
+                continue;
+            }
+
+            if( _resources[use.resource].isImage && existing->second.layout != info.layout )
+                throw std::runtime_error(std::string("render graph pass ") + pass.name + " uses an image in two layouts!");
+            existing->second.stages |= info.stages;
+            existing->second.access |= info.access;
+            existing->second.write = existing->second.write || info.write;
+        }
+
+        for (auto& [index, info] : merged)
+        {
+            auto& resource = _resources[index];
+            if( resource.transient && resource.firstPass == passIndex )
+            {
+                if( !info.write )
+                    throw std::runtime_error(std::string("transient image ") + resource.name + " is read before it is written!");
+
+                //the first use discards, but only once whatever had the memory before is done with it
+                if( resource.aliasOf != INVALID_RENDER_GRAPH_RESOURCE )
+                {
+                    auto& previous = _resources[resource.aliasOf];
+                    resource.writeStages = previous.writeStages | previous.readStages;
+                    resource.writeAccess = previous.writeAccess;
+                }
+            }
+
+            transition(pass, resource, info);
+        }
+    }
+
+    _exportBarriers.srcStages = _exportBarriers.dstStages = 0;
+    _exportBarriers.imageBarriers.clear();
+    _exportBarriers.bufferBarriers.clear();
+    for (auto& resource : _resources)
+    {
+        if( resource.exported )
+            transition(_exportBarriers, resource, accessInfo(resource.finalAccess));
+    }
+
+    _stats.arenaBytes = _arena.stats().bytes;
+    _compiled = true;
+}
+
+void RenderGraph::transition(Pass& pass, Resource& resource, const AccessInfo& info)
+{
+    bool layoutChange = resource.isImage && info.layout != resource.state.layout;
+
+    if( info.write )
+    {
+        //write after write needs the writes finished and flushed, write after read only the reads finished
+        VkPipelineStageFlags srcStages = resource.writeStages | resource.readStages;
+        if( srcStages != 0 || layoutChange )
+            addBarrier(pass, resource, srcStages, resource.writeAccess, info.stages, info.access, info.layout);
+
+        resource.writeStages = info.stages;
+        resource.writeAccess = info.access & WRITE_ACCESS;
+        resource.readStages = 0;
+        resource.visibleAccess = info.access;
+    }
+    else
+    {
+        bool alreadyVisible = (info.stages & ~resource.readStages) == 0 && (info.access & ~resource.visibleAccess) == 0;
+        bool waitOnWrite = resource.writeStages != 0 && !alreadyVisible;
+
+        if( layoutChange || waitOnWrite )
+        {
+            //a transition is a write, so other readers since the last write have to be done first
+            VkPipelineStageFlags srcStages = resource.writeStages | (layoutChange ? resource.readStages : 0);
+            addBarrier(pass, resource, srcStages, resource.writeAccess, info.stages, info.access, info.layout);
+
+            if( layoutChange )
+            {
+                //later readers chain through this pass's stages to the transition
+                resource.writeStages = info.stages;
+                resource.readStages = 0;
+                resource.visibleAccess = 0;
+            }
+        }
+
+        resource.readStages |= info.stages;
+        resource.visibleAccess |= info.access;
+    }
+
+    if( resource.isImage )
+        resource.state.layout = info.layout;
+}
+
+void RenderGraph::addBarrier(Pass& pass, Resource& resource, VkPipelineStageFlags srcStages, VkAccessFlags srcAccess,
+    VkPipelineStageFlags dstStages, VkAccessFlags dstAccess, VkImageLayout newLayout)
+{
+    pass.srcStages |= srcStages != 0 ? srcStages : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+    pass.dstStages |= dstStages;
+
+    if( resource.isImage )
+    {
+        VkImageMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = srcAccess;
+        barrier.dstAccessMask = dstAccess;
+        barrier.oldLayout = resource.state.layout;
+        barrier.newLayout = newLayout;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = resource.image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.levelCount = 1;
+        barrier.subresourceRange.layerCount = 1;
+        pass.imageBarriers.push_back(barrier);
+        _stats.imageBarriers++;
+    }
+    else
+    {
+        VkBufferMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = srcAccess;
+        barrier.dstAccessMask = dstAccess;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer = resource.buffer;
+        barrier.offset = 0;
+        barrier.size = VK_WHOLE_SIZE;
+        pass.bufferBarriers.push_back(barrier);
+        _stats.bufferBarriers++;
+    }
+}
+
+//matches the frame's transients to the slot's images by position, rebuilding them all if anything changed
+void RenderGraph::placeTransients()
+{
+    ArenaVector<RenderGraphResource> transients{ArenaAllocator<RenderGraphResource>(_arena)};
+    for (RenderGraphResource i = 0; i < _resources.size(); i++)
+    {
+        if( _resources[i].transient && _resources[i].firstPass != UINT32_MAX )
+            transients.push_back(i);
+    }
+
+    auto& slot = _slots[_frameSlot];
+    bool same = slot.images.size() == transients.size();
+    for (size_t i = 0; same && i < transients.size(); i++)
+    {
+        auto& resource = _resources[transients[i]];
+        auto& image = slot.images[i];
+        same = image.desc.format == resource.desc.format
+            && image.desc.extent.width == resource.desc.extent.width
+            && image.desc.extent.height == resource.desc.extent.height
+            && image.desc.usage == resource.desc.usage
+            && image.firstPass == resource.firstPass
+            && image.lastPass == resource.lastPass;
+    }
+
+    //the slot's fence has been waited on, nothing can still be using its images
+    if( !same )
+    {
+        destroyTransients(slot);
+        buildTransients(slot, transients);
+    }
+
+    for (size_t i = 0; i < transients.size(); i++)
+    {
+        auto& resource = _resources[transients[i]];
+        auto& image = slot.images[i];
+        resource.image = image.image;
+        resource.view = image.view;
+
+        //the latest transient to finish in the same memory before this one starts
+        uint32_t previousLast = 0;
+        for (size_t j = 0; j < transients.size(); j++)
+        {
+            auto& other = slot.images[j];
+            if( j != i && other.memoryIndex == image.memoryIndex && other.lastPass < image.firstPass && other.lastPass >= previousLast )
+            {
+                resource.aliasOf = transients[j];
+                previousLast = other.lastPass;
+            }
+        }
+
+        _stats.transientBytes += image.size;
+    }
+
+    _stats.transientImages = static_cast<uint32_t>(transients.size());
+    for (auto& memory : slot.memory)
+        _stats.aliasedBytes += memory.size;
+}
+
+void RenderGraph::buildTransients(FrameSlot& slot, const ArenaVector<RenderGraphResource>& transients)
+{
+    std::vector<VkMemoryRequirements> requirements(transients.size());
+    slot.images.resize(transients.size());
+
+    for (size_t i = 0; i < transients.size(); i++)
+    {
+        auto& resource = _resources[transients[i]];
+        auto& image = slot.images[i];
+        image.desc = resource.desc;
+        image.firstPass = resource.firstPass;
+        image.lastPass = resource.lastPass;
+
+        VkImageCreateInfo imageInfo = {};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.format = resource.desc.format;
+        imageInfo.extent = {resource.desc.extent.width, resource.desc.extent.height, 1};
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.usage = resource.desc.usage;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        if (vkCreateImage(_device, &imageInfo, nullptr, &image.image) != VK_SUCCESS)
+            throw std::runtime_error("failed to create transient image!");
+
+        vkGetImageMemoryRequirements(_device, image.image, &requirements[i]);
+        image.size = requirements[i].size;
+    }
+
+    //biggest first, each into the first memory whose current images are all done before it starts (or
+    //start after it ends) and that has a memory type in common
+    std::vector<size_t> order(transients.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return requirements[a].size > requirements[b].size; });
+
+    std::vector<VkMemoryRequirements> memoryRequirements;
+    std::vector<std::vector<size_t>> members;
+    for (auto i : order)
+    {
+        auto& image = slot.images[i];
+
+        size_t memoryIndex = 0;
+        for (; memoryIndex < members.size(); memoryIndex++)
+        {
+            bool fits = (memoryRequirements[memoryIndex].memoryTypeBits & requirements[i].memoryTypeBits) != 0;
+            for (auto other : members[memoryIndex])
+                fits = fits && !overlaps(image.firstPass, image.lastPass, slot.images[other].firstPass, slot.images[other].lastPass);
+            if( fits )
+                break;
+        }
+
+        if( memoryIndex == members.size() )
+        {
+            memoryRequirements.push_back(requirements[i]);
+            members.emplace_back();
+        }
+
+        auto& combined = memoryRequirements[memoryIndex];
+        combined.size = std::max(combined.size, requirements[i].size);
+        combined.alignment = std::max(combined.alignment, requirements[i].alignment);
+        combined.memoryTypeBits &= requirements[i].memoryTypeBits;
+        members[memoryIndex].push_back(i);
+        image.memoryIndex = static_cast<uint32_t>(memoryIndex);
+    }
+
+    for (auto& combined : memoryRequirements)
+        slot.memory.push_back(_allocator.allocate(combined, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, GpuResourceKind::Image));
+
+    for (auto& image : slot.images)
+    {
+        auto& memory = slot.memory[image.memoryIndex];
+        vkBindImageMemory(_device, image.image, memory.memory, memory.offset);
+
+        VkImageViewCreateInfo viewInfo = {};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = image.image;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = image.desc.format;
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        viewInfo.subresourceRange.levelCount = 1;
+        viewInfo.subresourceRange.layerCount = 1;
+
+        if (vkCreateImageView(_device, &viewInfo, nullptr, &image.view) != VK_SUCCESS)
+            throw std::runtime_error("failed to create transient image view!");
+    }
+}
+
+void RenderGraph::destroyTransients(FrameSlot& slot)
+{
+    for (auto& image : slot.images)
+    {
+        vkDestroyImageView(_device, image.view, nullptr);
+        vkDestroyImage(_device, image.image, nullptr);
+    }
+    for (auto& memory : slot.memory)
+        _allocator.free(memory);
+
+    slot.images.clear();
+    slot.memory.clear();
+}
+
+void RenderGraph::execute(VkCommandBuffer commandBuffer, Profiler* profiler)
+{
+    if( !_compiled )
+        throw std::runtime_error("render graph executed without being compiled!");
+
+    auto recordBarriers = [&](const Pass& pass) {
+        if( pass.imageBarriers.empty() && pass.bufferBarriers.empty() )
+            return;
+
+        vkCmdPipelineBarrier(commandBuffer, pass.srcStages, pass.dstStages, 0, 0, nullptr,
+            static_cast<uint32_t>(pass.bufferBarriers.size()), pass.bufferBarriers.data(),
+            static_cast<uint32_t>(pass.imageBarriers.size()), pass.imageBarriers.data());
+        _stats.barrierBatches++;
+    };
+
+    for (auto& pass : _passes)
+    {
+        if( pass.culled )
+            continue;
+
+        GpuProfileScope scope(profiler, commandBuffer, pass.name);
+        recordBarriers(pass);
+        pass.execute.invoke(pass.execute.callable, commandBuffer);
+    }
+
+    recordBarriers(_exportBarriers);
+}
+
+VkImage RenderGraph::image(RenderGraphResource resource) const
+{
+    return _resources[resource].image;
+}
+
+VkImageView RenderGraph::imageView(RenderGraphResource resource) const
+{
+    return _resources[resource].view;
+}
+
+VkBuffer RenderGraph::buffer(RenderGraphResource resource) const
+{
+    return _resources[resource].buffer;
+}
+
+void RenderGraph::printStats(std::ostream& out) const
+{
+    const double mib = 1024.0 * 1024.0;
+
+    out << "Render graph:" << std::endl;
+    out << "\t" << _stats.passes << " passes, " << _stats.culledPasses << " culled" << std::endl;
+    out << "\t" << _stats.barrierBatches << " barrier batches (" << _stats.imageBarriers << " image, " << _stats.bufferBarriers << " buffer barriers)" << std::endl;
+    out << "\t" << _stats.transientImages << " transient images in " << (_stats.aliasedBytes / mib) << " MiB ("
+        << (_stats.transientBytes / mib) << " MiB without aliasing)" << std::endl;
+    out << "\t" << _stats.arenaBytes << " bytes of frame arena" << std::endl;
+}
@@ -0,0 +1,251 @@
+#pragma once
+
+#include "FrameArena.h"
+#include "GpuAllocator.h"
+#include "Profiler.h"
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <new>
+#include <ostream>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+//index of an image or buffer declared to the graph this frame
+using RenderGraphResource = uint32_t;
+const RenderGraphResource INVALID_RENDER_GRAPH_RESOURCE = UINT32_MAX;
+
+//how a pass touches a resource. each one stands for a fixed stage, access and (for images) layout, so
+//passes only say what they do and the graph works out the barriers
+enum class RenderGraphAccess
+{
+    ColorAttachmentWrite, //inside a render pass, COLOR_ATTACHMENT_OPTIMAL
+    SampledRead,          //fragment or compute shaders, SHADER_READ_ONLY_OPTIMAL
+    StorageRead,          //compute shaders, images in GENERAL
+    StorageWrite,
+    StorageReadWrite,
+    FragmentStorageReadWrite, //storage atomics from a fragment shader, e.g. texture streaming feedback
+    IndirectRead,         //buffers only, draw/dispatch indirect arguments
+    TransferRead,         //TRANSFER_SRC_OPTIMAL
+    TransferWrite,        //TRANSFER_DST_OPTIMAL
+    HostRead,             //buffers only, for exportResource
+    Present               //images only, for exportResource
+};
+
+//where a resource was left before the graph got it, imported resources only
+struct RenderGraphState
+{
+    VkPipelineStageFlags stages = 0;
+    VkAccessFlags access = 0; //writes not yet made available
+    VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+};
+
+//a transient image only exists inside the frame, the graph creates it and may share its memory with
+//other transients whose passes don't overlap
+struct TransientImageDesc
+{
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    VkExtent2D extent = {0, 0};
+    VkImageUsageFlags usage = 0; //added to whatever the passes' accesses need
+};
+
+struct RenderGraphStats
+{
+    uint32_t passes = 0;
+    uint32_t culledPasses = 0;
+    uint32_t barrierBatches = 0;   //vkCmdPipelineBarrier calls
+    uint32_t imageBarriers = 0;
+    uint32_t bufferBarriers = 0;
+    uint32_t transientImages = 0;
+    VkDeviceSize transientBytes = 0; //what the transients would take with memory of their own
+    VkDeviceSize aliasedBytes = 0;   //what they actually take
+    size_t arenaBytes = 0;           //cpu side scratch for declaring and compiling the frame
+};
+
+//a frame's passes, declared every frame in the order they should run along with what each one reads
+//and writes. compile() culls passes nothing depends on, works out the smallest set of barriers and
+//layout transitions between the rest (read after read needs none, and every barrier a pass needs goes
+//out as one vkCmdPipelineBarrier) and places transient images. execute() records it all into one
+//command buffer.
+//
+//transient images are created per frame slot and kept from frame to frame while the graph's shape stays
+//the same. transients whose first and last uses don't overlap share memory, the first use of each is
+//always a discard (from UNDEFINED) that waits on the last use of whatever was there before it.
+//
+//everything runs on one queue, in declaration order. passes can't be reordered, only dropped.
+//
+//a steady frame doesn't touch the heap: pass callbacks and compile()'s scratch go in a frame arena and
+//the passes themselves, with their barrier lists, are recycled from frame to frame
+class RenderGraph
+{
+public:
+    class PassBuilder
+    {
+    public:
+        PassBuilder(RenderGraph& graph, uint32_t pass) : _graph(graph), _pass(pass) {}
+
+        //a pass may use a resource more than once, but an image only ever in one layout
+        PassBuilder& use(RenderGraphResource resource, RenderGraphAccess access);
+        //never culled, for passes whose results leave the graph some other way
+        PassBuilder& sideEffects();
+
+    private:
+        RenderGraph& _graph;
+        uint32_t _pass;
+    };
+
+    RenderGraph(VkDevice device, GpuAllocator& allocator, uint32_t frameSlots);
+    ~RenderGraph();
+
+    RenderGraph(const RenderGraph&) = delete;
+    RenderGraph& operator=(const RenderGraph&) = delete;
+
+    //starts declaring a new frame, once the slot's fence has been waited on
+    void beginFrame(uint32_t frameSlot);
+
+    RenderGraphResource importImage(const char* name, VkImage image, VkImageView view, VkFormat format, VkExtent2D extent,
+        const RenderGraphState& initial);
+    RenderGraphResource importBuffer(const char* name, VkBuffer buffer, const RenderGraphState& initial = {});
+    RenderGraphResource createImage(const char* name, const TransientImageDesc& desc);
+
+    //the resource is wanted after the frame, left in the state of finalAccess. passes that don't lead
+    //to an exported resource (or have side effects) are culled
+    void exportResource(RenderGraphResource resource, RenderGraphAccess finalAccess);
+
+    //name must outlive the profiler, it is used as the pass's gpu profile scope. execute is called as
+    //execute(VkCommandBuffer) and is kept until the next beginFrame()
+    template<typename Execute>
+    PassBuilder addPass(const char* name, Execute&& execute)
+    {
+        using Callable = std::decay_t<Execute>;
+
+        PassCallback callback;
+        callback.callable = new (_arena.allocate(sizeof(Callable), alignof(Callable))) Callable(std::forward<Execute>(execute));
+        callback.invoke = [](void* callable, VkCommandBuffer commandBuffer) { (*static_cast<Callable*>(callable))(commandBuffer); };
+        callback.destroy = [](void* callable) { static_cast<Callable*>(callable)->~Callable(); };
+        return addPassCallback(name, callback);
+    }
+
+    void compile();
+    //each pass gets a gpu profile scope when profiler isn't null
+    void execute(VkCommandBuffer commandBuffer, Profiler* profiler);
+
+    //only valid from compile() until the next beginFrame()
+    VkImage image(RenderGraphResource resource) const;
+    VkImageView imageView(RenderGraphResource resource) const;
+    VkBuffer buffer(RenderGraphResource resource) const;
+
+    const RenderGraphStats& stats() const { return _stats; }
+    void printStats(std::ostream& out) const;
+
+private:
+    //what a RenderGraphAccess (or several on one resource in one pass) amounts to
+    struct AccessInfo
+    {
+        VkPipelineStageFlags stages = 0;
+        VkAccessFlags access = 0;
+        VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkImageUsageFlags usage = 0;
+        bool write = false;
+    };
+
+    struct Use
+    {
+        RenderGraphResource resource;
+        RenderGraphAccess access;
+    };
+
+    //a type erased callable living in the arena, std::function would allocate for most lambdas
+    struct PassCallback
+    {
+        void* callable = nullptr;
+        void (*invoke)(void* callable, VkCommandBuffer commandBuffer) = nullptr;
+        void (*destroy)(void* callable) = nullptr;
+    };
+
+    struct Pass
+    {
+        const char* name;
+        PassCallback execute;
+        std::vector<Use> uses;
+        bool sideEffects = false;
+        bool culled = false;
+
+        //filled in by compile()
+        VkPipelineStageFlags srcStages = 0;
+        VkPipelineStageFlags dstStages = 0;
+        std::vector<VkImageMemoryBarrier> imageBarriers;
+        std::vector<VkBufferMemoryBarrier> bufferBarriers;
+    };
+
+    struct Resource
+    {
+        const char* name;
+        bool isImage = false;
+        bool transient = false;
+        VkImage image = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        VkBuffer buffer = VK_NULL_HANDLE;
+        TransientImageDesc desc;
+        RenderGraphState state;
+        bool exported = false;
+        RenderGraphAccess finalAccess = RenderGraphAccess::Present;
+
+        //first and last pass using it, after culling
+        uint32_t firstPass = UINT32_MAX;
+        uint32_t lastPass = 0;
+        //the transient that last had this one's memory, its final state is what the first use waits on
+        RenderGraphResource aliasOf = INVALID_RENDER_GRAPH_RESOURCE;
+
+        //the barrier tracking, reads since the last write only need to wait on that write once
+        VkPipelineStageFlags writeStages = 0;
+        VkAccessFlags writeAccess = 0;
+        VkPipelineStageFlags readStages = 0;
+        VkAccessFlags visibleAccess = 0;
+    };
+
+    //a transient's physical image, matched to the frame's declarations by position
+    struct TransientImage
+    {
+        TransientImageDesc desc;
+        uint32_t firstPass = 0;
+        uint32_t lastPass = 0;
+        VkDeviceSize size = 0;
+        VkImage image = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        uint32_t memoryIndex = 0;
+    };
+
+    struct FrameSlot
+    {
+        std::vector<TransientImage> images;
+        std::vector<GpuAllocation> memory;
+    };
+
+    static AccessInfo accessInfo(RenderGraphAccess access);
+
+    void cullPasses();
+    void placeTransients();
+    PassBuilder addPassCallback(const char* name, const PassCallback& execute);
+    void releasePasses();
+    void buildTransients(FrameSlot& slot, const ArenaVector<RenderGraphResource>& transients);
+    void destroyTransients(FrameSlot& slot);
+    void addBarrier(Pass& pass, Resource& resource, VkPipelineStageFlags srcStages, VkAccessFlags srcAccess,
+        VkPipelineStageFlags dstStages, VkAccessFlags dstAccess, VkImageLayout newLayout);
+    void transition(Pass& pass, Resource& resource, const AccessInfo& info);
+
+    VkDevice _device;
+    GpuAllocator& _allocator;
+    std::vector<FrameSlot> _slots;
+    uint32_t _frameSlot = 0;
+
+    std::vector<Resource> _resources;
+    std::vector<Pass> _passes;
+    std::vector<Pass> _sparePasses; //last frame's, handed out again so their vectors keep their capacity
+    FrameArena _arena;              //reset by beginFrame()
+    Pass _exportBarriers; //transitions to each exported resource's final state, after the last pass
+    bool _compiled = false;
+    RenderGraphStats _stats;
+};
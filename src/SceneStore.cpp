@@ -0,0 +1,316 @@
+#include "SceneStore.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define VKL_SCENE_SSE2 1
+#endif
+
+namespace
+{
+    //entities per job, big enough that the job system's overhead disappears next to the kernels
+    const uint32_t SCENE_BATCH_SIZE = 4096;
+
+    //columns start on a cache line and hold a whole number of them
+    const size_t COLUMN_ALIGNMENT = 64;
+    const uint32_t COLUMN_GRANULARITY = COLUMN_ALIGNMENT / sizeof(float);
+    const uint32_t FLOAT_COLUMNS = 11;
+    const uint32_t UINT_COLUMNS = 3;
+
+    void* alignedAlloc(size_t size)
+    {
+#ifdef _WIN32
+        return _aligned_malloc(size, COLUMN_ALIGNMENT);
+#else
+        return std::aligned_alloc(COLUMN_ALIGNMENT, size);
+#endif
+    }
+}
+
+void SceneStore::AlignedFree::operator()(void* memory) const
+{
+#ifdef _WIN32
+    _aligned_free(memory);
+#else
+    std::free(memory);
+#endif
+}
+
+SceneStore::SceneStore(uint32_t capacity)
+{
+    reserve(std::max(capacity, COLUMN_GRANULARITY));
+}
+
+SceneStore::~SceneStore() = default;
+
+void SceneStore::reserve(uint32_t capacity)
+{
+    if( capacity <= _capacity )
+        return;
+
+    capacity = (capacity + COLUMN_GRANULARITY - 1) / COLUMN_GRANULARITY * COLUMN_GRANULARITY;
+    size_t columnBytes = static_cast<size_t>(capacity) * sizeof(float);
+    static_assert(sizeof(float) == sizeof(uint32_t), "every column is 4 bytes wide");
+
+    std::unique_ptr<unsigned char, AlignedFree> arena(static_cast<unsigned char*>(alignedAlloc(columnBytes * (FLOAT_COLUMNS + UINT_COLUMNS))));
+    if( !arena )
+        throw std::runtime_error("failed to allocate scene store!");
+
+    //same order every time, so moving to the new arena is a copy per column
+    float** floatColumns[FLOAT_COLUMNS] = {&_localX, &_localY, &_localCos, &_localSin, &_localScale,
+        &_worldX, &_worldY, &_worldCos, &_worldSin, &_worldScale, &_radius};
+    uint32_t** uintColumns[UINT_COLUMNS] = {&_parent, &_mesh, &_color};
+
+    unsigned char* next = arena.get();
+    for (auto column : floatColumns)
+    {
+        if( _size > 0 )
+            std::memcpy(next, *column, _size * sizeof(float));
+        *column = reinterpret_cast<float*>(next);
+        next += columnBytes;
+    }
+    for (auto column : uintColumns)
+    {
+        if( _size > 0 )
+            std::memcpy(next, *column, _size * sizeof(uint32_t));
+        *column = reinterpret_cast<uint32_t*>(next);
+        next += columnBytes;
+    }
+
+    _arena = std::move(arena);
+    _capacity = capacity;
+}
+
+EntityId SceneStore::create(const Transform2D& local, const Renderable& renderable, EntityId parent)
+{
+    uint32_t depth = 0;
+    if( parent != NO_PARENT )
+    {
+        if( parent >= _size )
+            throw std::runtime_error("scene entity's parent doesn't exist!");
+        depth = static_cast<uint32_t>(std::upper_bound(_depthStarts.begin(), _depthStarts.end(), parent) - _depthStarts.begin());
+    }
+
+    //depth is the parent's depth + 1, which can't be more than one past the depth being filled in
+    if( depth + 1 < _depthStarts.size() )
+        throw std::runtime_error("scene entities have to be created breadth first!");
+    if( depth == _depthStarts.size() )
+        _depthStarts.push_back(_size);
+
+    if( _size == _capacity )
+        reserve(_capacity * 2);
+
+    EntityId entity = _size++;
+    _parent[entity] = parent;
+    _mesh[entity] = renderable.mesh;
+    _color[entity] = renderable.color;
+    _radius[entity] = renderable.radius;
+    setLocal(entity, local);
+
+    //usable before the first updateTransforms
+    _worldX[entity] = local.x;
+    _worldY[entity] = local.y;
+    _worldCos[entity] = _localCos[entity];
+    _worldSin[entity] = _localSin[entity];
+    _worldScale[entity] = local.scale;
+    return entity;
+}
+
+void SceneStore::setLocal(EntityId entity, const Transform2D& local)
+{
+    _localX[entity] = local.x;
+    _localY[entity] = local.y;
+    _localScale[entity] = local.scale;
+    setLocalRotation(entity, local.rotation);
+}
+
+void SceneStore::setLocalRotation(EntityId entity, float rotation)
+{
+    _localCos[entity] = std::cos(rotation);
+    _localSin[entity] = std::sin(rotation);
+}
+
+void SceneStore::updateTransforms(JobSystem& jobs)
+{
+    for (size_t depth = 0; depth < _depthStarts.size(); depth++)
+    {
+        uint32_t first = _depthStarts[depth];
+        uint32_t last = depth + 1 < _depthStarts.size() ? _depthStarts[depth + 1] : _size;
+
+        jobs.parallelFor(last - first, SCENE_BATCH_SIZE, [&](uint32_t begin, uint32_t end, uint32_t) {
+            if( depth == 0 )
+                updateRootRange(first + begin, first + end);
+            else
+                updateRange(first + begin, first + end);
+        });
+    }
+}
+
+void SceneStore::updateRootRange(uint32_t begin, uint32_t end)
+{
+    size_t bytes = (end - begin) * sizeof(float);
+    std::memcpy(_worldX + begin, _localX + begin, bytes);
+    std::memcpy(_worldY + begin, _localY + begin, bytes);
+    std::memcpy(_worldCos + begin, _localCos + begin, bytes);
+    std::memcpy(_worldSin + begin, _localSin + begin, bytes);
+    std::memcpy(_worldScale + begin, _localScale + begin, bytes);
+}
+
+//world = parent world * local. the parent's columns are gathered a lane at a time, everything else is
+//straight loads and stores
+void SceneStore::updateRange(uint32_t begin, uint32_t end)
+{
+    uint32_t i = begin;
+
+#ifdef VKL_SCENE_SSE2
+    if( _simd )
+    {
+        for (; i + 4 <= end; i += 4)
+        {
+            const uint32_t* p = _parent + i;
+            __m128 px = _mm_setr_ps(_worldX[p[0]], _worldX[p[1]], _worldX[p[2]], _worldX[p[3]]);
+            __m128 py = _mm_setr_ps(_worldY[p[0]], _worldY[p[1]], _worldY[p[2]], _worldY[p[3]]);
+            __m128 pc = _mm_setr_ps(_worldCos[p[0]], _worldCos[p[1]], _worldCos[p[2]], _worldCos[p[3]]);
+            __m128 ps = _mm_setr_ps(_worldSin[p[0]], _worldSin[p[1]], _worldSin[p[2]], _worldSin[p[3]]);
+            __m128 pscale = _mm_setr_ps(_worldScale[p[0]], _worldScale[p[1]], _worldScale[p[2]], _worldScale[p[3]]);
+
+            __m128 lx = _mm_loadu_ps(_localX + i);
+            __m128 ly = _mm_loadu_ps(_localY + i);
+            __m128 lc = _mm_loadu_ps(_localCos + i);
+            __m128 ls = _mm_loadu_ps(_localSin + i);
+            __m128 lscale = _mm_loadu_ps(_localScale + i);
+
+            __m128 rx = _mm_sub_ps(_mm_mul_ps(pc, lx), _mm_mul_ps(ps, ly));
+            __m128 ry = _mm_add_ps(_mm_mul_ps(ps, lx), _mm_mul_ps(pc, ly));
+            _mm_storeu_ps(_worldX + i, _mm_add_ps(px, _mm_mul_ps(pscale, rx)));
+            _mm_storeu_ps(_worldY + i, _mm_add_ps(py, _mm_mul_ps(pscale, ry)));
+            _mm_storeu_ps(_worldCos + i, _mm_sub_ps(_mm_mul_ps(pc, lc), _mm_mul_ps(ps, ls)));
+            _mm_storeu_ps(_worldSin + i, _mm_add_ps(_mm_mul_ps(ps, lc), _mm_mul_ps(pc, ls)));
+            _mm_storeu_ps(_worldScale + i, _mm_mul_ps(pscale, lscale));
+        }
+    }
+#endif
+
+    for (; i < end; i++)
+    {
+        uint32_t p = _parent[i];
+        float rx = _worldCos[p] * _localX[i] - _worldSin[p] * _localY[i];
+        float ry = _worldSin[p] * _localX[i] + _worldCos[p] * _localY[i];
+        _worldX[i] = _worldX[p] + _worldScale[p] * rx;
+        _worldY[i] = _worldY[p] + _worldScale[p] * ry;
+
+        float c = _worldCos[p] * _localCos[i] - _worldSin[p] * _localSin[i];
+        float s = _worldSin[p] * _localCos[i] + _worldCos[p] * _localSin[i];
+        _worldCos[i] = c;
+        _worldSin[i] = s;
+        _worldScale[i] = _worldScale[p] * _localScale[i];
+    }
+}
+
+uint32_t SceneStore::cullRange(uint32_t begin, uint32_t end, const SceneView* view, uint32_t* visible) const
+{
+    uint32_t count = 0;
+    if( view == nullptr )
+    {
+        for (uint32_t i = begin; i < end; i++)
+            visible[count++] = i;
+        return count;
+    }
+
+    float minX = view->centre[0] - view->halfExtent[0];
+    float maxX = view->centre[0] + view->halfExtent[0];
+    float minY = view->centre[1] - view->halfExtent[1];
+    float maxY = view->centre[1] + view->halfExtent[1];
+
+    uint32_t i = begin;
+
+#ifdef VKL_SCENE_SSE2
+    if( _simd )
+    {
+        __m128 vminX = _mm_set1_ps(minX);
+        __m128 vmaxX = _mm_set1_ps(maxX);
+        __m128 vminY = _mm_set1_ps(minY);
+        __m128 vmaxY = _mm_set1_ps(maxY);
+
+        for (; i + 4 <= end; i += 4)
+        {
+            __m128 x = _mm_loadu_ps(_worldX + i);
+            __m128 y = _mm_loadu_ps(_worldY + i);
+            __m128 r = _mm_mul_ps(_mm_loadu_ps(_radius + i), _mm_loadu_ps(_worldScale + i));
+
+            __m128 inside = _mm_and_ps(_mm_cmpge_ps(_mm_add_ps(x, r), vminX), _mm_cmple_ps(_mm_sub_ps(x, r), vmaxX));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(y, r), vminY));
+            inside = _mm_and_ps(inside, _mm_cmple_ps(_mm_sub_ps(y, r), vmaxY));
+
+            //branch free compaction, every lane is written and only the visible ones advance
+            int mask = _mm_movemask_ps(inside);
+            for (uint32_t lane = 0; lane < 4; lane++)
+            {
+                visible[count] = i + lane;
+                count += (mask >> lane) & 1;
+            }
+        }
+    }
+#endif
+
+    for (; i < end; i++)
+    {
+        float r = _radius[i] * _worldScale[i];
+        if( _worldX[i] + r >= minX && _worldX[i] - r <= maxX && _worldY[i] + r >= minY && _worldY[i] - r <= maxY )
+            visible[count++] = i;
+    }
+
+    return count;
+}
+
+void SceneStore::writeInstance(EntityId entity, GpuInstance& instance) const
+{
+    //built on the stack and copied over whole, out may well be write combined memory
+    GpuInstance result = {};
+    float x = _worldX[entity];
+    float y = _worldY[entity];
+    float scale = _worldScale[entity];
+
+    result.boundingSphere[0] = x;
+    result.boundingSphere[1] = y;
+    result.boundingSphere[3] = _radius[entity] * scale;
+    result.position[0] = x;
+    result.position[1] = y;
+    result.position[3] = scale;
+
+    uint32_t color = _color[entity];
+    for (uint32_t channel = 0; channel < 4; channel++)
+        result.color[channel] = static_cast<float>((color >> (channel * 8)) & 0xff) / 255.f;
+
+    result.mesh = _mesh[entity];
+    result.rotation[0] = _worldCos[entity];
+    result.rotation[1] = _worldSin[entity];
+    instance = result;
+}
+
+uint32_t SceneStore::writeInstances(JobSystem& jobs, const SceneView* view, GpuInstance* out, uint32_t maxInstances) const
+{
+    std::atomic<uint32_t> written{0};
+
+    //each batch culls into its own list, then claims a run of the output with one atomic
+    jobs.parallelFor(_size, SCENE_BATCH_SIZE, [&](uint32_t begin, uint32_t end, uint32_t) {
+        uint32_t visible[SCENE_BATCH_SIZE];
+        for (uint32_t first = begin; first < end; first += SCENE_BATCH_SIZE)
+        {
+            uint32_t last = std::min(end, first + SCENE_BATCH_SIZE);
+            uint32_t count = cullRange(first, last, view, visible);
+
+            uint32_t base = written.fetch_add(count, std::memory_order_relaxed);
+            for (uint32_t i = 0; i < count && base + i < maxInstances; i++)
+                writeInstance(visible[i], out[base + i]);
+        }
+    });
+
+    return std::min(written.load(), maxInstances);
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "GpuScene.h"
+#include "JobSystem.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+//index of an entity in the store, entities are never removed
+using EntityId = uint32_t;
+const EntityId NO_PARENT = UINT32_MAX;
+
+//2d similarity transform relative to the parent (or the world for roots)
+struct Transform2D
+{
+    float x = 0.f;
+    float y = 0.f;
+    float rotation = 0.f; //radians
+    float scale = 1.f;
+};
+
+//the parts of an entity that end up in its GpuInstance
+struct Renderable
+{
+    uint32_t mesh = 0;
+    uint32_t color = 0xffffffff; //rgba8, r in the low byte
+    float radius = 1.f;          //bounding circle at scale 1, around the entity's origin
+};
+
+//entities as structure of arrays: every component is its own column, all of them carved out of one
+//64 byte aligned allocation, so each kernel streams through just the columns it needs a few lanes at a
+//time. rotations are kept as cos/sin pairs, composing two of them is a couple of multiplies rather than
+//any trig.
+//
+//entities are stored in hierarchy order, every parent before any of its children and all of one depth
+//before the next, so create() has to be called breadth first. each depth is then a contiguous range whose
+//parents are all already final, and updateTransforms() runs one depth at a time, each split across the
+//job system.
+//
+//the kernels use SSE2 where the compiler targets it (always on x86-64) and plain loops elsewhere
+class SceneStore
+{
+public:
+    explicit SceneStore(uint32_t capacity = 0);
+    ~SceneStore();
+
+    SceneStore(const SceneStore&) = delete;
+    SceneStore& operator=(const SceneStore&) = delete;
+
+    //throws if parent is deeper than the depth being filled in, see above
+    EntityId create(const Transform2D& local, const Renderable& renderable, EntityId parent = NO_PARENT);
+    void reserve(uint32_t capacity);
+
+    uint32_t size() const { return _size; }
+    uint32_t depthCount() const { return static_cast<uint32_t>(_depthStarts.size()); }
+
+    void setLocal(EntityId entity, const Transform2D& local);
+    void setLocalRotation(EntityId entity, float rotation);
+
+    //world transforms from the local ones, parents first
+    void updateTransforms(JobSystem& jobs);
+
+    //writes a GpuInstance for every entity whose world bounds overlap view (every entity when view is
+    //null) straight into out, in no particular order. returns how many were written, never more than
+    //maxInstances
+    uint32_t writeInstances(JobSystem& jobs, const SceneView* view, GpuInstance* out, uint32_t maxInstances) const;
+
+    //world space, valid after updateTransforms
+    float worldX(EntityId entity) const { return _worldX[entity]; }
+    float worldY(EntityId entity) const { return _worldY[entity]; }
+    float worldScale(EntityId entity) const { return _worldScale[entity]; }
+
+    //plain loops instead of the SSE2 kernels, for comparing the two
+    void setSimd(bool simd) { _simd = simd; }
+    bool simd() const { return _simd; }
+
+private:
+    struct AlignedFree
+    {
+        void operator()(void* memory) const;
+    };
+
+    void updateRange(uint32_t begin, uint32_t end);
+    void updateRootRange(uint32_t begin, uint32_t end);
+    uint32_t cullRange(uint32_t begin, uint32_t end, const SceneView* view, uint32_t* visible) const;
+    void writeInstance(EntityId entity, GpuInstance& instance) const;
+
+    uint32_t _size = 0;
+    uint32_t _capacity = 0;
+    std::unique_ptr<unsigned char, AlignedFree> _arena;
+    bool _simd = true;
+
+    //first entity of each depth
+    std::vector<uint32_t> _depthStarts;
+
+    //columns, all _capacity long and pointing into _arena
+    float* _localX = nullptr;
+    float* _localY = nullptr;
+    float* _localCos = nullptr;
+    float* _localSin = nullptr;
+    float* _localScale = nullptr;
+    float* _worldX = nullptr;
+    float* _worldY = nullptr;
+    float* _worldCos = nullptr;
+    float* _worldSin = nullptr;
+    float* _worldScale = nullptr;
+    float* _radius = nullptr;
+    uint32_t* _parent = nullptr;
+    uint32_t* _mesh = nullptr;
+    uint32_t* _color = nullptr;
+};
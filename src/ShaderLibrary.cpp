@@ -0,0 +1,105 @@
+#include "ShaderLibrary.h"
+
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+#ifdef VKL_EMBED_SHADERS
+#include "EmbeddedShaders.h"
+#else
+#include "AssetArchive.h"
+#endif
+
+//set by cmake to where the build put the .spv files, an absolute path so the working directory doesn't matter
+#ifndef VKL_SHADER_DIR
+#define VKL_SHADER_DIR "resources/shaders"
+#endif
+
+namespace ShaderLibrary
+{
+    bool isEmbedded()
+    {
+#ifdef VKL_EMBED_SHADERS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+#ifndef VKL_EMBED_SHADERS
+    //mapped once on first use and kept for the life of the process
+    static std::shared_ptr<const AssetArchive> shaderArchive()
+    {
+        static std::once_flag once;
+        static std::shared_ptr<const AssetArchive> archive;
+
+        std::call_once(once, []() {
+            try
+            {
+                archive = AssetArchive::open(std::string(VKL_SHADER_DIR) + "/shaders.pak");
+            }
+            catch (const std::exception&)
+            {
+                //no archive, load() falls back to the loose .spv files
+            }
+        });
+
+        return archive;
+    }
+#endif
+
+    static std::mutex overridesMutex;
+    static std::unordered_map<std::string, std::string> overrides; //shader name to spir-v path
+
+    void overrideSource(const std::string& name, const std::string& path)
+    {
+        std::lock_guard<std::mutex> lock(overridesMutex);
+        overrides[name] = path;
+    }
+
+    //mapped afresh every time, the file is replaced rather than rewritten on each recompile
+    static AssetSpan loadOverride(const std::string& name)
+    {
+        std::string path;
+        {
+            std::lock_guard<std::mutex> lock(overridesMutex);
+            auto found = overrides.find(name);
+            if( found == overrides.end() )
+                return AssetSpan();
+            path = found->second;
+        }
+
+        auto code = MappedFile::open(path)->span();
+        if( code.size() % sizeof(uint32_t) != 0 || code.empty() )
+            throw std::runtime_error(path + " is not valid spir-v!");
+        return code;
+    }
+
+    AssetSpan load(const std::string& name)
+    {
+        auto reloaded = loadOverride(name);
+        if( !reloaded.empty() )
+            return reloaded;
+
+#ifdef VKL_EMBED_SHADERS
+        for (const auto* entry = embedded_shaders::entries; entry->name != nullptr; entry++)
+        {
+            if( name == entry->name )
+                return AssetSpan(entry->code, entry->size);
+        }
+
+        throw std::runtime_error("shader " + name + " is not embedded in this build!");
+#else
+        AssetSpan code;
+        if( auto archive = shaderArchive() )
+            code = archive->find(name + ".spv");
+        if( code.empty() )
+            code = MappedFile::open(std::string(VKL_SHADER_DIR) + "/" + name + ".spv")->span();
+
+        if( code.size() % sizeof(uint32_t) != 0 || code.empty() )
+            throw std::runtime_error(name + " is not valid spir-v!");
+
+        return code;
+#endif
+    }
+}
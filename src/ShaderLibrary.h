@@ -0,0 +1,18 @@
+#pragma once
+
+#include "MappedFile.h"
+
+#include <string>
+
+namespace ShaderLibrary
+{
+    //spir-v for one of the shaders in resources/shaders, name is the source file name ("shader.vert").
+    //points straight at the copy embedded in the executable, or into the mapped shader archive
+    AssetSpan load(const std::string& name);
+
+    //load() maps the spir-v at path for name from now on, for shaders recompiled while running (see
+    //src/ShaderReloader.h). may be called from any thread, as may load()
+    void overrideSource(const std::string& name, const std::string& path);
+
+    bool isEmbedded();
+}
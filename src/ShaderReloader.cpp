@@ -0,0 +1,286 @@
+#include "ShaderReloader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+//set by cmake, like VKL_SHADER_DIR in src/ShaderLibrary.cpp
+#ifndef VKL_SHADER_SOURCE_DIR
+#define VKL_SHADER_SOURCE_DIR "resources/shaders"
+#endif
+#ifndef VKL_SHADER_DIR
+#define VKL_SHADER_DIR "resources/shaders"
+#endif
+#ifndef VKL_GLSLC
+#define VKL_GLSLC "glslc"
+#endif
+
+//the same stages cmake/CompileShaders.cmake compiles, anything else (.glsl) is only ever #included
+static bool isShaderStage(const std::filesystem::path& path)
+{
+    static const char* stages[] = {".vert", ".frag", ".comp", ".geom", ".tesc", ".tese"};
+    auto extension = path.extension().string();
+    return std::any_of(std::begin(stages), std::end(stages), [&](const char* stage) { return extension == stage; });
+}
+
+//the names in a source's #include "..." lines, includes are all relative to the source directory
+static std::vector<std::string> includesOf(const std::filesystem::path& path)
+{
+    std::vector<std::string> includes;
+    std::ifstream file(path);
+    std::string line;
+    while( std::getline(file, line) )
+    {
+        auto start = line.find_first_not_of(" \t");
+        if( start == std::string::npos || line.compare(start, 8, "#include") != 0 )
+            continue;
+        auto open = line.find('"', start + 8);
+        auto close = open == std::string::npos ? open : line.find('"', open + 1);
+        if( close != std::string::npos )
+            includes.push_back(line.substr(open + 1, close - open - 1));
+    }
+    return includes;
+}
+
+static std::string quoteArgument(const std::string& argument)
+{
+    return "\"" + argument + "\"";
+}
+
+ShaderReloader::ShaderReloader()
+    : ShaderReloader(VKL_SHADER_SOURCE_DIR, std::string(VKL_SHADER_DIR) + "/reloaded", VKL_GLSLC)
+{
+}
+
+ShaderReloader::ShaderReloader(const std::string& sourceDir, const std::string& outputDir, const std::string& compiler)
+    : _sourceDir(sourceDir), _outputDir(outputDir), _compiler(compiler)
+{
+    std::error_code error;
+    std::filesystem::create_directories(_outputDir, error);
+    if( error )
+        throw std::runtime_error("failed to create " + _outputDir + " for reloaded shaders!");
+
+#ifdef __linux__
+    //closing a file written in place or renaming one over it, between them that is every editor
+    _inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if( _inotify < 0 || inotify_add_watch(_inotify, _sourceDir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0 )
+    {
+        if( _inotify >= 0 )
+            close(_inotify);
+        throw std::runtime_error("failed to watch " + _sourceDir + " for shader changes!");
+    }
+#else
+    //what is there now is what the build compiled
+    for (auto& entry : std::filesystem::directory_iterator(_sourceDir))
+        _modified[entry.path().filename().string()] = entry.last_write_time();
+#endif
+
+    _watcher = std::thread([this] { watch(); });
+}
+
+ShaderReloader::~ShaderReloader()
+{
+    _stopping.store(true, std::memory_order_release);
+    _watcher.join();
+
+#ifdef __linux__
+    close(_inotify);
+#endif
+}
+
+bool ShaderReloader::takeCompiled(std::vector<CompiledShader>& compiled)
+{
+    compiled.clear();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if( _compiled.empty() )
+        return false;
+    compiled.swap(_compiled);
+    return true;
+}
+
+void ShaderReloader::watch()
+{
+    while( !_stopping.load(std::memory_order_acquire) )
+    {
+        std::set<std::string> changed;
+        std::vector<std::string> shaders;
+        try
+        {
+            waitForChanges(changed);
+            if( changed.empty() )
+                continue;
+            shaders = affectedShaders(changed);
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Shader reload: " << e.what() << std::endl;
+            continue;
+        }
+
+        for (auto& name : shaders)
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            std::string path;
+            if( !compile(name, path) )
+                continue;
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            std::cout << "Shader reload: recompiled " << name << " in " << ms << "ms" << std::endl;
+
+            //one changed twice before the frame loop took the first is only handed over once
+            std::lock_guard<std::mutex> lock(_mutex);
+            _compiled.erase(std::remove_if(_compiled.begin(), _compiled.end(), [&](const CompiledShader& shader) { return shader.name == name; }),
+                _compiled.end());
+            _compiled.push_back({name, path});
+        }
+    }
+}
+
+#ifdef __linux__
+void ShaderReloader::waitForChanges(std::set<std::string>& changed)
+{
+    pollfd watched = {};
+    watched.fd = _inotify;
+    watched.events = POLLIN;
+
+    //woken every so often to see whether we are stopping
+    if( poll(&watched, 1, POLL_INTERVAL_MS) <= 0 )
+        return;
+
+    do
+    {
+        alignas(inotify_event) char buffer[4096];
+        ssize_t length = 0;
+        while( (length = read(_inotify, buffer, sizeof(buffer))) > 0 )
+        {
+            for (char* at = buffer; at < buffer + length; )
+            {
+                auto event = reinterpret_cast<const inotify_event*>(at);
+                if( event->len > 0 )
+                    changed.insert(event->name);
+                at += sizeof(inotify_event) + event->len;
+            }
+        }
+    } while( !_stopping.load(std::memory_order_acquire) && poll(&watched, 1, SETTLE_MS) > 0 );
+}
+#else
+void ShaderReloader::waitForChanges(std::set<std::string>& changed)
+{
+    auto scan = [&]() {
+        bool found = false;
+        for (auto& entry : std::filesystem::directory_iterator(_sourceDir))
+        {
+            auto name = entry.path().filename().string();
+            auto time = entry.last_write_time();
+            auto known = _modified.find(name);
+            if( known == _modified.end() || known->second != time )
+            {
+                _modified[name] = time;
+                changed.insert(name);
+                found = true;
+            }
+        }
+        return found;
+    };
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(POLL_INTERVAL_MS));
+    if( !scan() )
+        return;
+
+    do
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(SETTLE_MS));
+    } while( !_stopping.load(std::memory_order_acquire) && scan() );
+}
+#endif
+
+//every shader stage that is one of the changed files or #includes one, directly or not
+std::vector<std::string> ShaderReloader::affectedShaders(const std::set<std::string>& changed) const
+{
+    std::function<bool(const std::string&, std::set<std::string>&)> dependsOnChange = [&](const std::string& name, std::set<std::string>& visited) {
+        if( !visited.insert(name).second )
+            return false;
+        if( changed.count(name) > 0 )
+            return true;
+        for (auto& include : includesOf(std::filesystem::path(_sourceDir) / name))
+        {
+            if( dependsOnChange(include, visited) )
+                return true;
+        }
+        return false;
+    };
+
+    std::vector<std::string> shaders;
+    for (auto& entry : std::filesystem::directory_iterator(_sourceDir))
+    {
+        if( !entry.is_regular_file() || !isShaderStage(entry.path()) )
+            continue;
+
+        std::set<std::string> visited;
+        auto name = entry.path().filename().string();
+        if( dependsOnChange(name, visited) )
+            shaders.push_back(name);
+    }
+
+    std::sort(shaders.begin(), shaders.end());
+    return shaders;
+}
+
+//glslc with the arguments the build gives it. it writes next to the last good spir-v and replaces it only
+//once it has succeeded, anything still mapping the old file keeps seeing the old one
+bool ShaderReloader::compile(const std::string& name, std::string& path)
+{
+    path = _outputDir + "/" + name + ".spv";
+    std::string temporary = path + ".tmp";
+
+    std::string command = quoteArgument(_compiler) + " -I " + quoteArgument(_sourceDir) + " " + quoteArgument(_sourceDir + "/" + name)
+        + " -o " + quoteArgument(temporary) + " 2>&1";
+#ifdef _WIN32
+    //cmd drops the outer quotes of a command line that starts with one
+    FILE* pipe = _popen(quoteArgument(command).c_str(), "r");
+#else
+    FILE* pipe = popen(command.c_str(), "r");
+#endif
+    if( pipe == nullptr )
+    {
+        std::cerr << "Shader reload: failed to run " << _compiler << std::endl;
+        return false;
+    }
+
+    std::string output;
+    char buffer[256];
+    while( fgets(buffer, sizeof(buffer), pipe) != nullptr )
+        output += buffer;
+#ifdef _WIN32
+    int status = _pclose(pipe);
+#else
+    int status = pclose(pipe);
+#endif
+
+    if( status != 0 )
+    {
+        std::cerr << "Shader reload: " << name << " failed to compile, keeping the last good one" << std::endl << output;
+        std::remove(temporary.c_str());
+        return false;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    if( error )
+    {
+        std::cerr << "Shader reload: failed to replace " << path << ": " << error.message() << std::endl;
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+//a shader the reloader has recompiled, its spir-v is at path
+struct CompiledShader
+{
+    std::string name; //the source file name, as ShaderLibrary::load() takes it
+    std::string path;
+};
+
+//watches the glsl sources and recompiles whatever changed with glslc, all on its own thread.
+//
+//changes are picked up with inotify on linux and by polling modification times elsewhere. an edit to
+//an #included file recompiles every shader that includes it. editors tend to save in more than one
+//step, so changes are gathered until the directory has been quiet for a moment. a shader that fails to
+//compile has its errors printed and is left out, the last good spir-v stays in use.
+//
+//compiled spir-v is written into its own directory, never over what the build produced, and handed
+//over through takeCompiled(). what to do with it (ShaderLibrary::overrideSource, rebuilding pipelines)
+//is up to the caller
+class ShaderReloader
+{
+public:
+    //the directories and compiler the build used, see cmake/CompileShaders.cmake
+    ShaderReloader();
+    ShaderReloader(const std::string& sourceDir, const std::string& outputDir, const std::string& compiler);
+    ~ShaderReloader();
+
+    ShaderReloader(const ShaderReloader&) = delete;
+    ShaderReloader& operator=(const ShaderReloader&) = delete;
+
+    const std::string& sourceDir() const { return _sourceDir; }
+
+    //swaps in what has compiled since the last call, false (and compiled emptied) when nothing has.
+    //doesn't allocate, compiled keeps its storage from call to call
+    bool takeCompiled(std::vector<CompiledShader>& compiled);
+
+private:
+    static const uint32_t POLL_INTERVAL_MS = 100;
+    static const uint32_t SETTLE_MS = 50; //quiet time before a burst of changes is compiled
+
+    void watch();
+    void waitForChanges(std::set<std::string>& changed);
+    std::vector<std::string> affectedShaders(const std::set<std::string>& changed) const;
+    bool compile(const std::string& name, std::string& path);
+
+    std::string _sourceDir;
+    std::string _outputDir;
+    std::string _compiler;
+
+#ifdef __linux__
+    int _inotify = -1;
+#else
+    std::unordered_map<std::string, std::filesystem::file_time_type> _modified; //by file name
+#endif
+
+    std::mutex _mutex;
+    std::vector<CompiledShader> _compiled; //guarded by _mutex
+
+    std::atomic<bool> _stopping{false};
+    std::thread _watcher;
+};
@@ -0,0 +1,117 @@
+#include "StaticMesh.h"
+
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    //matches the push constants in mesh.glsl
+    struct MeshPushConstants
+    {
+        float boundingSphere[4]; //xyz centre, w radius
+        float rotation[4];       //cos and sin of the yaw, then of the pitch
+        float scale[2];          //clip space per unit of model space
+        BindlessHandle vertexBuffer;
+        BindlessHandle texture;
+        BindlessHandle feedbackBuffer;
+        uint32_t textureId;
+        float textureSize[2];
+    };
+
+    static_assert(sizeof(MeshPushConstants) == 64, "MeshPushConstants layout");
+    static_assert(sizeof(MeshPushConstants) <= BINDLESS_PUSH_CONSTANT_SIZE, "mesh push constants don't fit");
+}
+
+StaticMesh::StaticMesh(VkDevice device, GpuAllocator& allocator, UploadRing& uploads, BindlessHeap& bindless,
+    const std::vector<uint32_t>& sharedFamilies, const MeshFile& file)
+    : _device(device), _allocator(allocator), _bindless(bindless), _sharedFamilies(sharedFamilies)
+{
+    auto& header = file.header();
+    if( header.indexCount == 0 )
+        throw std::runtime_error("mesh has no triangles!");
+
+    _vertexCount = header.vertexCount;
+    _indexCount = header.indexCount;
+    _meshletCount = header.meshletCount;
+    _indexType = header.indexSize == 2 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+    std::memcpy(_boundingSphere, header.boundingSphere, sizeof(_boundingSphere));
+
+    AssetSpan vertices = file.vertices();
+    AssetSpan indices = file.indices();
+    _gpuBytes = vertices.size() + indices.size();
+
+    _vertexBuffer = createBuffer(vertices.size(), VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, _vertexMemory);
+    _indexBuffer = createBuffer(indices.size(), VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, _indexMemory);
+
+    //straight out of the mapping into the ring, the pages are read in as the copy touches them
+    uploads.uploadBuffer(_vertexBuffer, 0, vertices.data(), vertices.size());
+    uploads.uploadBuffer(_indexBuffer, 0, indices.data(), indices.size());
+    uploads.waitIdle();
+
+    _vertexHandle = _bindless.addBuffer(_vertexBuffer);
+}
+
+StaticMesh::~StaticMesh()
+{
+    //only destroyed once the device is idle, so the handle can go straight back
+    _bindless.releaseBuffer(_vertexHandle, 0);
+
+    vkDestroyBuffer(_device, _vertexBuffer, nullptr);
+    vkDestroyBuffer(_device, _indexBuffer, nullptr);
+    _allocator.free(_vertexMemory);
+    _allocator.free(_indexMemory);
+}
+
+VkBuffer StaticMesh::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, GpuAllocation& memory)
+{
+    VkBufferCreateInfo bufferInfo = {};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = size;
+    bufferInfo.usage = usage;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    //the upload ring may write from another family than the one drawing
+    if( _sharedFamilies.size() > 1 )
+    {
+        bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        bufferInfo.queueFamilyIndexCount = static_cast<uint32_t>(_sharedFamilies.size());
+        bufferInfo.pQueueFamilyIndices = _sharedFamilies.data();
+    }
+
+    VkBuffer buffer = VK_NULL_HANDLE;
+    if (vkCreateBuffer(_device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
+        throw std::runtime_error("failed to create mesh buffer!");
+
+    VkMemoryRequirements memoryRequirements = {};
+    vkGetBufferMemoryRequirements(_device, buffer, &memoryRequirements);
+
+    memory = _allocator.allocate(memoryRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, GpuResourceKind::Buffer);
+    vkBindBufferMemory(_device, buffer, memory.memory, memory.offset);
+    return buffer;
+}
+
+void StaticMesh::recordDraw(VkCommandBuffer commandBuffer, const MeshView& view)
+{
+    //fills 90% of the screen's height (or width, if that's shorter) whichever way it's turned
+    float scale = 0.9f / std::max(_boundingSphere[3], 1e-6f);
+
+    MeshPushConstants pushConstants = {};
+    std::memcpy(pushConstants.boundingSphere, _boundingSphere, sizeof(_boundingSphere));
+    pushConstants.rotation[0] = std::cos(view.yaw);
+    pushConstants.rotation[1] = std::sin(view.yaw);
+    pushConstants.rotation[2] = std::cos(view.pitch);
+    pushConstants.rotation[3] = std::sin(view.pitch);
+    pushConstants.scale[0] = view.aspect >= 1.f ? scale / view.aspect : scale;
+    pushConstants.scale[1] = view.aspect >= 1.f ? scale : scale * view.aspect;
+    pushConstants.vertexBuffer = _vertexHandle;
+    pushConstants.texture = view.texture;
+    pushConstants.feedbackBuffer = view.feedbackBuffer;
+    pushConstants.textureId = view.feedbackIndex;
+    pushConstants.textureSize[0] = view.textureSize[0];
+    pushConstants.textureSize[1] = view.textureSize[1];
+    vkCmdPushConstants(commandBuffer, _bindless.pipelineLayout(), VK_SHADER_STAGE_ALL, 0, sizeof(pushConstants), &pushConstants);
+
+    vkCmdBindIndexBuffer(commandBuffer, _indexBuffer, 0, _indexType);
+    vkCmdDrawIndexed(commandBuffer, _indexCount, 1, 0, 0, 0);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "BindlessHeap.h"
+#include "GpuAllocator.h"
+#include "MeshFile.h"
+#include "UploadRing.h"
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+//how the mesh is shown this frame, it is always fitted to the screen by its bounding sphere
+struct MeshView
+{
+    float yaw = 0.f;   //radians about y
+    float pitch = 0.f; //radians about x, after the yaw
+    float aspect = 1.f;
+
+    //optional, see TextureStreamer. the texture is multiplied over the lighting when its handle is valid
+    BindlessHandle texture = INVALID_BINDLESS_HANDLE;
+    float textureSize[2] = {1.f, 1.f};   //of the texture's full size level, for the feedback
+    BindlessHandle feedbackBuffer = INVALID_BINDLESS_HANDLE;
+    uint32_t feedbackIndex = 0;
+};
+
+//a MeshFile in gpu buffers. the mapped sections go straight to the upload ring with no copy in between,
+//vertices stay quantised and are pulled and unpacked in mesh.vert through the bindless heap, indices
+//stay 16 bit where the file has them that way
+class StaticMesh
+{
+public:
+    StaticMesh(VkDevice device, GpuAllocator& allocator, UploadRing& uploads, BindlessHeap& bindless,
+        const std::vector<uint32_t>& sharedFamilies, const MeshFile& file);
+    ~StaticMesh();
+
+    StaticMesh(const StaticMesh&) = delete;
+    StaticMesh& operator=(const StaticMesh&) = delete;
+
+    //inside the render pass, with the mesh pipeline and the bindless set already bound
+    void recordDraw(VkCommandBuffer commandBuffer, const MeshView& view);
+
+    uint32_t vertexCount() const { return _vertexCount; }
+    uint32_t indexCount() const { return _indexCount; }
+    uint32_t meshletCount() const { return _meshletCount; }
+    VkDeviceSize gpuBytes() const { return _gpuBytes; }
+
+private:
+    VkBuffer createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, GpuAllocation& memory);
+
+    VkDevice _device;
+    GpuAllocator& _allocator;
+    BindlessHeap& _bindless;
+    std::vector<uint32_t> _sharedFamilies;
+
+    uint32_t _vertexCount = 0;
+    uint32_t _indexCount = 0;
+    uint32_t _meshletCount = 0;
+    VkIndexType _indexType = VK_INDEX_TYPE_UINT32;
+    float _boundingSphere[4] = {};
+    VkDeviceSize _gpuBytes = 0;
+
+    VkBuffer _vertexBuffer = VK_NULL_HANDLE;
+    GpuAllocation _vertexMemory;
+    BindlessHandle _vertexHandle = INVALID_BINDLESS_HANDLE;
+    VkBuffer _indexBuffer = VK_NULL_HANDLE;
+    GpuAllocation _indexMemory;
+};
@@ -0,0 +1,63 @@
+#include "TextureFile.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+uint32_t textureFileBytesPerPixel(TextureFileFormat format)
+{
+    switch( format )
+    {
+    case TextureFileFormat::Rgba8Srgb:
+        return 4;
+    }
+    return 0;
+}
+
+TextureFile::TextureFile(std::shared_ptr<const MappedFile> file)
+    : _file(std::move(file))
+{
+    const std::string& path = _file->path();
+    if( _file->size() < sizeof(TextureFileHeader) )
+        throw std::runtime_error(path + " is too small to be a texture!");
+
+    _header = reinterpret_cast<const TextureFileHeader*>(_file->data());
+    if( _header->magic != TEXTURE_FILE_MAGIC || _header->version != TEXTURE_FILE_VERSION )
+        throw std::runtime_error(path + " is not a version " + std::to_string(TEXTURE_FILE_VERSION) + " texture!");
+    if( _header->fileSize != _file->size() )
+        throw std::runtime_error(path + " is truncated!");
+
+    uint32_t bytesPerPixel = textureFileBytesPerPixel(_header->format);
+    if( bytesPerPixel == 0 )
+        throw std::runtime_error(path + " has an unsupported format!");
+    if( _header->width == 0 || _header->height == 0 || _header->levelCount == 0 || _header->levelCount > 32 )
+        throw std::runtime_error(path + " has a bad size or level count!");
+
+    uint64_t fileSize = _file->size();
+    if( sizeof(TextureFileHeader) + static_cast<uint64_t>(_header->levelCount) * sizeof(TextureFileLevel) > fileSize )
+        throw std::runtime_error(path + " has a level table outside the file!");
+    _levels = reinterpret_cast<const TextureFileLevel*>(_file->data() + sizeof(TextureFileHeader));
+
+    //every level has to be the one below halved, down to 1x1 or wherever the file stops
+    for (uint32_t i = 0; i < _header->levelCount; i++)
+    {
+        const TextureFileLevel& level = _levels[i];
+        uint32_t width = std::max(_header->width >> i, 1u);
+        uint32_t height = std::max(_header->height >> i, 1u);
+        if( level.width != width || level.height != height
+            || level.size != static_cast<uint64_t>(width) * height * bytesPerPixel )
+            throw std::runtime_error(path + " has a level that doesn't match its mip chain!");
+        if( level.offset % TEXTURE_FILE_ALIGNMENT != 0 || level.offset > fileSize || level.size > fileSize - level.offset )
+            throw std::runtime_error(path + " has a level outside the file!");
+    }
+}
+
+std::shared_ptr<const TextureFile> TextureFile::open(const std::string& path)
+{
+    return std::shared_ptr<const TextureFile>(new TextureFile(MappedFile::open(path)));
+}
+
+AssetSpan TextureFile::levelData(uint32_t index) const
+{
+    const TextureFileLevel& level = _levels[index];
+    return _file->span(static_cast<size_t>(level.offset), static_cast<size_t>(level.size));
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+//a texture with its whole mip chain ready to go straight into an image, written by VKLearningTextureImport
+//(see TextureImport.h). layout:
+//
+//  TextureFileHeader
+//  TextureFileLevel[levelCount]  finest first
+//  level data                    one tightly packed section per level, coarsest first
+//
+//the coarsest levels come first in the file so the tail the streamer loads up front is one contiguous
+//read. every section starts on a TEXTURE_FILE_ALIGNMENT boundary, everything is little endian and offsets
+//are from the start of the file
+const uint32_t TEXTURE_FILE_MAGIC = 0x58544b56; //"VKTX"
+const uint32_t TEXTURE_FILE_VERSION = 1;
+const uint64_t TEXTURE_FILE_ALIGNMENT = 16;
+
+//not VkFormat, so the tools don't need vulkan. TextureStreamer maps them
+enum class TextureFileFormat : uint32_t
+{
+    Rgba8Srgb = 1,
+};
+
+struct TextureFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    TextureFileFormat format;
+    uint32_t levelCount;
+    uint64_t fileSize;
+};
+
+struct TextureFileLevel
+{
+    uint64_t offset;
+    uint64_t size;
+    uint32_t width;
+    uint32_t height;
+};
+
+static_assert(sizeof(TextureFileHeader) == 32, "TextureFileHeader layout");
+static_assert(sizeof(TextureFileLevel) == 24, "TextureFileLevel layout");
+
+uint32_t textureFileBytesPerPixel(TextureFileFormat format);
+
+//a mapped texture file. levels are views into the mapping, hand them to the upload ring as they are
+class TextureFile
+{
+public:
+    //maps the file and validates the header and level table, throws if they don't describe a full mip
+    //chain or any level falls outside the file
+    static std::shared_ptr<const TextureFile> open(const std::string& path);
+
+    const TextureFileHeader& header() const { return *_header; }
+    const std::string& path() const { return _file->path(); }
+    uint32_t width() const { return _header->width; }
+    uint32_t height() const { return _header->height; }
+    TextureFileFormat format() const { return _header->format; }
+    uint32_t levelCount() const { return _header->levelCount; }
+
+    const TextureFileLevel& level(uint32_t index) const { return _levels[index]; }
+    AssetSpan levelData(uint32_t index) const;
+
+private:
+    explicit TextureFile(std::shared_ptr<const MappedFile> file);
+
+    std::shared_ptr<const MappedFile> _file;
+    const TextureFileHeader* _header = nullptr;
+    const TextureFileLevel* _levels = nullptr;
+};
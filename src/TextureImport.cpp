@@ -0,0 +1,203 @@
+#include "TextureImport.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+    uint64_t alignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    //the srgb curve both ways, decoding goes through a table since there are only 256 inputs
+    float srgbToLinear(uint8_t value)
+    {
+        static const auto table = [] {
+            std::vector<float> result(256);
+            for (uint32_t i = 0; i < 256; i++)
+            {
+                float c = i / 255.f;
+                result[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            }
+            return result;
+        }();
+        return table[value];
+    }
+
+    uint8_t linearToSrgb(float value)
+    {
+        value = std::clamp(value, 0.f, 1.f);
+        float c = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.f / 2.4f) - 0.055f;
+        return static_cast<uint8_t>(std::lround(c * 255.f));
+    }
+
+    //skips whitespace and # comments between the header's fields
+    uint32_t readPpmField(std::istream& in, const std::string& path)
+    {
+        while( true )
+        {
+            int c = in.peek();
+            if( c == '#' )
+                in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            else if( c == ' ' || c == '\t' || c == '\n' || c == '\r' )
+                in.get();
+            else
+                break;
+        }
+
+        uint32_t value = 0;
+        if( !(in >> value) )
+            throw std::runtime_error(path + " has a bad ppm header!");
+        return value;
+    }
+
+    ImportedImage downsample(const ImportedImage& source)
+    {
+        ImportedImage result;
+        result.width = std::max(source.width / 2, 1u);
+        result.height = std::max(source.height / 2, 1u);
+        result.pixels.resize(static_cast<size_t>(result.width) * result.height * 4);
+
+        //the source pixels folding into each destination one, 3 wide when an odd size leaves one over
+        for (uint32_t y = 0; y < result.height; y++)
+        {
+            uint32_t y0 = std::min(2 * y, source.height - 1);
+            uint32_t y1 = y + 1 == result.height ? source.height : std::min(2 * y + 2, source.height);
+            for (uint32_t x = 0; x < result.width; x++)
+            {
+                uint32_t x0 = std::min(2 * x, source.width - 1);
+                uint32_t x1 = x + 1 == result.width ? source.width : std::min(2 * x + 2, source.width);
+
+                float sum[4] = {};
+                for (uint32_t sy = y0; sy < y1; sy++)
+                {
+                    for (uint32_t sx = x0; sx < x1; sx++)
+                    {
+                        const uint8_t* pixel = &source.pixels[(static_cast<size_t>(sy) * source.width + sx) * 4];
+                        for (uint32_t c = 0; c < 3; c++)
+                            sum[c] += srgbToLinear(pixel[c]);
+                        sum[3] += pixel[3] / 255.f; //alpha is linear already
+                    }
+                }
+
+                float count = static_cast<float>((y1 - y0) * (x1 - x0));
+                uint8_t* pixel = &result.pixels[(static_cast<size_t>(y) * result.width + x) * 4];
+                for (uint32_t c = 0; c < 3; c++)
+                    pixel[c] = linearToSrgb(sum[c] / count);
+                pixel[3] = static_cast<uint8_t>(std::lround(std::clamp(sum[3] / count, 0.f, 1.f) * 255.f));
+            }
+        }
+
+        return result;
+    }
+}
+
+ImportedImage loadPpm(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if( !file.is_open() )
+        throw std::runtime_error("failed to open " + path + "!");
+
+    char magic[2] = {};
+    file.read(magic, 2);
+    if( !file || magic[0] != 'P' || magic[1] != '6' )
+        throw std::runtime_error(path + " is not a binary ppm!");
+
+    ImportedImage image;
+    image.width = readPpmField(file, path);
+    image.height = readPpmField(file, path);
+    uint32_t maxValue = readPpmField(file, path);
+    if( image.width == 0 || image.height == 0 || image.width > 16384 || image.height > 16384 )
+        throw std::runtime_error(path + " has an unsupported size!");
+    if( maxValue != 255 )
+        throw std::runtime_error(path + " isn't 8 bits per channel!");
+    file.get(); //the single whitespace before the pixels
+
+    size_t pixelCount = static_cast<size_t>(image.width) * image.height;
+    std::vector<uint8_t> rgb(pixelCount * 3);
+    file.read(reinterpret_cast<char*>(rgb.data()), static_cast<std::streamsize>(rgb.size()));
+    if( !file )
+        throw std::runtime_error(path + " is truncated!");
+
+    image.pixels.resize(pixelCount * 4);
+    for (size_t i = 0; i < pixelCount; i++)
+    {
+        image.pixels[4 * i + 0] = rgb[3 * i + 0];
+        image.pixels[4 * i + 1] = rgb[3 * i + 1];
+        image.pixels[4 * i + 2] = rgb[3 * i + 2];
+        image.pixels[4 * i + 3] = 255;
+    }
+    return image;
+}
+
+std::vector<ImportedImage> buildMipChain(ImportedImage image)
+{
+    std::vector<ImportedImage> levels;
+    levels.push_back(std::move(image));
+    while( levels.back().width > 1 || levels.back().height > 1 )
+        levels.push_back(downsample(levels.back()));
+    return levels;
+}
+
+uint64_t writeTextureFile(const std::string& path, const std::vector<ImportedImage>& levels)
+{
+    if( levels.empty() )
+        throw std::runtime_error("texture has no levels!");
+
+    TextureFileHeader header = {};
+    header.magic = TEXTURE_FILE_MAGIC;
+    header.version = TEXTURE_FILE_VERSION;
+    header.width = levels[0].width;
+    header.height = levels[0].height;
+    header.format = TextureFileFormat::Rgba8Srgb;
+    header.levelCount = static_cast<uint32_t>(levels.size());
+
+    //the table is finest first, the data coarsest first
+    std::vector<TextureFileLevel> table(levels.size());
+    uint64_t offset = alignUp(sizeof(TextureFileHeader) + table.size() * sizeof(TextureFileLevel), TEXTURE_FILE_ALIGNMENT);
+    for (size_t i = levels.size(); i-- > 0; )
+    {
+        table[i].offset = offset;
+        table[i].size = levels[i].pixels.size();
+        table[i].width = levels[i].width;
+        table[i].height = levels[i].height;
+        offset = alignUp(offset + table[i].size, TEXTURE_FILE_ALIGNMENT);
+    }
+    header.fileSize = table[0].offset + table[0].size;
+
+    std::vector<uint8_t> data(static_cast<size_t>(header.fileSize), 0);
+    std::memcpy(data.data(), &header, sizeof(header));
+    std::memcpy(data.data() + sizeof(header), table.data(), table.size() * sizeof(TextureFileLevel));
+    for (size_t i = 0; i < levels.size(); i++)
+        std::memcpy(data.data() + table[i].offset, levels[i].pixels.data(), levels[i].pixels.size());
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if( !file.is_open() )
+        throw std::runtime_error("failed to open " + path + " for writing!");
+    file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    if( !file )
+        throw std::runtime_error("failed to write " + path + "!");
+
+    return header.fileSize;
+}
+
+TextureImportStats importTexture(const std::string& inputPath, const std::string& outputPath)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    TextureImportStats stats;
+
+    auto levels = buildMipChain(loadPpm(inputPath));
+
+    stats.width = levels[0].width;
+    stats.height = levels[0].height;
+    stats.levels = static_cast<uint32_t>(levels.size());
+    stats.fileBytes = writeTextureFile(outputPath, levels);
+    stats.ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    return stats;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "TextureFile.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//one mip level of an rgba8 srgb image, rows top to bottom and tightly packed
+struct ImportedImage
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<uint8_t> pixels;
+};
+
+struct TextureImportStats
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t levels = 0;
+    uint64_t fileBytes = 0;
+    double ms = 0.0;
+};
+
+//binary netpbm (P6) with a maxval of 255, comments allowed in the header. alpha comes out opaque
+ImportedImage loadPpm(const std::string& path);
+
+//the full chain down to 1x1, level 0 being the image itself. each level is a box filter over the one
+//above, averaged in linear space so the chain doesn't darken as it gets smaller. odd sizes fold the
+//last row or column in with its neighbour
+std::vector<ImportedImage> buildMipChain(ImportedImage image);
+
+//writes the chain out in the TextureFile format, returns the file's size
+uint64_t writeTextureFile(const std::string& path, const std::vector<ImportedImage>& levels);
+
+//the whole pipeline: load, build mips, write
+TextureImportStats importTexture(const std::string& inputPath, const std::string& outputPath);
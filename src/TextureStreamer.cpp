@@ -0,0 +1,482 @@
+#include "TextureStreamer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    //what feedback holds for a texture nothing drew this frame
+    const uint32_t FEEDBACK_UNSEEN = UINT32_MAX;
+
+    //loads queued or in progress at once. kept short so what gets loaded next is decided on recent feedback
+    const uint32_t MAX_OUTSTANDING_LOADS = 4;
+
+    //the I/O thread puts at most this much (or a quarter of the ring, if that's less) into the ring at a time
+    //and waits for it to land before the next, so a big level never fills the ring and stalls the frame
+    //loop's own uploads behind it
+    const VkDeviceSize STREAM_BAND_BYTES = 1024 * 1024;
+
+    const size_t PAGE_SIZE = 4096;
+
+    VkFormat toVkFormat(TextureFileFormat format)
+    {
+        switch( format )
+        {
+        case TextureFileFormat::Rgba8Srgb:
+            return VK_FORMAT_R8G8B8A8_SRGB;
+        }
+        throw std::runtime_error("unsupported texture format!");
+    }
+
+    double msSince(std::chrono::high_resolution_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+}
+
+TextureStreamer::TextureStreamer(VkDevice device, GpuAllocator& allocator, UploadRing& uploads, BindlessHeap& bindless,
+    const std::vector<uint32_t>& sharedFamilies, uint32_t framesInFlight, VkDeviceSize budget, uint32_t maxTextures)
+    : _device(device), _allocator(allocator), _uploads(uploads), _bindless(bindless), _sharedFamilies(sharedFamilies),
+      _framesInFlight(framesInFlight), _budget(budget), _maxTextures(maxTextures)
+{
+    _stats.budget = budget;
+
+    VkSamplerCreateInfo samplerInfo = {};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_LINEAR;
+    samplerInfo.minFilter = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.minLod = 0.f;
+    samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+
+    if (vkCreateSampler(_device, &samplerInfo, nullptr, &_sampler) != VK_SUCCESS)
+        throw std::runtime_error("failed to create texture streaming sampler!");
+
+    //host visible so update() can read it straight after the fence, the graph exports it as HostRead
+    _feedback.resize(framesInFlight);
+    for (auto& feedback : _feedback)
+    {
+        VkBufferCreateInfo bufferInfo = {};
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = sizeof(uint32_t) * static_cast<VkDeviceSize>(maxTextures);
+        bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        if (vkCreateBuffer(_device, &bufferInfo, nullptr, &feedback.buffer) != VK_SUCCESS)
+            throw std::runtime_error("failed to create texture feedback buffer!");
+
+        VkMemoryRequirements memoryRequirements = {};
+        vkGetBufferMemoryRequirements(_device, feedback.buffer, &memoryRequirements);
+        feedback.memory = _allocator.allocate(memoryRequirements, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, GpuResourceKind::Buffer);
+        vkBindBufferMemory(_device, feedback.buffer, feedback.memory.memory, feedback.memory.offset);
+        std::memset(feedback.memory.mapped, 0xff, static_cast<size_t>(bufferInfo.size));
+
+        feedback.handle = _bindless.addBuffer(feedback.buffer);
+    }
+
+    //sized up front so neither thread's queues allocate once streaming
+    _textures.reserve(maxTextures);
+    _requests.reserve(maxTextures);
+    _completed.reserve(maxTextures);
+    _arrived.reserve(maxTextures);
+    _retired.reserve(maxTextures);
+
+    _ioThread = std::thread([this] { ioLoop(); });
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    stopLoading();
+
+    //only destroyed once the device is idle, so nothing has to wait out frames in flight
+    for (auto& completed : _completed)
+        destroyImage(completed.image);
+    for (auto& retired : _retired)
+        destroyImage(retired.image);
+    for (auto& texture : _textures)
+        destroyImage(texture.image);
+
+    for (auto& feedback : _feedback)
+    {
+        _bindless.releaseBuffer(feedback.handle, 0);
+        vkDestroyBuffer(_device, feedback.buffer, nullptr);
+        _allocator.free(feedback.memory);
+    }
+
+    vkDestroySampler(_device, _sampler, nullptr);
+}
+
+VkDeviceSize TextureStreamer::levelBytes(const TextureFile& file, uint32_t firstLevel)
+{
+    VkDeviceSize bytes = 0;
+    for (uint32_t level = firstLevel; level < file.levelCount(); level++)
+        bytes += file.level(level).size;
+    return bytes;
+}
+
+StreamedTextureId TextureStreamer::add(std::shared_ptr<const TextureFile> file)
+{
+    if( _textures.size() >= _maxTextures )
+        throw std::runtime_error("texture streamer is full!");
+
+    Texture texture;
+    texture.tailLevel = file->levelCount() - 1;
+    for (uint32_t level = 0; level < file->levelCount(); level++)
+    {
+        if( std::max(file->level(level).width, file->level(level).height) <= TEXTURE_TAIL_SIZE )
+        {
+            texture.tailLevel = level;
+            break;
+        }
+    }
+    texture.residentLevel = file->levelCount();
+    texture.wantedLevel = texture.tailLevel;
+    texture.file = std::move(file);
+
+    StreamedTextureId id = static_cast<StreamedTextureId>(_textures.size());
+    _textures.push_back(std::move(texture));
+    _stats.textures++;
+
+    //tails skip the budget, they are what gets drawn while anything else is on its way
+    queueLoad(id, _textures[id].tailLevel);
+    return id;
+}
+
+void TextureStreamer::queueLoad(StreamedTextureId id, uint32_t firstLevel)
+{
+    Texture& texture = _textures[id];
+
+    LoadRequest request;
+    request.id = id;
+    request.firstLevel = firstLevel;
+    request.estimate = levelBytes(*texture.file, firstLevel);
+    request.file = texture.file;
+
+    texture.loading = true;
+    _pendingBytes += request.estimate;
+    _outstanding++;
+
+    {
+        std::lock_guard<std::mutex> lock(_ioMutex);
+        _requests.push_back(std::move(request));
+    }
+    _ioWake.notify_one();
+}
+
+void TextureStreamer::markUsed(StreamedTextureId id, uint32_t level, uint64_t frameNumber)
+{
+    Texture& texture = _textures[id];
+    texture.wantedLevel = std::min(level, texture.tailLevel);
+    texture.lastUsedFrame = frameNumber;
+}
+
+void TextureStreamer::update(uint32_t frameSlot, uint64_t frameNumber)
+{
+    //what the frame that last used this slot drew with
+    auto* requested = static_cast<uint32_t*>(_feedback[frameSlot].memory.mapped);
+    for (size_t id = 0; id < _textures.size(); id++)
+    {
+        if( requested[id] != FEEDBACK_UNSEEN )
+            markUsed(static_cast<StreamedTextureId>(id), requested[id], frameNumber);
+    }
+    std::memset(requested, 0xff, _textures.size() * sizeof(uint32_t));
+
+    //swap finished loads in, the frame about to be recorded is the first to see the new handle
+    {
+        std::lock_guard<std::mutex> lock(_ioMutex);
+        if( _ioError )
+            std::rethrow_exception(_ioError);
+        _arrived.swap(_completed);
+    }
+    for (auto& arrived : _arrived)
+    {
+        Texture& texture = _textures[arrived.request.id];
+        if( texture.image.image != VK_NULL_HANDLE )
+        {
+            //the handle is released here, destroyImage() mustn't release it again
+            _bindless.releaseTexture(texture.image.handle, frameNumber);
+            _retired.push_back({texture.image, frameNumber});
+            _retired.back().image.handle = INVALID_BINDLESS_HANDLE;
+        }
+
+        arrived.image.handle = _bindless.addTexture(arrived.image.view, _sampler);
+        texture.image = arrived.image;
+        texture.residentLevel = arrived.request.firstLevel;
+        texture.loading = false;
+
+        _pendingBytes -= arrived.request.estimate;
+        _residentBytes += arrived.image.bytes;
+        _outstanding--;
+        _stats.loads++;
+    }
+    _arrived.clear();
+    _stats.peakResidentBytes = std::max(_stats.peakResidentBytes, _residentBytes);
+
+    //same rule as BindlessHeap::collectGarbage, released in frame order so the safe ones are at the front
+    if( frameNumber >= _framesInFlight )
+    {
+        uint64_t safeFrame = frameNumber - _framesInFlight + 1;
+        size_t count = 0;
+        for (; count < _retired.size() && _retired[count].frameNumber < safeFrame; count++)
+        {
+            _residentBytes -= _retired[count].image.bytes;
+            destroyImage(_retired[count].image);
+        }
+        _retired.erase(_retired.begin(), _retired.begin() + count);
+    }
+
+    scheduleLoads();
+}
+
+void TextureStreamer::scheduleLoads()
+{
+    if( _outstanding >= MAX_OUTSTANDING_LOADS )
+        return;
+
+    //the most recently drawn texture short of what it wants, the biggest shortfall among those
+    Texture* best = nullptr;
+    for (auto& texture : _textures)
+    {
+        if( texture.loading || texture.image.image == VK_NULL_HANDLE || texture.wantedLevel >= texture.residentLevel )
+            continue;
+        if( best == nullptr || texture.lastUsedFrame > best->lastUsedFrame
+            || (texture.lastUsedFrame == best->lastUsedFrame && texture.residentLevel - texture.wantedLevel > best->residentLevel - best->wantedLevel) )
+            best = &texture;
+    }
+    if( best == nullptr )
+        return;
+
+    //straight to what it wants if that fits, otherwise a level at a time
+    StreamedTextureId id = static_cast<StreamedTextureId>(best - _textures.data());
+    VkDeviceSize committed = _residentBytes + _pendingBytes;
+    for (uint32_t level : {best->wantedLevel, best->residentLevel - 1})
+    {
+        if( committed + levelBytes(*best->file, level) <= _budget )
+        {
+            queueLoad(id, level);
+            return;
+        }
+    }
+
+    //full, make room for next time
+    evictOne(*best);
+}
+
+bool TextureStreamer::evictOne(const Texture& requester)
+{
+    //levels nobody wants any more go first, then the least recently used. never anything drawn as
+    //recently as the requester, or two textures on screen would just take turns evicting each other
+    Texture* victim = nullptr;
+    auto priority = [](const Texture& texture) { return texture.residentLevel < texture.wantedLevel ? 0 : 1; };
+    for (auto& texture : _textures)
+    {
+        if( &texture == &requester || texture.loading || texture.image.image == VK_NULL_HANDLE || texture.residentLevel >= texture.tailLevel )
+            continue;
+        if( texture.residentLevel >= texture.wantedLevel && texture.lastUsedFrame >= requester.lastUsedFrame )
+            continue;
+        if( victim == nullptr || priority(texture) < priority(*victim)
+            || (priority(texture) == priority(*victim) && texture.lastUsedFrame < victim->lastUsedFrame) )
+            victim = &texture;
+    }
+    if( victim == nullptr )
+        return false;
+
+    queueLoad(static_cast<StreamedTextureId>(victim - _textures.data()), victim->residentLevel + 1);
+    _stats.evictions++;
+    return true;
+}
+
+void TextureStreamer::stopLoading()
+{
+    if( !_ioThread.joinable() )
+        return;
+
+    //whatever the I/O thread is in the middle of finishes first
+    {
+        std::lock_guard<std::mutex> lock(_ioMutex);
+        _stopping = true;
+    }
+    _ioWake.notify_all();
+    _ioThread.join();
+}
+
+void TextureStreamer::destroyImage(Image& image)
+{
+    if( image.image == VK_NULL_HANDLE )
+        return;
+
+    if( image.handle != INVALID_BINDLESS_HANDLE )
+        _bindless.releaseTexture(image.handle, 0);
+    if( image.view != VK_NULL_HANDLE )
+        vkDestroyImageView(_device, image.view, nullptr);
+    vkDestroyImage(_device, image.image, nullptr);
+    if( image.memory.isValid() )
+        _allocator.free(image.memory);
+    image = {};
+}
+
+void TextureStreamer::ioLoop()
+{
+    while( true )
+    {
+        LoadRequest request;
+        {
+            std::unique_lock<std::mutex> lock(_ioMutex);
+            _ioWake.wait(lock, [&] { return _stopping || !_requests.empty(); });
+            if( _stopping )
+                return;
+
+            //never more than a handful queued, so taking the front is cheap
+            request = std::move(_requests.front());
+            _requests.erase(_requests.begin());
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        Image image;
+        try
+        {
+            image = load(request);
+        }
+        catch (...)
+        {
+            //handed to the frame loop, which rethrows it from update()
+            std::lock_guard<std::mutex> lock(_ioMutex);
+            _ioError = std::current_exception();
+            return;
+        }
+        double ms = msSince(start);
+
+        std::lock_guard<std::mutex> lock(_ioMutex);
+        _completed.push_back({std::move(request), image});
+        _bytesStreamed += _completed.back().request.estimate;
+        _ioMs += ms;
+        _maxLoadMs = std::max(_maxLoadMs, ms);
+    }
+}
+
+TextureStreamer::Image TextureStreamer::load(const LoadRequest& request)
+{
+    const TextureFile& file = *request.file;
+    const TextureFileLevel& first = file.level(request.firstLevel);
+    uint32_t levelCount = file.levelCount() - request.firstLevel;
+
+    VkImageCreateInfo imageInfo = {};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = toVkFormat(file.format());
+    imageInfo.extent = {first.width, first.height, 1};
+    imageInfo.mipLevels = levelCount;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    //the upload ring may write from another family than the one sampling
+    if( _sharedFamilies.size() > 1 )
+    {
+        imageInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        imageInfo.queueFamilyIndexCount = static_cast<uint32_t>(_sharedFamilies.size());
+        imageInfo.pQueueFamilyIndices = _sharedFamilies.data();
+    }
+
+    Image image;
+    if (vkCreateImage(_device, &imageInfo, nullptr, &image.image) != VK_SUCCESS)
+        throw std::runtime_error("failed to create streamed texture image!");
+
+    try
+    {
+        fillImage(request, image, levelCount, imageInfo.format);
+    }
+    catch (...)
+    {
+        destroyImage(image);
+        throw;
+    }
+    return image;
+}
+
+void TextureStreamer::fillImage(const LoadRequest& request, Image& image, uint32_t levelCount, VkFormat format)
+{
+    const TextureFile& file = *request.file;
+
+    VkMemoryRequirements memoryRequirements = {};
+    vkGetImageMemoryRequirements(_device, image.image, &memoryRequirements);
+    image.memory = _allocator.allocate(memoryRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, GpuResourceKind::Image);
+    image.bytes = memoryRequirements.size;
+    vkBindImageMemory(_device, image.image, image.memory.memory, image.memory.offset);
+
+    //coarsest first, the same order they sit in the file
+    for (uint32_t level = file.levelCount(); level-- > request.firstLevel; )
+    {
+        const TextureFileLevel& info = file.level(level);
+        AssetSpan data = file.levelData(level);
+
+        //fault the pages in here rather than in the ring's memcpy, which holds the ring's lock
+        volatile uint8_t sink = 0;
+        for (size_t offset = 0; offset < data.size(); offset += PAGE_SIZE)
+            sink = sink + data.data()[offset];
+
+        VkDeviceSize rowBytes = info.size / info.height;
+        VkDeviceSize bandBytes = std::min(STREAM_BAND_BYTES, _uploads.capacity() / 4);
+        uint32_t bandRows = static_cast<uint32_t>(std::max<VkDeviceSize>(bandBytes / rowBytes, 1));
+        for (uint32_t row = 0; row < info.height; row += bandRows)
+        {
+            uint32_t rows = std::min(bandRows, info.height - row);
+            UploadTicket ticket = _uploads.uploadImageRows(image.image, info.width, row, rows, level - request.firstLevel,
+                data.data() + rowBytes * row, rowBytes * rows, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+            waitForUpload(ticket);
+        }
+    }
+
+    VkImageViewCreateInfo viewInfo = {};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = image.image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = format;
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.baseMipLevel = 0;
+    viewInfo.subresourceRange.levelCount = levelCount;
+    viewInfo.subresourceRange.baseArrayLayer = 0;
+    viewInfo.subresourceRange.layerCount = 1;
+
+    if (vkCreateImageView(_device, &viewInfo, nullptr, &image.view) != VK_SUCCESS)
+        throw std::runtime_error("failed to create streamed texture view!");
+}
+
+void TextureStreamer::waitForUpload(UploadTicket ticket)
+{
+    //polls, UploadRing::wait would hold the ring's lock (and with it any upload from the frame loop) for
+    //as long as the copy takes
+    _uploads.flush();
+    while( !_uploads.isComplete(ticket) )
+        std::this_thread::sleep_for(std::chrono::microseconds(250));
+}
+
+TextureStreamerStats TextureStreamer::stats() const
+{
+    TextureStreamerStats result = _stats;
+    result.residentBytes = _residentBytes;
+
+    std::lock_guard<std::mutex> lock(_ioMutex);
+    result.bytesStreamed = _bytesStreamed;
+    result.ioMs = _ioMs;
+    result.maxLoadMs = _maxLoadMs;
+    return result;
+}
+
+void TextureStreamer::printStats(std::ostream& out) const
+{
+    TextureStreamerStats s = stats();
+
+    out << "texture streamer: " << s.textures << " textures, " << (s.residentBytes / (1024.0 * 1024.0)) << " of "
+        << (s.budget / (1024.0 * 1024.0)) << " MiB resident, peak " << (s.peakResidentBytes / (1024.0 * 1024.0)) << " MiB" << std::endl;
+    out << "  " << s.loads << " loads, " << s.evictions << " evictions, " << (s.bytesStreamed / (1024.0 * 1024.0))
+        << " MiB streamed in " << s.ioMs << " ms on the I/O thread (slowest load " << s.maxLoadMs << " ms)" << std::endl;
+}
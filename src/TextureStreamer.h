@@ -0,0 +1,184 @@
+#pragma once
+
+#include "BindlessHeap.h"
+#include "GpuAllocator.h"
+#include "TextureFile.h"
+#include "UploadRing.h"
+
+#include <vulkan/vulkan.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+//index of a texture added to the streamer, also its slot in the feedback buffers
+using StreamedTextureId = uint32_t;
+
+//levels no bigger than this on either side are the mip tail, loaded first and never evicted
+const uint32_t TEXTURE_TAIL_SIZE = 64;
+
+struct TextureStreamerStats
+{
+    VkDeviceSize budget = 0;
+    VkDeviceSize residentBytes = 0;     //every image alive, including replaced ones waiting out frames in flight
+    VkDeviceSize peakResidentBytes = 0;
+    uint32_t textures = 0;
+    uint32_t loads = 0;                 //images built, tails included
+    uint32_t evictions = 0;             //levels dropped to make room
+    uint64_t bytesStreamed = 0;
+    double ioMs = 0.0;                  //the I/O thread's time spent loading, none of it on the frame loop
+    double maxLoadMs = 0.0;
+};
+
+//streams mip chained textures (TextureFile) under a fixed memory budget. each texture is one image holding
+//its finest resident level down to 1x1. the mip tail goes in first so there is always something to sample,
+//finer levels are streamed in as the feedback asks for them, and when the budget is full the least recently
+//used texture gives up its finest level to make room.
+//
+//changing what is resident builds a new image with the new level range on a background I/O thread, which
+//reads the mapped file and paces its uploads through the ring a band at a time, so nothing on the frame
+//loop waits on disk or on the copies. the finished image swaps in under a new bindless handle and the old
+//one is destroyed once the frames in flight that might read it are done. a texture's image is briefly
+//there twice while it is replaced, dropping a level builds the smaller one first, so the budget can be
+//overshot by a quarter of the texture being evicted until the bigger one goes.
+//
+//feedback is a buffer of uint32 per frame slot, one per texture: mesh.frag atomicMins the level it would
+//sample into it, update() reads the slot's buffer once its fence has been waited on. without fragment
+//stores markUsed() does the same from the cpu
+class TextureStreamer
+{
+public:
+    TextureStreamer(VkDevice device, GpuAllocator& allocator, UploadRing& uploads, BindlessHeap& bindless,
+        const std::vector<uint32_t>& sharedFamilies, uint32_t framesInFlight, VkDeviceSize budget, uint32_t maxTextures = 1024);
+    ~TextureStreamer();
+
+    //finishes the load in progress and stops the I/O thread, which submits uploads of its own. nothing is
+    //loaded after this, update() only swaps in what had already arrived
+    void stopLoading();
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    //queues the mip tail, the texture can't be sampled until handle() says otherwise
+    StreamedTextureId add(std::shared_ptr<const TextureFile> file);
+
+    //INVALID_BINDLESS_HANDLE until the tail is in, changes whenever the resident levels do so fetch it every frame
+    BindlessHandle handle(StreamedTextureId id) const { return _textures[id].image.handle; }
+    const TextureFile& file(StreamedTextureId id) const { return *_textures[id].file; }
+
+    //call with the frame about to be recorded, after its frame slot's fence has been waited on. reads and
+    //clears the slot's feedback, swaps in finished loads and decides what to load or evict next
+    void update(uint32_t frameSlot, uint64_t frameNumber);
+
+    //the cpu side of the feedback, for when shaders can't write it
+    void markUsed(StreamedTextureId id, uint32_t level, uint64_t frameNumber);
+
+    VkBuffer feedbackBuffer(uint32_t frameSlot) const { return _feedback[frameSlot].buffer; }
+    BindlessHandle feedbackHandle(uint32_t frameSlot) const { return _feedback[frameSlot].handle; }
+
+    //nothing queued or loading, frames are only allocation free while this holds
+    bool idle() const { return _outstanding == 0; }
+
+    TextureStreamerStats stats() const;
+    void printStats(std::ostream& out) const;
+
+private:
+    struct Image
+    {
+        VkImage image = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        GpuAllocation memory;
+        VkDeviceSize bytes = 0;
+        BindlessHandle handle = INVALID_BINDLESS_HANDLE;
+    };
+
+    //owned by the frame loop, the I/O thread only ever sees requests and hands back completed loads
+    struct Texture
+    {
+        std::shared_ptr<const TextureFile> file;
+        uint32_t tailLevel = 0;
+        uint32_t residentLevel = 0; //finest level in image, levelCount while there is no image
+        uint32_t wantedLevel = 0;   //finest level the feedback last asked for
+        uint64_t lastUsedFrame = 0;
+        bool loading = false;
+        Image image;
+    };
+
+    struct LoadRequest
+    {
+        StreamedTextureId id = 0;
+        uint32_t firstLevel = 0;
+        VkDeviceSize estimate = 0; //what the budget was charged until the real size is known
+        std::shared_ptr<const TextureFile> file;
+    };
+
+    struct CompletedLoad
+    {
+        LoadRequest request;
+        Image image;
+    };
+
+    struct RetiredImage
+    {
+        Image image;
+        uint64_t frameNumber;
+    };
+
+    struct FeedbackBuffer
+    {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        GpuAllocation memory;
+        BindlessHandle handle = INVALID_BINDLESS_HANDLE;
+    };
+
+    static VkDeviceSize levelBytes(const TextureFile& file, uint32_t firstLevel);
+
+    void queueLoad(StreamedTextureId id, uint32_t firstLevel);
+    void scheduleLoads();
+    bool evictOne(const Texture& requester);
+    void destroyImage(Image& image);
+
+    //the I/O thread
+    void ioLoop();
+    Image load(const LoadRequest& request);
+    void fillImage(const LoadRequest& request, Image& image, uint32_t levelCount, VkFormat format);
+    void waitForUpload(UploadTicket ticket);
+
+    VkDevice _device;
+    GpuAllocator& _allocator;
+    UploadRing& _uploads;
+    BindlessHeap& _bindless;
+    std::vector<uint32_t> _sharedFamilies;
+    uint32_t _framesInFlight;
+    VkDeviceSize _budget;
+    uint32_t _maxTextures;
+
+    VkSampler _sampler = VK_NULL_HANDLE;
+    std::vector<FeedbackBuffer> _feedback;
+
+    //frame loop only
+    std::vector<Texture> _textures;
+    std::vector<RetiredImage> _retired;
+    std::vector<CompletedLoad> _arrived; //swapped with _completed, so taking them doesn't allocate
+    VkDeviceSize _residentBytes = 0;
+    VkDeviceSize _pendingBytes = 0;
+    uint32_t _outstanding = 0;
+    TextureStreamerStats _stats;
+
+    //shared with the I/O thread
+    mutable std::mutex _ioMutex;
+    std::condition_variable _ioWake;
+    std::vector<LoadRequest> _requests; //oldest first
+    std::vector<CompletedLoad> _completed;
+    uint64_t _bytesStreamed = 0;
+    double _ioMs = 0.0;
+    double _maxLoadMs = 0.0;
+    std::exception_ptr _ioError;
+    bool _stopping = false;
+    std::thread _ioThread;
+};
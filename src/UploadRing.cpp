@@ -0,0 +1,472 @@
+#include "UploadRing.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+    //satisfies the copy offset rules for every uncompressed format and 16 byte compressed blocks
+    const VkDeviceSize UPLOAD_ALIGNMENT = 16;
+
+    //batches are submitted early once they cover this much of the ring, so one frame's worth of
+    //uploads can't hold the whole ring hostage until the next flush
+    const VkDeviceSize AUTO_FLUSH_FRACTION = 4;
+
+    VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    double secondsSince(std::chrono::high_resolution_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+}
+
+UploadRing::UploadRing(VkDevice device, DeviceQueues& queues, GpuAllocator& allocator, VkDeviceSize capacity)
+    : _device(device), _queues(queues), _allocator(allocator), _capacity(alignUp(capacity, UPLOAD_ALIGNMENT))
+{
+    VkBufferCreateInfo bufferInfo = {};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = _capacity;
+    bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateBuffer(_device, &bufferInfo, nullptr, &_buffer) != VK_SUCCESS)
+        throw std::runtime_error("failed to create upload ring buffer!");
+
+    VkMemoryRequirements memoryRequirements = {};
+    vkGetBufferMemoryRequirements(_device, _buffer, &memoryRequirements);
+
+    //coherent so nothing needs flushing, the allocator keeps host visible memory mapped for us
+    _memory = _allocator.allocate(memoryRequirements, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, GpuResourceKind::Buffer);
+    vkBindBufferMemory(_device, _buffer, _memory.memory, _memory.offset);
+    _mapped = static_cast<uint8_t*>(_memory.mapped);
+
+    _stats.capacity = _capacity;
+}
+
+UploadRing::~UploadRing()
+{
+    waitIdle();
+
+    for (auto& batch : _freeBatches)
+    {
+        vkDestroyCommandPool(_device, batch.commandPool, nullptr);
+        vkDestroyFence(_device, batch.fence, nullptr);
+    }
+
+    vkDestroyBuffer(_device, _buffer, nullptr);
+    _allocator.free(_memory);
+}
+
+bool UploadRing::tryAllocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset)
+{
+    if( _used == 0 )
+        _head = _tail = 0;
+
+    VkDeviceSize aligned = alignUp(_head, alignment);
+
+    //free space is [head, capacity) + [0, tail) when head is ahead of tail, [head, tail) once it has wrapped
+    if( _used == 0 || _head > _tail )
+    {
+        if( aligned + size <= _capacity )
+            offset = aligned;
+        else if( size <= _tail )
+            offset = 0; //wrap, the end of the ring is wasted until this batch retires
+        else
+            return false;
+    }
+    else if( _head < _tail && aligned + size <= _tail )
+        offset = aligned;
+    else
+        return false;
+
+    VkDeviceSize consumed = offset == 0 && _head != 0 ? (_capacity - _head) + size : (offset - _head) + size;
+    _used += consumed;
+    _pendingConsumed += consumed;
+    _head = offset + size;
+    _stats.peakUsage = std::max(_stats.peakUsage, _used);
+    return true;
+}
+
+VkDeviceSize UploadRing::allocate(VkDeviceSize size, VkDeviceSize alignment)
+{
+    if( size > _capacity )
+        throw std::runtime_error("upload does not fit in the upload ring!");
+
+    VkDeviceSize offset = 0;
+    if( tryAllocate(size, alignment, offset) )
+        return offset;
+
+    retireLocked(false);
+    if( tryAllocate(size, alignment, offset) )
+        return offset;
+
+    //genuinely full, submit what we have so its space can come back then wait for the oldest batches
+    auto start = std::chrono::high_resolution_clock::now();
+    _stats.stalls++;
+
+    flushLocked();
+    while( !tryAllocate(size, alignment, offset) )
+    {
+        if( _inFlight.empty() )
+            throw std::runtime_error("upload ring is empty but still can't fit the upload!");
+        retireLocked(true);
+    }
+
+    _stats.stallMs += secondsSince(start) * 1000.0;
+    return offset;
+}
+
+UploadTicket UploadRing::uploadBuffer(VkBuffer destination, VkDeviceSize destinationOffset, const void* data, VkDeviceSize size)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    //big uploads go in pieces so the ring can keep recycling underneath them
+    VkDeviceSize maxChunk = std::max(_capacity / 2, UPLOAD_ALIGNMENT);
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+    for (VkDeviceSize done = 0; done < size; )
+    {
+        VkDeviceSize chunk = std::min(size - done, maxChunk);
+        VkDeviceSize offset = allocate(chunk, UPLOAD_ALIGNMENT);
+        std::memcpy(_mapped + offset, bytes + done, static_cast<size_t>(chunk));
+
+        BufferCopy copy = {};
+        copy.destination = destination;
+        copy.region.srcOffset = offset;
+        copy.region.dstOffset = destinationOffset + done;
+        copy.region.size = chunk;
+        copy.sequence = static_cast<uint32_t>(_pendingBufferCopies.size());
+        _pendingBufferCopies.push_back(copy);
+
+        _pendingBytes += chunk;
+        _stats.bytesStaged += chunk;
+        _stats.copies++;
+        done += chunk;
+
+        if( _pendingConsumed >= _capacity / AUTO_FLUSH_FRACTION )
+            flushLocked();
+    }
+
+    return pendingTicket();
+}
+
+UploadTicket UploadRing::uploadImage(VkImage destination, uint32_t width, uint32_t height, uint32_t mipLevel,
+    const void* data, VkDeviceSize size, VkImageLayout finalLayout)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    //whole rows at a time, the same limit uploadBuffer splits at
+    VkDeviceSize maxChunk = std::max(_capacity / 2, UPLOAD_ALIGNMENT);
+    VkDeviceSize rowBytes = size / std::max(height, 1u);
+    if( rowBytes == 0 || rowBytes * height != size )
+        throw std::runtime_error("image upload isn't a whole number of rows!");
+    if( rowBytes > maxChunk )
+        throw std::runtime_error("a row of the image does not fit in the upload ring!");
+
+    uint32_t bandRows = static_cast<uint32_t>(std::min<VkDeviceSize>(maxChunk / rowBytes, height));
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (uint32_t row = 0; row < height; row += bandRows)
+    {
+        uint32_t rows = std::min(bandRows, height - row);
+        recordImageRows(destination, width, row, rows, mipLevel, bytes + rowBytes * row, rowBytes * rows, finalLayout);
+    }
+
+    return pendingTicket();
+}
+
+UploadTicket UploadRing::uploadImageRows(VkImage destination, uint32_t width, uint32_t firstRow, uint32_t rowCount, uint32_t mipLevel,
+    const void* data, VkDeviceSize size, VkImageLayout finalLayout)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if( rowCount == 0 || size % rowCount != 0 )
+        throw std::runtime_error("image upload isn't a whole number of rows!");
+    recordImageRows(destination, width, firstRow, rowCount, mipLevel, static_cast<const uint8_t*>(data), size, finalLayout);
+
+    return pendingTicket();
+}
+
+void UploadRing::recordImageRows(VkImage destination, uint32_t width, uint32_t firstRow, uint32_t rowCount, uint32_t mipLevel,
+    const uint8_t* data, VkDeviceSize size, VkImageLayout finalLayout)
+{
+    VkDeviceSize offset = allocate(size, UPLOAD_ALIGNMENT);
+    std::memcpy(_mapped + offset, data, static_cast<size_t>(size));
+
+    ImageCopy copy = {};
+    copy.destination = destination;
+    copy.initialLayout = firstRow == 0 ? VK_IMAGE_LAYOUT_UNDEFINED : finalLayout;
+    copy.finalLayout = finalLayout;
+    copy.region.bufferOffset = offset;
+    copy.region.bufferRowLength = 0;
+    copy.region.bufferImageHeight = 0;
+    copy.region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    copy.region.imageSubresource.mipLevel = mipLevel;
+    copy.region.imageSubresource.baseArrayLayer = 0;
+    copy.region.imageSubresource.layerCount = 1;
+    copy.region.imageOffset = {0, static_cast<int32_t>(firstRow), 0};
+    copy.region.imageExtent = {width, rowCount, 1};
+    copy.sequence = static_cast<uint32_t>(_pendingImageCopies.size());
+    _pendingImageCopies.push_back(copy);
+
+    _pendingBytes += size;
+    _stats.bytesStaged += size;
+    _stats.copies++;
+
+    if( _pendingConsumed >= _capacity / AUTO_FLUSH_FRACTION )
+        flushLocked();
+}
+
+//the open batch gets _nextTicket when it is flushed, or it already went out as _nextTicket - 1
+UploadTicket UploadRing::pendingTicket() const
+{
+    return _pendingBufferCopies.empty() && _pendingImageCopies.empty() ? _nextTicket - 1 : _nextTicket;
+}
+
+UploadRing::Batch UploadRing::acquireBatch()
+{
+    if( !_freeBatches.empty() )
+    {
+        Batch batch = _freeBatches.back();
+        _freeBatches.pop_back();
+        return batch;
+    }
+
+    Batch batch;
+
+    VkCommandPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    poolInfo.queueFamilyIndex = _queues.family(QueueType::Transfer);
+
+    if (vkCreateCommandPool(_device, &poolInfo, nullptr, &batch.commandPool) != VK_SUCCESS)
+        throw std::runtime_error("failed to create upload command pool!");
+
+    VkCommandBufferAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = batch.commandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 1;
+
+    if (vkAllocateCommandBuffers(_device, &allocInfo, &batch.commandBuffer) != VK_SUCCESS)
+        throw std::runtime_error("failed to allocate upload command buffer!");
+
+    VkFenceCreateInfo fenceInfo = {};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+    if (vkCreateFence(_device, &fenceInfo, nullptr, &batch.fence) != VK_SUCCESS)
+        throw std::runtime_error("failed to create upload fence!");
+
+    return batch;
+}
+
+void UploadRing::flushLocked()
+{
+    if( _pendingBufferCopies.empty() && _pendingImageCopies.empty() )
+        return;
+
+    Batch batch = acquireBatch();
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    if (vkBeginCommandBuffer(batch.commandBuffer, &beginInfo) != VK_SUCCESS)
+        throw std::runtime_error("failed to begin recording upload command buffer!");
+
+    //one vkCmdCopyBuffer per destination however many uploads it got this batch
+    std::sort(_pendingBufferCopies.begin(), _pendingBufferCopies.end(), [](const BufferCopy& a, const BufferCopy& b) {
+        return a.destination != b.destination ? a.destination < b.destination : a.sequence < b.sequence;
+    });
+
+    for (size_t i = 0; i < _pendingBufferCopies.size(); )
+    {
+        _regions.clear();
+        VkBuffer destination = _pendingBufferCopies[i].destination;
+        for (; i < _pendingBufferCopies.size() && _pendingBufferCopies[i].destination == destination; i++)
+            _regions.push_back(_pendingBufferCopies[i].region);
+
+        vkCmdCopyBuffer(batch.commandBuffer, _buffer, destination, static_cast<uint32_t>(_regions.size()), _regions.data());
+    }
+
+    if( !_pendingImageCopies.empty() )
+    {
+        //grouped by level so each one gets a single pair of barriers however many bands it came in
+        std::sort(_pendingImageCopies.begin(), _pendingImageCopies.end(), [](const ImageCopy& a, const ImageCopy& b) {
+            if( a.destination != b.destination )
+                return a.destination < b.destination;
+            if( a.region.imageSubresource.mipLevel != b.region.imageSubresource.mipLevel )
+                return a.region.imageSubresource.mipLevel < b.region.imageSubresource.mipLevel;
+            return a.sequence < b.sequence;
+        });
+
+        _toTransfer.clear();
+        _toFinal.clear();
+        VkPipelineStageFlags transferSourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        for (size_t i = 0; i < _pendingImageCopies.size(); i++)
+        {
+            const auto& copy = _pendingImageCopies[i];
+            if( i > 0 && _pendingImageCopies[i - 1].destination == copy.destination
+                && _pendingImageCopies[i - 1].region.imageSubresource.mipLevel == copy.region.imageSubresource.mipLevel )
+                continue;
+
+            VkImageMemoryBarrier barrier = {};
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.image = copy.destination;
+            barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            barrier.subresourceRange.baseMipLevel = copy.region.imageSubresource.mipLevel;
+            barrier.subresourceRange.levelCount = 1;
+            barrier.subresourceRange.baseArrayLayer = 0;
+            barrier.subresourceRange.layerCount = 1;
+
+            //the first of the group decides, a level carrying on from an earlier batch has to wait for its copies
+            barrier.oldLayout = copy.initialLayout;
+            barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.srcAccessMask = copy.initialLayout == VK_IMAGE_LAYOUT_UNDEFINED ? 0 : VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            _toTransfer.push_back(barrier);
+            if( copy.initialLayout != VK_IMAGE_LAYOUT_UNDEFINED )
+                transferSourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+            //consumers wait on the fence, so there is nothing further down this queue to order against
+            barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.newLayout = copy.finalLayout;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = 0;
+            _toFinal.push_back(barrier);
+        }
+
+        vkCmdPipelineBarrier(batch.commandBuffer, transferSourceStage, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+            0, nullptr, 0, nullptr, static_cast<uint32_t>(_toTransfer.size()), _toTransfer.data());
+
+        for (size_t i = 0; i < _pendingImageCopies.size(); )
+        {
+            _imageRegions.clear();
+            VkImage destination = _pendingImageCopies[i].destination;
+            for (; i < _pendingImageCopies.size() && _pendingImageCopies[i].destination == destination; i++)
+                _imageRegions.push_back(_pendingImageCopies[i].region);
+
+            vkCmdCopyBufferToImage(batch.commandBuffer, _buffer, destination, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                static_cast<uint32_t>(_imageRegions.size()), _imageRegions.data());
+        }
+
+        vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+            0, nullptr, 0, nullptr, static_cast<uint32_t>(_toFinal.size()), _toFinal.data());
+    }
+
+    if (vkEndCommandBuffer(batch.commandBuffer) != VK_SUCCESS)
+        throw std::runtime_error("failed to record upload command buffer!");
+
+    if (_queues.submit(QueueType::Transfer, batch.commandBuffer, batch.fence) != VK_SUCCESS)
+        throw std::runtime_error("failed to submit upload batch!");
+
+    batch.ticket = _nextTicket++;
+    batch.consumed = _pendingConsumed;
+    batch.ringEnd = _head;
+    batch.bytes = _pendingBytes;
+
+    if( _inFlight.empty() )
+        _busyStart = std::chrono::high_resolution_clock::now();
+    _inFlight.push_back(batch);
+    _stats.batches++;
+
+    _pendingBufferCopies.clear();
+    _pendingImageCopies.clear();
+    _pendingConsumed = 0;
+    _pendingBytes = 0;
+}
+
+void UploadRing::retireLocked(bool block)
+{
+    while( !_inFlight.empty() )
+    {
+        Batch& batch = _inFlight.front();
+
+        //when blocking only wait for the oldest, anything after it is picked up if it happens to be done
+        if( block )
+        {
+            vkWaitForFences(_device, 1, &batch.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+            block = false;
+        }
+        else if( vkGetFenceStatus(_device, batch.fence) != VK_SUCCESS )
+            break;
+
+        _tail = batch.ringEnd;
+        _used -= batch.consumed;
+        _completedTicket = batch.ticket;
+        _stats.bytesRetired += batch.bytes;
+
+        vkResetFences(_device, 1, &batch.fence);
+        vkResetCommandPool(_device, batch.commandPool, 0);
+        _freeBatches.push_back(batch);
+        _inFlight.erase(_inFlight.begin());
+
+        if( _inFlight.empty() )
+            _stats.busySeconds += secondsSince(_busyStart);
+    }
+}
+
+void UploadRing::flush()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    flushLocked();
+}
+
+void UploadRing::retire()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    retireLocked(false);
+}
+
+bool UploadRing::isComplete(UploadTicket ticket)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if( ticket > _completedTicket )
+        retireLocked(false);
+    return ticket <= _completedTicket;
+}
+
+void UploadRing::wait(UploadTicket ticket)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if( ticket >= _nextTicket )
+        flushLocked();
+
+    while( ticket > _completedTicket && !_inFlight.empty() )
+        retireLocked(true);
+}
+
+void UploadRing::waitIdle()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    flushLocked();
+
+    while( !_inFlight.empty() )
+        retireLocked(true);
+}
+
+UploadRingStats UploadRing::stats() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    UploadRingStats result = _stats;
+    if( !_inFlight.empty() )
+        result.busySeconds += secondsSince(_busyStart);
+    return result;
+}
+
+void UploadRing::printStats(std::ostream& out) const
+{
+    UploadRingStats s = stats();
+
+    out << "upload ring: " << (s.capacity / 1024) << " KiB, peak use " << (s.peakUsage / 1024) << " KiB" << std::endl;
+    out << "  " << (s.bytesRetired / (1024.0 * 1024.0)) << " MiB uploaded in " << s.copies << " copies over " << s.batches
+        << " batches, " << s.bandwidthMBps() << " MB/s" << std::endl;
+    out << "  stalls: " << s.stalls << " (" << s.stallMs << " ms waiting for ring space)" << std::endl;
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "DeviceQueues.h"
+#include "GpuAllocator.h"
+
+#include <vulkan/vulkan.h>
+
+#include <chrono>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+//identifies the batch an upload went out in, complete once the batch's fence has been seen signalled
+using UploadTicket = uint64_t;
+
+struct UploadRingStats
+{
+    uint64_t bytesStaged = 0;    //copied into the ring
+    uint64_t bytesRetired = 0;   //copies the gpu has finished
+    uint32_t copies = 0;         //copy regions recorded
+    uint32_t batches = 0;        //submissions, each one carries many copies
+    uint32_t stalls = 0;         //times an upload had to block waiting for ring space
+    double stallMs = 0.0;
+    double busySeconds = 0.0;    //wall time with at least one batch in flight
+    VkDeviceSize capacity = 0;
+    VkDeviceSize peakUsage = 0;
+
+    //over the time something was actually in flight, so idle frames don't drag it down
+    double bandwidthMBps() const { return busySeconds > 0.0 ? bytesRetired / (1024.0 * 1024.0) / busySeconds : 0.0; }
+};
+
+//streams data into buffers and images through one persistently mapped staging buffer used as a ring.
+//uploads are copied into the ring straight away and recorded into the open batch, flush() submits
+//everything recorded since the last flush as one command buffer on the transfer queue. retire() polls
+//the batch fences and hands their ring space back, it never blocks, so calling it once a frame keeps
+//the frame loop free of waits unless the ring is genuinely full (which counts as a stall).
+//
+//submits go to QueueType::Transfer, which may be a different family to graphics. destinations then
+//need VK_SHARING_MODE_CONCURRENT across both (see DeviceQueues::family) as no ownership transfer is done,
+//and images are left in their final layout with no further synchronisation: only use them once
+//isComplete says so
+class UploadRing
+{
+public:
+    UploadRing(VkDevice device, DeviceQueues& queues, GpuAllocator& allocator, VkDeviceSize capacity);
+    ~UploadRing();
+
+    UploadRing(const UploadRing&) = delete;
+    UploadRing& operator=(const UploadRing&) = delete;
+
+    //uploads bigger than the ring are split over several batches, the returned ticket covers all of them
+    UploadTicket uploadBuffer(VkBuffer destination, VkDeviceSize destinationOffset, const void* data, VkDeviceSize size);
+
+    //a whole mip level of a single layer uncompressed colour image, tightly packed. the level is taken from
+    //undefined (its previous contents are discarded) to finalLayout. levels bigger than half the ring go
+    //in bands of rows, possibly over several batches, the returned ticket covers all of them
+    UploadTicket uploadImage(VkImage destination, uint32_t width, uint32_t height, uint32_t mipLevel,
+        const void* data, VkDeviceSize size, VkImageLayout finalLayout);
+
+    //rows [firstRow, firstRow + rowCount) of a level, for callers pacing a big level themselves. the band
+    //starting at row 0 takes the level from undefined, later ones expect it in finalLayout already, so
+    //the bands of a level have to go in order
+    UploadTicket uploadImageRows(VkImage destination, uint32_t width, uint32_t firstRow, uint32_t rowCount, uint32_t mipLevel,
+        const void* data, VkDeviceSize size, VkImageLayout finalLayout);
+
+    //submits the open batch, if there is one
+    void flush();
+
+    //non blocking, reclaims the space of every batch the gpu has finished with
+    void retire();
+
+    bool isComplete(UploadTicket ticket);
+    //flushes if needed then blocks until the ticket's batch is done
+    void wait(UploadTicket ticket);
+    void waitIdle();
+
+    VkDeviceSize capacity() const { return _capacity; }
+    UploadRingStats stats() const;
+    void printStats(std::ostream& out) const;
+
+private:
+    //sequence keeps copies to the same destination in the order they were made once the batch is sorted,
+    //std::stable_sort would do the same but allocates a buffer every time
+    struct BufferCopy
+    {
+        VkBuffer destination;
+        VkBufferCopy region;
+        uint32_t sequence;
+    };
+
+    //a band after the first of a level finds it in finalLayout, or in transfer dst when an earlier band
+    //went in the same batch
+    struct ImageCopy
+    {
+        VkImage destination;
+        VkBufferImageCopy region;
+        VkImageLayout initialLayout;
+        VkImageLayout finalLayout;
+        uint32_t sequence;
+    };
+
+    struct Batch
+    {
+        VkCommandPool commandPool = VK_NULL_HANDLE;
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        VkFence fence = VK_NULL_HANDLE;
+        UploadTicket ticket = 0;
+        VkDeviceSize consumed = 0; //ring bytes including alignment and wrap padding
+        VkDeviceSize ringEnd = 0;  //where the tail moves once this batch retires
+        uint64_t bytes = 0;
+    };
+
+    //lock must be held for all of these
+    VkDeviceSize allocate(VkDeviceSize size, VkDeviceSize alignment);
+    bool tryAllocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset);
+    void flushLocked();
+    void retireLocked(bool block);
+    void recordImageRows(VkImage destination, uint32_t width, uint32_t firstRow, uint32_t rowCount, uint32_t mipLevel,
+        const uint8_t* data, VkDeviceSize size, VkImageLayout finalLayout);
+    UploadTicket pendingTicket() const;
+    Batch acquireBatch();
+
+    VkDevice _device;
+    DeviceQueues& _queues;
+    GpuAllocator& _allocator;
+
+    VkBuffer _buffer = VK_NULL_HANDLE;
+    GpuAllocation _memory;
+    uint8_t* _mapped = nullptr;
+    VkDeviceSize _capacity = 0;
+
+    mutable std::mutex _mutex;
+    VkDeviceSize _head = 0;
+    VkDeviceSize _tail = 0;
+    VkDeviceSize _used = 0;
+
+    //the batch being recorded into
+    std::vector<BufferCopy> _pendingBufferCopies;
+    std::vector<ImageCopy> _pendingImageCopies;
+    VkDeviceSize _pendingConsumed = 0;
+    uint64_t _pendingBytes = 0;
+
+    //flushLocked()'s scratch, kept so a steady stream of uploads doesn't allocate
+    std::vector<VkBufferCopy> _regions;
+    std::vector<VkBufferImageCopy> _imageRegions;
+    std::vector<VkImageMemoryBarrier> _toTransfer;
+    std::vector<VkImageMemoryBarrier> _toFinal;
+
+    std::vector<Batch> _inFlight; //oldest first, never more than a handful so popping the front is cheap
+    std::vector<Batch> _freeBatches;
+    UploadTicket _nextTicket = 1;
+    UploadTicket _completedTicket = 0;
+
+    UploadRingStats _stats;
+    std::chrono::high_resolution_clock::time_point _busyStart;
+};
@@ -0,0 +1,321 @@
+#include "ValidationLog.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace
+{
+    //how long the logger sleeps when the ring is empty, the callback never wakes it
+    const auto LOGGER_IDLE_SLEEP = std::chrono::milliseconds(2);
+
+    const char* const TRUNCATED_SUFFIX = " ...\n";
+
+    uint64_t hashText(const char* text)
+    {
+        //FNV-1a
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for( ; *text != '\0'; text++ )
+        {
+            hash ^= static_cast<uint8_t>(*text);
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    //0 marks an empty table entry, so keys never are
+    uint64_t messageKey(VkDebugUtilsMessageSeverityFlagBitsEXT severity, const VkDebugUtilsMessengerCallbackDataEXT* data)
+    {
+        uint64_t id = data->messageIdNumber != 0 ? static_cast<uint32_t>(data->messageIdNumber)
+                                                 : hashText(data->pMessage != nullptr ? data->pMessage : "");
+        uint64_t key = (id ^ (static_cast<uint64_t>(severity) << 56)) * 0x9e3779b97f4a7c15ull;
+        return key != 0 ? key : 1;
+    }
+
+    const char* severityName(VkDebugUtilsMessageSeverityFlagBitsEXT severity)
+    {
+        if( severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT )
+            return "error";
+        if( severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT )
+            return "warning";
+        if( severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT )
+            return "info";
+        return "verbose";
+    }
+
+    //appends as much of text as fits, returns the new length
+    uint32_t append(char* buffer, uint32_t length, uint32_t capacity, const char* text)
+    {
+        while( *text != '\0' && length < capacity )
+            buffer[length++] = *text++;
+        return length;
+    }
+}
+
+bool parseValidationLevel(const std::string& name, ValidationLevel& level)
+{
+    if( name == "off" )
+        level = ValidationLevel::Off;
+    else if( name == "errors" )
+        level = ValidationLevel::Errors;
+    else if( name == "warnings" )
+        level = ValidationLevel::Warnings;
+    else if( name == "info" )
+        level = ValidationLevel::Info;
+    else if( name == "verbose" )
+        level = ValidationLevel::Verbose;
+    else
+        return false;
+
+    return true;
+}
+
+const char* validationLevelName(ValidationLevel level)
+{
+    switch( level )
+    {
+        case ValidationLevel::Off:      return "off";
+        case ValidationLevel::Errors:   return "errors";
+        case ValidationLevel::Warnings: return "warnings";
+        case ValidationLevel::Info:     return "info";
+        case ValidationLevel::Verbose:  return "verbose";
+    }
+    return "unknown";
+}
+
+ValidationLog::ValidationLog(ValidationLevel level, std::vector<std::string> mutedIds, uint32_t ringSlots)
+    : _level(level)
+    , _mutedIds(std::move(mutedIds))
+{
+    if( ringSlots < 2 || (ringSlots & (ringSlots - 1)) != 0 )
+        throw std::runtime_error("validation log ring size has to be a power of two!");
+
+    _seen = std::make_unique<Seen[]>(SEEN_CAPACITY);
+    _slots = std::make_unique<Slot[]>(ringSlots);
+    for (uint32_t i = 0; i < ringSlots; i++)
+        _slots[i].sequence.store(i, std::memory_order_relaxed);
+    _mask = ringSlots - 1;
+
+    _logger = std::thread([this] { drain(); });
+}
+
+ValidationLog::~ValidationLog()
+{
+    _stopping.store(true, std::memory_order_release);
+    _logger.join();
+}
+
+void ValidationLog::fillMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo)
+{
+    VkDebugUtilsMessageSeverityFlagsEXT severities = 0;
+    switch( _level )
+    {
+        case ValidationLevel::Verbose:  severities |= VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT; [[fallthrough]];
+        case ValidationLevel::Info:     severities |= VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT;    [[fallthrough]];
+        case ValidationLevel::Warnings: severities |= VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT; [[fallthrough]];
+        case ValidationLevel::Errors:   severities |= VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;   break;
+        case ValidationLevel::Off:      break;
+    }
+
+    createInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
+    createInfo.messageSeverity = severities;
+    createInfo.messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
+    createInfo.pfnUserCallback = callback;
+    createInfo.pUserData = this;
+}
+
+VKAPI_ATTR VkBool32 VKAPI_CALL ValidationLog::callback(VkDebugUtilsMessageSeverityFlagBitsEXT severity,
+    VkDebugUtilsMessageTypeFlagsEXT type, const VkDebugUtilsMessengerCallbackDataEXT* data, void* userData)
+{
+    static_cast<ValidationLog*>(userData)->post(severity, type, data);
+    //never abort the call that triggered the message
+    return VK_FALSE;
+}
+
+void ValidationLog::post(VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT type,
+    const VkDebugUtilsMessengerCallbackDataEXT* data) noexcept
+{
+    _messages.fetch_add(1, std::memory_order_relaxed);
+    if( severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT )
+        _errors.fetch_add(1, std::memory_order_relaxed);
+    else if( severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT )
+        _warnings.fetch_add(1, std::memory_order_relaxed);
+
+    bool claimed = false;
+    Seen* seen = findSeen(messageKey(severity, data), claimed);
+    if( seen != nullptr && !claimed )
+    {
+        seen->count.fetch_add(1, std::memory_order_relaxed);
+        if( seen->state.load(std::memory_order_acquire) == SeenMuted )
+            _muted.fetch_add(1, std::memory_order_relaxed);
+        else
+            _repeats.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    bool muted = isMuted(data);
+    if( seen != nullptr )
+    {
+        if( data->pMessageIdName != nullptr )
+            std::snprintf(seen->name, sizeof(seen->name), "%s", data->pMessageIdName);
+        else
+            std::snprintf(seen->name, sizeof(seen->name), "0x%08x", static_cast<uint32_t>(data->messageIdNumber));
+        seen->count.fetch_add(1, std::memory_order_relaxed);
+        seen->state.store(muted ? SeenMuted : SeenLogged, std::memory_order_release);
+    }
+
+    if( muted )
+    {
+        _muted.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    if( !push(severity, type, data->pMessage != nullptr ? data->pMessage : "") )
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+ValidationLog::Seen* ValidationLog::findSeen(uint64_t key, bool& claimed) noexcept
+{
+    //linear probing, entries are claimed once and never removed
+    for (uint32_t probe = 0; probe < SEEN_PROBES; probe++)
+    {
+        Seen& seen = _seen[(key + probe) & (SEEN_CAPACITY - 1)];
+        uint64_t current = seen.key.load(std::memory_order_acquire);
+        if( current == 0 && seen.key.compare_exchange_strong(current, key, std::memory_order_acq_rel) )
+        {
+            claimed = true;
+            return &seen;
+        }
+        //a failed claim leaves the winner's key in current, which may well be this one
+        if( current == key )
+            return &seen;
+    }
+    return nullptr;
+}
+
+bool ValidationLog::isMuted(const VkDebugUtilsMessengerCallbackDataEXT* data) const noexcept
+{
+    if( _mutedIds.empty() )
+        return false;
+
+    char number[16];
+    std::snprintf(number, sizeof(number), "0x%08x", static_cast<uint32_t>(data->messageIdNumber));
+    for (const auto& id : _mutedIds)
+    {
+        if( (data->pMessageIdName != nullptr && id == data->pMessageIdName) || id == number )
+            return true;
+    }
+    return false;
+}
+
+bool ValidationLog::push(VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT type, const char* message) noexcept
+{
+    uint64_t position = _head.load(std::memory_order_relaxed);
+    Slot* slot = nullptr;
+    while( true )
+    {
+        slot = &_slots[position & _mask];
+        uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+        int64_t difference = static_cast<int64_t>(sequence) - static_cast<int64_t>(position);
+        if( difference == 0 )
+        {
+            if( _head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed) )
+                break;
+        }
+        else if( difference < 0 )
+            return false; //the logger hasn't got to this slot since it was last used, full
+        else
+            position = _head.load(std::memory_order_relaxed);
+    }
+
+    //room for the suffix is always left, so a truncated message still ends in a newline
+    const uint32_t capacity = MESSAGE_SIZE - static_cast<uint32_t>(std::strlen(TRUNCATED_SUFFIX));
+    uint32_t length = append(slot->text, 0, capacity, "VK_DEBUG [");
+    length = append(slot->text, length, capacity, severityName(severity));
+    if( type & VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT )
+        length = append(slot->text, length, capacity, ", performance");
+    length = append(slot->text, length, capacity, "] ");
+    length = append(slot->text, length, capacity, message);
+    length = append(slot->text, length, MESSAGE_SIZE, length < capacity ? "\n" : TRUNCATED_SUFFIX);
+    slot->length = length;
+
+    slot->sequence.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+bool ValidationLog::pop()
+{
+    Slot& slot = _slots[_tail & _mask];
+    if( slot.sequence.load(std::memory_order_acquire) != _tail + 1 )
+        return false;
+
+    std::cerr.write(slot.text, slot.length);
+    _logged.fetch_add(1, std::memory_order_relaxed);
+
+    //hand the slot back to the producers for their next lap of the ring
+    slot.sequence.store(_tail + _mask + 1, std::memory_order_release);
+    _tail++;
+    return true;
+}
+
+void ValidationLog::drain()
+{
+    while( true )
+    {
+        //read before draining, whatever was pushed before the stop is written out on this last pass
+        bool stopping = _stopping.load(std::memory_order_acquire);
+
+        bool wrote = false;
+        while( pop() )
+            wrote = true;
+        if( wrote )
+            std::cerr.flush();
+
+        if( stopping )
+            break;
+        if( !wrote )
+            std::this_thread::sleep_for(LOGGER_IDLE_SLEEP);
+    }
+}
+
+ValidationLogStats ValidationLog::stats() const
+{
+    ValidationLogStats s;
+    s.messages = _messages.load(std::memory_order_relaxed);
+    s.errors = _errors.load(std::memory_order_relaxed);
+    s.warnings = _warnings.load(std::memory_order_relaxed);
+    s.logged = _logged.load(std::memory_order_relaxed);
+    s.repeats = _repeats.load(std::memory_order_relaxed);
+    s.muted = _muted.load(std::memory_order_relaxed);
+    s.dropped = _dropped.load(std::memory_order_relaxed);
+    return s;
+}
+
+void ValidationLog::printStats(std::ostream& out) const
+{
+    ValidationLogStats s = stats();
+
+    out << "validation (" << validationLevelName(_level) << "): " << s.messages << " messages, " << s.errors << " errors, "
+        << s.warnings << " warnings, " << s.repeats << " repeats, " << s.muted << " muted, " << s.dropped << " dropped" << std::endl;
+
+    const uint32_t MAX_REPEATED_SHOWN = 10;
+    std::vector<const Seen*> repeated;
+    for (uint32_t i = 0; i < SEEN_CAPACITY; i++)
+    {
+        if( _seen[i].count.load(std::memory_order_relaxed) > 1 )
+            repeated.push_back(&_seen[i]);
+    }
+    std::sort(repeated.begin(), repeated.end(), [](const Seen* a, const Seen* b) {
+        return a->count.load(std::memory_order_relaxed) > b->count.load(std::memory_order_relaxed);
+    });
+
+    for (size_t i = 0; i < std::min<size_t>(repeated.size(), MAX_REPEATED_SHOWN); i++)
+    {
+        const Seen* seen = repeated[i];
+        out << "\t" << seen->count.load(std::memory_order_relaxed) << "x " << seen->name
+            << (seen->state.load(std::memory_order_relaxed) == SeenMuted ? " (muted)" : "") << std::endl;
+    }
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+//how much of what the validation layers say gets through, each level adds a severity to the one before
+enum class ValidationLevel
+{
+    Off,      //no layers, no messenger, the driver is called directly
+    Errors,
+    Warnings,
+    Info,
+    Verbose   //every loader and layer message, slow
+};
+
+bool parseValidationLevel(const std::string& name, ValidationLevel& level);
+const char* validationLevelName(ValidationLevel level);
+
+struct ValidationLogStats
+{
+    uint64_t messages = 0;  //reached the callback
+    uint64_t errors = 0;
+    uint64_t warnings = 0;
+    uint64_t logged = 0;    //written out, the first of each message
+    uint64_t repeats = 0;   //seen before, only counted
+    uint64_t muted = 0;
+    uint64_t dropped = 0;   //arrived while the ring was full
+};
+
+//the debug messenger's callback. the layers call it on whichever thread made the vulkan call, in the
+//middle of that call, so it does as little as it can there: the message is looked up in a fixed table by
+//its id (its text when it has none), repeats only bump a counter, and the first of each is copied into a
+//fixed size slot of a lock free ring. a logger thread drains the ring to std::cerr. nothing on the
+//callback's path allocates, locks or waits on output, a full ring drops the message and counts it.
+//
+//messages are deduplicated by id, so two instances of the same VUID on different objects show as one
+//line plus a count in the summary. muted ids (pMessageIdName, or the id number as 0x%08x) are counted only
+class ValidationLog
+{
+public:
+    ValidationLog(ValidationLevel level, std::vector<std::string> mutedIds, uint32_t ringSlots = 256);
+    //drains what is left, destroy every messenger pointing at it first (the instance included)
+    ~ValidationLog();
+
+    ValidationLog(const ValidationLog&) = delete;
+    ValidationLog& operator=(const ValidationLog&) = delete;
+
+    ValidationLevel level() const { return _level; }
+
+    //severities and types for the level, with this log as the callback's user data. chained into the
+    //instance create info as well, to hear about vkCreateInstance and vkDestroyInstance
+    void fillMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo);
+
+    ValidationLogStats stats() const;
+    //totals, then the most repeated messages
+    void printStats(std::ostream& out) const;
+
+private:
+    static const uint32_t MESSAGE_SIZE = 4096;
+    static const uint32_t SEEN_CAPACITY = 4096; //distinct messages deduplicated, past that they are all logged
+    static const uint32_t SEEN_PROBES = 32;
+
+    enum SeenState : uint32_t
+    {
+        SeenPending = 0, //claimed, the first one is still deciding
+        SeenLogged,
+        SeenMuted
+    };
+
+    struct Seen
+    {
+        std::atomic<uint64_t> key{0};
+        std::atomic<uint32_t> count{0};
+        std::atomic<uint32_t> state{SeenPending};
+        char name[96] = {}; //written by whoever claimed the key, only read once the messenger is gone
+    };
+
+    struct Slot
+    {
+        std::atomic<uint64_t> sequence{0};
+        uint32_t length = 0;
+        char text[MESSAGE_SIZE];
+    };
+
+    static VKAPI_ATTR VkBool32 VKAPI_CALL callback(VkDebugUtilsMessageSeverityFlagBitsEXT severity,
+        VkDebugUtilsMessageTypeFlagsEXT type, const VkDebugUtilsMessengerCallbackDataEXT* data, void* userData);
+
+    void post(VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT type,
+        const VkDebugUtilsMessengerCallbackDataEXT* data) noexcept;
+    //null when the table is full, claimed says whether this call is the first to see the key
+    Seen* findSeen(uint64_t key, bool& claimed) noexcept;
+    bool isMuted(const VkDebugUtilsMessengerCallbackDataEXT* data) const noexcept;
+    bool push(VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT type, const char* message) noexcept;
+
+    //the logger thread
+    void drain();
+    bool pop();
+
+    ValidationLevel _level;
+    std::vector<std::string> _mutedIds;
+
+    std::unique_ptr<Seen[]> _seen;
+
+    //bounded mpsc ring, each slot's sequence says whose turn it is (Vyukov's queue)
+    std::unique_ptr<Slot[]> _slots;
+    uint64_t _mask;
+    alignas(64) std::atomic<uint64_t> _head{0}; //next slot a producer claims
+    alignas(64) uint64_t _tail = 0;             //next slot the logger reads, logger thread only
+
+    alignas(64) std::atomic<uint64_t> _messages{0};
+    std::atomic<uint64_t> _errors{0};
+    std::atomic<uint64_t> _warnings{0};
+    std::atomic<uint64_t> _logged{0};
+    std::atomic<uint64_t> _repeats{0};
+    std::atomic<uint64_t> _muted{0};
+    std::atomic<uint64_t> _dropped{0};
+
+    std::atomic<bool> _stopping{false};
+    std::thread _logger;
+};
@@ -0,0 +1,191 @@
+#include "FrameArena.h"
+#include "HeapStats.h"
+#include "JobSystem.h"
+#include "RenderGraph.h"
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+
+//a steady frame doesn't touch the heap. this runs the cpu side of one, the frame arena and its
+//containers, the render graph declaring and compiling a frame and the job system's parallelFor, over
+//and over and counts global operator new with HeapStats. once warm, not one frame may allocate. no
+//device needed, see the README
+
+//frames before counting starts, the arena and the recycled containers settle within the first couple
+static const uint32_t WARMUP_FRAMES = 4;
+static const uint32_t COUNTED_FRAMES = 64;
+
+static int failures = 0;
+
+#define CHECK(condition) check((condition), #condition, __LINE__)
+
+static void check(bool passed, const char* condition, int line)
+{
+    if( passed )
+        return;
+    std::cerr << "frame_allocation_test.cpp:" << line << ": check failed: " << condition << std::endl;
+    failures++;
+}
+
+//runs frame() WARMUP_FRAMES times, then checks COUNTED_FRAMES more make no heap allocations at all
+template<typename Frame>
+static void checkSteadyState(const char* name, const Frame& frame)
+{
+    for (uint32_t i = 0; i < WARMUP_FRAMES; i++)
+        frame(i);
+
+    uint64_t start = heapAllocationCount();
+    for (uint32_t i = WARMUP_FRAMES; i < WARMUP_FRAMES + COUNTED_FRAMES; i++)
+        frame(i);
+    uint64_t allocations = heapAllocationCount() - start;
+
+    if( allocations > 0 )
+        std::cerr << name << ": " << allocations << " heap allocations over " << COUNTED_FRAMES << " warm frames" << std::endl;
+    CHECK(allocations == 0);
+}
+
+//kept where the compiler can see them escape, a new and delete it can see both ends of may be left out
+static std::unique_ptr<int> g_single;
+static std::unique_ptr<int[]> g_array;
+
+//the counter has to see allocations at all, or everything below passes for nothing
+static void testHeapStatsCounts()
+{
+    uint64_t start = heapAllocationCount();
+    g_single = std::make_unique<int>(1);
+    g_array.reset(new int[16]);
+    CHECK(heapAllocationCount() - start == 2);
+}
+
+static void testFrameArena()
+{
+    FrameArena arena(256);
+
+    //allocations are aligned and don't overlap
+    auto a = static_cast<uint8_t*>(arena.allocate(3, 1));
+    auto b = static_cast<uint8_t*>(arena.allocate(16, 16));
+    CHECK(reinterpret_cast<uintptr_t>(b) % 16 == 0);
+    CHECK(b >= a + 3);
+    CHECK(arena.stats().allocations == 2);
+
+    //spilling past the block chains another on, the reset swaps the chain for one block that holds it all
+    for (uint32_t i = 0; i < 8; i++)
+        arena.allocate(100);
+    CHECK(arena.stats().blockAllocations > 1);
+    uint64_t blocks = arena.stats().blockAllocations;
+    arena.reset();
+    CHECK(arena.stats().blockAllocations == blocks + 1);
+    CHECK(arena.stats().bytes == 0 && arena.stats().allocations == 0);
+    CHECK(arena.stats().capacity >= 8 * 100);
+
+    //the same frame again fits without the arena going back to the heap
+    uint64_t start = heapAllocationCount();
+    arena.allocate(3, 1);
+    arena.allocate(16, 16);
+    for (uint32_t i = 0; i < 8; i++)
+        arena.allocate(100);
+    CHECK(heapAllocationCount() == start);
+    CHECK(arena.stats().blockAllocations == blocks + 1);
+    arena.reset();
+
+    //containers living in the arena, growing ones included, and more each frame than the arena first had
+    checkSteadyState("ArenaVector", [&](uint32_t frame) {
+        arena.reset();
+        ArenaVector<uint32_t> grown{ArenaAllocator<uint32_t>(arena)};
+        for (uint32_t i = 0; i < 200 + frame % 3; i++)
+            grown.push_back(i);
+
+        ArenaVector<uint64_t> reserved{ArenaAllocator<uint64_t>(arena)};
+        reserved.reserve(64);
+        reserved.assign(64, frame);
+        CHECK(grown.size() == 200 + frame % 3 && reserved.back() == frame);
+    });
+    CHECK(arena.stats().peakBytes > 256);
+}
+
+//nothing the graph does before execute() needs a device as long as its resources are imported
+static void testRenderGraph()
+{
+    GpuMemoryBackend backend;
+    backend.allocate = [](uint32_t, VkDeviceSize, VkDeviceMemory*) { return VK_ERROR_OUT_OF_DEVICE_MEMORY; };
+    backend.free = [](VkDeviceMemory) {};
+    backend.map = [](VkDeviceMemory, void**) { return VK_ERROR_OUT_OF_DEVICE_MEMORY; };
+    backend.unmap = [](VkDeviceMemory) {};
+    VkPhysicalDeviceMemoryProperties memoryProperties = {};
+    GpuAllocator allocator(memoryProperties, backend);
+
+    const uint32_t frameSlots = 2;
+    RenderGraph graph(VK_NULL_HANDLE, allocator, frameSlots);
+
+    VkImage swapchainImage = reinterpret_cast<VkImage>(uintptr_t(1));
+    VkImage sceneImage = reinterpret_cast<VkImage>(uintptr_t(2));
+    VkBuffer instances = reinterpret_cast<VkBuffer>(uintptr_t(3));
+    VkBuffer feedback = reinterpret_cast<VkBuffer>(uintptr_t(4));
+    uint32_t executed = 0;
+
+    checkSteadyState("RenderGraph", [&](uint32_t frame) {
+        graph.beginFrame(frame % frameSlots);
+
+        RenderGraphState attachment = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED};
+        auto swapchain = graph.importImage("swapchain", swapchainImage, VK_NULL_HANDLE, VK_FORMAT_B8G8R8A8_SRGB, {1280, 720}, attachment);
+        auto scene = graph.importImage("scene", sceneImage, VK_NULL_HANDLE, VK_FORMAT_R16G16B16A16_SFLOAT, {1280, 720}, attachment);
+        auto instanceBuffer = graph.importBuffer("instances", instances);
+        auto feedbackBuffer = graph.importBuffer("feedback", feedback);
+
+        //captures big enough that a std::function would have gone to the heap
+        uint64_t padding[4] = {frame, frame, frame, frame};
+        graph.addPass("upload", [&executed, padding](VkCommandBuffer) { executed += static_cast<uint32_t>(padding[0]); })
+            .use(instanceBuffer, RenderGraphAccess::TransferWrite);
+        graph.addPass("scene", [&executed, padding](VkCommandBuffer) { executed += static_cast<uint32_t>(padding[1]); })
+            .use(instanceBuffer, RenderGraphAccess::IndirectRead)
+            .use(scene, RenderGraphAccess::ColorAttachmentWrite)
+            .use(feedbackBuffer, RenderGraphAccess::StorageWrite);
+        graph.addPass("post", [&executed, padding](VkCommandBuffer) { executed += static_cast<uint32_t>(padding[2]); })
+            .use(scene, RenderGraphAccess::SampledRead)
+            .use(swapchain, RenderGraphAccess::ColorAttachmentWrite);
+        //writes nothing, so nothing can depend on it and it is culled every frame
+        graph.addPass("unused", [&executed, padding](VkCommandBuffer) { executed += static_cast<uint32_t>(padding[3]); })
+            .use(feedbackBuffer, RenderGraphAccess::StorageRead);
+        graph.exportResource(swapchain, RenderGraphAccess::Present);
+        graph.exportResource(feedbackBuffer, RenderGraphAccess::HostRead);
+
+        graph.compile();
+        CHECK(graph.stats().passes == 4 && graph.stats().culledPasses == 1);
+        CHECK(graph.image(swapchain) == swapchainImage);
+    });
+}
+
+static void testJobSystem()
+{
+    JobSystem jobs(3);
+    std::vector<uint32_t> values(4096);
+
+    checkSteadyState("JobSystem::parallelFor", [&](uint32_t frame) {
+        //as much captured as the frame's own loops capture
+        uint32_t* data = values.data();
+        uint32_t a = frame, b = frame + 1, c = frame + 2;
+        jobs.parallelFor(static_cast<uint32_t>(values.size()), 64, [data, a, b, c](uint32_t begin, uint32_t end, uint32_t) {
+            for (uint32_t i = begin; i < end; i++)
+                data[i] = a + b + c + i;
+        });
+        CHECK(values[100] == 3 * frame + 3 + 100);
+    });
+}
+
+int main()
+{
+    testHeapStatsCounts();
+    testFrameArena();
+    testRenderGraph();
+    testJobSystem();
+
+    if( failures > 0 )
+    {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+
+    std::cout << "all frame allocation checks passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,410 @@
+#include "GpuAllocator.h"
+
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <set>
+#include <vector>
+
+//runs the allocator over a fake GpuMemoryBackend, no device needed: allocation, free, buddy
+//merging, defragmentation and the linear pool. exits non zero if anything fails, see the README
+
+static const VkDeviceSize BLOCK_SIZE = 4096; //16 of the smallest ranges, small enough to fill by hand
+static const VkDeviceSize SLOT = GpuAllocator::MIN_ALLOCATION_SIZE;
+
+static int failures = 0;
+
+#define CHECK(condition) check((condition), #condition, __LINE__)
+
+static void check(bool passed, const char* condition, int line)
+{
+    if( passed )
+        return;
+    std::cerr << "gpu_allocator_test.cpp:" << line << ": check failed: " << condition << std::endl;
+    failures++;
+}
+
+//hands out made up memory handles, host visible ones are backed by real bytes so mapped pointers can be checked
+struct FakeMemory
+{
+    uintptr_t nextHandle = 1;
+    std::map<VkDeviceMemory, std::vector<char>> live;
+    uint32_t allocateCount = 0;
+    uint32_t freeCount = 0;
+    uint32_t mappedCount = 0;
+
+    GpuMemoryBackend backend()
+    {
+        GpuMemoryBackend backend;
+        backend.allocate = [this](uint32_t, VkDeviceSize size, VkDeviceMemory* memory) {
+            *memory = reinterpret_cast<VkDeviceMemory>(nextHandle++);
+            live[*memory].resize(static_cast<size_t>(size));
+            allocateCount++;
+            return VK_SUCCESS;
+        };
+        backend.free = [this](VkDeviceMemory memory) {
+            check(live.erase(memory) == 1, "freed memory the backend handed out", __LINE__);
+            freeCount++;
+        };
+        backend.map = [this](VkDeviceMemory memory, void** data) {
+            *data = live[memory].data();
+            mappedCount++;
+            return VK_SUCCESS;
+        };
+        backend.unmap = [this](VkDeviceMemory) {
+            mappedCount--;
+        };
+        return backend;
+    }
+};
+
+//type 0 is device local, type 1 host visible
+static VkPhysicalDeviceMemoryProperties memoryProperties()
+{
+    VkPhysicalDeviceMemoryProperties properties = {};
+    properties.memoryTypeCount = 2;
+    properties.memoryTypes[0].propertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    properties.memoryTypes[1].propertyFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    properties.memoryHeapCount = 1;
+    return properties;
+}
+
+static VkMemoryRequirements requirements(VkDeviceSize size, VkDeviceSize alignment = 1, uint32_t typeBits = 1u)
+{
+    VkMemoryRequirements requirements = {};
+    requirements.size = size;
+    requirements.alignment = alignment;
+    requirements.memoryTypeBits = typeBits;
+    return requirements;
+}
+
+static GpuAllocation allocateSlot(GpuAllocator& allocator, VkDeviceSize size = SLOT, uint64_t userData = 0)
+{
+    return allocator.allocate(requirements(size), 0, GpuResourceKind::Buffer, 0, userData);
+}
+
+static void testAllocation()
+{
+    FakeMemory fake;
+    {
+        GpuAllocator allocator(memoryProperties(), fake.backend(), BLOCK_SIZE);
+
+        //sizes round up to the next buddy size and land on multiples of it
+        auto small = allocateSlot(allocator, 100);
+        auto medium = allocateSlot(allocator, 700);
+        auto aligned = allocator.allocate(requirements(SLOT, 2048), 0, GpuResourceKind::Buffer);
+        CHECK(small.isValid() && medium.isValid() && aligned.isValid());
+        CHECK(small.memory == medium.memory && medium.memory == aligned.memory);
+        CHECK(small.offset % SLOT == 0);
+        CHECK(medium.offset % 1024 == 0);
+        CHECK(aligned.offset % 2048 == 0);
+        CHECK(small.offset != medium.offset && medium.offset != aligned.offset && small.offset != aligned.offset);
+
+        auto stats = allocator.stats();
+        CHECK(stats.blockCount == 1);
+        CHECK(stats.allocationCount == 3);
+        CHECK(stats.usedBytes == 100 + 700 + SLOT);
+        CHECK(stats.reservedBytes == SLOT + 1024 + 2048);
+
+        //images never share a block with buffers
+        auto image = allocator.allocate(requirements(SLOT), 0, GpuResourceKind::Image);
+        CHECK(image.memory != small.memory);
+
+        //more than half a block gets its own memory
+        auto big = allocateSlot(allocator, BLOCK_SIZE / 2 + 1);
+        CHECK(big.dedicated && big.offset == 0);
+        CHECK(allocator.stats().dedicatedAllocationCount == 1);
+
+        //host visible memory stays mapped, allocations point at their own offset
+        auto mapped = allocator.allocate(requirements(SLOT, 1, 0b10), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, GpuResourceKind::Buffer);
+        auto mappedToo = allocator.allocate(requirements(SLOT, 1, 0b10), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, GpuResourceKind::Buffer);
+        CHECK(mapped.memoryTypeIndex == 1 && small.memoryTypeIndex == 0);
+        CHECK(mapped.mapped == fake.live[mapped.memory].data() + mapped.offset);
+        CHECK(mappedToo.mapped == fake.live[mappedToo.memory].data() + mappedToo.offset);
+        CHECK(small.mapped == nullptr);
+
+        allocator.free(big);
+        CHECK(!big.isValid());
+        CHECK(allocator.stats().dedicatedAllocationCount == 0);
+    }
+
+    //the allocator gives back everything it still holds
+    CHECK(fake.live.empty());
+    CHECK(fake.allocateCount == fake.freeCount);
+    CHECK(fake.mappedCount == 0);
+}
+
+static void testFreeAndMerge()
+{
+    FakeMemory fake;
+    {
+        GpuAllocator allocator(memoryProperties(), fake.backend(), BLOCK_SIZE);
+
+        std::vector<GpuAllocation> slots;
+        for (VkDeviceSize i = 0; i < BLOCK_SIZE / SLOT; i++)
+            slots.push_back(allocateSlot(allocator));
+        CHECK(allocator.stats().blockCount == 1);
+        CHECK(allocator.stats().largestFreeRange == 0);
+
+        //two buddies merge back into one range of twice the size, the new allocation reuses it
+        allocator.free(slots[0]);
+        allocator.free(slots[1]);
+        CHECK(allocator.stats().largestFreeRange == 2 * SLOT);
+        auto merged = allocateSlot(allocator, 2 * SLOT);
+        CHECK(merged.memory == slots[2].memory && merged.offset == 0);
+        allocator.free(merged);
+
+        //neighbours that aren't buddies don't merge
+        allocator.free(slots[3]);
+        allocator.free(slots[4]);
+        CHECK(allocator.stats().largestFreeRange == 2 * SLOT);
+
+        //in any order, everything merges back into the whole block
+        for (size_t i = slots.size(); i-- > 0; )
+            allocator.free(slots[i]);
+        auto stats = allocator.stats();
+        CHECK(stats.allocationCount == 0);
+        CHECK(stats.reservedBytes == 0);
+        CHECK(stats.largestFreeRange == BLOCK_SIZE);
+        CHECK(stats.fragmentation == 0.f);
+
+        //the last empty block is kept around, a second empty one is released
+        CHECK(stats.blockCount == 1);
+        for (VkDeviceSize i = 0; i < BLOCK_SIZE / SLOT + 1; i++)
+            slots.push_back(allocateSlot(allocator));
+        CHECK(allocator.stats().blockCount == 2);
+        for (auto& slot : slots)
+            allocator.free(slot);
+        CHECK(allocator.stats().blockCount == 1);
+        CHECK(fake.live.size() == 1);
+    }
+
+    CHECK(fake.live.empty());
+}
+
+//a block that empties stays unless another of its kind is already empty, full ones don't count
+static void testEmptyBlockKept()
+{
+    FakeMemory fake;
+    {
+        GpuAllocator allocator(memoryProperties(), fake.backend(), BLOCK_SIZE);
+
+        std::vector<GpuAllocation> full;
+        for (VkDeviceSize i = 0; i < BLOCK_SIZE / SLOT; i++)
+            full.push_back(allocateSlot(allocator));
+        auto working = allocateSlot(allocator);
+        CHECK(working.memory != full[0].memory);
+
+        //freeing and allocating again on the second block never goes back to the backend
+        uint32_t allocateCount = fake.allocateCount;
+        uint32_t freeCount = fake.freeCount;
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            allocator.free(working);
+            CHECK(allocator.stats().blockCount == 2);
+            working = allocateSlot(allocator);
+        }
+        CHECK(fake.allocateCount == allocateCount && fake.freeCount == freeCount);
+
+        //with a third block empty, the second goes as soon as it empties too
+        std::vector<GpuAllocation> second;
+        for (VkDeviceSize i = 1; i < BLOCK_SIZE / SLOT; i++)
+            second.push_back(allocateSlot(allocator));
+        auto third = allocateSlot(allocator);
+        CHECK(allocator.stats().blockCount == 3);
+        allocator.free(third);
+        CHECK(allocator.stats().blockCount == 3);
+        allocator.free(working);
+        for (auto& allocation : second)
+            allocator.free(allocation);
+        CHECK(allocator.stats().blockCount == 2);
+        CHECK(fake.freeCount == freeCount + 1);
+    }
+
+    CHECK(fake.live.empty());
+}
+
+//every source is a different allocation, no range is the destination of two moves and nothing is moved
+//out of a block that is also being moved into
+static void checkMoves(const std::vector<GpuDefragMove>& moves)
+{
+    std::set<std::pair<VkDeviceMemory, VkDeviceSize>> sources;
+    std::set<std::pair<VkDeviceMemory, VkDeviceSize>> destinations;
+    std::set<VkDeviceMemory> sourceBlocks;
+    std::set<VkDeviceMemory> destinationBlocks;
+    for (const auto& move : moves)
+    {
+        CHECK(sources.insert(std::make_pair(move.from.memory, move.from.offset)).second);
+        CHECK(destinations.insert(std::make_pair(move.to.memory, move.to.offset)).second);
+        CHECK(move.from.memory != move.to.memory);
+        CHECK(move.from.userData == move.to.userData && move.from.size == move.to.size);
+        sourceBlocks.insert(move.from.memory);
+        destinationBlocks.insert(move.to.memory);
+    }
+
+    for (auto memory : sourceBlocks)
+        CHECK(destinationBlocks.count(memory) == 0);
+}
+
+static void testDefragment()
+{
+    FakeMemory fake;
+    {
+        GpuAllocator allocator(memoryProperties(), fake.backend(), BLOCK_SIZE);
+
+        //a nearly full block with two free slots and a nearly empty one with two allocations
+        std::vector<GpuAllocation> full;
+        for (VkDeviceSize i = 0; i < BLOCK_SIZE / SLOT; i++)
+            full.push_back(allocateSlot(allocator));
+        allocateSlot(allocator, SLOT, 1);
+        allocateSlot(allocator, SLOT, 2);
+        allocator.free(full[5]);
+        allocator.free(full[9]);
+        CHECK(allocator.stats().blockCount == 2);
+
+        //limited to one allocation's worth of bytes, only one moves
+        auto moves = allocator.defragment(SLOT);
+        CHECK(moves.size() == 1);
+        checkMoves(moves);
+        CHECK(moves.size() == 1 && moves[0].to.memory == full[0].memory);
+        allocator.commitDefragmentation(moves);
+
+        moves = allocator.defragment(BLOCK_SIZE);
+        CHECK(moves.size() == 1);
+        checkMoves(moves);
+        allocator.commitDefragmentation(moves);
+
+        //the emptied block is the only empty one so it stays, everything else lives in the full block
+        auto stats = allocator.stats();
+        CHECK(stats.allocationCount == BLOCK_SIZE / SLOT);
+        CHECK(stats.largestFreeRange == BLOCK_SIZE);
+        CHECK(allocator.defragment(BLOCK_SIZE).empty());
+    }
+
+    CHECK(fake.live.empty());
+}
+
+//blocks are drained in order of how full they are. a block that has just been given an allocation is
+//fuller than the one it came from and would be drained next, which would plan a copy out of memory the
+//first move hasn't written yet
+static void testDefragmentChained()
+{
+    FakeMemory fake;
+    {
+        GpuAllocator allocator(memoryProperties(), fake.backend(), BLOCK_SIZE);
+
+        //fullest: 15 slots, one free slot but no room for 4
+        //middle: 12 slots, room for 4 at the end
+        //emptiest: a single allocation of 4 slots
+        std::vector<GpuAllocation> fullest;
+        std::vector<GpuAllocation> middle;
+        for (VkDeviceSize i = 0; i < BLOCK_SIZE / SLOT; i++)
+            fullest.push_back(allocateSlot(allocator, SLOT, 100 + i));
+        for (VkDeviceSize i = 0; i < BLOCK_SIZE / SLOT; i++)
+            middle.push_back(allocateSlot(allocator, SLOT, 200 + i));
+        auto emptiest = allocateSlot(allocator, 4 * SLOT, 300);
+        CHECK(allocator.stats().blockCount == 3);
+        CHECK(emptiest.memory != fullest[0].memory && emptiest.memory != middle[0].memory);
+
+        allocator.free(fullest[7]);
+        for (size_t i = 12; i < 16; i++)
+            allocator.free(middle[i]);
+
+        //the big one only fits in the middle block, which then must not have its own slots moved on
+        auto moves = allocator.defragment(BLOCK_SIZE * 4);
+        checkMoves(moves);
+        CHECK(moves.size() == 1);
+        CHECK(moves.size() == 1 && moves[0].from.userData == 300 && moves[0].to.memory == middle[0].memory);
+        allocator.commitDefragmentation(moves);
+
+        auto stats = allocator.stats();
+        CHECK(stats.allocationCount == 15 + 12 + 1);
+        CHECK(stats.reservedBytes == (15 + 12 + 4) * SLOT);
+
+        //the middle block is full now and nothing fits anywhere fuller
+        CHECK(allocator.defragment(BLOCK_SIZE * 4).empty());
+    }
+
+    CHECK(fake.live.empty());
+}
+
+static void testLinearPool()
+{
+    FakeMemory fake;
+    {
+        GpuAllocator allocator(memoryProperties(), fake.backend(), BLOCK_SIZE);
+        {
+            const VkDeviceSize capacity = 1024;
+            GpuLinearPool pool(allocator, capacity, 1);
+            const GpuAllocation& block = pool.block();
+            CHECK(pool.capacity() == capacity);
+            CHECK(block.isValid() && block.mapped != nullptr);
+
+            //three ranges one after another, aligned
+            GpuAllocation first, second, third, allocation;
+            CHECK(pool.allocate(300, 16, first));
+            uint64_t firstMarker = pool.marker();
+            CHECK(pool.allocate(300, 16, second));
+            CHECK(pool.allocate(300, 16, third));
+            uint64_t thirdMarker = pool.marker();
+            CHECK(first.memory == block.memory && first.offset == block.offset);
+            CHECK(second.offset == block.offset + 304 && third.offset == block.offset + 608);
+            CHECK(second.mapped == static_cast<char*>(block.mapped) + 304);
+            CHECK(pool.usedBytes() == 908);
+
+            //the fourth doesn't fit before the end and the front is still in use, nothing changes
+            CHECK(!pool.allocate(300, 16, allocation));
+            CHECK(pool.marker() == thirdMarker);
+            CHECK(!pool.allocate(capacity + 1, 1, allocation));
+
+            //once the first is released the next one wraps round to the front, skipping the end
+            pool.releaseUpTo(firstMarker);
+            CHECK(pool.allocate(300, 16, allocation));
+            CHECK(allocation.offset == block.offset && allocation.mapped == block.mapped);
+            CHECK(pool.usedBytes() == capacity);
+
+            //right behind it is still the second, until that is released too
+            CHECK(!pool.allocate(16, 16, allocation));
+            pool.releaseUpTo(thirdMarker);
+            CHECK(pool.allocate(16, 16, allocation));
+            CHECK(allocation.offset == block.offset + 304);
+
+            //releasing never goes backwards or past what has been handed out
+            uint64_t head = pool.marker();
+            pool.releaseUpTo(firstMarker);
+            CHECK(pool.usedBytes() == head - thirdMarker);
+            pool.releaseUpTo(UINT64_MAX);
+            CHECK(pool.usedBytes() == 0);
+
+            //empty, the whole pool can be taken at once
+            CHECK(pool.allocate(capacity, 1, allocation));
+            CHECK(allocation.offset == block.offset);
+            pool.reset();
+            CHECK(pool.usedBytes() == 0);
+        }
+
+        //the pool's memory went back to the allocator with it
+        CHECK(allocator.stats().allocationCount == 0);
+    }
+
+    CHECK(fake.live.empty());
+}
+
+int main()
+{
+    testAllocation();
+    testFreeAndMerge();
+    testEmptyBlockKept();
+    testDefragment();
+    testDefragmentChained();
+    testLinearPool();
+
+    if( failures > 0 )
+    {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+
+    std::cout << "all gpu allocator checks passed" << std::endl;
+    return 0;
+}
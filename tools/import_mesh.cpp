@@ -0,0 +1,33 @@
+#include "MeshImport.h"
+
+#include <cstdlib>
+#include <iostream>
+
+//import_mesh <input.obj> <output.vkm> converts a mesh into the format MeshFile reads, see MeshImport.h
+int main(int argc, char** argv)
+{
+    if( argc != 3 )
+    {
+        std::cerr << "usage: " << argv[0] << " <input.obj> <output.vkm>" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        auto stats = importMesh(argv[1], argv[2]);
+
+        //position, normal and uv as floats is 32 bytes a vertex, and indices would be 32 bit
+        uint64_t unpackedBytes = stats.vertices * 32ull + stats.triangles * 12ull;
+        std::cout << "Imported " << argv[1] << " in " << stats.ms << "ms: " << stats.vertices << " vertices, "
+                  << stats.triangles << " triangles, " << stats.meshlets << " meshlets" << std::endl;
+        std::cout << "  cache misses per triangle " << stats.acmrBefore << " -> " << stats.acmrAfter << std::endl;
+        std::cout << "  wrote " << stats.fileBytes << " bytes to " << argv[2] << " (" << unpackedBytes << " unquantised)" << std::endl;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
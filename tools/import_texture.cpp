@@ -0,0 +1,30 @@
+#include "TextureImport.h"
+
+#include <cstdlib>
+#include <iostream>
+
+//import_texture <input.ppm> <output.vkt> builds the mip chain and writes the format TextureFile reads, see TextureImport.h
+int main(int argc, char** argv)
+{
+    if( argc != 3 )
+    {
+        std::cerr << "usage: " << argv[0] << " <input.ppm> <output.vkt>" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        auto stats = importTexture(argv[1], argv[2]);
+
+        std::cout << "Imported " << argv[1] << " in " << stats.ms << "ms: " << stats.width << "x" << stats.height
+                  << ", " << stats.levels << " levels" << std::endl;
+        std::cout << "  wrote " << stats.fileBytes << " bytes to " << argv[2] << std::endl;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
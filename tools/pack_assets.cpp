@@ -0,0 +1,29 @@
+#include "AssetArchive.h"
+
+#include <cstdlib>
+#include <iostream>
+
+//pack_assets <archive> <file>... packs each file under its file name, see AssetArchive.h for the format
+int main(int argc, char** argv)
+{
+    if( argc < 2 )
+    {
+        std::cerr << "usage: " << argv[0] << " <archive> <file>..." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        AssetArchive::Writer writer;
+        for( int i = 2; i < argc; i++ )
+            writer.addFile(argv[i]);
+        writer.write(argv[1]);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}